@@ -147,6 +147,79 @@ mfxStatus MFX_CDECL MFXCreateSession(mfxLoader loader, mfxU32 i, mfxSession* ses
 */
 mfxStatus MFX_CDECL MFXDispReleaseImplDescription(mfxLoader loader, mfxHDL hdl);
 
+#ifdef ONEVPL_EXPERIMENTAL
+/*!
+   @brief
+      Callback function which is called when the background load started by MFXLoadAsync is complete.
+
+   @param[in] loader   Loader handle.
+   @param[in] sts      Result of the load, same as returned by MFXLoadWait.
+   @param[in] userData Pointer passed to MFXLoadAsync.
+*/
+typedef void (MFX_CDECL *mfxLoadReadyCallback)(mfxLoader loader, mfxStatus sts, mfxHDL userData);
+
+/*!
+   @brief
+      Starts searching for and querying all available implementations on a background thread.
+      The application may continue with other work and use MFXLoadWait, or the callback, to learn
+      when the loader is ready. MFXEnumImplementations, MFXCreateSession, MFXDispReleaseImplDescription and
+      MFXUnload called before the loader is ready block only until the background load is complete.
+      MFXCreateConfig and MFXSetConfigFilterProperty do not block, and filters are applied when the
+      background load is complete. Properties which select the acceleration mode should be set
+      before calling this function.
+
+   @param[in] loader   Loader handle.
+   @param[in] callback Function to call from the background thread when the load is complete. Can be equal to NULL.
+   @param[in] userData Pointer which is passed to the callback. Can be equal to NULL.
+
+   @return
+      MFX_ERR_NONE               The background load was started. \n
+      MFX_ERR_NULL_PTR           If loader is NULL. \n
+      MFX_ERR_UNDEFINED_BEHAVIOR If a load was already started, or if MFXEnumImplementations or MFXCreateSession were already called. \n
+      MFX_ERR_MEMORY_ALLOC       If the background thread could not be started.
+
+   @since This function is available since API version 2.8.
+*/
+mfxStatus MFX_CDECL MFXLoadAsync(mfxLoader loader, mfxLoadReadyCallback callback, mfxHDL userData);
+
+/*!
+   @brief
+      Waits until the background load started by MFXLoadAsync is complete, or until the timeout expires.
+      Use a timeout of 0 to poll.
+
+   @param[in] loader   Loader handle.
+   @param[in] wait     Wait time in milliseconds. Use MFX_INFINITE to wait until the load is complete.
+
+   @return
+      MFX_ERR_NONE            The load is complete and at least one implementation was found. \n
+      MFX_ERR_NULL_PTR        If loader is NULL. \n
+      MFX_ERR_NOT_INITIALIZED If MFXLoadAsync was not called. \n
+      MFX_ERR_NOT_FOUND       The load is complete and no implementation was found. \n
+      MFX_WRN_IN_EXECUTION    The load is not complete yet.
+
+   @since This function is available since API version 2.8.
+*/
+mfxStatus MFX_CDECL MFXLoadWait(mfxLoader loader, mfxU32 wait);
+
+/*!
+   @brief
+      Writes the trace events recorded by the loader since the last flush to the trace file.
+      Tracing is enabled by setting the ONEVPL_DISPATCHER_TRACE_FILE environment variable to the name of the trace
+      file before calling MFXLoad. Remaining events are written by MFXUnload.
+
+   @param[in] loader   Loader handle.
+
+   @return
+      MFX_ERR_NONE            The events were written, or there were no new events. \n
+      MFX_ERR_NULL_PTR        If loader is NULL. \n
+      MFX_ERR_NOT_INITIALIZED If tracing is not enabled. \n
+      MFX_ERR_UNKNOWN         If the trace file could not be written.
+
+   @since This function is available since API version 2.8.
+*/
+mfxStatus MFX_CDECL MFXDispFlushTrace(mfxLoader loader);
+#endif
+
 /* Helper macro definitions to add config filter properties. */
 
 /*! Adds single property of mfxU32 type.
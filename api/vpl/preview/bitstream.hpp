@@ -9,11 +9,13 @@
 #include <algorithm>
 #include <chrono>
 #include <functional>
+#include <memory>
 #include <utility>
 
 #include "vpl/preview/defs.hpp"
 #include "vpl/preview/exception.hpp"
 
+#include "vpl/preview/detail/mirrored_buffer.hpp"
 #include "vpl/preview/detail/sdk_callable.hpp"
 #include "vpl/preview/detail/string_helpers.hpp"
 #include "vpl/mfxstructures.h"
@@ -67,12 +69,17 @@ public:
         bits_.CodecId         = (uint32_t)codecID;
     }
 
-    /// @brief default ctor
-    virtual ~bitstream() {}
+    /// @brief Dtor. Frees internal buffer.
+    virtual ~bitstream() {
+        delete[] bits_.Data;
+    }
+
+    bitstream(const bitstream&) = delete;
+    bitstream& operator=(const bitstream&) = delete;
 
     /// @brief Reallocs internal buffer with the given buffer size increase value. Valid data is copied into new buffer
     /// @param[in] bufferinc Number of bytes to increase the buffer.
-    void realloc(uint32_t bufferinc = buffer_len::DEFAULT_LENGHT) {
+    virtual void realloc(uint32_t bufferinc = buffer_len::DEFAULT_LENGHT) {
         uint8_t* new_buffer = new uint8_t[bufferinc + bits_.MaxLength];
 
         if (bits_.DataOffset) {
@@ -104,8 +111,8 @@ public:
     iDECLARE_MEMBER_ACCESS(uint16_t, bits_, PicStruct);
     iDECLARE_MEMBER_ACCESS(uint16_t, bits_, FrameType);
     iDECLARE_MEMBER_ACCESS(uint16_t, bits_, DataFlag);
-    iDECLARE_MEMBER_ACCESS(uint16_t, bits_, DataOffset);
-    iDECLARE_MEMBER_ACCESS(uint16_t, bits_, DataLength);
+    iDECLARE_MEMBER_ACCESS(uint32_t, bits_, DataOffset);
+    iDECLARE_MEMBER_ACCESS(uint32_t, bits_, DataLength);
 
     /// @brief Returns pointer to the head of internal circular buffer.
     /// @return Pointer to the head of internal circular buffer.
@@ -176,22 +183,118 @@ inline std::ostream& operator<<(std::ostream& out, const bitstream& b) {
 class bitstream_as_src : public bitstream {
 public:
     /// @brief Default ctor
-    bitstream_as_src() : bitstream() {}
+    bitstream_as_src() : bitstream(), own_data_(nullptr), own_max_length_(0), ring_() {}
     /// @brief Constructs bitstream object with given codec ID and default buffer length
     /// @param[in] codecID codec's fourCC code
-    explicit bitstream_as_src(codec_format_fourcc codecID) : bitstream(codecID) {}
+    explicit bitstream_as_src(codec_format_fourcc codecID)
+            : bitstream(codecID),
+              own_data_(nullptr),
+              own_max_length_(0),
+              ring_() {}
     /// @brief Constructs bitstream object with given codec ID and given buffer length
     /// @param[in] codecID codec's fourCC code
     /// @param[in] buffersize circular buffer size in bytes
     bitstream_as_src(codec_format_fourcc codecID, uint32_t buffersize)
-            : bitstream(codecID, buffersize) {}
+            : bitstream(codecID, buffersize),
+              own_data_(nullptr),
+              own_max_length_(0),
+              ring_() {}
+
+    /// @brief Points the bitstream to the data owned by the caller (for example memory mapped file)
+    /// instead of the internal buffer, so the data is not copied. The data must stay valid while it is attached.
+    /// @param[in] data Pointer to the first valid byte.
+    /// @param[in] length Number of valid bytes.
+    void attach(uint8_t* data, uint32_t length) {
+        if (!own_data_) {
+            own_data_       = bits_.Data;
+            own_max_length_ = bits_.MaxLength;
+        }
+        bits_.Data       = data;
+        bits_.DataOffset = 0;
+        bits_.DataLength = length;
+        bits_.MaxLength  = length;
+    }
+
+    /// @brief Dtor. Restores internal buffer so that it is freed instead of the attached data.
+    ~bitstream_as_src() {
+        if (own_data_)
+            bits_.Data = own_data_;
+        // ring buffer is freed by its owner
+        if (ring_)
+            bits_.Data = nullptr;
+    }
+
+    /// @brief Switches internal buffer to the ring buffer which is mapped twice into the address space
+    /// (see detail::mirrored_buffer). pull_in() then never moves unconsumed data: the start of the buffer
+    /// follows the start of valid data and wraps around, while the valid data stays contiguous. Buffer size
+    /// is rounded up to the page size. Valid data is kept.
+    /// @return False if the platform can't provide such buffer, then the current buffer stays in use.
+    bool use_ring_buffer() {
+        if (ring_)
+            return true;
+        detach();
+        if (!make_ring(bits_.MaxLength))
+            return false;
+        return true;
+    }
+
+    /// @brief Checks whether the internal buffer is the ring buffer.
+    /// @return True if use_ring_buffer() succeeded.
+    bool is_ring_buffer() const {
+        return ring_ != nullptr;
+    }
+
+    /// @brief Checks whether the bitstream points to the attached data.
+    /// @return True if data is attached.
+    bool is_attached() const {
+        return own_data_ != nullptr;
+    }
+
+    /// @brief Switches the bitstream back to the internal buffer. Valid data is copied into the internal buffer.
+    void detach() {
+        if (!own_data_)
+            return;
+
+        uint8_t* data   = bits_.Data + bits_.DataOffset;
+        uint32_t length = bits_.DataLength;
+
+        bits_.Data       = own_data_;
+        bits_.MaxLength  = own_max_length_;
+        bits_.DataOffset = 0;
+        bits_.DataLength = 0;
+        own_data_        = nullptr;
+        own_max_length_  = 0;
+
+        if (length > bits_.MaxLength)
+            grow(length - bits_.MaxLength);
+
+        std::copy(data, data + length, bits_.Data);
+        bits_.DataLength = length;
+    }
+
+    /// @brief Reallocs internal buffer with the given buffer size increase value. Valid data is copied into new buffer.
+    /// Attached data is detached first.
+    /// @param[in] bufferinc Number of bytes to increase the buffer.
+    void realloc(uint32_t bufferinc = buffer_len::DEFAULT_LENGHT) override {
+        detach();
+        grow(bufferinc);
+    }
 
     /// @brief Stores maximum possible portion of data in the circular buffer. Data is strored after
     /// unused portion of the buffer in the length of avialable space in the buffer.
     /// @param[in] reader source reader callback.
     void pull_in(std::function<uint32_t(uint8_t*, uint32_t, bool&)> reader) {
         bool eosFlag = false;
-        if (bits_.DataOffset) {
+        detach();
+        if (ring_) {
+            // move the start of the buffer to the valid data instead of moving the data
+            uint8_t* start = bits_.Data + bits_.DataOffset;
+            if (start >= ring_->data() + ring_->size())
+                start -= ring_->size();
+            bits_.Data       = start;
+            bits_.DataOffset = 0;
+        }
+        else if (bits_.DataOffset) {
             std::copy(bits_.Data + bits_.DataOffset,
                       bits_.Data + bits_.DataOffset + bits_.DataLength,
                       bits_.Data);
@@ -202,6 +305,47 @@ public:
                                              eosFlag);
         // if(eosFlag) bits_.DataFlag = MFX_BITSTREAM_EOS;
     }
+
+protected:
+    /// @brief Increases internal buffer. Valid data is copied into the new buffer.
+    /// @param[in] bufferinc Number of bytes to increase the buffer.
+    void grow(uint32_t bufferinc) {
+        if (!ring_) {
+            bitstream::realloc(bufferinc);
+            return;
+        }
+        if (!make_ring(bits_.MaxLength + bufferinc))
+            throw base_exception(MFX_ERR_MEMORY_ALLOC);
+    }
+
+    /// @brief Allocates new ring buffer and moves valid data into it.
+    /// @param[in] length Minimum buffer length.
+    /// @return False if ring buffer can't be allocated.
+    bool make_ring(uint32_t length) {
+        auto ring = std::make_unique<detail::mirrored_buffer>(length);
+        if (!ring->valid())
+            return false;
+
+        std::copy(bits_.Data + bits_.DataOffset,
+                  bits_.Data + bits_.DataOffset + bits_.DataLength,
+                  ring->data());
+        if (!ring_)
+            delete[] bits_.Data;
+        ring_.swap(ring);
+
+        // window starting anywhere in the first copy has MaxLength bytes mapped
+        bits_.Data       = ring_->data();
+        bits_.DataOffset = 0;
+        bits_.MaxLength  = ring_->size();
+        return true;
+    }
+
+    /// @brief Internal buffer while external data is attached, otherwise nullptr.
+    uint8_t* own_data_;
+    /// @brief Length of the internal buffer while external data is attached.
+    uint32_t own_max_length_;
+    /// @brief Ring buffer used as the internal buffer, otherwise nullptr.
+    std::unique_ptr<detail::mirrored_buffer> ring_;
 };
 
 /// @brief Defines the buffer that holds compressed video data. Used as the output from encoder.
@@ -218,6 +362,22 @@ public:
               session_(nullptr),
               valid_(false) {}
 
+    /// @brief Prepares the bitstream for reuse as the output of another operation. Valid data, sync point and
+    /// output fields are cleared, buffer is kept.
+    void recycle() {
+        reset();
+        bits_.TimeStamp       = MFX_TIMESTAMP_UNKNOWN;
+        bits_.DecodeTimeStamp = MFX_TIMESTAMP_UNKNOWN;
+        bits_.PicStruct       = 0;
+        bits_.FrameType       = 0;
+        bits_.DataFlag        = 0;
+        bits_.NumExtParam     = 0;
+        bits_.ExtParam        = nullptr;
+        sp_                   = nullptr;
+        session_              = nullptr;
+        valid_                = false;
+    }
+
     /// @brief Indefinitely waits for operation completion.
     void wait() {
         if (sp_) {
@@ -230,6 +390,17 @@ public:
         }
     }
 
+    /// @brief Waits for the operation which writes into the buffer, if its result was not waited for yet.
+    /// Errors are ignored, the data stays invalid then. Called before the buffer is reused or freed.
+    void sync_pending() noexcept {
+        if (sp_ && !valid_) {
+            if (MFXVideoCORE_SyncOperation(session_, sp_, MFX_INFINITE) == MFX_ERR_NONE)
+                valid_ = true;
+            else
+                sp_ = nullptr;
+        }
+    }
+
     /// @brief Temporal method to assotiate externally allocated surface with sync point generated
     /// by the processing function.
     /// @param[in] context Pair of session handle and sync point.
@@ -0,0 +1,221 @@
+/*############################################################################
+  # Copyright Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "vpl/preview/bitstream.hpp"
+
+#include "vpl/preview/detail/object_pool.hpp"
+
+namespace oneapi {
+namespace vpl {
+
+/// @brief Bitstream pool counters.
+struct bitstream_pool_stats {
+    /// @brief Number of bitstreams allocated because no idle bitstream was available.
+    uint64_t allocations;
+    /// @brief Number of bitstreams taken from the pool.
+    uint64_t reuses;
+    /// @brief Number of times a buffer was enlarged, by the pool or by the encoder.
+    uint64_t reallocations;
+    /// @brief Number of bitstreams freed because the pool was full.
+    uint64_t discards;
+    /// @brief Number of idle bitstreams in the pool.
+    uint64_t idle;
+    /// @brief Number of bitstreams in use.
+    uint64_t in_use;
+    /// @brief Largest amount of data observed in a returned bitstream, in bytes.
+    uint32_t peak_data_length;
+};
+
+/// @brief Keeps output bitstreams for reuse by the following operations.
+/// @details Bitstream taken with acquire() is returned to the pool when the last shared pointer to it is
+/// destroyed, from any thread, after the operation writing into it completes. New bitstreams get buffers twice
+/// as large as the largest amount of data observed so far, and reused bitstreams are enlarged the same way once
+/// that data no longer fits, so the encoder rarely has to ask for a larger buffer. Create the pool with
+/// std::make_shared(), otherwise bitstreams are freed instead of returned to the pool.
+class bitstream_pool : public std::enable_shared_from_this<bitstream_pool> {
+public:
+    /// @brief Ctor.
+    /// @param[in] max_idle Maximum number of idle bitstreams kept in the pool
+    /// @param[in] initial_length Buffer length of bitstreams allocated before any data was observed
+    explicit bitstream_pool(uint32_t max_idle       = 16,
+                            uint32_t initial_length = bitstream::buffer_len::DEFAULT_LENGHT)
+            : max_idle_(max_idle),
+              initial_length_(initial_length),
+              idle_(),
+              in_use_(),
+              stats_(),
+              mutex_() {}
+
+    /// @brief Dtor. Frees idle bitstreams. Bitstreams in use are freed when released.
+    ~bitstream_pool() {
+        for (auto b : idle_)
+            delete b;
+    }
+
+    bitstream_pool(const bitstream_pool &) = delete;
+    bitstream_pool &operator=(const bitstream_pool &) = delete;
+
+    /// @brief Waits for the operations writing into the bitstreams in use. Owner of the pool calls it before
+    /// the session which schedules these operations is closed, so the bitstreams can be freed afterwards.
+    void sync_in_use() {
+        std::lock_guard<std::mutex> guard(mutex_);
+        for (auto b : in_use_)
+            b->sync_pending();
+    }
+
+    /// @brief Returns pool counters.
+    /// @return Pool counters
+    bitstream_pool_stats stats() const {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return stats_;
+    }
+
+    /// @brief Takes idle bitstream from the pool or allocates a new one.
+    /// @param[in] codecID codec's fourCC code
+    /// @return Empty bitstream, which is returned to the pool when the last reference is dropped.
+    std::shared_ptr<bitstream_as_dst> acquire(codec_format_fourcc codecID = codec_format_fourcc(0)) {
+        bitstream_as_dst *b = nullptr;
+        uint32_t length     = 0;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            // room to track the bitstream, so that the push_back calls below don't throw
+            in_use_.reserve(stats_.in_use + 1);
+            length = target_length();
+            if (!idle_.empty()) {
+                b = idle_.back();
+                idle_.pop_back();
+                stats_.idle--;
+                stats_.reuses++;
+
+                // grow only if the largest observed data does not fit, so small changes in frame
+                // size do not cause reallocation on every acquire
+                if (b->get_max_buffer_length() >= stats_.peak_data_length)
+                    length = b->get_max_buffer_length();
+            }
+            else {
+                stats_.allocations++;
+            }
+            stats_.in_use++;
+        }
+
+        if (!b) {
+            try {
+                b = new bitstream_as_dst(codecID, length);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> guard(mutex_);
+                stats_.in_use--;
+                throw;
+            }
+            std::lock_guard<std::mutex> guard(mutex_);
+            in_use_.push_back(b);
+        }
+        else {
+            // bitstream goes back to the pool if it can't be enlarged
+            auto put_back = [this](bitstream_as_dst *p) {
+                release(p, p->get_max_buffer_length());
+            };
+            {
+                std::lock_guard<std::mutex> guard(mutex_);
+                in_use_.push_back(b);
+            }
+            std::unique_ptr<bitstream_as_dst, decltype(put_back)> owned(b, put_back);
+            if (b->get_max_buffer_length() < length) {
+                b->realloc(length - b->get_max_buffer_length());
+                std::lock_guard<std::mutex> guard(mutex_);
+                stats_.reallocations++;
+            }
+            b->set_CodecId(codecID);
+            owned.release();
+        }
+
+        uint32_t acquired_length             = b->get_max_buffer_length();
+        std::weak_ptr<bitstream_pool> owner = weak_from_this();
+        // control block comes from the block pool too, so steady state acquire doesn't touch the heap
+        return std::shared_ptr<bitstream_as_dst>(
+            b,
+            [owner, acquired_length](bitstream_as_dst *p) {
+                if (auto pool = owner.lock()) {
+                    pool->release(p, acquired_length);
+                }
+                else {
+                    // the owner waited for the operations in flight before the pool was destroyed
+                    p->sync_pending();
+                    delete p;
+                }
+            },
+            detail::pool_allocator<bitstream_as_dst>());
+    }
+
+protected:
+    /// @brief Buffer length for the next bitstream.
+    /// @return Buffer length in bytes.
+    uint32_t target_length() const {
+        uint64_t length = 2ull * stats_.peak_data_length;
+        if (length < initial_length_)
+            length = initial_length_;
+        if (length > UINT32_MAX)
+            length = UINT32_MAX;
+        return static_cast<uint32_t>(length);
+    }
+
+    /// @brief Returns bitstream to the pool.
+    /// @param[in] b Bitstream
+    /// @param[in] acquired_length Buffer length when the bitstream was acquired
+    void release(bitstream_as_dst *b, uint32_t acquired_length) {
+        // the runtime may still write into the buffer
+        b->sync_pending();
+        uint32_t data_end = b->get_DataOffset() + b->get_DataLength();
+
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            for (auto &p : in_use_) {
+                if (p == b) {
+                    p = in_use_.back();
+                    in_use_.pop_back();
+                    break;
+                }
+            }
+            stats_.in_use--;
+            if (b->get_max_buffer_length() != acquired_length)
+                stats_.reallocations++;
+            if (data_end > stats_.peak_data_length)
+                stats_.peak_data_length = data_end;
+
+            if (idle_.size() < max_idle_) {
+                b->recycle();
+                idle_.push_back(b);
+                stats_.idle++;
+                return;
+            }
+            stats_.discards++;
+        }
+        delete b;
+    }
+
+    /// @brief Maximum number of idle bitstreams
+    uint32_t max_idle_;
+    /// @brief Buffer length before any data was observed
+    uint32_t initial_length_;
+    /// @brief Idle bitstreams
+    std::vector<bitstream_as_dst *> idle_;
+    /// @brief Bitstreams handed out
+    std::vector<bitstream_as_dst *> in_use_;
+    /// @brief Counters
+    bitstream_pool_stats stats_;
+    /// @brief Serializes access to the pool
+    mutable std::mutex mutex_;
+};
+
+} // namespace vpl
+} // namespace oneapi
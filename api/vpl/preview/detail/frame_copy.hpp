@@ -0,0 +1,340 @@
+/*############################################################################
+  # Copyright Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+  #define ONEVPL_PREVIEW_X86
+  #include <immintrin.h>
+  #if defined(_MSC_VER)
+    #include <intrin.h>
+  #endif
+#endif
+
+// functions using SSE2 or AVX2 are compiled for it regardless of the compiler flags
+// and called only if the CPU supports it (SSE2 is optional on 32-bit x86)
+#if defined(ONEVPL_PREVIEW_X86) && (defined(__GNUC__) || defined(__clang__))
+  #define ONEVPL_PREVIEW_TARGET_SSE2 __attribute__((target("sse2")))
+  #define ONEVPL_PREVIEW_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+  #define ONEVPL_PREVIEW_TARGET_SSE2
+  #define ONEVPL_PREVIEW_TARGET_AVX2
+#endif
+
+namespace oneapi {
+namespace vpl {
+namespace detail {
+
+/// @brief Kernels which copy planes of raw frames from tightly packed staging buffer into surface with pitch,
+/// converting planar chroma to interleaved chroma where needed. Best kernel for the CPU is selected at run time.
+namespace frame_copy {
+
+/// @brief Checks whether the CPU supports SSE2.
+/// @return True if SSE2 kernels can be used.
+inline bool has_sse2() {
+#if defined(__x86_64__) || defined(_M_X64)
+    return true;
+#elif defined(ONEVPL_PREVIEW_X86)
+    #if defined(_MSC_VER)
+    static const bool sse2 = []() {
+        int info[4] = {};
+        __cpuid(info, 1);
+        return (info[3] & (1 << 26)) != 0;
+    }();
+    return sse2;
+    #else
+    static const bool sse2 = __builtin_cpu_supports("sse2");
+    return sse2;
+    #endif
+#else
+    return false;
+#endif
+}
+
+/// @brief Checks whether the CPU and OS support AVX2.
+/// @return True if AVX2 kernels can be used.
+inline bool has_avx2() {
+#if defined(ONEVPL_PREVIEW_X86)
+    #if defined(_MSC_VER)
+    static const bool avx2 = []() {
+        int info[4] = {};
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+        __cpuid(info, 1);
+        // OS saves YMM registers
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx     = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+            return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }();
+    return avx2;
+    #else
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+    #endif
+#else
+    return false;
+#endif
+}
+
+/// @brief Copies rows of a plane.
+/// @param[in] src Source plane
+/// @param[in] src_pitch Source pitch in bytes
+/// @param[out] dst Destination plane
+/// @param[in] dst_pitch Destination pitch in bytes
+/// @param[in] row_bytes Number of bytes to copy in each row
+/// @param[in] rows Number of rows
+inline void copy_plane(const uint8_t* src,
+                       uint32_t src_pitch,
+                       uint8_t* dst,
+                       uint32_t dst_pitch,
+                       uint32_t row_bytes,
+                       uint32_t rows) {
+    if (src_pitch == row_bytes && dst_pitch == row_bytes) {
+        std::memcpy(dst, src, static_cast<size_t>(row_bytes) * rows);
+        return;
+    }
+    for (uint32_t y = 0; y < rows; y++)
+        std::memcpy(dst + static_cast<size_t>(y) * dst_pitch, src + static_cast<size_t>(y) * src_pitch, row_bytes);
+}
+
+/// @brief Interleaves one row of 8-bit U and V samples: UVUV...
+/// @param[in] u U samples
+/// @param[in] v V samples
+/// @param[out] uv Interleaved samples
+/// @param[in] n Number of samples in each of @p u and @p v
+inline void interleave_row_8_c(const uint8_t* u, const uint8_t* v, uint8_t* uv, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        uv[2 * i]     = u[i];
+        uv[2 * i + 1] = v[i];
+    }
+}
+
+/// @brief Interleaves one row of 16-bit U and V samples and shifts them left.
+/// @param[in] u U samples
+/// @param[in] v V samples
+/// @param[out] uv Interleaved samples
+/// @param[in] n Number of samples in each of @p u and @p v
+/// @param[in] shift Number of bits to shift
+inline void interleave_row_16_c(const uint16_t* u, const uint16_t* v, uint16_t* uv, uint32_t n, int shift) {
+    for (uint32_t i = 0; i < n; i++) {
+        uv[2 * i]     = static_cast<uint16_t>(u[i] << shift);
+        uv[2 * i + 1] = static_cast<uint16_t>(v[i] << shift);
+    }
+}
+
+/// @brief Shifts one row of 16-bit samples left.
+/// @param[in] src Source samples
+/// @param[out] dst Destination samples
+/// @param[in] n Number of samples
+/// @param[in] shift Number of bits to shift
+inline void shift_row_16_c(const uint16_t* src, uint16_t* dst, uint32_t n, int shift) {
+    for (uint32_t i = 0; i < n; i++)
+        dst[i] = static_cast<uint16_t>(src[i] << shift);
+}
+
+#if defined(ONEVPL_PREVIEW_X86)
+/// @brief SSE2 version of interleave_row_8_c().
+ONEVPL_PREVIEW_TARGET_SSE2 inline void interleave_row_8_sse2(const uint8_t* u,
+                                                             const uint8_t* v,
+                                                             uint8_t* uv,
+                                                             uint32_t n) {
+    uint32_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(u + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(v + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(uv + 2 * i), _mm_unpacklo_epi8(a, b));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(uv + 2 * i + 16), _mm_unpackhi_epi8(a, b));
+    }
+    interleave_row_8_c(u + i, v + i, uv + 2 * i, n - i);
+}
+
+/// @brief SSE2 version of interleave_row_16_c().
+ONEVPL_PREVIEW_TARGET_SSE2 inline void interleave_row_16_sse2(const uint16_t* u,
+                                                              const uint16_t* v,
+                                                              uint16_t* uv,
+                                                              uint32_t n,
+                                                              int shift) {
+    __m128i s  = _mm_cvtsi32_si128(shift);
+    uint32_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i a = _mm_sll_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(u + i)), s);
+        __m128i b = _mm_sll_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(v + i)), s);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(uv + 2 * i), _mm_unpacklo_epi16(a, b));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(uv + 2 * i + 8), _mm_unpackhi_epi16(a, b));
+    }
+    interleave_row_16_c(u + i, v + i, uv + 2 * i, n - i, shift);
+}
+
+/// @brief SSE2 version of shift_row_16_c().
+ONEVPL_PREVIEW_TARGET_SSE2 inline void shift_row_16_sse2(const uint16_t* src,
+                                                         uint16_t* dst,
+                                                         uint32_t n,
+                                                         int shift) {
+    __m128i s  = _mm_cvtsi32_si128(shift);
+    uint32_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_sll_epi16(a, s));
+    }
+    shift_row_16_c(src + i, dst + i, n - i, shift);
+}
+
+/// @brief AVX2 version of interleave_row_8_c().
+ONEVPL_PREVIEW_TARGET_AVX2 inline void interleave_row_8_avx2(const uint8_t* u,
+                                                             const uint8_t* v,
+                                                             uint8_t* uv,
+                                                             uint32_t n) {
+    uint32_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i a  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(u + i));
+        __m256i b  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + i));
+        // unpack works within 128-bit lanes, so put the lanes back in order
+        __m256i lo = _mm256_unpacklo_epi8(a, b);
+        __m256i hi = _mm256_unpackhi_epi8(a, b);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(uv + 2 * i), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(uv + 2 * i + 32),
+                            _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    interleave_row_8_sse2(u + i, v + i, uv + 2 * i, n - i);
+}
+
+/// @brief AVX2 version of interleave_row_16_c().
+ONEVPL_PREVIEW_TARGET_AVX2 inline void interleave_row_16_avx2(const uint16_t* u,
+                                                              const uint16_t* v,
+                                                              uint16_t* uv,
+                                                              uint32_t n,
+                                                              int shift) {
+    __m128i s  = _mm_cvtsi32_si128(shift);
+    uint32_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i a  = _mm256_sll_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(u + i)), s);
+        __m256i b  = _mm256_sll_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + i)), s);
+        __m256i lo = _mm256_unpacklo_epi16(a, b);
+        __m256i hi = _mm256_unpackhi_epi16(a, b);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(uv + 2 * i), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(uv + 2 * i + 16),
+                            _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    interleave_row_16_sse2(u + i, v + i, uv + 2 * i, n - i, shift);
+}
+
+/// @brief AVX2 version of shift_row_16_c().
+ONEVPL_PREVIEW_TARGET_AVX2 inline void shift_row_16_avx2(const uint16_t* src,
+                                                         uint16_t* dst,
+                                                         uint32_t n,
+                                                         int shift) {
+    __m128i s  = _mm_cvtsi32_si128(shift);
+    uint32_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_sll_epi16(a, s));
+    }
+    shift_row_16_sse2(src + i, dst + i, n - i, shift);
+}
+#endif // ONEVPL_PREVIEW_X86
+
+/// @brief Interleaves planar 8-bit U and V planes into UV plane (I420 to NV12 chroma).
+/// @param[in] u U plane
+/// @param[in] v V plane
+/// @param[in] src_pitch Pitch of @p u and @p v in bytes
+/// @param[out] uv UV plane
+/// @param[in] dst_pitch Pitch of @p uv in bytes
+/// @param[in] width Number of samples in each row of @p u
+/// @param[in] rows Number of rows
+inline void interleave_uv_8(const uint8_t* u,
+                            const uint8_t* v,
+                            uint32_t src_pitch,
+                            uint8_t* uv,
+                            uint32_t dst_pitch,
+                            uint32_t width,
+                            uint32_t rows) {
+    auto row = &interleave_row_8_c;
+#if defined(ONEVPL_PREVIEW_X86)
+    if (has_avx2())
+        row = &interleave_row_8_avx2;
+    else if (has_sse2())
+        row = &interleave_row_8_sse2;
+#endif
+    for (uint32_t y = 0; y < rows; y++)
+        row(u + static_cast<size_t>(y) * src_pitch,
+            v + static_cast<size_t>(y) * src_pitch,
+            uv + static_cast<size_t>(y) * dst_pitch,
+            width);
+}
+
+/// @brief Interleaves planar 16-bit U and V planes into UV plane and shifts samples left
+/// (I010 to P010 chroma).
+/// @param[in] u U plane
+/// @param[in] v V plane
+/// @param[in] src_pitch Pitch of @p u and @p v in bytes
+/// @param[out] uv UV plane
+/// @param[in] dst_pitch Pitch of @p uv in bytes
+/// @param[in] width Number of samples in each row of @p u
+/// @param[in] rows Number of rows
+/// @param[in] shift Number of bits to shift
+inline void interleave_uv_16(const uint8_t* u,
+                             const uint8_t* v,
+                             uint32_t src_pitch,
+                             uint8_t* uv,
+                             uint32_t dst_pitch,
+                             uint32_t width,
+                             uint32_t rows,
+                             int shift) {
+    auto row = &interleave_row_16_c;
+#if defined(ONEVPL_PREVIEW_X86)
+    if (has_avx2())
+        row = &interleave_row_16_avx2;
+    else if (has_sse2())
+        row = &interleave_row_16_sse2;
+#endif
+    for (uint32_t y = 0; y < rows; y++)
+        row(reinterpret_cast<const uint16_t*>(u + static_cast<size_t>(y) * src_pitch),
+            reinterpret_cast<const uint16_t*>(v + static_cast<size_t>(y) * src_pitch),
+            reinterpret_cast<uint16_t*>(uv + static_cast<size_t>(y) * dst_pitch),
+            width,
+            shift);
+}
+
+/// @brief Copies 16-bit plane and shifts samples left (LSB aligned to MSB aligned samples).
+/// @param[in] src Source plane
+/// @param[in] src_pitch Source pitch in bytes
+/// @param[out] dst Destination plane
+/// @param[in] dst_pitch Destination pitch in bytes
+/// @param[in] width Number of samples in each row
+/// @param[in] rows Number of rows
+/// @param[in] shift Number of bits to shift
+inline void shift_plane_16(const uint8_t* src,
+                           uint32_t src_pitch,
+                           uint8_t* dst,
+                           uint32_t dst_pitch,
+                           uint32_t width,
+                           uint32_t rows,
+                           int shift) {
+    auto row = &shift_row_16_c;
+#if defined(ONEVPL_PREVIEW_X86)
+    if (has_avx2())
+        row = &shift_row_16_avx2;
+    else if (has_sse2())
+        row = &shift_row_16_sse2;
+#endif
+    for (uint32_t y = 0; y < rows; y++)
+        row(reinterpret_cast<const uint16_t*>(src + static_cast<size_t>(y) * src_pitch),
+            reinterpret_cast<uint16_t*>(dst + static_cast<size_t>(y) * dst_pitch),
+            width,
+            shift);
+}
+
+} // namespace frame_copy
+} // namespace detail
+} // namespace vpl
+} // namespace oneapi
@@ -0,0 +1,200 @@
+/*############################################################################
+  # Copyright Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#pragma once
+
+#include <cstdint>
+
+#if !defined(_WIN32) && !defined(_WIN64)
+  #include <stdlib.h>
+  #include <sys/mman.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+#endif
+
+#include "vpl/preview/detail/windows.hpp"
+
+namespace oneapi {
+namespace vpl {
+namespace detail {
+
+/// @brief Ring buffer memory which is mapped twice, back to back, into the address space.
+/// @details Byte at data()[i + size()] is the same as byte at data()[i], so any range of up to size() bytes
+/// which starts in the first copy is contiguous in memory. Ring buffer users can advance the start of valid
+/// data past the end of the buffer and wrap it around by subtracting size(), without ever moving the data.
+class mirrored_buffer {
+public:
+    /// @brief Ctor. Allocates the buffer.
+    /// @param[in] min_size Minimum buffer size in bytes. Size is rounded up to allocation granularity.
+    /// Check valid() for allocation failure.
+    explicit mirrored_buffer(uint32_t min_size) : data_(nullptr), size_(0) {
+        uint64_t granularity = get_granularity();
+        uint64_t size        = ((static_cast<uint64_t>(min_size) + granularity - 1) / granularity) * granularity;
+        if (!size)
+            size = granularity;
+        // both copies must be addressable with 32-bit offsets
+        if (2 * size > UINT32_MAX)
+            return;
+        map(static_cast<uint32_t>(size));
+    }
+
+    /// @brief Dtor. Frees the buffer.
+    ~mirrored_buffer() {
+        unmap();
+    }
+
+    mirrored_buffer(const mirrored_buffer &) = delete;
+    mirrored_buffer &operator=(const mirrored_buffer &) = delete;
+
+    /// @brief Checks whether the buffer was allocated.
+    /// @return True if allocated.
+    bool valid() const {
+        return data_ != nullptr;
+    }
+
+    /// @brief Returns start of the first copy of the buffer.
+    /// @return Pointer to the buffer. 2 * size() bytes are addressable.
+    uint8_t *data() const {
+        return data_;
+    }
+
+    /// @brief Returns buffer size.
+    /// @return Size of one copy of the buffer in bytes.
+    uint32_t size() const {
+        return size_;
+    }
+
+    /// @brief Returns granularity of the buffer size.
+    /// @return Granularity in bytes.
+    static uint32_t get_granularity() {
+#if defined(_WIN32) || defined(_WIN64)
+        SYSTEM_INFO info = {};
+        GetSystemInfo(&info);
+        return info.dwAllocationGranularity;
+#else
+        return static_cast<uint32_t>(sysconf(_SC_PAGESIZE));
+#endif
+    }
+
+protected:
+#if defined(_WIN32) || defined(_WIN64)
+    /// @brief Maps both copies of the buffer.
+    /// @param[in] size Buffer size in bytes.
+    void map(uint32_t size) {
+        mapping_ = CreateFileMapping(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, size, nullptr);
+        if (!mapping_)
+            return;
+
+        // reserve address range for both copies, then map the views into it.
+        // other thread can take the range after it is released, so retry a few times.
+        for (int attempt = 0; attempt < 8 && !data_; attempt++) {
+            uint8_t *base = static_cast<uint8_t *>(VirtualAlloc(nullptr, 2 * size, MEM_RESERVE, PAGE_NOACCESS));
+            if (!base)
+                break;
+            VirtualFree(base, 0, MEM_RELEASE);
+
+            void *first  = MapViewOfFileEx(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, size, base);
+            void *second = first ? MapViewOfFileEx(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, size, base + size)
+                                 : nullptr;
+            if (first && second) {
+                data_ = base;
+                size_ = size;
+                break;
+            }
+            if (first)
+                UnmapViewOfFile(first);
+        }
+
+        if (!data_) {
+            CloseHandle(mapping_);
+            mapping_ = nullptr;
+        }
+    }
+
+    /// @brief Unmaps both copies of the buffer.
+    void unmap() {
+        if (data_) {
+            UnmapViewOfFile(data_);
+            UnmapViewOfFile(data_ + size_);
+        }
+        if (mapping_)
+            CloseHandle(mapping_);
+        data_    = nullptr;
+        size_    = 0;
+        mapping_ = nullptr;
+    }
+
+    /// @brief File mapping object backing both copies
+    HANDLE mapping_ = nullptr;
+#else
+    /// @brief Creates anonymous file backing both copies.
+    /// @return File descriptor or -1.
+    static int create_backing_file() {
+        int fd = -1;
+    #if defined(SYS_memfd_create)
+        fd = static_cast<int>(syscall(SYS_memfd_create, "vpl-mirrored-buffer", 1U /* MFD_CLOEXEC */));
+    #endif
+        if (fd < 0) {
+            // kernel without memfd - use unlinked file in shared memory
+            char name[] = "/dev/shm/vpl-mirrored-buffer-XXXXXX";
+            fd          = mkstemp(name);
+            if (fd >= 0)
+                unlink(name);
+        }
+        return fd;
+    }
+
+    /// @brief Maps both copies of the buffer.
+    /// @param[in] size Buffer size in bytes.
+    void map(uint32_t size) {
+        int fd = create_backing_file();
+        if (fd < 0)
+            return;
+
+        if (ftruncate(fd, size) != 0) {
+            close(fd);
+            return;
+        }
+
+        // reserve address range for both copies, then map the file over each half
+        void *reserved = mmap(nullptr, 2 * static_cast<size_t>(size), PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (reserved == MAP_FAILED) {
+            close(fd);
+            return;
+        }
+
+        uint8_t *base = static_cast<uint8_t *>(reserved);
+        void *first   = mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+        void *second  = mmap(base + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+        close(fd);
+
+        if (first == MAP_FAILED || second == MAP_FAILED) {
+            munmap(base, 2 * static_cast<size_t>(size));
+            return;
+        }
+
+        data_ = base;
+        size_ = size;
+    }
+
+    /// @brief Unmaps both copies of the buffer.
+    void unmap() {
+        if (data_)
+            munmap(data_, 2 * static_cast<size_t>(size_));
+        data_ = nullptr;
+        size_ = 0;
+    }
+#endif
+
+    /// @brief Start of the first copy
+    uint8_t *data_;
+    /// @brief Size of one copy
+    uint32_t size_;
+};
+
+} // namespace detail
+} // namespace vpl
+} // namespace oneapi
@@ -0,0 +1,128 @@
+/*############################################################################
+  # Copyright Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+
+namespace oneapi {
+namespace vpl {
+namespace detail {
+
+/// @brief Free list of memory blocks of one size. Blocks are never returned to the heap, so once the number of
+/// objects alive reaches its steady state, allocations don't touch the heap.
+/// @tparam Size Block size in bytes
+template <std::size_t Size>
+class block_pool {
+public:
+    /// @brief Returns the pool for this block size. The pool is never destroyed, so objects can be freed
+    /// during static destruction.
+    /// @return Pool instance
+    static block_pool &instance() {
+        static block_pool *pool = new block_pool();
+        return *pool;
+    }
+
+    /// @brief Takes block from the free list or allocates a new one.
+    /// @return Pointer to the block
+    void *allocate() {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            if (free_) {
+                node *n = free_;
+                free_   = n->next_;
+                return n;
+            }
+        }
+        return ::operator new(block_size);
+    }
+
+    /// @brief Puts block to the free list.
+    /// @param[in] p Pointer to the block
+    void deallocate(void *p) noexcept {
+        node *n = static_cast<node *>(p);
+        std::lock_guard<std::mutex> guard(mutex_);
+        n->next_ = free_;
+        free_    = n;
+    }
+
+protected:
+    block_pool() : free_(nullptr), mutex_() {}
+
+    /// @brief Free block
+    struct node {
+        node *next_;
+    };
+
+    /// @brief Actual block size: free blocks hold the list link
+    static constexpr std::size_t block_size = (Size < sizeof(node)) ? sizeof(node) : Size;
+
+    /// @brief Head of the free list
+    node *free_;
+    /// @brief Serializes access to the free list
+    std::mutex mutex_;
+};
+
+/// @brief Allocator which takes single objects from block_pool. Used with std::allocate_shared, so the object
+/// and the shared pointer control block are recycled together.
+/// @tparam T Type of the object
+template <typename T>
+class pool_allocator {
+public:
+    using value_type = T;
+
+    pool_allocator() noexcept = default;
+
+    template <typename U>
+    pool_allocator(const pool_allocator<U> &) noexcept {}
+
+    /// @brief Allocates memory for n objects.
+    /// @param[in] n Number of objects
+    /// @return Pointer to the memory
+    T *allocate(std::size_t n) {
+        static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "over-aligned types are not supported");
+        if (n == 1)
+            return static_cast<T *>(block_pool<sizeof(T)>::instance().allocate());
+        return static_cast<T *>(::operator new(n * sizeof(T)));
+    }
+
+    /// @brief Frees memory of n objects.
+    /// @param[in] p Pointer to the memory
+    /// @param[in] n Number of objects
+    void deallocate(T *p, std::size_t n) noexcept {
+        if (n == 1)
+            block_pool<sizeof(T)>::instance().deallocate(p);
+        else
+            ::operator delete(p);
+    }
+
+    template <typename U>
+    bool operator==(const pool_allocator<U> &) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const pool_allocator<U> &) const noexcept {
+        return false;
+    }
+};
+
+/// @brief Creates object owned by a shared pointer, with the memory taken from block_pool.
+/// @tparam T Type of the object
+/// @param[in] args Ctor arguments
+/// @return Shared pointer to the object
+template <typename T, typename... Args>
+std::shared_ptr<T> make_pooled(Args &&... args) {
+    return std::allocate_shared<T>(pool_allocator<T>(), std::forward<Args>(args)...);
+}
+
+} // namespace detail
+} // namespace vpl
+} // namespace oneapi
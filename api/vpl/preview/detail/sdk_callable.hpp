@@ -49,6 +49,19 @@ struct CAPI {
                                     MFXVideoVPP_Reset,
                                     MFXVideoVPP_GetVideoParam,
                                     MFXVideoVPP_Close };
+
+    /// @brief Decode+VPP. Init and Reset here touch the decoder only, channels are passed by the session.
+    static inline sdk_c_api DecoderVPP = {
+        MFXVideoDECODE_Query,
+        [](mfxSession s, mfxVideoParam* par) {
+            return MFXVideoDECODE_VPP_Init(s, par, nullptr, 0);
+        },
+        [](mfxSession s, mfxVideoParam* par) {
+            return MFXVideoDECODE_VPP_Reset(s, par, nullptr, 0);
+        },
+        MFXVideoDECODE_VPP_GetVideoParam,
+        MFXVideoDECODE_VPP_Close
+    };
 };
 
 /// @brief Safely calls C functions and throw exception in case of negative error code. User can provide own
@@ -0,0 +1,248 @@
+/*############################################################################
+  # Copyright Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "vpl/mfxdispatcher.h"
+#include "vpl/preview/detail/sdk_callable.hpp"
+#include "vpl/preview/detail/variant.hpp"
+#include "vpl/preview/exception.hpp"
+#include "vpl/preview/impl_caps.hpp"
+
+namespace oneapi {
+namespace vpl {
+namespace detail {
+
+/// @brief Loader which is shared between all sessions created with the same set of properties.
+/// @details Libraries are searched and implementations are enumerated only once per loader.
+/// Loader is unloaded when the last session (or selector) referencing it is destroyed.
+class shared_loader {
+public:
+    /// @brief Ctor. Creates loader and applies properties as dispatcher filters.
+    /// @param[in] props List of properties
+    /// @param[in] format Implementation capabilities report format
+    shared_loader(const std::vector<std::pair<std::string, variant>> &props,
+                  mfxImplCapsDeliveryFormat format)
+            : loader_(MFXLoad()),
+              format_(format),
+              handles_(),
+              caps_(),
+              enumerated_(false),
+              mutex_() {
+        if (!loader_)
+            throw base_exception(MFX_ERR_NOT_FOUND);
+
+        try {
+            for (auto &opt : props) {
+                auto cfg = MFXCreateConfig(loader_);
+                [[maybe_unused]] c_api_invoker e(default_checker,
+                                                 MFXSetConfigFilterProperty,
+                                                 cfg,
+                                                 (const uint8_t *)opt.first.c_str(),
+                                                 opt.second.get_variant());
+            }
+        }
+        catch (...) {
+            MFXUnload(loader_);
+            throw;
+        }
+    }
+
+    /// @brief Dtor. Releases enumerated capabilities and unloads the loader.
+    ~shared_loader() {
+        caps_.clear();
+        for (auto h : handles_)
+            MFXDispReleaseImplDescription(loader_, h);
+        MFXUnload(loader_);
+    }
+
+    shared_loader(const shared_loader &) = delete;
+    shared_loader &operator=(const shared_loader &) = delete;
+
+    /// @brief Returns capabilities of all implementations which match the properties. Enumeration
+    /// is done on the first call only. Caller must hold the lock returned by lock().
+    /// @return List of capabilities, index in the list is the implementation index.
+    const std::vector<std::shared_ptr<base_implementation_capabilities>> &capabilities() {
+        if (enumerated_)
+            return caps_;
+
+        implementation_capabilities_factory factory;
+        uint32_t idx = 0;
+        while (true) {
+            void *h       = nullptr;
+            mfxStatus sts = MFXEnumImplementations(loader_, idx, format_, &h);
+
+            // break if no idx
+            if (sts == MFX_ERR_NOT_FOUND)
+                break;
+            if (sts < 0)
+                throw base_exception(sts);
+
+            handles_.push_back(h);
+            caps_.push_back(factory.create(format_, h));
+            idx++;
+        }
+        enumerated_ = true;
+
+        return caps_;
+    }
+
+    /// @brief Creates session on the implementation with index @p idx. Caller must hold the lock
+    /// returned by lock().
+    /// @param[in] idx Implementation index
+    /// @return Session handle
+    mfxSession create_session(uint32_t idx) {
+        mfxSession s = nullptr;
+        [[maybe_unused]] c_api_invoker e(default_checker, MFXCreateSession, loader_, idx, &s);
+        return s;
+    }
+
+    /// @brief Locks the loader. Dispatcher loader must not be accessed from several threads at once.
+    /// @return Lock object
+    std::unique_lock<std::mutex> lock() {
+        return std::unique_lock<std::mutex>(mutex_);
+    }
+
+    /// @brief Returns existing loader for this set of properties or creates a new one.
+    /// @param[in] props List of properties
+    /// @param[in] format Implementation capabilities report format
+    /// @return Shared loader
+    static std::shared_ptr<shared_loader> get(
+        const std::vector<std::pair<std::string, variant>> &props,
+        mfxImplCapsDeliveryFormat format) {
+        std::string key;
+        if (!make_key(props, format, key)) {
+            // properties can't be compared by value, so don't share this loader
+            return std::make_shared<shared_loader>(props, format);
+        }
+
+        static std::mutex registry_mutex;
+        static std::map<std::string, std::weak_ptr<shared_loader>> registry;
+
+        std::lock_guard<std::mutex> guard(registry_mutex);
+
+        if (auto it = registry.find(key); it != registry.end()) {
+            if (auto loader = it->second.lock())
+                return loader;
+        }
+
+        // drop entries for loaders which are already destroyed
+        for (auto it = registry.begin(); it != registry.end();) {
+            if (it->second.expired())
+                it = registry.erase(it);
+            else
+                ++it;
+        }
+
+        auto loader   = std::make_shared<shared_loader>(props, format);
+        registry[key] = loader;
+        return loader;
+    }
+
+protected:
+    /// @brief Builds registry key from the property values.
+    /// @return False if some property is passed by pointer to unknown data type.
+    static bool make_key(const std::vector<std::pair<std::string, variant>> &props,
+                         mfxImplCapsDeliveryFormat format,
+                         std::string &key) {
+        std::ostringstream out;
+        out << format;
+        for (auto &opt : props) {
+            mfxVariant v = opt.second.get_variant();
+            out << '\n' << opt.first << '=' << v.Type << ':';
+
+            // only the member of the type is set, the other bytes of Data are garbage
+            switch (v.Type) {
+                case MFX_VARIANT_TYPE_UNSET:
+                    continue;
+                case MFX_VARIANT_TYPE_U8:
+                    out << static_cast<uint32_t>(v.Data.U8);
+                    continue;
+                case MFX_VARIANT_TYPE_I8:
+                    out << static_cast<int32_t>(v.Data.I8);
+                    continue;
+                case MFX_VARIANT_TYPE_U16:
+                    out << v.Data.U16;
+                    continue;
+                case MFX_VARIANT_TYPE_I16:
+                    out << v.Data.I16;
+                    continue;
+                case MFX_VARIANT_TYPE_U32:
+                    out << v.Data.U32;
+                    continue;
+                case MFX_VARIANT_TYPE_I32:
+                    out << v.Data.I32;
+                    continue;
+                case MFX_VARIANT_TYPE_U64:
+                    out << v.Data.U64;
+                    continue;
+                case MFX_VARIANT_TYPE_I64:
+                    out << v.Data.I64;
+                    continue;
+                // hexfloat keeps all bits, so different values never share a key
+                case MFX_VARIANT_TYPE_F32:
+                    out << std::hexfloat << v.Data.F32 << std::defaultfloat;
+                    continue;
+                case MFX_VARIANT_TYPE_F64:
+                    out << std::hexfloat << v.Data.F64 << std::defaultfloat;
+                    continue;
+                case MFX_VARIANT_TYPE_PTR:
+                    break;
+                default:
+                    return false;
+            }
+
+            if (!v.Data.Ptr)
+                return false;
+
+            if (ends_with(opt.first, "Width") || ends_with(opt.first, "Height")) {
+                auto range = reinterpret_cast<const mfxRange32U *>(v.Data.Ptr);
+                out << range->Min << '-' << range->Max << '-' << range->Step;
+            }
+            else if (ends_with(opt.first, "ImplName") || ends_with(opt.first, "License") ||
+                     ends_with(opt.first, "Keywords") || ends_with(opt.first, "DeviceID") ||
+                     ends_with(opt.first, "FunctionsName")) {
+                out << reinterpret_cast<const char *>(v.Data.Ptr);
+            }
+            else {
+                return false;
+            }
+        }
+        key = out.str();
+        return true;
+    }
+
+    /// @brief Checks if string @p s ends with @p suffix
+    static bool ends_with(const std::string &s, const std::string &suffix) {
+        return s.size() >= suffix.size() &&
+               s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    /// @brief Loader handle
+    mfxLoader loader_;
+    /// @brief Implementation capabilities report format
+    mfxImplCapsDeliveryFormat format_;
+    /// @brief Raw capabilities handles, released at unload
+    std::vector<void *> handles_;
+    /// @brief Enumerated capabilities
+    std::vector<std::shared_ptr<base_implementation_capabilities>> caps_;
+    /// @brief True if implementations are already enumerated
+    bool enumerated_;
+    /// @brief Serializes access to the loader
+    std::mutex mutex_;
+};
+
+} // namespace detail
+} // namespace vpl
+} // namespace oneapi
@@ -0,0 +1,158 @@
+/*############################################################################
+  # Copyright Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+namespace oneapi {
+namespace vpl {
+namespace detail {
+
+/// @brief Vector of trivially copyable elements which keeps up to N elements inline and moves to the heap only
+/// when it grows past N. Copies with memcpy.
+/// @tparam T Type of the element
+/// @tparam N Number of inline elements
+template <typename T, std::size_t N>
+class small_vector {
+    static_assert(std::is_trivially_copyable<T>::value, "small_vector supports trivially copyable types only");
+
+public:
+    using value_type     = T;
+    using iterator       = T *;
+    using const_iterator = const T *;
+
+    /// @brief Default ctor. Creates empty vector.
+    small_vector() : inline_(), data_(inline_), size_(0), capacity_(N) {}
+
+    /// @brief Copy ctor.
+    /// @param[in] other another object to use as data source
+    small_vector(const small_vector &other) : small_vector() {
+        assign(other);
+    }
+
+    /// @brief Copy operator.
+    /// @param[in] other another object to use as data source
+    /// @returns Reference to this object
+    small_vector &operator=(const small_vector &other) {
+        if (this != &other)
+            assign(other);
+        return *this;
+    }
+
+    /// @brief Dtor.
+    ~small_vector() {
+        if (data_ != inline_)
+            delete[] data_;
+    }
+
+    std::size_t size() const {
+        return size_;
+    }
+    bool empty() const {
+        return size_ == 0;
+    }
+    T *data() {
+        return data_;
+    }
+    const T *data() const {
+        return data_;
+    }
+    iterator begin() {
+        return data_;
+    }
+    iterator end() {
+        return data_ + size_;
+    }
+    const_iterator begin() const {
+        return data_;
+    }
+    const_iterator end() const {
+        return data_ + size_;
+    }
+    T &operator[](std::size_t i) {
+        return data_[i];
+    }
+    const T &operator[](std::size_t i) const {
+        return data_[i];
+    }
+
+    /// @brief Removes all elements. Keeps the storage.
+    void clear() {
+        size_ = 0;
+    }
+
+    /// @brief Appends element.
+    /// @param[in] value Element
+    void push_back(const T &value) {
+        reserve(size_ + 1);
+        data_[size_++] = value;
+    }
+
+    /// @brief Inserts element before pos.
+    /// @param[in] pos Position
+    /// @param[in] value Element
+    /// @return Iterator to the inserted element
+    iterator insert(const_iterator pos, const T &value) {
+        std::size_t i = static_cast<std::size_t>(pos - data_);
+        reserve(size_ + 1);
+        std::memmove(data_ + i + 1, data_ + i, (size_ - i) * sizeof(T));
+        data_[i] = value;
+        size_++;
+        return data_ + i;
+    }
+
+    /// @brief Removes element at pos.
+    /// @param[in] pos Position
+    /// @return Iterator to the element following the removed one
+    iterator erase(const_iterator pos) {
+        std::size_t i = static_cast<std::size_t>(pos - data_);
+        std::memmove(data_ + i, data_ + i + 1, (size_ - i - 1) * sizeof(T));
+        size_--;
+        return data_ + i;
+    }
+
+    /// @brief Makes sure that n elements fit without reallocation.
+    /// @param[in] n Number of elements
+    void reserve(std::size_t n) {
+        if (n <= capacity_)
+            return;
+        std::size_t capacity = 2 * capacity_;
+        if (capacity < n)
+            capacity = n;
+        T *data = new T[capacity];
+        std::memcpy(data, data_, size_ * sizeof(T));
+        if (data_ != inline_)
+            delete[] data_;
+        data_     = data;
+        capacity_ = capacity;
+    }
+
+protected:
+    /// @brief Copies elements of another vector.
+    /// @param[in] other another object to use as data source
+    void assign(const small_vector &other) {
+        size_ = 0;
+        reserve(other.size_);
+        std::memcpy(data_, other.data_, other.size_ * sizeof(T));
+        size_ = other.size_;
+    }
+
+    /// @brief Inline storage
+    T inline_[N];
+    /// @brief Current storage: inline_ or heap
+    T *data_;
+    /// @brief Number of elements
+    std::size_t size_;
+    /// @brief Number of elements which fit into the current storage
+    std::size_t capacity_;
+};
+
+} // namespace detail
+} // namespace vpl
+} // namespace oneapi
@@ -0,0 +1,33 @@
+/*############################################################################
+  # Copyright Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#pragma once
+
+// Includes windows.h for the preview API headers without leaking the min/max macros and the rarely used parts of
+// the Windows API into the code of the user. Macros defined here are undefined again, so the settings of the user
+// are kept as they are.
+
+#if defined(_WIN32) || defined(_WIN64)
+  #ifndef NOMINMAX
+    #define NOMINMAX
+    #define ONEVPL_PREVIEW_UNDEF_NOMINMAX
+  #endif
+  #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+    #define ONEVPL_PREVIEW_UNDEF_WIN32_LEAN_AND_MEAN
+  #endif
+
+  #include <windows.h>
+
+  #ifdef ONEVPL_PREVIEW_UNDEF_NOMINMAX
+    #undef NOMINMAX
+    #undef ONEVPL_PREVIEW_UNDEF_NOMINMAX
+  #endif
+  #ifdef ONEVPL_PREVIEW_UNDEF_WIN32_LEAN_AND_MEAN
+    #undef WIN32_LEAN_AND_MEAN
+    #undef ONEVPL_PREVIEW_UNDEF_WIN32_LEAN_AND_MEAN
+  #endif
+#endif
@@ -6,12 +6,15 @@
 
 #pragma once
 
+#include <algorithm>
 #include <exception>
-#include <map>
+#include <utility>
 #include <vector>
 
 #include "vpl/preview/extension_buffer.hpp"
 
+#include "vpl/preview/detail/small_vector.hpp"
+
 namespace oneapi {
 namespace vpl {
 
@@ -19,132 +22,137 @@ namespace vpl {
 static constexpr uint32_t ignore_ID_list[IGNORE_LIST_LEN] = { 0, MFX_EXTBUFF_VPP_AUXDATA };
 
 /// @brief Base class to replerent list of extension buffers.
-/// Buffer pointers are stored as a map, so a single occurance of the same
-/// extension buffer is possible.
+/// Buffer pointers are stored sorted by ID, so a single occurance of the same
+/// extension buffer is possible. Array of raw buffer pointers is cached and rebuilt
+/// only when the set of buffers changes, so lists attached on every frame are cheap.
 class buffer_list {
 public:
+    /// @brief Extension buffer ID in the form of FourCC code and pointer to the extension buffer.
+    struct entry {
+        /// Extension buffer ID
+        uint32_t id;
+        /// Pointer to the extension buffer
+        extension_buffer_base* buffer;
+    };
+
+    /// @brief Sorted list of extension buffers. Lists usually hold a few buffers, so they are kept inline.
+    using entries = detail::small_vector<entry, 8>;
+
     /// @brief default ctor
-    buffer_list() : extBuffers_() , mfxBuffers_(0) {}
-
-    buffer_list(const buffer_list& other) : extBuffers_(other.extBuffers_), mfxBuffers_(0){}
-    buffer_list& operator=(const buffer_list& other){
-        if(mfxBuffers_ != other.mfxBuffers_){
-            if(mfxBuffers_){
-                delete[] mfxBuffers_;
-                mfxBuffers_ = nullptr;
-            }
-            extBuffers_ = other.extBuffers_;
-        }
-        return *this;
-    }	
+    buffer_list() : extBuffers_(), mfxBuffers_(), dirty_(false) {}
 
     /// @brief dtor
-    virtual ~buffer_list() {
-        delete[] mfxBuffers_;
-    }
+    virtual ~buffer_list() {}
 
-    /// @brief returns reference to the map with extension buffers. Key is buffer ID in the form of FourCC codes
-    /// value is the pointer to the extension buffer.
-    /// @return reference to the map with the pointers to the extension buffers
-    std::map<uint32_t, extension_buffer_base*>& get_buffers() {
+    /// @brief returns sorted list of extension buffers.
+    /// @return reference to the list with the IDs and pointers to the extension buffers
+    const entries& get_buffers() const {
         return extBuffers_;
     }
 
-    /// @brief Reurns number of extension buffers in the map.
-    /// @return Number of extension buffers in the map.
+    /// @brief Reurns number of extension buffers in the list.
+    /// @return Number of extension buffers in the list.
     std::size_t get_size() const {
         return extBuffers_.size();
     }
-    /// @brief adds extension buffer pointer to the map
+    /// @brief adds extension buffer pointer to the list. Replaces buffer with the same ID.
     /// @param[in] o pointer to the extension buffer
     void add_buffer(extension_buffer_base* o) {
-        // extBuffers_.insert(std::pair<uint32_t,eb>(o.get_ID(),o)); // this is language hack. ref can't be in the std::map
-        extBuffers_[o->get_ID()] = o;
+        uint32_t id = o->get_ID();
+        auto it     = find(id);
+        if (it != extBuffers_.end() && it->id == id) {
+            if (it->buffer != o) {
+                it->buffer = o;
+                dirty_     = true;
+            }
+            return;
+        }
+        extBuffers_.insert(it, { id, o });
+        dirty_ = true;
     }
 
-    /// @brief verifies that map contains given key (extension buffer)
+    /// @brief verifies that list contains given key (extension buffer)
     /// @tparam ID extension buffer ID in the form of FourCC code.
-    /// @return true if buffer exists in the map.
+    /// @return true if buffer exists in the list.
     template <uint32_t ID>
-    bool has_buffer() {
-        if (extBuffers_.find(ID) != extBuffers_.end())
-            return true;
-        return false;
+    bool has_buffer() const {
+        return has_buffer(ID);
     }
 
-    /// @brief verifies that map contains given key (extension buffer)
-    /// @tparam ID extension buffer ID in the form of FourCC code.
-    /// @return true if buffer exists in the map.
-    bool has_buffer(uint32_t ID) {
-        if (extBuffers_.find(ID) != extBuffers_.end())
-            return true;
-        return false;
+    /// @brief verifies that list contains given key (extension buffer)
+    /// @param[in] ID extension buffer ID in the form of FourCC code.
+    /// @return true if buffer exists in the list.
+    bool has_buffer(uint32_t ID) const {
+        auto it = find(ID);
+        return it != extBuffers_.end() && it->id == ID;
     }
 
     /// @brief returns extension buffer of given type and ID.
     /// @tparam T extension buffer class.
     /// @tparam ID extension buffer ID in the form of FourCC code.
-    /// @return pointer to the extension buffer or nullptr is that buffer doesn't in the map
+    /// @return pointer to the extension buffer or nullptr is that buffer doesn't in the list
     template <typename T, uint32_t ID>
     T* get_buffer() {
-        auto buff = extBuffers_.find(ID);
-        if (buff != extBuffers_.end()) {
-            return reinterpret_cast<T*>(buff->second->get_base_ptr());
-        }
-        return nullptr;
+        return get_buffer<T>(ID);
     }
 
     /// @brief returns extension buffer of given type and ID.
     /// @tparam T extension buffer class.
-    /// @tparam ID extension buffer ID in the form of FourCC code.
-    /// @return pointer to the extension buffer or nullptr if that buffer isn't in the map
+    /// @param[in] ID extension buffer ID in the form of FourCC code.
+    /// @return pointer to the extension buffer or nullptr if that buffer isn't in the list
     template <typename T>
     T* get_buffer(uint32_t ID) {
-        auto buff = extBuffers_.find(ID);
-        if (buff != extBuffers_.end()) {
-            return reinterpret_cast<T*>(buff->second->get_base_ptr());
+        auto it = find(ID);
+        if (it != extBuffers_.end() && it->id == ID) {
+            return reinterpret_cast<T*>(it->buffer->get_base_ptr());
         }
         return nullptr;
     }
 
-    /// @brief returns pair of array of pointers to the extension buffer and number of buffers
+    /// @brief returns pair of array of pointers to the extension buffer and number of buffers.
+    /// Buffers from the ignore list are skipped. The array is owned by the list and stays valid until
+    /// the set of buffers changes.
     /// @return pair of array of pointers to the extension buffer and number of buffers
-    /// @todo output unique_ptr instead of pointer to the member variable
     auto get_raw_ext_buffers() {
-        uint32_t ignoreNum = 0;
-
-        std::for_each(ignore_ID_list, ignore_ID_list + IGNORE_LIST_LEN, [&](uint32_t id) {
-            if (has_buffer(id))
-                ignoreNum++;
-        });
-
-        delete[] mfxBuffers_;
-        mfxBuffers_ = new mfxExtBuffer*[extBuffers_.size() - ignoreNum];
-        int i       = 0;
-
-        for (const auto& buf : extBuffers_) {
-            auto& id           = buf.first;
-            auto& value        = buf.second;
-            auto exists_ignore = std::any_of(ignore_ID_list,
-                                             ignore_ID_list + IGNORE_LIST_LEN,
-                                             [&id](uint32_t ignore_id) {
-                                                 return id == ignore_id;
-                                             });
-            if (exists_ignore)
-                continue;
-            mfxBuffers_[i] = value->get_base_ptr();
-            i++;
+        if (dirty_) {
+            mfxBuffers_.clear();
+            for (const auto& buf : extBuffers_) {
+                if (std::find(ignore_ID_list, ignore_ID_list + IGNORE_LIST_LEN, buf.id) !=
+                    ignore_ID_list + IGNORE_LIST_LEN)
+                    continue;
+                mfxBuffers_.push_back(buf.buffer->get_base_ptr());
+            }
+            dirty_ = false;
         }
-        return std::pair(mfxBuffers_, extBuffers_.size() - ignoreNum);
+        return std::pair(mfxBuffers_.empty() ? nullptr : mfxBuffers_.data(), mfxBuffers_.size());
     }
 
 protected:
-    /// Map of extension buffers with key equal to the buffer ID
-    /// @tparam extension_buffer_base* pointer to the extension buffer class.
-    /// @tparam uint32_t extension buffer ID in the form of FourCC code.
-    std::map<uint32_t, extension_buffer_base*> extBuffers_;
-    /// @todo remove
-    mfxExtBuffer** mfxBuffers_;
+    /// @brief Finds position of the buffer with given ID or the position to insert it.
+    /// @param[in] ID extension buffer ID in the form of FourCC code.
+    /// @return Iterator to the first buffer with the ID not less than the given one.
+    entries::iterator find(uint32_t ID) {
+        return std::lower_bound(extBuffers_.begin(),
+                                extBuffers_.end(),
+                                ID,
+                                [](const entry& e, uint32_t id) {
+                                    return e.id < id;
+                                });
+    }
+
+    /// @brief Finds position of the buffer with given ID or the position to insert it.
+    /// @param[in] ID extension buffer ID in the form of FourCC code.
+    /// @return Iterator to the first buffer with the ID not less than the given one.
+    entries::const_iterator find(uint32_t ID) const {
+        return const_cast<buffer_list*>(this)->find(ID);
+    }
+
+    /// List of extension buffers sorted by the buffer ID
+    entries extBuffers_;
+    /// Cached array of raw pointers to the extension buffers
+    detail::small_vector<mfxExtBuffer*, 8> mfxBuffers_;
+    /// Set when the cached array doesn't match the list
+    bool dirty_;
 };
 
 /// @brief This class hold list of extension buffers used during decoder's initialization stage
@@ -97,24 +97,33 @@ public:
         }
     }
 
+    /// @brief Takes over the reference to mfxFrameSurface1 object which the caller owns, like surfaces returned by
+    /// the runtime. Reference counter isn't incremented, and is decremented once when the object is destroyed, so
+    /// each frame_surface object holds exactly one reference regardless of the number of shared pointers to it.
+    /// @param[in] surface mfxFrameSurface1 surface to take over.
+    /// @param[in] lazy_sync Do lazy sync or not.
+    void adopt(mfxFrameSurface1* surface, bool lazy_sync = false) {
+        if (!surface_) {
+            surface_   = surface;
+            lazy_sync_ = lazy_sync;
+        }
+    }
+
     /// @brief Inject mfxFrameSurface1 object to take care of it. This is temporal method until VPL RT will support all
     /// functions for the internal memory allocation
-    /// @todo Check reference counter correctness.
+    /// @deprecated Use adopt() for surfaces returned by the runtime.
     /// @param[in] surface mfxFrameSurface1 surface to use.
     /// @param[in] n_times Reference counter increment.
     /// @param[in] lazy_sync Do lazy sync or not.
     void inject(mfxFrameSurface1* surface, unsigned int n_times, bool lazy_sync = false) {
         if (!surface_) {
-            uint32_t c;
             surface_   = surface;
             lazy_sync_ = lazy_sync;
-            surface_->FrameInterface->GetRefCounter(surface_, &c);
             for (unsigned int i = 0; i < n_times; i++) {
                 detail::c_api_invoker(detail::default_checker,
                                         surface_->FrameInterface->AddRef,
                                         surface_);
             }
-            surface_->FrameInterface->GetRefCounter(surface_, &c);
         }
     }
 
@@ -6,16 +6,21 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <chrono>
-#include <deque>
+#include <iterator>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "vpl/preview/bitstream.hpp"
 #include "vpl/preview/defs.hpp"
 #include "vpl/preview/frame_surface.hpp"
 
+#include "vpl/preview/detail/object_pool.hpp"
+
 namespace oneapi {
 namespace vpl {
 
@@ -26,7 +31,7 @@ struct operation_status {
     /// @brief Ctor. Initializes structure with default values.
     /// @param[in] component Type of the component generated from the status.
     /// @param[in] owner Pointer to the component generated from this status.
-    operation_status(component component, void *owner)
+    operation_status(component component = component::unknown, void *owner = nullptr)
             : schedule_status_(status::Unknown),
               exec_status_(status::Unknown),
               fatal_(false),
@@ -58,6 +63,101 @@ inline std::ostream &operator<<(std::ostream &out, const operation_status &o) {
     return out;
 }
 
+/// @brief Maximum number of operations kept in the processing history of the future.
+constexpr size_t OPERATION_HISTORY_CAPACITY = 16;
+
+/// @brief Processing history of the future. Statuses are stored inline, so creating and copying the history
+/// doesn't allocate. When the history is full, the oldest statuses are dropped: back() is always the status of the
+/// latest operation, but front() is not the first operation of the pipeline anymore. Pipelines longer than
+/// OPERATION_HISTORY_CAPACITY stages keep only the statuses of their last OPERATION_HISTORY_CAPACITY operations.
+class operation_history {
+public:
+    using value_type             = operation_status;
+    using iterator               = operation_status *;
+    using const_iterator         = const operation_status *;
+    using reverse_iterator       = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    /// @brief Default ctor. Creates empty history.
+    operation_history() : items_(), size_(0) {}
+
+    /// @brief Adds the latest status. Drops the oldest one if the history is full.
+    /// @param[in] op Operation status
+    void push_back(const operation_status &op) {
+        if (size_ == items_.size()) {
+            std::move(items_.begin() + 1, items_.end(), items_.begin());
+            size_--;
+        }
+        items_[size_++] = op;
+    }
+
+    /// @brief Adds status older than all statuses in the history. Ignored if the history is full.
+    /// @param[in] op Operation status
+    void push_front(const operation_status &op) {
+        if (size_ == items_.size())
+            return;
+        std::move_backward(items_.begin(), items_.begin() + size_, items_.begin() + size_ + 1);
+        items_[0] = op;
+        size_++;
+    }
+
+    /// @brief Removes all statuses.
+    void clear() {
+        size_ = 0;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+    size_t size() const {
+        return size_;
+    }
+
+    operation_status &front() {
+        return items_[0];
+    }
+    const operation_status &front() const {
+        return items_[0];
+    }
+    operation_status &back() {
+        return items_[size_ - 1];
+    }
+    const operation_status &back() const {
+        return items_[size_ - 1];
+    }
+
+    iterator begin() {
+        return items_.data();
+    }
+    iterator end() {
+        return items_.data() + size_;
+    }
+    const_iterator begin() const {
+        return items_.data();
+    }
+    const_iterator end() const {
+        return items_.data() + size_;
+    }
+    reverse_iterator rbegin() {
+        return reverse_iterator(end());
+    }
+    reverse_iterator rend() {
+        return reverse_iterator(begin());
+    }
+    const_reverse_iterator rbegin() const {
+        return const_reverse_iterator(end());
+    }
+    const_reverse_iterator rend() const {
+        return const_reverse_iterator(begin());
+    }
+
+protected:
+    /// @brief Statuses, oldest first
+    std::array<operation_status, OPERATION_HISTORY_CAPACITY> items_;
+    /// @brief Number of statuses
+    size_t size_;
+};
+
 /// @brief This class represent future data container and used to glue processing of the individual components
 /// into the pipeline. Once component which is down in the pipeline recieved that object, it must use it to wait for
 /// the data. States of the data in this object:
@@ -140,6 +240,8 @@ public:
     }
 
     /// @brief Propagate processing history from previous future object in the pipeline.
+    /// @details Statuses of this future are kept. If the joint history doesn't fit into
+    /// OPERATION_HISTORY_CAPACITY entries, the oldest statuses of the previous future are dropped.
     /// @param old Reference to the previouse future object in the pipeline
     /// @tparam T Type of the data container
     template <typename T>
@@ -150,7 +252,7 @@ public:
     }
 
     /// Processing history
-    std::deque<operation_status> history_;
+    operation_history history_;
 
 protected:
     /// @brief Checks if we need to wait for the data or skip the processing.
@@ -189,6 +291,129 @@ protected:
     }
 };
 
+/// @brief Keeps futures of the scheduled operations which were not handed to the user yet, so that up to the
+/// configured number of operations is in flight in the runtime. Futures are handed back in submission order:
+/// while the queue is filling up, user gets placeholder futures with status::NotEnoughData, the same way as for
+/// frames buffered inside the component. Once end of stream is reached, remaining futures are handed back one by
+/// one. With depth 1 every future is handed back immediately.
+/// @tparam future_t future class
+template <typename future_t>
+class future_queue {
+public:
+    /// @brief Ctor.
+    /// @param[in] depth Maximum number of operations in flight.
+    explicit future_queue(uint32_t depth = 1)
+            : depth_(depth ? depth : 1),
+              ring_(),
+              head_(0),
+              count_(0) {}
+
+    /// @brief Sets maximum number of operations in flight. Intended to be called before the processing starts.
+    /// @param[in] depth Maximum number of operations in flight. 0 is treated as 1.
+    void set_depth(uint32_t depth) {
+        depth_ = depth ? depth : 1;
+    }
+
+    /// @brief Returns maximum number of operations in flight.
+    /// @return Maximum number of operations in flight.
+    uint32_t get_depth() const {
+        return depth_;
+    }
+
+    /// @brief Returns number of queued futures.
+    /// @return Number of queued futures.
+    size_t size() const {
+        return count_;
+    }
+
+    /// @brief Waits for the operations of all queued futures and drops them. Errors of these operations are
+    /// ignored, the results aren't delivered anyway.
+    void clear() {
+        while (count_) {
+            std::shared_ptr<future_t> f = pop();
+            try {
+                f->wait();
+            }
+            catch (...) {
+            }
+        }
+    }
+
+    /// @brief Passes future of the just scheduled operation through the queue.
+    /// @param[in] f Future with the last operation status added.
+    /// @return Oldest future if the queue is full or stream is over, placeholder if the queue is filling up,
+    /// or f itself if the operation didn't produce data.
+    /// @details If f had a fatal error, f is returned and all queued futures are dropped after their operations
+    /// complete: after a fatal error the results of the operations in flight are not delivered and the queue is
+    /// empty again.
+    std::shared_ptr<future_t> pass(std::shared_ptr<future_t> f) {
+        if (f->had_fatal()) {
+            clear();
+            return f;
+        }
+
+        switch (f->get_last_schedule_status()) {
+            case status::Ok: {
+                if (depth_ <= 1 && !count_)
+                    return f;
+                push(std::move(f));
+                if (count_ >= depth_)
+                    return pop();
+
+                std::shared_ptr<future_t> placeholder = detail::make_pooled<future_t>(nullptr);
+                placeholder->history_ = newest().history_;
+                placeholder->history_.back().schedule_status_ = status::NotEnoughData;
+                return placeholder;
+            }
+            case status::EndOfStreamReached:
+                if (count_)
+                    return pop();
+                return f;
+            default:
+                return f;
+        }
+    }
+
+protected:
+    /// @brief Adds future to the queue. Storage grows only when the depth is raised.
+    /// @param[in] f Future
+    void push(std::shared_ptr<future_t> f) {
+        if (count_ == ring_.size()) {
+            std::vector<std::shared_ptr<future_t>> ring(count_ < depth_ ? depth_ : 2 * count_);
+            for (size_t i = 0; i < count_; i++)
+                ring[i] = std::move(ring_[(head_ + i) % ring_.size()]);
+            ring_.swap(ring);
+            head_ = 0;
+        }
+        ring_[(head_ + count_) % ring_.size()] = std::move(f);
+        count_++;
+    }
+
+    /// @brief Returns the latest queued future.
+    /// @return Latest future.
+    future_t &newest() {
+        return *ring_[(head_ + count_ - 1) % ring_.size()];
+    }
+
+    /// @brief Takes the oldest future from the queue.
+    /// @return Oldest future.
+    std::shared_ptr<future_t> pop() {
+        std::shared_ptr<future_t> f = std::move(ring_[head_]);
+        head_                       = (head_ + 1) % ring_.size();
+        count_--;
+        return f;
+    }
+
+    /// @brief Maximum number of operations in flight
+    uint32_t depth_;
+    /// @brief Futures in submission order, starting at head_
+    std::vector<std::shared_ptr<future_t>> ring_;
+    /// @brief Index of the oldest future
+    size_t head_;
+    /// @brief Number of queued futures
+    size_t count_;
+};
+
 using future_surface_t   = future<std::shared_ptr<frame_surface>>;
 using future_bitstream_t = future<std::shared_ptr<bitstream_as_dst>>;
 
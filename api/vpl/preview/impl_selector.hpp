@@ -11,14 +11,34 @@
 #include <vector>
 
 #include "vpl/preview/detail/sdk_callable.hpp"
+#include "vpl/preview/detail/shared_loader.hpp"
 #include "vpl/preview/exception.hpp"
 #include "vpl/preview/impl_caps.hpp"
 #include "vpl/mfxdispatcher.h"
 #include "vpl/preview/options.hpp"
+#include "vpl/preview/session_pool.hpp"
 
 namespace oneapi {
 namespace vpl {
 
+namespace detail {
+
+/// @brief Session created by implementation_selector::session().
+struct selected_session {
+    /// @brief Loader which created the session
+    std::shared_ptr<shared_loader> loader;
+    /// @brief Session handle and accelerator handle, if the session was taken from the pool
+    pooled_session handle;
+    /// @brief Implementation index
+    uint32_t impl_idx;
+    /// @brief Pool to return the session to, if any
+    std::shared_ptr<session_pool> pool;
+    /// @brief True if the session was taken from the pool
+    bool reused;
+};
+
+} // namespace detail
+
 /// @brief Selects oneVPL implementation according to the specified properties.
 /// @details This object iterates over the available implementations and selects an appropriate one
 /// based on the @p list of properties. API user can create an instance of that class. If user
@@ -29,7 +49,8 @@ protected:
     /// @brief Protected ctor.
     /// @param list List of properties
     implementation_selector()
-            : format_(MFX_IMPLCAPS_IMPLDESCSTRUCTURE) {}
+            : format_(MFX_IMPLCAPS_IMPLDESCSTRUCTURE),
+              pool_() {}
 
     virtual std::vector<std::pair<std::string, detail::variant>> get_properties() const = 0;
 
@@ -37,51 +58,35 @@ public:
     /// @brief dtor
     virtual ~implementation_selector() {}
 
+    /// @brief Sets pool of idle sessions. Sessions created with this selector are taken from the
+    /// pool if possible, and are returned to it when destroyed.
+    /// @param[in] pool Session pool. Null disables pooling.
+    void set_session_pool(std::shared_ptr<session_pool> pool) {
+        pool_ = pool;
+    }
+
     /// @brief Creates session which has the requested properties. Session class object calls
     /// this method at the ctor and takes care on deletion of loader and session handles.
-    /// @return Pair of loader handle and associated session handle.
-    auto session() const {
-        mfxStatus sts;
-        implementation_capabilities_factory factory;
-        auto loader = MFXLoad();
-
-        // convert options to mfxConfig
-        auto opts = get_properties();
-
-        std::for_each(opts.begin(), opts.end(), [&](auto opt) {
-            auto cfg = MFXCreateConfig(loader);
-            [[maybe_unused]] detail::c_api_invoker e(detail::default_checker,
-                                    MFXSetConfigFilterProperty,
-                                    cfg,
-                                    (const uint8_t *)opt.first.c_str(),
-                                    opt.second.get_variant());
-        });
-
-        uint32_t idx = 0;
-        while (true) {
-            void *h;
-            sts = MFXEnumImplementations(loader, idx, format_, &h);
-
-            std::shared_ptr<void> handle(h, [&] (void *p) {
-                MFXDispReleaseImplDescription(loader, p);
-            });
-
-            // break if no idx
-            if (sts == MFX_ERR_NOT_FOUND)
-                break;
-            if (sts < 0)
-                throw base_exception(sts);
-
-            std::shared_ptr<base_implementation_capabilities> caps = factory.create(format_, h);
-
-            if (this->operator()(caps)) {
-                mfxSession s;
-                detail::c_api_invoker e(detail::default_checker, MFXCreateSession, loader, idx, &s);
-                return std::pair(loader, s);
+    /// @details Loader is shared between all sessions created with the same properties, so
+    /// libraries are searched and implementations are enumerated only once for all of them.
+    /// If a session pool is set, idle session of the selected implementation is reused.
+    /// @return Shared loader and associated session handle.
+    detail::selected_session session() const {
+        auto loader = detail::shared_loader::get(get_properties(), format_);
+        auto lock   = loader->lock();
+
+        auto &caps = loader->capabilities();
+        for (uint32_t idx = 0; idx < caps.size(); idx++) {
+            if (this->operator()(caps[idx])) {
+                detail::selected_session s = { loader, {}, idx, pool_, false };
+                if (pool_ && pool_->acquire(loader, idx, s.handle)) {
+                    s.reused = true;
+                    return s;
+                }
+                s.handle.session = loader->create_session(idx);
+                return s;
             }
-            idx++;
         }
-        MFXUnload(loader);
         throw base_exception(MFX_ERR_NOT_INITIALIZED);
     }
 
@@ -95,6 +100,9 @@ protected:
     /// @brief Implementation capabilities report format
     /// @todo Replace either with enum or typename
     mfxImplCapsDeliveryFormat format_;
+
+    /// @brief Pool of idle sessions, may be null
+    std::shared_ptr<session_pool> pool_;
 };
 
 /// @brief Default implementation selector. It accepts first implementation matching provided properties.
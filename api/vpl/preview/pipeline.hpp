@@ -0,0 +1,541 @@
+/*############################################################################
+  # Copyright Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#pragma once
+
+// coroutine pipeline needs C++20 coroutines, header is empty otherwise
+#if defined(__has_include)
+  #if __has_include(<coroutine>) && defined(__cpp_impl_coroutine)
+    #define ONEVPL_PREVIEW_COROUTINES 1
+  #endif
+#endif
+
+#if defined(ONEVPL_PREVIEW_COROUTINES)
+
+  #include <chrono>
+  #include <condition_variable>
+  #include <coroutine>
+  #include <cstdint>
+  #include <deque>
+  #include <exception>
+  #include <functional>
+  #include <memory>
+  #include <mutex>
+  #include <optional>
+  #include <thread>
+  #include <utility>
+  #include <vector>
+
+  #include "vpl/preview/future.hpp"
+  #include "vpl/preview/session.hpp"
+
+namespace oneapi {
+namespace vpl {
+
+class executor;
+
+template <typename T>
+class task;
+
+namespace detail {
+
+/// @brief Part of the coroutine promise shared by all task types.
+struct task_promise_base {
+    /// @brief Executor which runs the coroutine. Inherited from the awaiting coroutine.
+    executor *executor_ = nullptr;
+    /// @brief Coroutine to resume when this one is done.
+    std::coroutine_handle<> continuation_ = nullptr;
+    /// @brief Exception thrown out of the coroutine body.
+    std::exception_ptr exception_ = nullptr;
+
+    /// @brief Resumes the awaiting coroutine on completion.
+    struct final_awaiter {
+        bool await_ready() noexcept {
+            return false;
+        }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+            std::coroutine_handle<> c = h.promise().continuation_;
+            return c ? c : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+
+    /// @brief Tasks are lazy: the body runs when the task is awaited or spawned.
+    std::suspend_always initial_suspend() noexcept {
+        return {};
+    }
+    final_awaiter final_suspend() noexcept {
+        return {};
+    }
+    void unhandled_exception() {
+        exception_ = std::current_exception();
+    }
+};
+
+/// @brief Coroutine promise of task<T>.
+template <typename T>
+struct task_promise : task_promise_base {
+    task<T> get_return_object() noexcept;
+
+    template <typename U>
+    void return_value(U &&value) {
+        value_.emplace(std::forward<U>(value));
+    }
+
+    T result() {
+        if (exception_)
+            std::rethrow_exception(exception_);
+        return std::move(*value_);
+    }
+
+    /// @brief Value provided with co_return.
+    std::optional<T> value_;
+};
+
+/// @brief Coroutine promise of task<void>.
+template <>
+struct task_promise<void> : task_promise_base {
+    task<void> get_return_object() noexcept;
+
+    void return_void() noexcept {}
+
+    void result() {
+        if (exception_)
+            std::rethrow_exception(exception_);
+    }
+};
+
+} // namespace detail
+
+/// @brief Coroutine which produces a value of type T. Task starts when it is awaited with co_await from another
+/// task, or when it is handed to executor::spawn(). Awaiting coroutine is resumed when the task is done.
+/// @tparam T Type of the value
+template <typename T = void>
+class task {
+public:
+    /// @brief Coroutine promise type
+    using promise_type = detail::task_promise<T>;
+
+    /// @brief Ctor.
+    /// @param[in] h Coroutine handle
+    explicit task(std::coroutine_handle<promise_type> h) noexcept : handle_(h) {}
+
+    /// @brief Move ctor.
+    /// @param[in] other Another task
+    task(task &&other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+    task(const task &) = delete;
+    task &operator=(const task &) = delete;
+
+    /// @brief Dtor. Destroys the coroutine frame.
+    ~task() {
+        if (handle_)
+            handle_.destroy();
+    }
+
+    /// @brief Awaiter which starts the task and suspends the awaiting coroutine until the task is done.
+    struct awaiter {
+        std::coroutine_handle<promise_type> handle_;
+
+        bool await_ready() const noexcept {
+            return !handle_ || handle_.done();
+        }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> awaiting) noexcept {
+            handle_.promise().executor_     = awaiting.promise().executor_;
+            handle_.promise().continuation_ = awaiting;
+            return handle_;
+        }
+        T await_resume() {
+            return handle_.promise().result();
+        }
+    };
+
+    /// @brief Makes the task awaitable.
+    /// @return Awaiter
+    awaiter operator co_await() && noexcept {
+        return awaiter{ handle_ };
+    }
+
+    /// @brief Makes the task awaitable.
+    /// @return Awaiter
+    awaiter operator co_await() & noexcept {
+        return awaiter{ handle_ };
+    }
+
+protected:
+    /// @brief Coroutine handle
+    std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+
+template <typename T>
+inline task<T> task_promise<T>::get_return_object() noexcept {
+    return task<T>(std::coroutine_handle<task_promise<T>>::from_promise(*this));
+}
+
+inline task<void> task_promise<void>::get_return_object() noexcept {
+    return task<void>(std::coroutine_handle<task_promise<void>>::from_promise(*this));
+}
+
+/// @brief Top level coroutine created by executor::spawn(). Destroys itself when done.
+struct root_task {
+    struct promise_type : task_promise_base {
+        root_task get_return_object() noexcept {
+            return root_task{ std::coroutine_handle<promise_type>::from_promise(*this) };
+        }
+        std::suspend_never final_suspend() noexcept {
+            return {};
+        }
+        void return_void() noexcept {}
+    };
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+} // namespace detail
+
+/// @brief Runs coroutine pipelines over a small number of threads. Coroutines don't block threads while they
+/// wait for sync points: they are suspended, and the executor resumes them once the data is ready. Since the
+/// runtime has no completion notification, pending sync points are polled with zero timeout by one thread at a
+/// time. Each coroutine is resumed by one thread at a time, so sessions used only by a single pipeline need no
+/// locking.
+///
+/// Example:
+/// @code
+/// vpl::task<> transcode(vpl::decode_session<Reader> &dec, vpl::encode_session &enc, Writer &out) {
+///     while (true) {
+///         auto frame = co_await vpl::next_frame(dec);
+///         auto bits  = co_await vpl::next_bitstream(enc, frame);
+///         if (bits->get_last_schedule_status() == vpl::status::EndOfStreamReached)
+///             break;
+///         if (bits->get_last_schedule_status() == vpl::status::Ok)
+///             out.write(bits->get());
+///     }
+/// }
+///
+/// vpl::executor ex(4);
+/// for (auto &stream : streams)
+///     ex.spawn(transcode(stream.dec, stream.enc, stream.out));
+/// ex.join();
+/// @endcode
+class executor {
+public:
+    /// @brief Ctor. Starts worker threads.
+    /// @param[in] threads Number of worker threads. 0 is treated as 1.
+    /// @param[in] poll_interval Time between polls of pending sync points when nothing else is ready to run.
+    explicit executor(uint32_t threads                         = 2,
+                      std::chrono::microseconds poll_interval = std::chrono::microseconds(500))
+            : poll_interval_(poll_interval),
+              ready_(),
+              waiting_(),
+              threads_(),
+              active_(0),
+              polling_(false),
+              stop_(false),
+              exception_(nullptr),
+              mutex_(),
+              work_cv_(),
+              idle_cv_() {
+        if (!threads)
+            threads = 1;
+        for (uint32_t i = 0; i < threads; i++)
+            threads_.emplace_back([this]() {
+                worker();
+            });
+    }
+
+    /// @brief Dtor. Waits for spawned coroutines and stops worker threads.
+    ~executor() {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            idle_cv_.wait(lock, [this]() {
+                return active_ == 0;
+            });
+            stop_ = true;
+        }
+        work_cv_.notify_all();
+        for (auto &t : threads_)
+            t.join();
+    }
+
+    executor(const executor &) = delete;
+    executor &operator=(const executor &) = delete;
+
+    /// @brief Starts the task on the executor. The task is owned by the executor until it is done.
+    /// @param[in] t Task to run
+    void spawn(task<void> t) {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            active_++;
+        }
+        detail::root_task root = run_root(std::move(t));
+        root.handle_.promise().executor_ = this;
+        schedule(root.handle_);
+    }
+
+    /// @brief Waits until all spawned tasks are done.
+    /// @throw Rethrows the first exception thrown out of a spawned task.
+    void join() {
+        std::exception_ptr e;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            idle_cv_.wait(lock, [this]() {
+                return active_ == 0;
+            });
+            e = std::exchange(exception_, nullptr);
+        }
+        if (e)
+            std::rethrow_exception(e);
+    }
+
+    /// @brief Returns number of spawned tasks which are not done yet.
+    /// @return Number of tasks.
+    uint32_t get_active_count() const {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return active_;
+    }
+
+    /// @brief Returns number of worker threads.
+    /// @return Number of threads.
+    uint32_t get_thread_count() const {
+        return static_cast<uint32_t>(threads_.size());
+    }
+
+    /// @brief Queues suspended coroutine to be resumed by a worker thread.
+    /// @param[in] h Coroutine handle
+    void schedule(std::coroutine_handle<> h) {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            ready_.push_back(h);
+        }
+        work_cv_.notify_one();
+    }
+
+    /// @brief Parks suspended coroutine until the predicate returns true. The predicate is called from worker
+    /// threads, one call at a time, and must not block.
+    /// @param[in] h Coroutine handle
+    /// @param[in] is_ready Predicate
+    void schedule_when(std::coroutine_handle<> h, std::function<bool()> is_ready) {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            waiting_.push_back({ h, std::move(is_ready) });
+        }
+        work_cv_.notify_one();
+    }
+
+protected:
+    /// @brief Suspended coroutine and the condition to resume it.
+    struct waiter {
+        std::coroutine_handle<> handle_;
+        std::function<bool()> is_ready_;
+    };
+
+    /// @brief Runs spawned task and accounts its completion.
+    /// @param[in] t Task to run
+    /// @return Root coroutine
+    detail::root_task run_root(task<void> t) {
+        try {
+            co_await std::move(t);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> guard(mutex_);
+            if (!exception_)
+                exception_ = std::current_exception();
+        }
+        finished();
+    }
+
+    /// @brief Accounts completion of the spawned task.
+    void finished() {
+        bool idle = false;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            idle = (--active_ == 0);
+        }
+        if (idle)
+            idle_cv_.notify_all();
+    }
+
+    /// @brief Moves coroutines with completed sync points into the ready queue. Called with the mutex locked.
+    /// @param[in] lock Lock of the mutex, released while predicates are called.
+    /// @return True if any coroutine became ready.
+    bool poll(std::unique_lock<std::mutex> &lock) {
+        polling_                    = true;
+        std::vector<waiter> pending = std::move(waiting_);
+        waiting_.clear();
+        lock.unlock();
+
+        std::vector<std::coroutine_handle<>> ready;
+        std::vector<waiter> still_waiting;
+        for (auto &w : pending) {
+            bool done = true;
+            try {
+                done = w.is_ready_();
+            }
+            catch (...) {
+                // resumed coroutine gets the error when it touches the data
+            }
+            if (done)
+                ready.push_back(w.handle_);
+            else
+                still_waiting.push_back(std::move(w));
+        }
+
+        lock.lock();
+        for (auto &w : still_waiting)
+            waiting_.push_back(std::move(w));
+        for (auto h : ready)
+            ready_.push_back(h);
+        polling_ = false;
+        if (ready.size() > 1)
+            work_cv_.notify_all();
+        return !ready.empty();
+    }
+
+    /// @brief Worker thread body.
+    void worker() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            if (!ready_.empty()) {
+                std::coroutine_handle<> h = ready_.front();
+                ready_.pop_front();
+                lock.unlock();
+                h.resume();
+                lock.lock();
+                continue;
+            }
+            if (stop_)
+                break;
+            if (!waiting_.empty() && !polling_) {
+                if (poll(lock))
+                    continue;
+                work_cv_.wait_for(lock, poll_interval_);
+                continue;
+            }
+            if (!waiting_.empty())
+                work_cv_.wait_for(lock, poll_interval_);
+            else
+                work_cv_.wait(lock);
+        }
+    }
+
+    /// @brief Time between polls when nothing is ready to run
+    std::chrono::microseconds poll_interval_;
+    /// @brief Coroutines ready to be resumed
+    std::deque<std::coroutine_handle<>> ready_;
+    /// @brief Coroutines waiting for sync points
+    std::vector<waiter> waiting_;
+    /// @brief Worker threads
+    std::vector<std::thread> threads_;
+    /// @brief Number of spawned tasks which are not done
+    uint32_t active_;
+    /// @brief Set while one of the threads polls sync points
+    bool polling_;
+    /// @brief Set when worker threads must exit
+    bool stop_;
+    /// @brief First exception thrown out of a spawned task
+    std::exception_ptr exception_;
+    /// @brief Protects the queues and counters
+    mutable std::mutex mutex_;
+    /// @brief Signaled when there is work for worker threads
+    std::condition_variable work_cv_;
+    /// @brief Signaled when the last spawned task is done
+    std::condition_variable idle_cv_;
+};
+
+/// @brief Awaiter which suspends the coroutine until the data of the future is ready. Futures without data to
+/// wait for (buffered, end of stream, fatal error) don't suspend.
+/// @tparam future_t future class
+template <typename future_t>
+class sync_awaiter {
+public:
+    /// @brief Ctor.
+    /// @param[in] f Future to wait for
+    explicit sync_awaiter(std::shared_ptr<future_t> f) : future_(std::move(f)) {}
+
+    bool await_ready() const {
+        if (!future_ || future_->history_.empty() || future_->had_fatal())
+            return true;
+        if (future_->get_last_schedule_status() != status::Ok)
+            return true;
+        return is_done(future_);
+    }
+
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> h) {
+        executor *ex = h.promise().executor_;
+        if (!ex) {
+            // not running on an executor - block the thread like future::wait does
+            future_->wait();
+            return false;
+        }
+        ex->schedule_when(h, [f = future_]() {
+            return is_done(f);
+        });
+        return true;
+    }
+
+    std::shared_ptr<future_t> await_resume() {
+        return future_;
+    }
+
+protected:
+    /// @brief Checks without blocking whether the operation is done.
+    /// @param[in] f Future
+    /// @return True if the data is ready or the operation failed.
+    static bool is_done(const std::shared_ptr<future_t> &f) {
+        return f->wait_for(std::chrono::milliseconds(0)) != async_op_status::timeout;
+    }
+
+    /// @brief Future to wait for
+    std::shared_ptr<future_t> future_;
+};
+
+/// @brief Suspends the coroutine until the data of the future is ready.
+/// @param[in] f Future to wait for
+/// @return Awaiter which resumes with the same future
+template <typename future_t>
+sync_awaiter<future_t> synchronized(std::shared_ptr<future_t> f) {
+    return sync_awaiter<future_t>(std::move(f));
+}
+
+/// @brief Decodes the next frame. Suspends the coroutine until the frame is ready.
+/// @param[in] s Decoder session
+/// @param[in] list List of extension buffers to attach to bitstream
+/// @return Future with the decoded frame and the operation status
+template <typename Reader>
+task<std::shared_ptr<future_surface_t>> next_frame(decode_session<Reader> &s,
+                                                   decoder_process_list list = {}) {
+    co_return co_await synchronized(s.process(list));
+}
+
+/// @brief Processes the next frame. Suspends the coroutine until the frame is ready.
+/// @param[in] s VPP session
+/// @param[in] in Future with the input frame
+/// @return Future with the processed frame and the operation status
+inline task<std::shared_ptr<future_surface_t>> next_frame(vpp_session &s,
+                                                          std::shared_ptr<future_surface_t> in) {
+    co_return co_await synchronized(s.process(co_await synchronized(in)));
+}
+
+/// @brief Encodes the next frame. Suspends the coroutine until the bitstream is ready.
+/// @param[in] s Encoder session
+/// @param[in] in Future with the input frame
+/// @param[in] list List of extension buffers to use
+/// @return Future with the bitstream and the operation status
+inline task<std::shared_ptr<future_bitstream_t>> next_bitstream(encode_session &s,
+                                                                std::shared_ptr<future_surface_t> in,
+                                                                encoder_process_list list = {}) {
+    co_return co_await synchronized(s.process(co_await synchronized(in), list));
+}
+
+} // namespace vpl
+} // namespace oneapi
+
+#endif // ONEVPL_PREVIEW_COROUTINES
@@ -6,17 +6,22 @@
 
 #pragma once
 
+#include <algorithm>
 #include <functional>
 #include <iostream>
+#include <exception>
 #include <limits>
 #include <memory>
+#include <vector>
 
+#include "vpl/preview/bitstream_pool.hpp"
 #include "vpl/preview/defs.hpp"
 #include "vpl/preview/exception.hpp"
 #include "vpl/preview/extension_buffer_list.hpp"
 #include "vpl/preview/frame_surface.hpp"
 #include "vpl/preview/future.hpp"
 #include "vpl/preview/impl_selector.hpp"
+#include "vpl/preview/session_pool.hpp"
 #include "vpl/preview/source_reader.hpp"
 #include "vpl/preview/stat.hpp"
 #include "vpl/preview/video_param.hpp"
@@ -57,10 +62,17 @@ protected:
             : c_api_callable_(callable),
               state_(state::Processing),
               component_(component::unknown),
-              accelerator_handle(nullptr) {
-        auto [l_, s_]  = sel.session();
-        this->loader_  = l_;
-        this->session_ = s_;        
+              fd_(-1),
+              accelerator_handle(nullptr),
+              healthy_(true),
+              initialized_(component::unknown),
+              close_initialized_(),
+              uncaught_exceptions_(std::uncaught_exceptions()) {
+        auto selected   = sel.session();
+        this->loader_   = selected.loader;
+        this->session_  = selected.handle.session;
+        this->pool_     = selected.pool;
+        this->impl_idx_ = selected.impl_idx;
 
         mfxStatus sts = MFXQueryIMPL(this->session_, &this->selected_impl_);
         if (sts != MFX_ERR_NONE) {
@@ -71,18 +83,52 @@ protected:
         if (sts != MFX_ERR_NONE) {
             this->version_ = { { 0, 0 } };
         }
-        init_accelerator_handle();
+
+        // accelerator handle was already set to the reused session
+        if (selected.reused) {
+            accelerator_handle = selected.handle.accelerator_handle;
+            fd_                = selected.handle.fd;
+            initialized_       = selected.handle.initialized;
+            close_initialized_ = selected.handle.close_component;
+        }
+        else {
+            init_accelerator_handle();
+        }
     }
 
 public:
-    /// @brief Dtor. Additionaly it closes loader.
+    /// @brief Dtor. Additionaly it releases reference to the shared loader. If the session was
+    /// created with a session pool, session handle is returned to the pool with the component still
+    /// initialized, so the next session of the same component only resets it.
     virtual ~session() {
+        if (pool_) {
+            // session is not reused if it reported errors, or is destroyed because of exception
+            bool healthy = healthy_ && std::uncaught_exceptions() <= uncaught_exceptions_;
+
+            detail::pooled_session s = { session_, accelerator_handle, fd_, &session::destroy_session };
+            if (healthy && initialized_ != component::unknown) {
+                s.initialized     = initialized_;
+                s.close_component = close_initialized_;
+            }
+            else {
+                mfxStatus sts = c_api_callable_.close(session_);
+                healthy       = healthy && !is_device_error(sts);
+            }
+
+            pool_->release(loader_, impl_idx_, s, healthy);
+            return;
+        }
+
         c_api_callable_.close(session_);
         MFXClose(session_);
-        MFXUnload(loader_);
         free_accelerator_handle();
     }
 
+    /// @brief Marks the session as failed, so it is not returned to the session pool.
+    void set_failed() {
+        healthy_ = false;
+    }
+
     /// @brief Returns implementation capabilities.
     /// @return Implementation capabilities.
     std::shared_ptr<VideoParams> Caps() {
@@ -116,9 +162,31 @@ public:
                 par->set_extension_buffers(buffers, static_cast<uint16_t>(size));
             }
         }
-        detail::c_api_invoker e(detail::default_checker,
+
+        // session from the session pool may have a component initialized by its previous owner
+        if (initialized_ == component_) {
+            detail::c_api_invoker e(
+                [this](mfxStatus s) {
+                    return s != MFX_ERR_INCOMPATIBLE_VIDEO_PARAM && track_errors(s);
+                },
+                std::bind(c_api_callable_.reset, session_, par->getMfx()));
+            if (e.sts_ != MFX_ERR_INCOMPATIBLE_VIDEO_PARAM) {
+                par->clear_extension_buffers();
+                return mfxstatus_to_onevplstatus(e.sts_);
+            }
+        }
+        if (initialized_ != component::unknown) {
+            close_initialized_(session_);
+            initialized_ = component::unknown;
+        }
+
+        detail::c_api_invoker e(track_errors,
                                 std::bind(c_api_callable_.init, session_, par->getMfx()));
         par->clear_extension_buffers();
+        if (e.sts_ >= MFX_ERR_NONE) {
+            initialized_       = component_;
+            close_initialized_ = c_api_callable_.close;
+        }
 
         return mfxstatus_to_onevplstatus(e.sts_);
     }
@@ -134,7 +202,7 @@ public:
             }
         }
 
-        detail::c_api_invoker e(detail::default_checker,
+        detail::c_api_invoker e(track_errors,
                                 std::bind(c_api_callable_.reset, session_, par->getMfx()),
                                 std::bind(c_api_callable_.init, session_, par->getMfx()));
         state_ = state::Processing;
@@ -225,6 +293,28 @@ protected:
         #endif
     }
 
+    /// @brief Checks if status means that the session can't be used anymore
+    static bool is_device_error(mfxStatus s) {
+        switch (s) {
+            case MFX_ERR_UNKNOWN:
+            case MFX_ERR_ABORTED:
+            case MFX_ERR_DEVICE_LOST:
+            case MFX_ERR_DEVICE_FAILED:
+            case MFX_ERR_GPU_HANG:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    /// @brief Closes session which was in the session pool
+    static void destroy_session(detail::pooled_session &s) {
+        MFXClose(s.session);
+        #ifdef LIBVA_SUPPORT
+            vaTerminate((VADisplay)s.accelerator_handle);
+            close(s.fd);
+        #endif
+    }
 
     /// @brief Accelerator handle
     void *accelerator_handle;
@@ -269,8 +359,33 @@ protected:
         }
     }
 
+    /// @brief False if session reported errors
+    bool healthy_;
+
+    /// @brief Component which is initialized in the session, component::unknown if none. Stays
+    /// initialized when the session is returned to the session pool.
+    component initialized_;
+    /// @brief Closes the initialized component
+    std::function<mfxStatus(mfxSession)> close_initialized_;
+
+    /// @brief Same as detail::default_checker, but also marks the session as failed.
+    std::function<bool(mfxStatus)> track_errors = [this](mfxStatus s) {
+        if (detail::default_checker(s)) {
+            healthy_ = false;
+            return true;
+        }
+        return false;
+    };
+
 private:
-    mfxLoader loader_;
+    /// @brief Loader shared with other sessions, unloaded with the last one.
+    std::shared_ptr<detail::shared_loader> loader_;
+    /// @brief Pool to return the session to, if any
+    std::shared_ptr<session_pool> pool_;
+    /// @brief Index of the implementation in the loader
+    uint32_t impl_idx_;
+    /// @brief Number of uncaught exceptions when the session was created
+    int uncaught_exceptions_;
 };
 
 /// @brief Manages decoder's sessions.
@@ -288,8 +403,11 @@ public:
             : session(sel, detail::CAPI<>::Decoder),
               bits_(codecID),
               rdr_(rdr),
-              params_() {
+              params_(),
+              in_flight_() {
         component_ = component::decoder;
+        // refills don't move unconsumed data if the platform supports it
+        bits_.use_ring_buffer();
         params_.set_CodecId(codecID);
         params_.clear_extension_buffers();
     }
@@ -304,14 +422,33 @@ public:
             : session(sel, detail::CAPI<>::Decoder),
               bits_((codec_format_fourcc)params.get_CodecId()),
               rdr_(rdr),
-              params_(params) {
+              params_(params),
+              in_flight_() {
         component_ = component::decoder;
+        // refills don't move unconsumed data if the platform supports it
+        bits_.use_ring_buffer();
         params_.clear_extension_buffers();
     }
 
     /// @brief Dtor
     ~decode_session() {}
 
+    /// @brief Sets number of decode operations process() keeps in flight before handing back the oldest future.
+    /// Futures are handed back in decode order. Raises AsyncDepth of the decoder parameters to the same value, so
+    /// call it before init_by_header().
+    /// @param[in] depth Number of operations in flight. 1 (default) hands back every future immediately.
+    void set_async_depth(uint32_t depth) {
+        in_flight_.set_depth(depth);
+        if (params_.get_AsyncDepth() < in_flight_.get_depth())
+            params_.set_AsyncDepth(static_cast<uint16_t>(in_flight_.get_depth()));
+    }
+
+    /// @brief Returns number of decode operations process() keeps in flight.
+    /// @return Number of operations in flight.
+    uint32_t get_async_depth() const {
+        return in_flight_.get_depth();
+    }
+
     /// @brief Initialize the session by using bitream portion. This step can be omitted if the codec ID is known or
     /// we don't need to get SSP or PPS data from the bitstream.
     /// @param[in] decHeaderList List of extension buffers for InitHeader stage. Can be NULL.
@@ -406,11 +543,8 @@ public:
                                 &syncp);
 
         if (surf) {
-            // out_surface = std::make_shared<frame_surface>(surf);
-            // out_surface.reset(new frame_surface(surf));
-            // std::shared_ptr<frame_surface> tmp = std::make_shared<frame_surface>(surf);
-            // out_surface.swap(tmp);
-            out_surface->inject(surf, out_surface.use_count() + 1);
+            // decoder hands out the surface with the reference owned by the application
+            out_surface->adopt(surf);
         }
 
         if (e.sts_ == MFX_ERR_MORE_DATA && state_ == state::Draining) {
@@ -425,7 +559,7 @@ public:
     /// @return Future object with decoded data
     std::shared_ptr<future<std::shared_ptr<frame_surface>>> process(
         decoder_process_list list = {}) {
-        std::shared_ptr<frame_surface> surface = std::make_shared<frame_surface>();
+        std::shared_ptr<frame_surface> surface = detail::make_pooled<frame_surface>();
         std::shared_ptr<future_surface_t> f;
 
         operation_status op(component_, this);
@@ -434,22 +568,22 @@ public:
             try {
                 status schedule_status;
                 schedule_status     = decode_frame(surface, list);
-                f                   = std::make_shared<future_surface_t>(surface);
+                f                   = detail::make_pooled<future_surface_t>(surface);
                 op.schedule_status_ = schedule_status;
             }
             catch (base_exception &e) {
-                f                   = std::make_shared<future_surface_t>(nullptr);
+                f                   = detail::make_pooled<future_surface_t>(nullptr);
                 op.schedule_status_ = mfxstatus_to_onevplstatus(e.get_status());
                 op.fatal_           = true;
             }
         }
         else {
-            f                   = std::make_shared<future_surface_t>(nullptr);
+            f                   = detail::make_pooled<future_surface_t>(nullptr);
             op.schedule_status_ = status::EndOfStreamReached;
         }
 
         f->add_operation(op);
-        return f;
+        return in_flight_.pass(f);
     }
     /// @brief Retrieve decoder statistic
     /// @return Decoder statistic
@@ -476,6 +610,348 @@ protected:
     Reader *rdr_;
     /// @brief Video params
     decoder_video_param params_;
+    /// @brief Futures of the decode operations in flight
+    future_queue<future_surface_t> in_flight_;
+};
+
+/// @brief Manages decode+VPP sessions. One decode call returns the decoded frame together with the frames of
+/// every configured VPP channel, so outputs like the rungs of an ABR ladder don't go through a separate VPP
+/// session. Outputs are indexed by channel ID: 0 is the decoded frame, channels get IDs from 1 in the order they
+/// are added.
+/// @tparam Reader Bitstream reader class
+template <typename Reader>
+class decode_vpp_session
+        : public session<decoder_video_param, decoder_init_reset_list, decoder_init_reset_list> {
+public:
+    /// @brief Futures of one decode call, indexed by channel ID
+    using channel_futures = std::vector<std::shared_ptr<future_surface_t>>;
+
+    /// @brief Constructs decode+VPP session
+    /// @param[in] sel Implementation selector
+    /// @param[in] codecID Codec ID
+    /// @param[in] rdr Bitstream reader
+    decode_vpp_session(const implementation_selector &sel, codec_format_fourcc codecID, Reader *rdr)
+            : session(sel, detail::CAPI<>::DecoderVPP),
+              bits_(codecID),
+              rdr_(rdr),
+              params_(),
+              channels_(),
+              skip_() {
+        component_ = component::decoder_vpp;
+        bits_.use_ring_buffer();
+        params_.set_CodecId(codecID);
+        params_.clear_extension_buffers();
+    }
+
+    /// @brief Constructs decode+VPP session
+    /// @param[in] sel Implementation selector
+    /// @param[in] params Video params of the decoder
+    /// @param[in] rdr Bitstream reader
+    decode_vpp_session(const implementation_selector &sel,
+                       const decoder_video_param &params,
+                       Reader *rdr)
+            : session(sel, detail::CAPI<>::DecoderVPP),
+              bits_((codec_format_fourcc)params.get_CodecId()),
+              rdr_(rdr),
+              params_(params),
+              channels_(),
+              skip_() {
+        component_ = component::decoder_vpp;
+        bits_.use_ring_buffer();
+        params_.clear_extension_buffers();
+    }
+
+    /// @brief Dtor
+    ~decode_vpp_session() {}
+
+    /// @brief Adds VPP channel. Channels are passed to the implementation by Init() and Reset(), so add them
+    /// before initialization. Channel ID of the params is replaced by the one assigned by the session.
+    /// @param[in] channel Channel params
+    /// @param[in] list List of extension buffers of the channel.
+    /// @return ID of the channel
+    uint16_t add_channel(const vpp_channel_param &channel, vpp_init_reset_list list = {}) {
+        uint16_t id = static_cast<uint16_t>(channels_.size() + 1);
+        channels_.push_back({ channel, list });
+        channels_.back().param_.set_ChannelId(id);
+        return id;
+    }
+
+    /// @brief Returns number of VPP channels, not counting the decoder output.
+    /// @return Number of channels
+    uint32_t get_channel_count() const {
+        return static_cast<uint32_t>(channels_.size());
+    }
+
+    /// @brief Stops or resumes output of the channel. Frames of skipped channels are not produced.
+    /// @param[in] id Channel ID
+    /// @param[in] skip True to skip the channel output, false to resume it
+    void skip_channel(uint16_t id, bool skip = true) {
+        auto it = std::find(skip_.begin(), skip_.end(), static_cast<uint32_t>(id));
+        if (skip && it == skip_.end())
+            skip_.push_back(id);
+        else if (!skip && it != skip_.end())
+            skip_.erase(it);
+    }
+
+    /// @brief Returns actual params of the VPP channel.
+    /// @param[in] id Channel ID
+    /// @return Channel params
+    std::shared_ptr<vpp_channel_param> get_channel_param(uint16_t id) {
+        std::shared_ptr<vpp_channel_param> out = std::make_shared<vpp_channel_param>();
+        out->set_ChannelId(id);
+        [[maybe_unused]] detail::c_api_invoker e(detail::default_checker,
+                                MFXVideoDECODE_VPP_GetChannelParam,
+                                session_,
+                                out->getMfx(),
+                                static_cast<mfxU32>(id));
+        return out;
+    }
+
+    /// @brief Initializes the decoder and all added VPP channels.
+    /// @param[in] par Init parameters of the decoder
+    /// @param[in] list List of extension buffers of the decoder.
+    /// @return Status of the initialization.
+    status Init(decoder_video_param *par, decoder_init_reset_list list = {}) {
+        if (list.get_size()) {
+            if (auto [buffers, size] = list.get_raw_ext_buffers(); size) {
+                par->set_extension_buffers(buffers, static_cast<uint16_t>(size));
+            }
+        }
+        std::vector<mfxVideoChannelParam *> channels = get_raw_channels();
+        detail::c_api_invoker e(track_errors,
+                                MFXVideoDECODE_VPP_Init,
+                                session_,
+                                par->getMfx(),
+                                channels.data(),
+                                static_cast<mfxU32>(channels.size()));
+        par->clear_extension_buffers();
+        clear_channel_extension_buffers();
+
+        return mfxstatus_to_onevplstatus(e.sts_);
+    }
+
+    /// @brief Resets the decoder and all added VPP channels.
+    /// @param[in] par Reset parameters of the decoder
+    /// @param[in] list List of extension buffers of the decoder.
+    /// @return Status of the reset.
+    status Reset(decoder_video_param *par, decoder_init_reset_list list) {
+        if (list.get_size()) {
+            if (auto [buffers, size] = list.get_raw_ext_buffers(); size) {
+                par->set_extension_buffers(buffers, static_cast<uint16_t>(size));
+            }
+        }
+        std::vector<mfxVideoChannelParam *> channels = get_raw_channels();
+        detail::c_api_invoker e(track_errors,
+                                MFXVideoDECODE_VPP_Reset,
+                                session_,
+                                par->getMfx(),
+                                channels.data(),
+                                static_cast<mfxU32>(channels.size()));
+        state_ = state::Processing;
+        par->clear_extension_buffers();
+        clear_channel_extension_buffers();
+        return mfxstatus_to_onevplstatus(e.sts_);
+    }
+
+    /// @brief Initialize the session by using bitream portion. Decoder params are taken from the stream
+    /// header, VPP channels must be added before.
+    /// @param[in] decHeaderList List of extension buffers for InitHeader stage. Can be NULL.
+    /// @param[in] initList List of extension buffers for Init stage. Can be NULL.
+    /// @return Ok or warnings
+    status init_by_header(decoder_init_header_list decHeaderList = {},
+                          decoder_init_reset_list initList       = {}) {
+        mfxStatus sts = MFX_ERR_MORE_DATA;
+
+        if (decHeaderList.get_size()) {
+            if (auto [buffers, size] = decHeaderList.get_raw_ext_buffers(); size) {
+                params_.set_extension_buffers(buffers, static_cast<uint16_t>(size));
+            }
+        }
+
+        do {
+            rdr_->get_data(&bits_);
+
+            detail::c_api_invoker e({ [](mfxStatus s) {
+                                        if (s == MFX_ERR_MORE_DATA)
+                                            return false;
+                                        return s < 0;
+                                    } },
+                                    MFXVideoDECODE_VPP_DecodeHeader,
+                                    session_,
+                                    bits_(),
+                                    params_.getMfx());
+            sts = e.sts_;
+        } while (sts == MFX_ERR_MORE_DATA && !rdr_->is_EOS());
+
+        params_.clear_extension_buffers();
+        if (sts != MFX_ERR_NONE && rdr_->is_EOS())
+            return status::EndOfStreamReached;
+        if (sts != MFX_ERR_NONE)
+            return mfxstatus_to_onevplstatus(sts);
+        return Init(&params_, initList);
+    }
+
+    /// @brief Decodes frame and runs all not skipped VPP channels on it.
+    /// @param[out] out_surfaces Output surfaces indexed by channel ID. Channels which have no output on this
+    /// call, get nullptr.
+    /// @param[in] list List of extension buffers to attach to bitstream.
+    /// @return Ok or warning
+    status decode_frame(std::vector<std::shared_ptr<frame_surface>> &out_surfaces,
+                        decoder_process_list list = {}) {
+        mfxSurfaceArray *surfaces = nullptr;
+
+        rdr_->get_data(&bits_);
+
+        mfxBitstream *bts;
+        if (bits_.get_DataLength() == 0 && rdr_->is_EOS()) {
+            bts    = nullptr;
+            state_ = state::Draining;
+        }
+        else {
+            bts = bits_();
+            if (auto [buffers, size] = list.get_raw_ext_buffers(); size) {
+                bts->NumExtParam = static_cast<uint16_t>(size);
+                bts->ExtParam    = buffers;
+            }
+            else {
+                bts->NumExtParam = 0;
+                bts->ExtParam    = nullptr;
+            }
+        }
+
+        detail::c_api_invoker e({ [](mfxStatus s) {
+                                    switch (s) {
+                                        case MFX_ERR_MORE_DATA:
+                                            return false;
+                                        case MFX_ERR_MORE_SURFACE:
+                                            return false;
+                                        default:
+                                            break;
+                                    }
+                                    return s < 0;
+                                } },
+                                MFXVideoDECODE_VPP_DecodeFrameAsync,
+                                session_,
+                                bts,
+                                skip_.empty() ? nullptr : skip_.data(),
+                                static_cast<mfxU32>(skip_.size()),
+                                &surfaces);
+
+        out_surfaces.assign(channels_.size() + 1, nullptr);
+        if (surfaces) {
+            // every surface of the array holds the reference owned by the application, array holds its own one
+            for (mfxU32 i = 0; i < surfaces->NumSurfaces; i++) {
+                mfxFrameSurface1 *surf = surfaces->Surfaces[i];
+                uint16_t id            = surf->Info.ChannelId;
+                if (id < out_surfaces.size() && !out_surfaces[id]) {
+                    out_surfaces[id] = detail::make_pooled<frame_surface>();
+                    out_surfaces[id]->adopt(surf);
+                }
+                else {
+                    surf->FrameInterface->Release(surf);
+                }
+            }
+            surfaces->Release(surfaces);
+        }
+
+        if (e.sts_ == MFX_ERR_MORE_DATA && state_ == state::Draining) {
+            state_ = state::Done;
+            return status::EndOfStreamReached;
+        }
+        return mfxstatus_to_onevplstatus(e.sts_);
+    }
+
+    /// @brief Decodes frame and runs all not skipped VPP channels on it.
+    /// @param[in] list List of extension buffers to attach to bitstream
+    /// @return Future objects indexed by channel ID. Futures of channels which have no output on this call,
+    /// hold nullptr and report NotEnoughData.
+    channel_futures process(decoder_process_list list = {}) {
+        channel_futures futures;
+        std::vector<std::shared_ptr<frame_surface>> surfaces;
+
+        operation_status op(component_, this);
+
+        if (state_ != state::Done) {
+            try {
+                op.schedule_status_ = decode_frame(surfaces, list);
+            }
+            catch (base_exception &e) {
+                op.schedule_status_ = mfxstatus_to_onevplstatus(e.get_status());
+                op.fatal_           = true;
+            }
+        }
+        else {
+            op.schedule_status_ = status::EndOfStreamReached;
+        }
+
+        surfaces.resize(channels_.size() + 1);
+        futures.reserve(surfaces.size());
+        for (auto &surface : surfaces) {
+            std::shared_ptr<future_surface_t> f = detail::make_pooled<future_surface_t>(surface);
+            operation_status channel_op         = op;
+            if (!surface && channel_op.schedule_status_ == status::Ok)
+                channel_op.schedule_status_ = status::NotEnoughData;
+            f->add_operation(channel_op);
+            futures.push_back(f);
+        }
+        return futures;
+    }
+
+    /// @brief Retrieve decoder statistic
+    /// @return Decoder statistic
+    std::shared_ptr<decode_stat> getStat() {
+        std::shared_ptr<decode_stat> out = std::make_shared<decode_stat>();
+        [[maybe_unused]] detail::c_api_invoker e(detail::default_checker,
+                                MFXVideoDECODE_VPP_GetDecodeStat,
+                                session_,
+                                out->get_raw());
+        return out;
+    }
+
+    /// @brief Get video params of the decoder
+    /// @return params
+    decoder_video_param getParams() {
+        return params_;
+    }
+
+protected:
+    /// @brief VPP channel with its extension buffers
+    struct channel {
+        /// @brief Channel params
+        vpp_channel_param param_;
+        /// @brief Extension buffers of the channel
+        vpp_init_reset_list list_;
+    };
+
+    /// @brief Attaches extension buffers to the channel params and returns pointers to raw channel params
+    /// @return Raw channel params
+    std::vector<mfxVideoChannelParam *> get_raw_channels() {
+        std::vector<mfxVideoChannelParam *> raw;
+        raw.reserve(channels_.size());
+        for (auto &c : channels_) {
+            if (auto [buffers, size] = c.list_.get_raw_ext_buffers(); size)
+                c.param_.set_extension_buffers(buffers, static_cast<uint16_t>(size));
+            raw.push_back(c.param_.getMfx());
+        }
+        return raw;
+    }
+
+    /// @brief Detaches extension buffers from the channel params
+    void clear_channel_extension_buffers() {
+        for (auto &c : channels_)
+            c.param_.clear_extension_buffers();
+    }
+
+    /// @brief Bitstream keeper
+    bitstream_as_src bits_;
+    /// @brief Bitstream reader
+    Reader *rdr_;
+    /// @brief Video params of the decoder
+    decoder_video_param params_;
+    /// @brief VPP channels, channel ID is the index + 1
+    std::vector<channel> channels_;
+    /// @brief IDs of the channels to skip
+    std::vector<mfxU32> skip_;
 };
 
 /// @brief Manages encoder's sessions.
@@ -486,7 +962,10 @@ public:
     /// @param[in] sel Implementation selector
     explicit encode_session(const implementation_selector &sel)
             : session(sel, detail::CAPI<>::Encoder),
-              rdr_(nullptr) {
+              rdr_(nullptr),
+              bits_pool_(std::make_shared<bitstream_pool>()),
+              in_flight_(),
+              ctrl_() {
         component_ = component::encoder;
     }
 
@@ -495,12 +974,33 @@ public:
     /// @param[in] rdr Pointer to the raw frame reader
     encode_session(const implementation_selector &sel, frame_source_reader *rdr)
             : session(sel, detail::CAPI<>::Encoder),
-              rdr_(rdr) {
+              rdr_(rdr),
+              bits_pool_(std::make_shared<bitstream_pool>()),
+              in_flight_(),
+              ctrl_() {
         component_ = component::encoder;
     }
 
-    /// @brief Dtor
-    ~encode_session() {}
+    /// @brief Dtor. Waits for the encode operations in flight, so the output buffers aren't freed while the
+    /// encoder still writes into them.
+    ~encode_session() {
+        in_flight_.clear();
+        bits_pool_->sync_in_use();
+    }
+
+    /// @brief Sets number of encode operations process() keeps in flight before handing back the oldest future.
+    /// Futures are handed back in submission order. Set AsyncDepth of the encoder parameters to at least the
+    /// same value, otherwise the runtime may not accept that many operations.
+    /// @param[in] depth Number of operations in flight. 1 (default) hands back every future immediately.
+    void set_async_depth(uint32_t depth) {
+        in_flight_.set_depth(depth);
+    }
+
+    /// @brief Returns number of encode operations process() keeps in flight.
+    /// @return Number of operations in flight.
+    uint32_t get_async_depth() const {
+        return in_flight_.get_depth();
+    }
 
     /// @brief Allocate and return shared pointer to the surface
     /// @todo temporary method
@@ -512,7 +1012,23 @@ public:
                                 session_,
                                 &surface);
 
-        return std::make_shared<frame_surface>(surface);
+        // the runtime hands out the surface with the reference owned by the application
+        std::shared_ptr<frame_surface> input = detail::make_pooled<frame_surface>();
+        input->adopt(surface);
+        return input;
+    }
+
+    /// @brief Takes output bitstream from the session's bitstream pool. The bitstream is returned to the pool
+    /// when the last reference to it is dropped.
+    /// @return Shared pointer to the empty bitstream
+    std::shared_ptr<bitstream_as_dst> alloc_output() {
+        return bits_pool_->acquire();
+    }
+
+    /// @brief Returns counters of the session's bitstream pool.
+    /// @return Bitstream pool counters
+    bitstream_pool_stats get_bitstream_pool_stats() const {
+        return bits_pool_->stats();
     }
 
     /// @brief Temporal method to sync the surface's data.
@@ -538,32 +1054,27 @@ public:
                         encoder_process_list list = {}) {
         mfxSyncPoint sp;
         mfxFrameSurface1 *surf = in_surface.get() ? in_surface.get()->get_raw_ptr() : nullptr;
-        std::shared_ptr<mfxEncodeCtrl> ctrl = nullptr;
-        bool alocated_ctrl                  = false;
+        mfxEncodeCtrl *ctrl    = nullptr;
 
         if (nullptr == surf) {
             state_ = state::Draining;
         }
         if(list.get_size() && list.has_buffer<0>()) {
-            ctrl.reset(list.get_buffer<mfxEncodeCtrl, 0>(), [](mfxEncodeCtrl *p) { p = nullptr; });
-            std::cout << "enc ctrl from the list" << std::endl;
-        } else {
-            ctrl = std::make_shared<mfxEncodeCtrl>();
-            *ctrl = {0};
-            alocated_ctrl = true;
-        }
-        
+            ctrl = list.get_buffer<mfxEncodeCtrl, 0>();
+        }
+
         // Asumption: Encoder will copy-in all extension buffers.
         if (auto [buffers, size] = list.get_raw_ext_buffers(); size) {
-            ctrl->ExtParam = buffers;
-            ctrl->NumExtParam = (mfxU16)size;
-        } else {
-            if (alocated_ctrl) {
-                ctrl.reset();
-            } else {
-                ctrl->ExtParam = 0;
-                ctrl->NumExtParam = 0;
+            if (!ctrl) {
+                // session's own control, so frames with extension buffers don't allocate
+                ctrl_ = {};
+                ctrl  = &ctrl_;
             }
+            ctrl->ExtParam    = buffers;
+            ctrl->NumExtParam = (mfxU16)size;
+        } else if (ctrl) {
+            ctrl->ExtParam    = 0;
+            ctrl->NumExtParam = 0;
         }
         detail::c_api_invoker e({ [](mfxStatus s) {
                                     switch (s) {
@@ -580,7 +1091,7 @@ public:
                                 } },
                                 MFXVideoENCODE_EncodeFrameAsync,
                                 session_,
-                                ctrl.get(),
+                                ctrl,
                                 surf,
                                 (*bs.get())(),
                                 &sp);
@@ -644,7 +1155,7 @@ public:
     std::shared_ptr<future_bitstream_t> process(std::shared_ptr<future_surface_t> in_future,
                                                 encoder_process_list list = {}) {
         std::shared_ptr<bitstream_as_dst> bits;
-        std::shared_ptr<future_bitstream_t> f_out = std::make_shared<future_bitstream_t>(nullptr);
+        std::shared_ptr<future_bitstream_t> f_out;
         operation_status op(component_, this);
 
         /// @todo add smart wait with status propagation
@@ -660,14 +1171,12 @@ public:
                     try {
                         status schedule_status;
 
-                        bits            = std::make_shared<bitstream_as_dst>();
+                        bits            = bits_pool_->acquire();
                         schedule_status = encode_frame(in_surface, bits, list);
-                        f_out           = std::make_shared<future_bitstream_t>(bits);
-                        f_out.reset(new future_bitstream_t(bits));
+                        f_out           = detail::make_pooled<future_bitstream_t>(bits);
                         op.schedule_status_ = schedule_status;
                     }
                     catch (base_exception &e) {
-                        std::cout << "encoder gonna die" << std::endl << std::flush;
                         op.schedule_status_ = mfxstatus_to_onevplstatus(e.get_status());
                         op.fatal_           = true;
                     }
@@ -678,9 +1187,11 @@ public:
             }
         }
 
+        if (!f_out)
+            f_out = detail::make_pooled<future_bitstream_t>(nullptr);
         f_out->add_operation(op);
         f_out->propagate_history(*(in_future.get()));
-        return f_out;
+        return in_flight_.pass(f_out);
     }
 
     /// @brief Retrieve encoder statistic
@@ -698,6 +1209,12 @@ public:
 protected:
     /// @brief Raw freames reader
     frame_source_reader *rdr_;
+    /// @brief Output bitstreams for process()
+    std::shared_ptr<bitstream_pool> bits_pool_;
+    /// @brief Futures of the encode operations in flight
+    future_queue<future_bitstream_t> in_flight_;
+    /// @brief Encode control for frames with extension buffers but without own control
+    mfxEncodeCtrl ctrl_;
 };
 
 /// @brief Manages VPP's sessions.
@@ -734,7 +1251,10 @@ public:
                                 session_,
                                 &surface);
 
-        return std::make_shared<frame_surface>(surface);
+        // the runtime hands out the surface with the reference owned by the application
+        std::shared_ptr<frame_surface> input = detail::make_pooled<frame_surface>();
+        input->adopt(surface);
+        return input;
     }
 
     /// @brief Allocate internal raw surface and attach it to the output surface
@@ -747,7 +1267,10 @@ public:
                                 session_,
                                 &surface);
 
-        out_surface->inject(surface, out_surface.use_count() + 1);
+        // the runtime hands out the surface with the reference owned by the application
+        if (!out_surface)
+            out_surface = detail::make_pooled<frame_surface>();
+        out_surface->adopt(surface);
 
         return;
     }
@@ -861,7 +1384,7 @@ public:
     /// @return Future object with the surface.
     std::shared_ptr<future_surface_t> process(std::shared_ptr<future_surface_t> in_future) {
         std::shared_ptr<frame_surface> surface;
-        std::shared_ptr<future_surface_t> f_out = std::make_shared<future_surface_t>(nullptr);
+        std::shared_ptr<future_surface_t> f_out;
         operation_status op(component_, this);
 
         /// @todo add smart wait with status propagation
@@ -877,7 +1400,7 @@ public:
                     try {
                         status schedule_status;
                         schedule_status = process_frame(in_surface, surface);
-                        f_out.reset(new future_surface_t(surface));
+                        f_out           = detail::make_pooled<future_surface_t>(surface);
                         op.schedule_status_ = schedule_status;
                     }
                     catch (base_exception &e) {
@@ -891,6 +1414,8 @@ public:
             }
         }
 
+        if (!f_out)
+            f_out = detail::make_pooled<future_surface_t>(nullptr);
         f_out->add_operation(op);
         f_out->propagate_history(*(in_future.get()));
 
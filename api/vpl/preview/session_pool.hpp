@@ -0,0 +1,195 @@
+/*############################################################################
+  # Copyright Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "vpl/mfxdispatcher.h"
+#include "vpl/preview/defs.hpp"
+#include "vpl/preview/detail/shared_loader.hpp"
+
+namespace oneapi {
+namespace vpl {
+
+namespace detail {
+
+/// @brief Session handle together with the accelerator handle which was set to it.
+struct pooled_session {
+    /// @brief Session handle
+    mfxSession session;
+    /// @brief Accelerator handle set to the session, owned by the session
+    void *accelerator_handle;
+    /// @brief Accelerator file descriptor
+    int fd;
+    /// @brief Closes the session and frees the accelerator handle
+    void (*destroy)(pooled_session &s);
+    /// @brief Component which is still initialized in the session, component::unknown if none
+    component initialized = component::unknown;
+    /// @brief Closes the initialized component
+    std::function<mfxStatus(mfxSession)> close_component = nullptr;
+};
+
+} // namespace detail
+
+/// @brief Session pool counters.
+struct session_pool_stats {
+    /// @brief Number of sessions taken from the pool.
+    uint64_t hits;
+    /// @brief Number of sessions created because no idle session was available.
+    uint64_t misses;
+    /// @brief Number of sessions closed because of errors.
+    uint64_t evictions;
+    /// @brief Number of healthy sessions closed because the pool was full.
+    uint64_t discards;
+    /// @brief Number of idle sessions in the pool.
+    uint64_t idle;
+};
+
+/// @brief Keeps idle sessions of each implementation for reuse by new sessions.
+/// @details Assign the pool to an implementation selector with
+/// implementation_selector::set_session_pool(). When a session created with that selector is
+/// destroyed, the session handle is returned to the pool instead of being closed, with its component
+/// still initialized. The next session created for the same implementation reuses it, which skips
+/// runtime and device initialization. If it is a session of the same component, its Init() only
+/// resets the component with the new parameters. Sessions which reported errors are closed instead of
+/// returned to the pool, as are idle sessions which fail a health check when taken from the pool.
+class session_pool {
+public:
+    /// @brief Ctor.
+    /// @param[in] max_idle Maximum number of idle sessions kept for each implementation
+    explicit session_pool(uint32_t max_idle = 4) : max_idle_(max_idle), idle_(), stats_(), mutex_() {}
+
+    /// @brief Dtor. Closes all idle sessions.
+    ~session_pool() {
+        clear();
+    }
+
+    session_pool(const session_pool &) = delete;
+    session_pool &operator=(const session_pool &) = delete;
+
+    /// @brief Closes all idle sessions.
+    void clear() {
+        std::map<key, idle_list> idle;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            idle.swap(idle_);
+            stats_.idle = 0;
+        }
+        for (auto &entry : idle) {
+            for (auto &s : entry.second.sessions)
+                s.destroy(s);
+        }
+    }
+
+    /// @brief Returns pool counters.
+    /// @return Pool counters
+    session_pool_stats stats() const {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return stats_;
+    }
+
+    /// @brief Takes idle session of implementation @p idx of the @p loader from the pool.
+    /// @param[in] loader Loader which created the session
+    /// @param[in] idx Implementation index
+    /// @param[out] out Idle session
+    /// @return False if there is no healthy idle session.
+    bool acquire(const std::shared_ptr<detail::shared_loader> &loader,
+                 uint32_t idx,
+                 detail::pooled_session &out) {
+        std::vector<detail::pooled_session> failed;
+        bool found = false;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            auto it = idle_.find(key(loader.get(), idx));
+            while (it != idle_.end() && !it->second.sessions.empty()) {
+                detail::pooled_session s = it->second.sessions.back();
+                it->second.sessions.pop_back();
+                stats_.idle--;
+
+                // session must still be usable
+                mfxIMPL impl  = 0;
+                mfxStatus sts = MFXQueryIMPL(s.session, &impl);
+                if (sts != MFX_ERR_NONE) {
+                    stats_.evictions++;
+                    failed.push_back(s);
+                    continue;
+                }
+
+                out   = s;
+                found = true;
+                break;
+            }
+            if (found)
+                stats_.hits++;
+            else
+                stats_.misses++;
+        }
+        for (auto &s : failed)
+            s.destroy(s);
+
+        return found;
+    }
+
+    /// @brief Returns session of implementation @p idx of the @p loader to the pool.
+    /// @param[in] loader Loader which created the session
+    /// @param[in] idx Implementation index
+    /// @param[in] s Session, its component may still be initialized
+    /// @param[in] healthy False if the session reported errors. Such session is closed.
+    void release(const std::shared_ptr<detail::shared_loader> &loader,
+                 uint32_t idx,
+                 detail::pooled_session s,
+                 bool healthy) {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            if (!healthy) {
+                stats_.evictions++;
+            }
+            else {
+                auto &entry = idle_[key(loader.get(), idx)];
+                if (entry.sessions.size() < max_idle_) {
+                    // keep loader alive as long as its sessions are in the pool
+                    entry.loader = loader;
+                    entry.sessions.push_back(s);
+                    stats_.idle++;
+                    return;
+                }
+                stats_.discards++;
+            }
+        }
+        s.destroy(s);
+    }
+
+protected:
+    /// @brief Idle sessions are kept per loader and implementation index
+    typedef std::pair<const detail::shared_loader *, uint32_t> key;
+
+    /// @brief Idle sessions of one implementation
+    struct idle_list {
+        /// @brief Loader which created the sessions
+        std::shared_ptr<detail::shared_loader> loader;
+        /// @brief Idle sessions
+        std::vector<detail::pooled_session> sessions;
+    };
+
+    /// @brief Maximum number of idle sessions per implementation
+    uint32_t max_idle_;
+    /// @brief Idle sessions
+    std::map<key, idle_list> idle_;
+    /// @brief Counters
+    session_pool_stats stats_;
+    /// @brief Serializes access to the pool
+    mutable std::mutex mutex_;
+};
+
+} // namespace vpl
+} // namespace oneapi
@@ -6,15 +6,29 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
 #include <cstring>
 #include <fstream>
 #include <memory>
 #include <string>
+#include <vector>
+
+#if !defined(_WIN32) && !defined(_WIN64)
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
 
 #include "vpl/preview/bitstream.hpp"
 #include "vpl/preview/defs.hpp"
 #include "vpl/preview/frame_surface.hpp"
 
+#include "vpl/preview/detail/frame_copy.hpp"
+#include "vpl/preview/detail/windows.hpp"
+
 namespace oneapi {
 namespace vpl {
 
@@ -108,6 +122,7 @@ public:
                 auto B = data.get_plane_ptrs_1_BGRA();
 
                 read_blob(B, pitch, width_ * 4, heigth_);
+                break;
             }
             default:
                 throw base_exception("raw_frame_file_reader unsupported format",
@@ -214,6 +229,7 @@ public:
                 auto B = data.get_plane_ptrs_1_BGRA();
 
                 read_blob(B, pitch, width_ * 4, heigth_);
+                break;
             }
             default:
                 throw base_exception("raw_frame_file_reader_by_name unsupported format",
@@ -254,6 +270,226 @@ protected:
     bool eof_;
 };
 
+/// @brief File based reader of uncompressed frames, which reads the whole frame with one call into the staging
+/// buffer and then copies it into the surface, converting the layout where needed.
+/// @details Supported pairs of file format and surface format:
+/// - i420 to i420 or nv12 (U and V planes are interleaved)
+/// - nv12 to nv12
+/// - i010 to p010 (planar 10-bit samples stored in LSBs are interleaved and shifted to MSBs)
+/// - p010 to p010
+/// - yuy2 to yuy2
+/// - bgra to bgra
+class raw_frame_bulk_file_reader : public frame_source_reader {
+public:
+    /// @brief Default ctor
+    /// @param[in] width Width of the frames.
+    /// @param[in] heigth Heigh of the frames.
+    /// @param[in] file_format Color format of the frames in the file.
+    /// @param[in] surface_format Color format of the surfaces to fill.
+    /// @param[in] name Name of the file to read from.
+    raw_frame_bulk_file_reader(uint16_t width,
+                               uint16_t heigth,
+                               color_format_fourcc file_format,
+                               color_format_fourcc surface_format,
+                               const std::string& name)
+            : frame_source_reader(),
+              width_(width),
+              heigth_(heigth),
+              file_format_(file_format),
+              surface_format_(surface_format),
+              frame_size_(0),
+              file_(nullptr),
+              staging_(),
+              eof_(false) {
+        if (!is_supported(file_format, surface_format)) {
+            throw base_exception("raw_frame_bulk_file_reader unsupported format",
+                                 MFX_ERR_NOT_IMPLEMENTED);
+        }
+
+        uint64_t luma   = static_cast<uint64_t>(width_) * heigth_;
+        uint64_t chroma = static_cast<uint64_t>(chroma_width()) * chroma_height();
+        switch (file_format_) {
+            case color_format_fourcc::i420:
+            case color_format_fourcc::nv12:
+                frame_size_ = luma + 2 * chroma;
+                break;
+            case color_format_fourcc::i010:
+            case color_format_fourcc::p010:
+                frame_size_ = 2 * (luma + 2 * chroma);
+                break;
+            case color_format_fourcc::yuy2:
+                frame_size_ = 4 * static_cast<uint64_t>(chroma_width()) * heigth_;
+                break;
+            default:
+                frame_size_ = 4 * luma;
+                break;
+        }
+
+        file_ = std::fopen(name.c_str(), "rb");
+        if (!file_) {
+            throw file_exception(std::string("Couldn't open ") + name);
+        }
+        // frames are read directly into the staging buffer, bypassing stdio buffer
+        std::setvbuf(file_, nullptr, _IONBF, 0);
+
+        staging_.resize(frame_size_ + STAGING_ALIGNMENT - 1);
+    }
+
+    /// @brief Dtor. Closes the file.
+    virtual ~raw_frame_bulk_file_reader() {
+        if (file_)
+            std::fclose(file_);
+    }
+
+    raw_frame_bulk_file_reader(const raw_frame_bulk_file_reader&) = delete;
+    raw_frame_bulk_file_reader& operator=(const raw_frame_bulk_file_reader&) = delete;
+
+    /// @brief Checks whether the pair of formats is supported.
+    /// @param[in] file_format Color format of the frames in the file.
+    /// @param[in] surface_format Color format of the surfaces to fill.
+    /// @return True if supported.
+    static bool is_supported(color_format_fourcc file_format, color_format_fourcc surface_format) {
+        switch (file_format) {
+            case color_format_fourcc::i420:
+                return surface_format == color_format_fourcc::i420 ||
+                       surface_format == color_format_fourcc::nv12;
+            case color_format_fourcc::i010:
+                return surface_format == color_format_fourcc::p010;
+            case color_format_fourcc::nv12:
+            case color_format_fourcc::p010:
+            case color_format_fourcc::yuy2:
+            case color_format_fourcc::bgra:
+                return surface_format == file_format;
+            default:
+                return false;
+        }
+    }
+
+    /// @brief Returns size of the frame in the file.
+    /// @return Size in bytes.
+    uint64_t get_frame_size() const {
+        return frame_size_;
+    }
+
+    /// @brief Reads next frame and stores it into the @p frame object
+    /// @param[out] frame data storage
+    /// @return True if data was read. Incomplete frame at the end of file is not stored.
+    virtual bool get_data(std::shared_ptr<frame_surface> frame) {
+        uint8_t* src = staging();
+        if (std::fread(src, 1, frame_size_, file_) != frame_size_) {
+            eof_ = true;
+            return false;
+        }
+
+        auto data      = frame->map_data(memory_access::write);
+        uint32_t pitch = data.get_pitch();
+        uint32_t w     = width_;
+        uint32_t h     = heigth_;
+        uint32_t cw    = chroma_width();
+        uint32_t ch    = chroma_height();
+        size_t luma    = static_cast<size_t>(w) * h;
+        size_t chroma  = static_cast<size_t>(cw) * ch;
+
+        switch (file_format_) {
+            case color_format_fourcc::i420: {
+                const uint8_t* U = src + luma;
+                const uint8_t* V = U + chroma;
+                if (surface_format_ == color_format_fourcc::nv12) {
+                    auto [Y, UV] = data.get_plane_ptrs_2();
+                    detail::frame_copy::copy_plane(src, w, Y, pitch, w, h);
+                    detail::frame_copy::interleave_uv_8(U, V, cw, UV, pitch, cw, ch);
+                }
+                else {
+                    auto [Y, dstU, dstV] = data.get_plane_ptrs_3();
+                    detail::frame_copy::copy_plane(src, w, Y, pitch, w, h);
+                    detail::frame_copy::copy_plane(U, cw, dstU, pitch / 2, cw, ch);
+                    detail::frame_copy::copy_plane(V, cw, dstV, pitch / 2, cw, ch);
+                }
+                break;
+            }
+            case color_format_fourcc::nv12: {
+                auto [Y, UV] = data.get_plane_ptrs_2();
+                detail::frame_copy::copy_plane(src, w, Y, pitch, w, h);
+                detail::frame_copy::copy_plane(src + luma, 2 * cw, UV, pitch, 2 * cw, ch);
+                break;
+            }
+            case color_format_fourcc::i010: {
+                auto [Y, UV]     = data.get_plane_ptrs_2();
+                const uint8_t* U = src + 2 * luma;
+                const uint8_t* V = U + 2 * chroma;
+                detail::frame_copy::shift_plane_16(src, 2 * w, Y, pitch, w, h, 6);
+                detail::frame_copy::interleave_uv_16(U, V, 2 * cw, UV, pitch, cw, ch, 6);
+                break;
+            }
+            case color_format_fourcc::p010: {
+                auto [Y, UV] = data.get_plane_ptrs_2();
+                detail::frame_copy::copy_plane(src, 2 * w, Y, pitch, 2 * w, h);
+                detail::frame_copy::copy_plane(src + 2 * luma, 4 * cw, UV, pitch, 4 * cw, ch);
+                break;
+            }
+            case color_format_fourcc::yuy2: {
+                auto Y = data.get_plane_ptrs_1();
+                detail::frame_copy::copy_plane(src, 4 * cw, Y, pitch, 4 * cw, h);
+                break;
+            }
+            default: {
+                auto B = data.get_plane_ptrs_1_BGRA();
+                detail::frame_copy::copy_plane(src, 4 * w, B, pitch, 4 * w, h);
+                break;
+            }
+        }
+        frame->unmap();
+        return true;
+    }
+
+    /// @brief Checks and retrieve end of stream status
+    /// @return True if EOS reached
+    bool is_EOS() const {
+        return eof_;
+    }
+
+protected:
+    /// Alignment of the staging buffer, suitable for any SIMD load
+    static constexpr size_t STAGING_ALIGNMENT = 64;
+
+    /// @brief Returns aligned start of the staging buffer.
+    /// @return Pointer to the staging buffer.
+    uint8_t* staging() {
+        uintptr_t p = reinterpret_cast<uintptr_t>(staging_.data());
+        p           = (p + STAGING_ALIGNMENT - 1) & ~(static_cast<uintptr_t>(STAGING_ALIGNMENT) - 1);
+        return reinterpret_cast<uint8_t*>(p);
+    }
+
+    /// @brief Returns width of chroma planes in samples.
+    /// @return Width of chroma planes.
+    uint32_t chroma_width() const {
+        return (static_cast<uint32_t>(width_) + 1) / 2;
+    }
+
+    /// @brief Returns height of chroma planes in rows.
+    /// @return Height of chroma planes.
+    uint32_t chroma_height() const {
+        return (static_cast<uint32_t>(heigth_) + 1) / 2;
+    }
+
+    /// @brief Width of frame.
+    uint16_t width_;
+    /// @brief Height of frame.
+    uint16_t heigth_;
+    /// @brief Color format of frame in the file.
+    color_format_fourcc file_format_;
+    /// @brief Color format of surface.
+    color_format_fourcc surface_format_;
+    /// @brief Size of frame in the file.
+    uint64_t frame_size_;
+    /// @brief File handle.
+    std::FILE* file_;
+    /// @brief Staging buffer for the whole frame.
+    std::vector<uint8_t> staging_;
+    /// @brief End of stream flag.
+    bool eof_;
+};
+
 /// @brief Interface for the bitstream source data reader
 class bitstream_source_reader : public source_reader {
 public:
@@ -340,5 +576,185 @@ protected:
     std::ifstream if_;
 };
 
+/// @brief Memory mapped file based source data reader.
+/// @details The file is mapped into memory and the bitstream is pointed directly to the mapping
+/// (see bitstream_as_src::attach()), so data is not copied. Each call moves the window of valid data to
+/// the first byte not yet consumed. Pages are mapped copy-on-write, so the file is never modified.
+class bitstream_mapped_file_reader : public bitstream_source_reader {
+public:
+    /// Default length of the window of valid data
+    enum window_len : uint32_t { DEFAULT_WINDOW = 16 * 1024 * 1024 };
+
+    /// @brief Maps the file with given name
+    /// @param[in] name File name
+    /// @param[in] window Maximum number of bytes in the bitstream after each call
+    explicit bitstream_mapped_file_reader(const std::string& name,
+                                          uint32_t window = window_len::DEFAULT_WINDOW)
+            : bitstream_source_reader(),
+              data_(nullptr),
+              size_(0),
+              pos_(0),
+              released_(0),
+              advised_(0),
+              window_(window ? window : window_len::DEFAULT_WINDOW),
+              eos_(false) {
+#if defined(_WIN32) || defined(_WIN64)
+        file_    = INVALID_HANDLE_VALUE;
+        mapping_ = nullptr;
+
+        file_ = CreateFileA(name.c_str(),
+                            GENERIC_READ,
+                            FILE_SHARE_READ,
+                            nullptr,
+                            OPEN_EXISTING,
+                            FILE_FLAG_SEQUENTIAL_SCAN,
+                            nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) {
+            throw file_exception(std::string("Couldn't open ") + name);
+        }
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file_, &size)) {
+            close();
+            throw file_exception(std::string("Error opening ") + name);
+        }
+        size_ = static_cast<uint64_t>(size.QuadPart);
+
+        if (size_) {
+            mapping_ = CreateFileMappingA(file_, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+            if (mapping_)
+                data_ = static_cast<uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_COPY, 0, 0, 0));
+            if (!data_) {
+                close();
+                throw file_exception(std::string("Couldn't map ") + name);
+            }
+        }
+#else
+        int fd = open(name.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw file_exception(std::string("Couldn't open ") + name);
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw file_exception(std::string("Error opening ") + name);
+        }
+        size_ = static_cast<uint64_t>(st.st_size);
+
+        if (size_) {
+            void* data = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                ::close(fd);
+                throw file_exception(std::string("Couldn't map ") + name);
+            }
+            data_ = static_cast<uint8_t*>(data);
+
+            // mapping stays valid after the file is closed
+            madvise(data_, size_, MADV_SEQUENTIAL);
+        }
+        ::close(fd);
+#endif
+        eos_ = (size_ == 0);
+    }
+
+    /// @brief Unmaps the file
+    ~bitstream_mapped_file_reader() {
+        close();
+    }
+
+    bitstream_mapped_file_reader(const bitstream_mapped_file_reader&) = delete;
+    bitstream_mapped_file_reader& operator=(const bitstream_mapped_file_reader&) = delete;
+
+    /// @brief Points the @p bitstream object to the next portion of the mapped file
+    /// @param[out] bits data storage
+    /// @return True if data was read
+    bool get_data(bitstream_as_src* bits) {
+        // skip data consumed since the previous call
+        uint8_t* head = bits->get_buffer_ptr();
+        if (bits->is_attached() && data_ && head >= data_ && head <= data_ + size_) {
+            pos_ = static_cast<uint64_t>(head - data_) + bits->get_DataOffset();
+        }
+
+        uint64_t remaining = size_ - pos_;
+        uint32_t length    = (remaining > window_) ? window_ : static_cast<uint32_t>(remaining);
+
+        bits->attach(data_ + pos_, length);
+        eos_ = (pos_ + length == size_);
+
+        advise(pos_ + length);
+        return true;
+    }
+
+    /// @brief Checks and retrieve end of stream status
+    /// @return True if EOS reached
+    bool is_EOS() const {
+        return eos_;
+    }
+
+protected:
+    /// @brief Requests readahead of the window after @p end and releases pages which were consumed
+    /// @param[in] end End of the current window
+    void advise([[maybe_unused]] uint64_t end) {
+#if !defined(_WIN32) && !defined(_WIN64)
+        const uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+
+        // read ahead one window at a time, not on each call
+        if (end < size_ && end + window_ / 2 > advised_) {
+            uint64_t start = (end / page) * page;
+            uint64_t len   = (std::min)(static_cast<uint64_t>(window_), size_ - start);
+            madvise(data_ + start, len, MADV_WILLNEED);
+            advised_ = start + len;
+        }
+
+        // drop mapped pages well behind the current position to keep resident memory bounded
+        uint64_t release_end = (pos_ > window_) ? ((pos_ - window_) / page) * page : 0;
+        if (release_end >= released_ + window_) {
+            madvise(data_ + released_, release_end - released_, MADV_DONTNEED);
+            released_ = release_end;
+        }
+#endif
+    }
+
+    /// @brief Unmaps the file and closes handles
+    void close() {
+#if defined(_WIN32) || defined(_WIN64)
+        if (data_)
+            UnmapViewOfFile(data_);
+        if (mapping_)
+            CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE)
+            CloseHandle(file_);
+        mapping_ = nullptr;
+        file_    = INVALID_HANDLE_VALUE;
+#else
+        if (data_)
+            munmap(data_, size_);
+#endif
+        data_ = nullptr;
+    }
+
+    /// @brief Mapped file
+    uint8_t* data_;
+    /// @brief File size in bytes
+    uint64_t size_;
+    /// @brief Offset of the first byte not consumed yet
+    uint64_t pos_;
+    /// @brief Pages before this offset were released
+    uint64_t released_;
+    /// @brief Readahead was requested up to this offset
+    uint64_t advised_;
+    /// @brief Maximum number of bytes in the bitstream
+    uint32_t window_;
+    /// @brief End of stream flag
+    bool eos_;
+#if defined(_WIN32) || defined(_WIN64)
+    /// @brief File handle
+    HANDLE file_;
+    /// @brief File mapping handle
+    HANDLE mapping_;
+#endif
+};
+
 } // namespace vpl
 } // namespace oneapi
@@ -179,6 +179,7 @@ public:
     DECLARE_MEMBER_ACCESS(frame_info, uint16_t, BitDepthChroma)
     DECLARE_MEMBER_ACCESS(frame_info, uint16_t, Shift)
     DECLARE_MEMBER_ACCESS(frame_info, mfxFrameId, FrameId)
+    DECLARE_MEMBER_ACCESS(frame_info, uint16_t, ChannelId)
 
     /// @brief Returns color format fourCC value.
     /// @return color format fourCC value.
@@ -824,5 +825,123 @@ inline std::ostream &operator<<(std::ostream &out, const vpp_video_param &vpp) {
     return out;
 }
 
+/// @brief Holds params of one VPP channel of the decode+VPP session.
+class vpp_channel_param {
+public:
+    /// @brief Constructs params and initialize them with default values.
+    vpp_channel_param() : param_() {}
+
+    /// @brief Constructs params with the given output frame info.
+    /// @param[in] info Output frame info of the channel.
+    explicit vpp_channel_param(frame_info info) : param_() {
+        param_.VPP = info();
+    }
+
+    /// @brief Copy ctor.
+    /// @param[in] other another object to use as data source
+    vpp_channel_param(const vpp_channel_param &other) : param_(other.param_) {
+        clear_extension_buffers();
+    }
+
+    /// @brief Copy operator.
+    /// @param[in] other another object to use as data source
+    /// @returns Reference to this object
+    vpp_channel_param &operator=(const vpp_channel_param &other) {
+        param_ = other.param_;
+        clear_extension_buffers();
+        return *this;
+    }
+
+public:
+    /// @brief Returns pointer to raw data
+    /// @return Pointer to raw data
+    mfxVideoChannelParam *getMfx() {
+        return &param_;
+    }
+
+    DECLARE_MEMBER_ACCESS(vpp_channel_param, uint16_t, Protected)
+
+    /// @brief Returns output frame info of the channel.
+    /// @return Output frame info.
+    frame_info get_frame_info() const {
+        return frame_info(param_.VPP);
+    }
+
+    /// @brief Sets output frame info of the channel.
+    /// @param[in] info Output frame info.
+    /// @return Reference to this object
+    vpp_channel_param &set_frame_info(frame_info info) {
+        param_.VPP = info();
+        return *this;
+    }
+
+    /// @brief Returns channel ID.
+    /// @return Channel ID.
+    uint16_t get_ChannelId() const {
+        return param_.VPP.ChannelId;
+    }
+
+    /// @brief Sets channel ID.
+    /// @param[in] id Channel ID.
+    /// @return Reference to this object
+    vpp_channel_param &set_ChannelId(uint16_t id) {
+        param_.VPP.ChannelId = id;
+        return *this;
+    }
+
+    /// @brief Returns i/o memory pattern value.
+    /// @return i/o memory pattern value.
+    io_pattern get_IOPattern() const {
+        return (io_pattern)param_.IOPattern;
+    }
+
+    /// @brief Sets i/o memory pattern value.
+    /// @param[in] IOPattern i/o memory pattern.
+    /// @return Reference to this object
+    vpp_channel_param &set_IOPattern(io_pattern IOPattern) {
+        param_.IOPattern = (uint16_t)IOPattern;
+        return *this;
+    }
+
+    /// @brief Attaches extension buffers to the channel params
+    /// @param[in] buffer Array of extension buffers
+    /// @param[in] num Number of extension buffers
+    /// @return Reference to this object
+    vpp_channel_param &set_extension_buffers(mfxExtBuffer **buffer, uint16_t num) {
+        param_.ExtParam    = buffer;
+        param_.NumExtParam = num;
+        return *this;
+    }
+
+    /// @brief Clear extension buffers from the channel params
+    /// @return Reference to this object
+    vpp_channel_param &clear_extension_buffers() {
+        param_.ExtParam    = nullptr;
+        param_.NumExtParam = 0;
+        return *this;
+    }
+
+    /// @brief Friend operator to print out state of the class in human readable form.
+    /// @param[inout] out Reference to the stream to write.
+    /// @param[in] c Reference to the vpp_channel_param instance to dump the state.
+    /// @return Reference to the stream.
+    friend std::ostream &operator<<(std::ostream &out, const vpp_channel_param &c);
+
+protected:
+    /// @brief Raw data
+    mfxVideoChannelParam param_;
+};
+
+inline std::ostream &operator<<(std::ostream &out, const vpp_channel_param &c) {
+    out << "Channel:" << std::endl;
+    out << detail::space(detail::INTENT, out, "ChannelId  = ") << c.param_.VPP.ChannelId << std::endl;
+    out << detail::space(detail::INTENT, out, "Protected  = ") << c.param_.Protected << std::endl;
+    out << detail::space(detail::INTENT, out, "IOPattern  = ")
+        << detail::IOPattern2String(c.param_.IOPattern) << std::endl;
+    out << "Output FrameInfo:" << std::endl;
+    out << frame_info(c.param_.VPP) << std::endl;
+    return out;
+}
+
 } // namespace vpl
 } // namespace oneapi
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "vpl/preview/bitstream.hpp"
+#include "vpl/preview/bitstream_pool.hpp"
 #include "vpl/preview/defs.hpp"
 #include "vpl/preview/exception.hpp"
 #include "vpl/preview/extension_buffer.hpp"
@@ -18,7 +19,9 @@
 #include "vpl/preview/options.hpp"
 #include "vpl/preview/option_tree.hpp"
 #include "vpl/preview/payload.hpp"
+#include "vpl/preview/pipeline.hpp"
 #include "vpl/preview/session.hpp"
+#include "vpl/preview/session_pool.hpp"
 #include "vpl/preview/source_reader.hpp"
 #include "vpl/preview/stat.hpp"
 #include "vpl/preview/video_param.hpp"
@@ -0,0 +1,583 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include "vpl/mfx.h"
+
+#include "src/components.h"
+
+// reference counters of all surfaces are protected by one lock, the stub RT is not about speed
+static std::mutex g_surfaceMutex;
+
+// NV12 surface in system memory from the internal pool of a component
+struct StubSurface {
+    explicit StubSurface(const mfxFrameInfo &info)
+            : surface(),
+              iface(),
+              refCounter(0),
+              orphan(false),
+              data((size_t)info.Width * info.Height * 3 / 2) {
+        iface.Context       = this;
+        iface.Version.Major = 1;
+        iface.Version.Minor = 0;
+        iface.AddRef        = AddRef;
+        iface.Release       = Release;
+        iface.GetRefCounter = GetRefCounter;
+        iface.Map           = Map;
+        iface.Unmap         = Unmap;
+        iface.Synchronize   = Synchronize;
+
+        surface.FrameInterface = &iface;
+        surface.Version.Major  = 1;
+        surface.Version.Minor  = 1;
+        surface.Info           = info;
+        surface.Data.PitchLow  = info.Width;
+        surface.Data.Y         = data.data();
+        surface.Data.UV        = data.data() + (size_t)info.Width * info.Height;
+    }
+
+    static StubSurface *Self(mfxFrameSurface1 *surface) {
+        if (!surface || !surface->FrameInterface)
+            return nullptr;
+        return (StubSurface *)surface->FrameInterface->Context;
+    }
+
+    static mfxStatus MFX_CDECL AddRef(mfxFrameSurface1 *surface) {
+        StubSurface *self = Self(surface);
+        if (!self)
+            return MFX_ERR_NULL_PTR;
+
+        std::lock_guard<std::mutex> lock(g_surfaceMutex);
+        self->refCounter++;
+        return MFX_ERR_NONE;
+    }
+
+    static mfxStatus MFX_CDECL Release(mfxFrameSurface1 *surface) {
+        StubSurface *self = Self(surface);
+        if (!self)
+            return MFX_ERR_NULL_PTR;
+
+        std::lock_guard<std::mutex> lock(g_surfaceMutex);
+        if (self->refCounter == 0)
+            return MFX_ERR_UNDEFINED_BEHAVIOR;
+
+        self->refCounter--;
+        // pool of a closed component left the surface to the last reference
+        if (self->refCounter == 0 && self->orphan)
+            delete self;
+        return MFX_ERR_NONE;
+    }
+
+    static mfxStatus MFX_CDECL GetRefCounter(mfxFrameSurface1 *surface, mfxU32 *counter) {
+        StubSurface *self = Self(surface);
+        if (!self || !counter)
+            return MFX_ERR_NULL_PTR;
+
+        std::lock_guard<std::mutex> lock(g_surfaceMutex);
+        *counter = self->refCounter;
+        return MFX_ERR_NONE;
+    }
+
+    static mfxStatus MFX_CDECL Map(mfxFrameSurface1 *surface, mfxU32 flags) {
+        return Self(surface) ? MFX_ERR_NONE : MFX_ERR_NULL_PTR;
+    }
+
+    static mfxStatus MFX_CDECL Unmap(mfxFrameSurface1 *surface) {
+        return Self(surface) ? MFX_ERR_NONE : MFX_ERR_NULL_PTR;
+    }
+
+    // components run synchronously, so the data is always ready
+    static mfxStatus MFX_CDECL Synchronize(mfxFrameSurface1 *surface, mfxU32 wait) {
+        return Self(surface) ? MFX_ERR_NONE : MFX_ERR_NULL_PTR;
+    }
+
+    mfxFrameSurface1 surface;
+    mfxFrameSurfaceInterface iface;
+    mfxU32 refCounter;
+    bool orphan;
+    std::vector<mfxU8> data;
+};
+
+// surfaces are reused once the application releases all references
+class StubSurfacePool {
+public:
+    explicit StubSurfacePool(const mfxFrameInfo &info) : m_info(info), m_surfaces() {}
+
+    ~StubSurfacePool() {
+        std::lock_guard<std::mutex> lock(g_surfaceMutex);
+        for (StubSurface *s : m_surfaces) {
+            if (s->refCounter)
+                s->orphan = true;
+            else
+                delete s;
+        }
+    }
+
+    // surface is returned with one reference owned by the caller
+    mfxStatus GetSurface(mfxFrameSurface1 **surface) {
+        if (!surface)
+            return MFX_ERR_NULL_PTR;
+
+        std::lock_guard<std::mutex> lock(g_surfaceMutex);
+        StubSurface *free = nullptr;
+        for (StubSurface *s : m_surfaces) {
+            if (s->refCounter == 0) {
+                free = s;
+                break;
+            }
+        }
+        if (!free) {
+            free = new StubSurface(m_info);
+            m_surfaces.push_back(free);
+        }
+
+        free->refCounter              = 1;
+        free->surface.Data.TimeStamp  = 0;
+        free->surface.Data.FrameOrder = 0;
+        *surface                      = &free->surface;
+        return MFX_ERR_NONE;
+    }
+
+    const mfxFrameInfo &GetInfo() const {
+        return m_info;
+    }
+
+private:
+    mfxFrameInfo m_info;
+    std::vector<StubSurface *> m_surfaces;
+};
+
+struct StubSession {
+    StubSession()
+            : decPar(),
+              decPool(),
+              decFrames(0),
+              vppPar(),
+              vppInPool(),
+              vppOutPool(),
+              encPar(),
+              encPool(),
+              encHeld(nullptr),
+              lastSyncPoint(0) {}
+
+    ~StubSession() {
+        if (encHeld)
+            encHeld->FrameInterface->Release(encHeld);
+    }
+
+    mfxSyncPoint NewSyncPoint() {
+        return (mfxSyncPoint)(uintptr_t)(++lastSyncPoint);
+    }
+
+    mfxVideoParam decPar;
+    std::unique_ptr<StubSurfacePool> decPool;
+    mfxU32 decFrames;
+
+    mfxVideoParam vppPar;
+    std::unique_ptr<StubSurfacePool> vppInPool;
+    std::unique_ptr<StubSurfacePool> vppOutPool;
+
+    mfxVideoParam encPar;
+    std::unique_ptr<StubSurfacePool> encPool;
+    mfxFrameSurface1 *encHeld; // input frame which is not encoded yet
+
+    uintptr_t lastSyncPoint;
+};
+
+static std::mutex g_sessionMutex;
+static std::set<StubSession *> g_sessions;
+
+mfxSession CreateStubSession() {
+    StubSession *s = new StubSession();
+
+    std::lock_guard<std::mutex> lock(g_sessionMutex);
+    g_sessions.insert(s);
+    return (mfxSession)s;
+}
+
+bool CloseStubSession(mfxSession session) {
+    StubSession *s = (StubSession *)session;
+    {
+        std::lock_guard<std::mutex> lock(g_sessionMutex);
+        if (!g_sessions.erase(s))
+            return false;
+    }
+    delete s;
+    return true;
+}
+
+bool IsStubSession(mfxSession session) {
+    std::lock_guard<std::mutex> lock(g_sessionMutex);
+    return g_sessions.count((StubSession *)session) != 0;
+}
+
+// sessions created with MFXInitEx() don't have components
+static StubSession *GetStubSession(mfxSession session) {
+    return IsStubSession(session) ? (StubSession *)session : nullptr;
+}
+
+static bool IsValidFrameInfo(const mfxFrameInfo &info) {
+    return info.Width && info.Height && info.FourCC == MFX_FOURCC_NV12;
+}
+
+// returns parameters without the application's extension buffers
+static mfxVideoParam StoreParams(const mfxVideoParam *par) {
+    mfxVideoParam stored = *par;
+    stored.ExtParam      = nullptr;
+    stored.NumExtParam   = 0;
+    return stored;
+}
+
+static void LoadParams(const mfxVideoParam &stored, mfxVideoParam *par) {
+    mfxExtBuffer **extParam = par->ExtParam;
+    mfxU16 numExtParam      = par->NumExtParam;
+    *par                    = stored;
+    par->ExtParam           = extParam;
+    par->NumExtParam        = numExtParam;
+}
+
+mfxStatus MFXVideoCORE_SyncOperation(mfxSession session, mfxSyncPoint syncp, mfxU32 wait) {
+    StubSession *s = GetStubSession(session);
+    if (!s)
+        return MFX_ERR_NOT_IMPLEMENTED;
+    if (!syncp)
+        return MFX_ERR_NULL_PTR;
+
+    // components run synchronously, so all operations are complete
+    return MFX_ERR_NONE;
+}
+
+mfxStatus MFXVideoDECODE_DecodeHeader(mfxSession session, mfxBitstream *bs, mfxVideoParam *par) {
+    StubSession *s = GetStubSession(session);
+    if (!s)
+        return MFX_ERR_NOT_IMPLEMENTED;
+    if (!bs || !par)
+        return MFX_ERR_NULL_PTR;
+    if (bs->DataLength == 0)
+        return MFX_ERR_MORE_DATA;
+
+    // stub streams have no headers, every stream has the same frame size
+    mfxFrameInfo &info  = par->mfx.FrameInfo;
+    info.FourCC         = MFX_FOURCC_NV12;
+    info.ChromaFormat   = MFX_CHROMAFORMAT_YUV420;
+    info.BitDepthLuma   = 8;
+    info.BitDepthChroma = 8;
+    info.Width          = STUB_DEC_WIDTH;
+    info.Height         = STUB_DEC_HEIGHT;
+    info.CropX          = 0;
+    info.CropY          = 0;
+    info.CropW          = STUB_DEC_WIDTH;
+    info.CropH          = STUB_DEC_HEIGHT;
+    info.FrameRateExtN  = 30;
+    info.FrameRateExtD  = 1;
+    info.PicStruct      = MFX_PICSTRUCT_PROGRESSIVE;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus MFXVideoDECODE_Init(mfxSession session, mfxVideoParam *par) {
+    StubSession *s = GetStubSession(session);
+    if (!s)
+        return MFX_ERR_NOT_IMPLEMENTED;
+    if (!par)
+        return MFX_ERR_NULL_PTR;
+    if (s->decPool)
+        return MFX_ERR_UNDEFINED_BEHAVIOR;
+    if (!IsValidFrameInfo(par->mfx.FrameInfo))
+        return MFX_ERR_INVALID_VIDEO_PARAM;
+
+    s->decPar    = StoreParams(par);
+    s->decFrames = 0;
+    s->decPool.reset(new StubSurfacePool(par->mfx.FrameInfo));
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus MFXVideoDECODE_Close(mfxSession session) {
+    StubSession *s = GetStubSession(session);
+    if (!s)
+        return MFX_ERR_NOT_IMPLEMENTED;
+    if (!s->decPool)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    s->decPool.reset();
+    return MFX_ERR_NONE;
+}
+
+mfxStatus MFXVideoDECODE_GetVideoParam(mfxSession session, mfxVideoParam *par) {
+    StubSession *s = GetStubSession(session);
+    if (!s)
+        return MFX_ERR_NOT_IMPLEMENTED;
+    if (!par)
+        return MFX_ERR_NULL_PTR;
+    if (!s->decPool)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    LoadParams(s->decPar, par);
+    return MFX_ERR_NONE;
+}
+
+mfxStatus MFXVideoDECODE_DecodeFrameAsync(mfxSession session,
+                                          mfxBitstream *bs,
+                                          mfxFrameSurface1 *surface_work,
+                                          mfxFrameSurface1 **surface_out,
+                                          mfxSyncPoint *syncp) {
+    StubSession *s = GetStubSession(session);
+    if (!s)
+        return MFX_ERR_NOT_IMPLEMENTED;
+    if (!surface_out || !syncp)
+        return MFX_ERR_NULL_PTR;
+    if (!s->decPool)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    // only internal memory is supported
+    if (surface_work)
+        return MFX_ERR_UNSUPPORTED;
+
+    // nothing is buffered, so draining is done at once
+    if (!bs || bs->DataLength == 0)
+        return MFX_ERR_MORE_DATA;
+
+    mfxU32 frameSize = (bs->DataLength < STUB_DEC_FRAME_SIZE) ? bs->DataLength : STUB_DEC_FRAME_SIZE;
+
+    mfxStatus sts = s->decPool->GetSurface(surface_out);
+    if (sts != MFX_ERR_NONE)
+        return sts;
+
+    bs->DataOffset += frameSize;
+    bs->DataLength -= frameSize;
+
+    (*surface_out)->Data.TimeStamp  = bs->TimeStamp;
+    (*surface_out)->Data.FrameOrder = s->decFrames++;
+    *syncp                          = s->NewSyncPoint();
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus MFXVideoENCODE_Init(mfxSession session, mfxVideoParam *par) {
+    StubSession *s = GetStubSession(session);
+    if (!s)
+        return MFX_ERR_NOT_IMPLEMENTED;
+    if (!par)
+        return MFX_ERR_NULL_PTR;
+    if (s->encPool)
+        return MFX_ERR_UNDEFINED_BEHAVIOR;
+    if (!IsValidFrameInfo(par->mfx.FrameInfo))
+        return MFX_ERR_INVALID_VIDEO_PARAM;
+
+    s->encPar = StoreParams(par);
+    s->encPool.reset(new StubSurfacePool(par->mfx.FrameInfo));
+
+    return MFX_ERR_NONE;
+}
+
+// frames of the new size must fit in the surfaces of the pool, like in a real encoder
+mfxStatus MFXVideoENCODE_Reset(mfxSession session, mfxVideoParam *par) {
+    StubSession *s = GetStubSession(session);
+    if (!s)
+        return MFX_ERR_NOT_IMPLEMENTED;
+    if (!par)
+        return MFX_ERR_NULL_PTR;
+    if (!s->encPool)
+        return MFX_ERR_NOT_INITIALIZED;
+    if (!IsValidFrameInfo(par->mfx.FrameInfo))
+        return MFX_ERR_INVALID_VIDEO_PARAM;
+    if (par->mfx.FrameInfo.Width > s->encPool->GetInfo().Width ||
+        par->mfx.FrameInfo.Height > s->encPool->GetInfo().Height)
+        return MFX_ERR_INCOMPATIBLE_VIDEO_PARAM;
+
+    s->encPar = StoreParams(par);
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus MFXVideoENCODE_Close(mfxSession session) {
+    StubSession *s = GetStubSession(session);
+    if (!s)
+        return MFX_ERR_NOT_IMPLEMENTED;
+    if (!s->encPool)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    if (s->encHeld) {
+        s->encHeld->FrameInterface->Release(s->encHeld);
+        s->encHeld = nullptr;
+    }
+    s->encPool.reset();
+    return MFX_ERR_NONE;
+}
+
+mfxStatus MFXVideoENCODE_GetVideoParam(mfxSession session, mfxVideoParam *par) {
+    StubSession *s = GetStubSession(session);
+    if (!s)
+        return MFX_ERR_NOT_IMPLEMENTED;
+    if (!par)
+        return MFX_ERR_NULL_PTR;
+    if (!s->encPool)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    LoadParams(s->encPar, par);
+    return MFX_ERR_NONE;
+}
+
+mfxStatus MFXVideoENCODE_EncodeFrameAsync(mfxSession session,
+                                          mfxEncodeCtrl *ctrl,
+                                          mfxFrameSurface1 *surface,
+                                          mfxBitstream *bs,
+                                          mfxSyncPoint *syncp) {
+    StubSession *s = GetStubSession(session);
+    if (!s)
+        return MFX_ERR_NOT_IMPLEMENTED;
+    if (!bs || !syncp)
+        return MFX_ERR_NULL_PTR;
+    if (!s->encPool)
+        return MFX_ERR_NOT_INITIALIZED;
+    if (surface && !surface->FrameInterface)
+        return MFX_ERR_UNSUPPORTED;
+
+    // the first frame is kept, so there is one frame of delay like with B-frames
+    if (!s->encHeld) {
+        if (surface) {
+            surface->FrameInterface->AddRef(surface);
+            s->encHeld = surface;
+        }
+        return MFX_ERR_MORE_DATA;
+    }
+
+    if ((mfxU64)bs->DataOffset + bs->DataLength + STUB_ENC_FRAME_SIZE > bs->MaxLength || !bs->Data)
+        return MFX_ERR_NOT_ENOUGH_BUFFER;
+
+    memset(bs->Data + bs->DataOffset + bs->DataLength,
+           (mfxU8)s->encHeld->Data.FrameOrder,
+           STUB_ENC_FRAME_SIZE);
+    bs->DataLength += STUB_ENC_FRAME_SIZE;
+    bs->TimeStamp = s->encHeld->Data.TimeStamp;
+    bs->FrameType = MFX_FRAMETYPE_I;
+
+    s->encHeld->FrameInterface->Release(s->encHeld);
+    s->encHeld = nullptr;
+    if (surface) {
+        surface->FrameInterface->AddRef(surface);
+        s->encHeld = surface;
+    }
+    *syncp = s->NewSyncPoint();
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus MFXVideoVPP_Init(mfxSession session, mfxVideoParam *par) {
+    StubSession *s = GetStubSession(session);
+    if (!s)
+        return MFX_ERR_NOT_IMPLEMENTED;
+    if (!par)
+        return MFX_ERR_NULL_PTR;
+    if (s->vppInPool)
+        return MFX_ERR_UNDEFINED_BEHAVIOR;
+    if (!IsValidFrameInfo(par->vpp.In) || !IsValidFrameInfo(par->vpp.Out))
+        return MFX_ERR_INVALID_VIDEO_PARAM;
+
+    s->vppPar = StoreParams(par);
+    s->vppInPool.reset(new StubSurfacePool(par->vpp.In));
+    s->vppOutPool.reset(new StubSurfacePool(par->vpp.Out));
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus MFXVideoVPP_Close(mfxSession session) {
+    StubSession *s = GetStubSession(session);
+    if (!s)
+        return MFX_ERR_NOT_IMPLEMENTED;
+    if (!s->vppInPool)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    s->vppInPool.reset();
+    s->vppOutPool.reset();
+    return MFX_ERR_NONE;
+}
+
+mfxStatus MFXVideoVPP_GetVideoParam(mfxSession session, mfxVideoParam *par) {
+    StubSession *s = GetStubSession(session);
+    if (!s)
+        return MFX_ERR_NOT_IMPLEMENTED;
+    if (!par)
+        return MFX_ERR_NULL_PTR;
+    if (!s->vppInPool)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    LoadParams(s->vppPar, par);
+    return MFX_ERR_NONE;
+}
+
+mfxStatus MFXVideoVPP_RunFrameVPPAsync(mfxSession session,
+                                       mfxFrameSurface1 *in,
+                                       mfxFrameSurface1 *out,
+                                       mfxExtVppAuxData *aux,
+                                       mfxSyncPoint *syncp) {
+    StubSession *s = GetStubSession(session);
+    if (!s)
+        return MFX_ERR_NOT_IMPLEMENTED;
+    if (!out || !syncp)
+        return MFX_ERR_NULL_PTR;
+    if (!s->vppInPool)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    // nothing is buffered, so draining is done at once
+    if (!in)
+        return MFX_ERR_MORE_DATA;
+
+    out->Data.TimeStamp  = in->Data.TimeStamp;
+    out->Data.FrameOrder = in->Data.FrameOrder;
+    *syncp               = s->NewSyncPoint();
+
+    return MFX_ERR_NONE;
+}
+
+// memory functions are associated with initialized session
+mfxStatus MFXMemory_GetSurfaceForVPP(mfxSession session, mfxFrameSurface1 **surface) {
+    StubSession *s = GetStubSession(session);
+    if (!s)
+        return MFX_ERR_NOT_IMPLEMENTED;
+    if (!s->vppInPool)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    return s->vppInPool->GetSurface(surface);
+}
+
+mfxStatus MFXMemory_GetSurfaceForVPPOut(mfxSession session, mfxFrameSurface1 **surface) {
+    StubSession *s = GetStubSession(session);
+    if (!s)
+        return MFX_ERR_NOT_IMPLEMENTED;
+    if (!s->vppOutPool)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    return s->vppOutPool->GetSurface(surface);
+}
+
+mfxStatus MFXMemory_GetSurfaceForEncode(mfxSession session, mfxFrameSurface1 **surface) {
+    StubSession *s = GetStubSession(session);
+    if (!s)
+        return MFX_ERR_NOT_IMPLEMENTED;
+    if (!s->encPool)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    return s->encPool->GetSurface(surface);
+}
+
+mfxStatus MFXMemory_GetSurfaceForDecode(mfxSession session, mfxFrameSurface1 **surface) {
+    StubSession *s = GetStubSession(session);
+    if (!s)
+        return MFX_ERR_NOT_IMPLEMENTED;
+    if (!s->decPool)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    return s->decPool->GetSurface(surface);
+}
@@ -0,0 +1,32 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef DISPATCHER_TEST_RUNTIMES_STUB_SRC_COMPONENTS_H_
+#define DISPATCHER_TEST_RUNTIMES_STUB_SRC_COMPONENTS_H_
+
+#include "vpl/mfxvideo.h"
+
+// sessions created with MFXInitialize() have decoder, VPP and encoder which don't process
+//   any pixels, but hand out internal surfaces and sync points like a real 2.x RT does,
+//   so applications can run their pipelines on top of the stub RT
+//
+// stub decoder takes up to STUB_DEC_FRAME_SIZE bytes of the bitstream per frame
+// stub encoder keeps one frame before it starts to write STUB_ENC_FRAME_SIZE bytes per frame
+#define STUB_DEC_FRAME_SIZE 1024
+#define STUB_ENC_FRAME_SIZE 100
+
+// frame size reported by the stub decoder's DecodeHeader
+#define STUB_DEC_WIDTH  352
+#define STUB_DEC_HEIGHT 288
+
+mfxSession CreateStubSession();
+
+// returns false if session was not created with CreateStubSession()
+bool CloseStubSession(mfxSession session);
+
+bool IsStubSession(mfxSession session);
+
+#endif // DISPATCHER_TEST_RUNTIMES_STUB_SRC_COMPONENTS_H_
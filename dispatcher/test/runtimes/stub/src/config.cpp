@@ -10,6 +10,7 @@
 #include "vpl/mfx.h"
 
 #include "src/caps.h"
+#include "src/components.h"
 
 // the auto-generated capabilities structs
 // only include one time in this library
@@ -129,7 +130,8 @@ mfxStatus MFXInitialize(mfxInitializationParam par, mfxSession *session) {
     }
 #endif
 
-    *session = (mfxSession)DEFAULT_SESSION_HANDLE_2X;
+    // each 2.x session has its own components
+    *session = CreateStubSession();
 
     return MFX_ERR_NONE;
 }
@@ -176,7 +178,7 @@ mfxStatus MFXCloneSession(mfxSession session, mfxSession *clone) {
         return MFX_ERR_INVALID_HANDLE;
 
     mfxU64 s = (mfxU64)session;
-    if (s != DEFAULT_SESSION_HANDLE_1X && s != DEFAULT_SESSION_HANDLE_2X)
+    if (s != DEFAULT_SESSION_HANDLE_1X && s != DEFAULT_SESSION_HANDLE_2X && !IsStubSession(session))
         return MFX_ERR_INVALID_HANDLE;
 
     *clone = (mfxSession)DEFAULT_CLONE_SESSION_HANDLE;
@@ -199,6 +201,9 @@ mfxStatus MFXClose(mfxSession session) {
     if (!session)
         return MFX_ERR_INVALID_HANDLE;
 
+    if (CloseStubSession(session))
+        return MFX_ERR_NONE;
+
     mfxU64 s = (mfxU64)session;
     if (s != DEFAULT_SESSION_HANDLE_1X && s != DEFAULT_SESSION_HANDLE_2X &&
         s != DEFAULT_CLONE_SESSION_HANDLE)
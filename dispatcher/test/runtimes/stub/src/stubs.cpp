@@ -38,14 +38,6 @@ mfxStatus MFXVideoCORE_QueryPlatform(mfxSession session, mfxPlatform *platform)
     return MFX_ERR_NOT_IMPLEMENTED;
 }
 
-mfxStatus MFXVideoCORE_SyncOperation(mfxSession session, mfxSyncPoint syncp, mfxU32 wait) {
-    return MFX_ERR_NOT_IMPLEMENTED;
-}
-
-mfxStatus MFXVideoDECODE_DecodeHeader(mfxSession session, mfxBitstream *bs, mfxVideoParam *par) {
-    return MFX_ERR_NOT_IMPLEMENTED;
-}
-
 mfxStatus MFXVideoDECODE_Query(mfxSession session, mfxVideoParam *in, mfxVideoParam *out) {
     return MFX_ERR_NOT_IMPLEMENTED;
 }
@@ -56,26 +48,6 @@ mfxStatus MFXVideoDECODE_QueryIOSurf(mfxSession session,
     return MFX_ERR_NOT_IMPLEMENTED;
 }
 
-mfxStatus MFXVideoDECODE_Init(mfxSession session, mfxVideoParam *par) {
-    return MFX_ERR_NOT_IMPLEMENTED;
-}
-
-mfxStatus MFXVideoDECODE_Close(mfxSession session) {
-    return MFX_ERR_NOT_IMPLEMENTED;
-}
-
-mfxStatus MFXVideoDECODE_DecodeFrameAsync(mfxSession session,
-                                          mfxBitstream *bs,
-                                          mfxFrameSurface1 *surface_work,
-                                          mfxFrameSurface1 **surface_out,
-                                          mfxSyncPoint *syncp) {
-    return MFX_ERR_NOT_IMPLEMENTED;
-}
-
-mfxStatus MFXVideoDECODE_GetVideoParam(mfxSession session, mfxVideoParam *par) {
-    return MFX_ERR_NOT_IMPLEMENTED;
-}
-
 mfxStatus MFXVideoDECODE_Reset(mfxSession session, mfxVideoParam *par) {
     return MFX_ERR_NOT_IMPLEMENTED;
 }
@@ -134,30 +106,6 @@ mfxStatus MFXVideoENCODE_QueryIOSurf(mfxSession session,
     return MFX_ERR_NOT_IMPLEMENTED;
 }
 
-mfxStatus MFXVideoENCODE_Init(mfxSession session, mfxVideoParam *par) {
-    return MFX_ERR_NOT_IMPLEMENTED;
-}
-
-mfxStatus MFXVideoENCODE_Close(mfxSession session) {
-    return MFX_ERR_NOT_IMPLEMENTED;
-}
-
-mfxStatus MFXVideoENCODE_EncodeFrameAsync(mfxSession session,
-                                          mfxEncodeCtrl *ctrl,
-                                          mfxFrameSurface1 *surface,
-                                          mfxBitstream *bs,
-                                          mfxSyncPoint *syncp) {
-    return MFX_ERR_NOT_IMPLEMENTED;
-}
-
-mfxStatus MFXVideoENCODE_Reset(mfxSession session, mfxVideoParam *par) {
-    return MFX_ERR_NOT_IMPLEMENTED;
-}
-
-mfxStatus MFXVideoENCODE_GetVideoParam(mfxSession session, mfxVideoParam *par) {
-    return MFX_ERR_NOT_IMPLEMENTED;
-}
-
 mfxStatus MFXVideoENCODE_GetEncodeStat(mfxSession session, mfxEncodeStat *stat) {
     return MFX_ERR_NOT_IMPLEMENTED;
 }
@@ -172,26 +120,6 @@ mfxStatus MFXVideoVPP_QueryIOSurf(mfxSession session,
     return MFX_ERR_NOT_IMPLEMENTED;
 }
 
-mfxStatus MFXVideoVPP_Init(mfxSession session, mfxVideoParam *par) {
-    return MFX_ERR_NOT_IMPLEMENTED;
-}
-
-mfxStatus MFXVideoVPP_Close(mfxSession session) {
-    return MFX_ERR_NOT_IMPLEMENTED;
-}
-
-mfxStatus MFXVideoVPP_GetVideoParam(mfxSession session, mfxVideoParam *par) {
-    return MFX_ERR_NOT_IMPLEMENTED;
-}
-
-mfxStatus MFXVideoVPP_RunFrameVPPAsync(mfxSession session,
-                                       mfxFrameSurface1 *in,
-                                       mfxFrameSurface1 *out,
-                                       mfxExtVppAuxData *aux,
-                                       mfxSyncPoint *syncp) {
-    return MFX_ERR_NOT_IMPLEMENTED;
-}
-
 mfxStatus MFXVideoVPP_Reset(mfxSession session, mfxVideoParam *par) {
     return MFX_ERR_NOT_IMPLEMENTED;
 }
@@ -206,23 +134,6 @@ mfxStatus MFXVideoVPP_ProcessFrameAsync(mfxSession session,
     return MFX_ERR_NOT_IMPLEMENTED;
 }
 
-// memory functions are associated with initialized session
-mfxStatus MFXMemory_GetSurfaceForVPP(mfxSession session, mfxFrameSurface1 **surface) {
-    return MFX_ERR_NOT_IMPLEMENTED;
-}
-
-mfxStatus MFXMemory_GetSurfaceForEncode(mfxSession session, mfxFrameSurface1 **surface) {
-    return MFX_ERR_NOT_IMPLEMENTED;
-}
-
-mfxStatus MFXMemory_GetSurfaceForDecode(mfxSession session, mfxFrameSurface1 **surface) {
-    return MFX_ERR_NOT_IMPLEMENTED;
-}
-
-mfxStatus MFXMemory_GetSurfaceForVPPOut(mfxSession session, mfxFrameSurface1 **surface) {
-    return MFX_ERR_NOT_IMPLEMENTED;
-}
-
 // DLL entry point
 
 #if defined(_WIN32) || defined(_WIN64)
@@ -0,0 +1,171 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+///
+/// Unit tests for background loading (MFXLoadAsync, MFXLoadWait).
+///
+/// @file
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+
+#include "src/dispatcher_common.h"
+
+#ifdef ONEVPL_EXPERIMENTAL
+
+struct LoadReadyInfo {
+    std::atomic<int> numCalls;
+    std::atomic<int> sts;
+};
+
+static void MFX_CDECL OnLoadReady(mfxLoader loader, mfxStatus sts, mfxHDL userData) {
+    LoadReadyInfo *info = reinterpret_cast<LoadReadyInfo *>(userData);
+    info->sts           = sts;
+    info->numCalls++;
+}
+
+TEST(Dispatcher_Stub_AsyncLoad, WaitThenCreateSession) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxStatus sts = MFXLoadAsync(loader, nullptr, nullptr);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    // filters may be set while loading
+    sts = SetConfigImpl(loader, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    sts = MFXLoadWait(loader, MFX_INFINITE);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    // poll after completion returns the same result
+    sts = MFXLoadWait(loader, 0);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxSession session = nullptr;
+    sts                = MFXCreateSession(loader, 0, &session);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    if (session)
+        MFXClose(session);
+    MFXUnload(loader);
+}
+
+TEST(Dispatcher_Stub_AsyncLoad, EnumWithoutWaitBlocksUntilReady) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxStatus sts = SetConfigImpl(loader, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    sts = MFXLoadAsync(loader, nullptr, nullptr);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxImplDescription *implDesc = nullptr;
+    sts                          = MFXEnumImplementations(loader,
+                                 0,
+                                 MFX_IMPLCAPS_IMPLDESCSTRUCTURE,
+                                 reinterpret_cast<mfxHDL *>(&implDesc));
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    ASSERT_FALSE(implDesc == nullptr);
+    EXPECT_EQ(std::string(implDesc->ImplName).find("Stub Implementation"), 0u);
+    MFXDispReleaseImplDescription(loader, implDesc);
+
+    MFXUnload(loader);
+}
+
+TEST(Dispatcher_Stub_AsyncLoad, CallbackIsCalledOnce) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    LoadReadyInfo info;
+    info.numCalls = 0;
+    info.sts      = MFX_ERR_UNKNOWN;
+
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxStatus sts = MFXLoadAsync(loader, OnLoadReady, &info);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    // second call is not allowed
+    sts = MFXLoadAsync(loader, OnLoadReady, &info);
+    EXPECT_EQ(sts, MFX_ERR_UNDEFINED_BEHAVIOR);
+
+    sts = MFXLoadWait(loader, MFX_INFINITE);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    // callback may still be running when the wait returns - unload joins the background thread
+    MFXUnload(loader);
+
+    EXPECT_EQ(info.numCalls.load(), 1);
+    EXPECT_EQ(info.sts.load(), MFX_ERR_NONE);
+}
+
+TEST(Dispatcher_Stub_AsyncLoad, SameImplListAsSyncLoad) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    mfxLoader loaderSync  = MFXLoad();
+    mfxLoader loaderAsync = MFXLoad();
+    EXPECT_FALSE(loaderSync == nullptr);
+    EXPECT_FALSE(loaderAsync == nullptr);
+
+    mfxStatus sts = MFXLoadAsync(loaderAsync, nullptr, nullptr);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    for (mfxU32 idx = 0;; idx++) {
+        mfxHDL pathSync = nullptr, pathAsync = nullptr;
+        mfxStatus stsSync  = MFXEnumImplementations(loaderSync, idx, MFX_IMPLCAPS_IMPLPATH, &pathSync);
+        mfxStatus stsAsync = MFXEnumImplementations(loaderAsync, idx, MFX_IMPLCAPS_IMPLPATH, &pathAsync);
+        EXPECT_EQ(stsSync, stsAsync);
+
+        if (stsSync != MFX_ERR_NONE || stsAsync != MFX_ERR_NONE)
+            break;
+
+        EXPECT_STREQ(reinterpret_cast<mfxChar *>(pathSync), reinterpret_cast<mfxChar *>(pathAsync));
+        MFXDispReleaseImplDescription(loaderSync, pathSync);
+        MFXDispReleaseImplDescription(loaderAsync, pathAsync);
+    }
+
+    MFXUnload(loaderSync);
+    MFXUnload(loaderAsync);
+}
+
+TEST(Dispatcher_Stub_AsyncLoad, NotStartedAndAfterEnumErrors) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxStatus sts = MFXLoadWait(loader, 0);
+    EXPECT_EQ(sts, MFX_ERR_NOT_INITIALIZED);
+
+    sts = SetConfigImpl(loader, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxHDL implPath = nullptr;
+    sts             = MFXEnumImplementations(loader, 0, MFX_IMPLCAPS_IMPLPATH, &implPath);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    MFXDispReleaseImplDescription(loader, implPath);
+
+    // libraries are already loaded
+    sts = MFXLoadAsync(loader, nullptr, nullptr);
+    EXPECT_EQ(sts, MFX_ERR_UNDEFINED_BEHAVIOR);
+
+    MFXUnload(loader);
+}
+
+TEST(Dispatcher_AsyncLoad, NullLoaderReturnsErrNull) {
+    EXPECT_EQ(MFXLoadAsync(nullptr, nullptr, nullptr), MFX_ERR_NULL_PTR);
+    EXPECT_EQ(MFXLoadWait(nullptr, 0), MFX_ERR_NULL_PTR);
+}
+
+#endif // ONEVPL_EXPERIMENTAL
@@ -0,0 +1,228 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+///
+/// Unit tests for persistent capabilities cache (ONEVPL_DISPATCHER_CACHE_FILE).
+///
+/// @file
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "src/dispatcher_common.h"
+
+#define CAPS_CACHE_TEST_FILE "vpl_caps_cache_test.bin"
+
+// subset of caps which is compared between cold and warm loads
+struct CapsSummary {
+    std::string implName;
+    mfxU32 apiVersion;
+    std::vector<mfxU32> decCodecs;
+    std::vector<mfxU32> encCodecs;
+    std::vector<mfxU32> vppFilters;
+    std::vector<std::string> implFuncs;
+};
+
+static void EnableCapsCache(bool bEnable) {
+#if defined(_WIN32) || defined(_WIN64)
+    SetEnvironmentVariable("ONEVPL_DISPATCHER_CACHE_FILE", bEnable ? CAPS_CACHE_TEST_FILE : NULL);
+#else
+    if (bEnable)
+        setenv("ONEVPL_DISPATCHER_CACHE_FILE", CAPS_CACHE_TEST_FILE, 1);
+    else
+        unsetenv("ONEVPL_DISPATCHER_CACHE_FILE");
+#endif
+}
+
+static bool CapsCacheFileExists() {
+    FILE *f = fopen(CAPS_CACHE_TEST_FILE, "rb");
+    if (!f)
+        return false;
+    fclose(f);
+    return true;
+}
+
+// load stub implementation, save summary of caps, and create a session
+static void LoadStubAndCreateSession(CapsSummary &caps, bool bCheckCacheHit) {
+    if (bCheckCacheHit)
+        CaptureOutputLog(true);
+
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxStatus sts = SetConfigImpl(loader, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxImplDescription *implDesc = nullptr;
+    sts                          = MFXEnumImplementations(loader,
+                                 0,
+                                 MFX_IMPLCAPS_IMPLDESCSTRUCTURE,
+                                 reinterpret_cast<mfxHDL *>(&implDesc));
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    ASSERT_FALSE(implDesc == nullptr);
+
+    caps.implName   = implDesc->ImplName;
+    caps.apiVersion = implDesc->ApiVersion.Version;
+    for (mfxU32 i = 0; i < implDesc->Dec.NumCodecs; i++)
+        caps.decCodecs.push_back(implDesc->Dec.Codecs[i].CodecID);
+    for (mfxU32 i = 0; i < implDesc->Enc.NumCodecs; i++)
+        caps.encCodecs.push_back(implDesc->Enc.Codecs[i].CodecID);
+    for (mfxU32 i = 0; i < implDesc->VPP.NumFilters; i++)
+        caps.vppFilters.push_back(implDesc->VPP.Filters[i].FilterFourCC);
+    MFXDispReleaseImplDescription(loader, implDesc);
+
+    mfxImplementedFunctions *implFuncs = nullptr;
+    sts                                = MFXEnumImplementations(loader,
+                                 0,
+                                 MFX_IMPLCAPS_IMPLEMENTEDFUNCTIONS,
+                                 reinterpret_cast<mfxHDL *>(&implFuncs));
+    if (sts == MFX_ERR_NONE && implFuncs) {
+        for (mfxU32 i = 0; i < implFuncs->NumFunctions; i++)
+            caps.implFuncs.push_back(implFuncs->FunctionsName[i]);
+        MFXDispReleaseImplDescription(loader, implFuncs);
+    }
+
+    mfxSession session = nullptr;
+    sts                = MFXCreateSession(loader, 0, &session);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    if (session)
+        MFXClose(session);
+    MFXUnload(loader);
+
+    if (bCheckCacheHit) {
+        std::string outputLog;
+        GetOutputLog(outputLog);
+        CheckOutputLog(outputLog, "caps cache hit");
+    }
+}
+
+static void ExpectSameCaps(const CapsSummary &a, const CapsSummary &b) {
+    EXPECT_EQ(a.implName, b.implName);
+    EXPECT_EQ(a.apiVersion, b.apiVersion);
+    EXPECT_EQ(a.decCodecs, b.decCodecs);
+    EXPECT_EQ(a.encCodecs, b.encCodecs);
+    EXPECT_EQ(a.vppFilters, b.vppFilters);
+    EXPECT_EQ(a.implFuncs, b.implFuncs);
+}
+
+TEST(Dispatcher_Stub_CapsCache, ColdLoadWritesCacheFile) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    remove(CAPS_CACHE_TEST_FILE);
+    EnableCapsCache(true);
+
+    CapsSummary caps;
+    LoadStubAndCreateSession(caps, false);
+    EXPECT_TRUE(CapsCacheFileExists());
+
+    EnableCapsCache(false);
+    remove(CAPS_CACHE_TEST_FILE);
+}
+
+TEST(Dispatcher_Stub_CapsCache, WarmLoadMatchesColdLoad) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    remove(CAPS_CACHE_TEST_FILE);
+    EnableCapsCache(true);
+
+    CapsSummary capsCold, capsWarm;
+    LoadStubAndCreateSession(capsCold, false);
+    LoadStubAndCreateSession(capsWarm, true);
+
+    ExpectSameCaps(capsCold, capsWarm);
+    EXPECT_FALSE(capsWarm.encCodecs.empty());
+
+    EnableCapsCache(false);
+    remove(CAPS_CACHE_TEST_FILE);
+}
+
+TEST(Dispatcher_Stub_CapsCache, CachedCapsMatchUncachedLoad) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    CapsSummary capsNoCache, capsWarm;
+    LoadStubAndCreateSession(capsNoCache, false);
+
+    remove(CAPS_CACHE_TEST_FILE);
+    EnableCapsCache(true);
+
+    CapsSummary capsCold;
+    LoadStubAndCreateSession(capsCold, false);
+    LoadStubAndCreateSession(capsWarm, true);
+
+    ExpectSameCaps(capsNoCache, capsWarm);
+
+    EnableCapsCache(false);
+    remove(CAPS_CACHE_TEST_FILE);
+}
+
+TEST(Dispatcher_Stub_CapsCache, CorruptCacheFileIsReplaced) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    FILE *f = fopen(CAPS_CACHE_TEST_FILE, "wb");
+    ASSERT_FALSE(f == nullptr);
+    fputs("VPLCAPS-not-a-valid-cache-file", f);
+    fclose(f);
+
+    EnableCapsCache(true);
+
+    // invalid file is ignored, caps are queried from the runtime
+    CapsSummary capsCold, capsWarm;
+    LoadStubAndCreateSession(capsCold, false);
+
+    // file was rewritten with valid contents
+    LoadStubAndCreateSession(capsWarm, true);
+
+    ExpectSameCaps(capsCold, capsWarm);
+
+    EnableCapsCache(false);
+    remove(CAPS_CACHE_TEST_FILE);
+}
+
+// create session with an encoder CodecID filter applied
+static mfxStatus CreateSessionWithEncoder(mfxU32 codecID) {
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxStatus sts = SetConfigImpl(loader, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    sts = SetConfigFilterProperty<mfxU32>(loader,
+                                          "mfxImplDescription.mfxEncoderDescription.encoder.CodecID",
+                                          codecID);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxSession session = nullptr;
+    sts                = MFXCreateSession(loader, 0, &session);
+
+    if (session)
+        MFXClose(session);
+    MFXUnload(loader);
+
+    return sts;
+}
+
+TEST(Dispatcher_Stub_CapsCache, CachedCapsAreFiltered) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    remove(CAPS_CACHE_TEST_FILE);
+    EnableCapsCache(true);
+
+    CapsSummary caps;
+    LoadStubAndCreateSession(caps, false);
+    ASSERT_FALSE(caps.encCodecs.empty());
+
+    // filters are applied to the caps restored from the cache
+    EXPECT_EQ(CreateSessionWithEncoder(caps.encCodecs[0]), MFX_ERR_NONE);
+    EXPECT_EQ(CreateSessionWithEncoder(MFX_MAKEFOURCC('X', 'X', 'X', 'X')), MFX_ERR_NOT_FOUND);
+
+    EnableCapsCache(false);
+    remove(CAPS_CACHE_TEST_FILE);
+}
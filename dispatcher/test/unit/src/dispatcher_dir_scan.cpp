@@ -0,0 +1,263 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+///
+/// Unit tests for reuse of directory listings when searching for libraries.
+///
+/// @file
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "src/dispatcher_common.h"
+
+#if !defined(_WIN32) && !defined(_WIN64)
+
+    #include <stdlib.h>
+    #include <sys/time.h>
+    #include <unistd.h>
+
+    #define DIR_SCAN_CACHED_MSG "directory unchanged, using cached list of libraries"
+
+// temporary search directory with links to the stub runtime
+// ONEVPL_SEARCH_PATH points to it while the object exists
+class StubSearchDir {
+public:
+    StubSearchDir() : m_dir(), m_stubDir(), m_origSearchPath() {
+        const char *searchPath = getenv("ONEVPL_SEARCH_PATH");
+        if (searchPath) {
+            m_origSearchPath = searchPath;
+            m_stubDir        = searchPath;
+        }
+
+        char dirTemplate[] = "/tmp/vpl_dir_scan_XXXXXX";
+        if (mkdtemp(dirTemplate))
+            m_dir = dirTemplate;
+
+        setenv("ONEVPL_SEARCH_PATH", m_dir.c_str(), 1);
+    }
+
+    ~StubSearchDir() {
+        for (auto &link : m_links)
+            unlink(link.c_str());
+        rmdir(m_dir.c_str());
+
+        if (m_origSearchPath.empty())
+            unsetenv("ONEVPL_SEARCH_PATH");
+        else
+            setenv("ONEVPL_SEARCH_PATH", m_origSearchPath.c_str(), 1);
+    }
+
+    bool IsValid() {
+        return !m_dir.empty() && !m_stubDir.empty();
+    }
+
+    // add link to a stub library, and set directory mtime to ageSec seconds ago
+    bool AddLink(const std::string &libName, long ageSec) {
+        return AddLink(libName, m_stubDir + "/" + libName, ageSec);
+    }
+
+    // add link with the given target, and set directory mtime to ageSec seconds ago
+    bool AddLink(const std::string &libName, const std::string &target, long ageSec) {
+        std::string link = m_dir + "/" + libName;
+        if (symlink(target.c_str(), link.c_str()) != 0)
+            return false;
+        m_links.push_back(link);
+
+        struct timeval tv[2];
+        gettimeofday(&tv[0], nullptr);
+        tv[0].tv_sec -= ageSec;
+        tv[1] = tv[0];
+        return (utimes(m_dir.c_str(), tv) == 0);
+    }
+
+    const std::string &GetDir() {
+        return m_dir;
+    }
+
+    const std::string &GetStubDir() {
+        return m_stubDir;
+    }
+
+private:
+    std::string m_dir;
+    std::string m_stubDir;
+    std::string m_origSearchPath;
+    std::vector<std::string> m_links;
+};
+
+// enumerate implementations without filters and return their library paths
+static std::vector<std::string> LoadAndGetImplPaths() {
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    std::vector<std::string> paths;
+    while (1) {
+        mfxHDL implPath = nullptr;
+        mfxStatus sts   = MFXEnumImplementations(loader,
+                                               (mfxU32)paths.size(),
+                                               MFX_IMPLCAPS_IMPLPATH,
+                                               &implPath);
+        if (sts != MFX_ERR_NONE)
+            break;
+        paths.push_back(reinterpret_cast<const char *>(implPath));
+        MFXDispReleaseImplDescription(loader, implPath);
+    }
+
+    MFXUnload(loader);
+
+    return paths;
+}
+
+static bool HasPath(const std::vector<std::string> &paths, const std::string &path) {
+    return std::find(paths.begin(), paths.end(), path) != paths.end();
+}
+
+// return canonical path of a file, empty if it does not exist
+static std::string GetRealPath(const std::string &path) {
+    std::string realPath;
+    char *fullPath = realpath(path.c_str(), nullptr);
+    if (fullPath) {
+        realPath = fullPath;
+        free(fullPath);
+    }
+    return realPath;
+}
+
+// enumerate implementations without filters and return the number found
+static mfxU32 LoadAndCountImpls() {
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxU32 numImpls = 0;
+    while (1) {
+        mfxHDL implPath = nullptr;
+        mfxStatus sts   = MFXEnumImplementations(loader, numImpls, MFX_IMPLCAPS_IMPLPATH, &implPath);
+        if (sts != MFX_ERR_NONE)
+            break;
+        MFXDispReleaseImplDescription(loader, implPath);
+        numImpls++;
+    }
+
+    MFXUnload(loader);
+
+    return numImpls;
+}
+
+TEST(Dispatcher_Stub_DirScan, UnchangedDirectoryIsNotScannedAgain) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    StubSearchDir searchDir;
+    ASSERT_TRUE(searchDir.IsValid());
+    ASSERT_TRUE(searchDir.AddLink("libvplstubrt64.so", 60));
+
+    // first load scans the directory
+    CaptureOutputLog(true);
+    mfxU32 numImplsFirst = LoadAndCountImpls();
+    std::string outputLog;
+    GetOutputLog(outputLog);
+    CheckOutputLog(outputLog, (DIR_SCAN_CACHED_MSG ": " + searchDir.GetDir()).c_str(), false);
+
+    // second load reuses the listing and finds the same implementations
+    CaptureOutputLog(true);
+    mfxU32 numImplsSecond = LoadAndCountImpls();
+    GetOutputLog(outputLog);
+    CheckOutputLog(outputLog, (DIR_SCAN_CACHED_MSG ": " + searchDir.GetDir()).c_str());
+
+    EXPECT_GT(numImplsFirst, 0u);
+    EXPECT_EQ(numImplsFirst, numImplsSecond);
+}
+
+TEST(Dispatcher_Stub_DirScan, ModifiedDirectoryIsScannedAgain) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    StubSearchDir searchDir;
+    ASSERT_TRUE(searchDir.IsValid());
+    ASSERT_TRUE(searchDir.AddLink("libvplstubrt64.so", 120));
+
+    mfxU32 numImplsFirst = LoadAndCountImpls();
+
+    // same library again under another name - new file but no new implementations
+    ASSERT_TRUE(searchDir.AddLink("libvplstubrt64.so.0", 60));
+
+    CaptureOutputLog(true);
+    mfxU32 numImplsSecond = LoadAndCountImpls();
+    std::string outputLog;
+    GetOutputLog(outputLog);
+    CheckOutputLog(outputLog, (DIR_SCAN_CACHED_MSG ": " + searchDir.GetDir()).c_str(), false);
+
+    // both links resolve to the same library, which is loaded once
+    EXPECT_GT(numImplsFirst, 0u);
+    EXPECT_EQ(numImplsFirst, numImplsSecond);
+}
+
+TEST(Dispatcher_Stub_DirScan, RecentlyModifiedDirectoryIsNotCached) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    StubSearchDir searchDir;
+    ASSERT_TRUE(searchDir.IsValid());
+    ASSERT_TRUE(searchDir.AddLink("libvplstubrt64.so", 0));
+
+    LoadAndCountImpls();
+
+    CaptureOutputLog(true);
+    LoadAndCountImpls();
+    std::string outputLog;
+    GetOutputLog(outputLog);
+    CheckOutputLog(outputLog, (DIR_SCAN_CACHED_MSG ": " + searchDir.GetDir()).c_str(), false);
+}
+
+TEST(Dispatcher_Stub_DirScan, RetargetedLinkIsResolvedAgain) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    StubSearchDir searchDir;
+    ASSERT_TRUE(searchDir.IsValid());
+
+    // versioned copies of the library live outside the search directory, and the link in
+    //   the search directory goes through a second link which is switched on upgrade
+    char dirTemplate[] = "/tmp/vpl_dir_scan_lib_XXXXXX";
+    ASSERT_TRUE(mkdtemp(dirTemplate) != nullptr);
+    std::string libDir     = dirTemplate;
+    std::string origLib    = searchDir.GetStubDir() + "/libvplstubrt64.so";
+    std::string copyLib    = libDir + "/libvplstubrt64.so.2";
+    std::string switchLink = libDir + "/libvplstubrt64.so";
+    {
+        std::ifstream src(origLib, std::ios::binary);
+        std::ofstream dst(copyLib, std::ios::binary);
+        dst << src.rdbuf();
+    }
+    ASSERT_EQ(symlink(origLib.c_str(), switchLink.c_str()), 0);
+    ASSERT_TRUE(searchDir.AddLink("libvplstubrt64.so", switchLink, 60));
+
+    std::vector<std::string> implPathsFirst = LoadAndGetImplPaths();
+
+    // upgrade - the search directory is not modified
+    unlink(switchLink.c_str());
+    ASSERT_EQ(symlink(copyLib.c_str(), switchLink.c_str()), 0);
+
+    CaptureOutputLog(true);
+    std::vector<std::string> implPathsSecond = LoadAndGetImplPaths();
+    std::string outputLog;
+    GetOutputLog(outputLog);
+    CheckOutputLog(outputLog, (DIR_SCAN_CACHED_MSG ": " + searchDir.GetDir()).c_str());
+
+    // new target is loaded although the listing of the search directory is reused
+    EXPECT_TRUE(HasPath(implPathsFirst, GetRealPath(origLib)));
+    EXPECT_FALSE(HasPath(implPathsFirst, GetRealPath(copyLib)));
+    EXPECT_TRUE(HasPath(implPathsSecond, GetRealPath(copyLib)));
+
+    unlink(switchLink.c_str());
+    unlink(copyLib.c_str());
+    rmdir(libDir.c_str());
+}
+
+#endif // !defined(_WIN32) && !defined(_WIN64)
@@ -0,0 +1,201 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+///
+/// Unit tests for lazy caps query mode (ONEVPL_DISPATCHER_LAZY_CAPS).
+///
+/// @file
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "src/dispatcher_common.h"
+
+static void EnableLazyCaps(bool bEnable) {
+#if defined(_WIN32) || defined(_WIN64)
+    SetEnvironmentVariable("ONEVPL_DISPATCHER_LAZY_CAPS", bEnable ? "ON" : NULL);
+#else
+    if (bEnable)
+        setenv("ONEVPL_DISPATCHER_LAZY_CAPS", "ON", 1);
+    else
+        unsetenv("ONEVPL_DISPATCHER_LAZY_CAPS");
+#endif
+}
+
+// enumerate all implementations (no filters) and save name, API version, and
+//   number of implemented functions of each, in order
+static void EnumAllImpls(std::vector<std::string> &implList) {
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    for (mfxU32 idx = 0;; idx++) {
+        mfxImplDescription *implDesc = nullptr;
+        mfxStatus sts                = MFXEnumImplementations(loader,
+                                               idx,
+                                               MFX_IMPLCAPS_IMPLDESCSTRUCTURE,
+                                               reinterpret_cast<mfxHDL *>(&implDesc));
+        if (sts != MFX_ERR_NONE)
+            break;
+
+        std::string implStr = std::string(implDesc->ImplName) + " " +
+                              std::to_string(implDesc->ApiVersion.Version);
+        MFXDispReleaseImplDescription(loader, implDesc);
+
+        mfxImplementedFunctions *implFuncs = nullptr;
+        sts                                = MFXEnumImplementations(loader,
+                                     idx,
+                                     MFX_IMPLCAPS_IMPLEMENTEDFUNCTIONS,
+                                     reinterpret_cast<mfxHDL *>(&implFuncs));
+        if (sts == MFX_ERR_NONE && implFuncs) {
+            implStr += " : " + std::to_string(implFuncs->NumFunctions);
+            MFXDispReleaseImplDescription(loader, implFuncs);
+        }
+
+        implList.push_back(implStr);
+    }
+
+    MFXUnload(loader);
+}
+
+TEST(Dispatcher_Stub_LazyCaps, SameImplListAsFullQuery) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    std::vector<std::string> implListFull, implListLazy;
+
+    EnableLazyCaps(false);
+    EnumAllImpls(implListFull);
+
+    EnableLazyCaps(true);
+    EnumAllImpls(implListLazy);
+    EnableLazyCaps(false);
+
+    EXPECT_FALSE(implListFull.empty());
+    EXPECT_EQ(implListFull, implListLazy);
+}
+
+TEST(Dispatcher_Stub_LazyCaps, ImplementedFunctionsQueriedOnEnum) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    EnableLazyCaps(true);
+    CaptureOutputLog(true);
+
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxStatus sts = SetConfigImpl(loader, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxImplementedFunctions *implFuncs = nullptr;
+    sts                                = MFXEnumImplementations(loader,
+                                 0,
+                                 MFX_IMPLCAPS_IMPLEMENTEDFUNCTIONS,
+                                 reinterpret_cast<mfxHDL *>(&implFuncs));
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    ASSERT_FALSE(implFuncs == nullptr);
+    EXPECT_GT(implFuncs->NumFunctions, 0u);
+    MFXDispReleaseImplDescription(loader, implFuncs);
+
+    MFXUnload(loader);
+
+    std::string outputLog;
+    GetOutputLog(outputLog);
+    CheckOutputLog(outputLog, "deferred caps query");
+
+    EnableLazyCaps(false);
+}
+
+TEST(Dispatcher_Stub_LazyCaps, ImplTypeFilterDoesNotQueryFunctions) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    EnableLazyCaps(true);
+    CaptureOutputLog(true);
+
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxStatus sts = SetConfigImpl(loader, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxSession session = nullptr;
+    sts                = MFXCreateSession(loader, 0, &session);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    if (session)
+        MFXClose(session);
+    MFXUnload(loader);
+
+    std::string outputLog;
+    GetOutputLog(outputLog);
+    CheckOutputLog(outputLog, "deferred caps query", false);
+
+    EnableLazyCaps(false);
+}
+
+TEST(Dispatcher_Stub_LazyCaps, ImplementedFunctionFilterCreatesSession) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    EnableLazyCaps(true);
+    Dispatcher_CreateSession_RequestImplementedFunctionCreatesSession(MFX_IMPL_TYPE_STUB);
+    EnableLazyCaps(false);
+}
+
+TEST(Dispatcher_Stub_LazyCaps, NotImplementedFunctionFilterReturnsNotFound) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    EnableLazyCaps(true);
+    Dispatcher_CreateSession_RequestNotImplementedFunctionReturnsNotFound(MFX_IMPL_TYPE_STUB);
+    EnableLazyCaps(false);
+}
+
+// legacy runtime excluded by the first filter value must be found once the
+//   same property is overwritten with a value that it supports
+TEST(Dispatcher_GPU_LazyCaps, LegacyRuntimeFoundAfterFilterOverwrite) {
+    SKIP_IF_DISP_GPU_MSDK_DISABLED();
+
+    EnableLazyCaps(true);
+
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxConfig cfg = MFXCreateConfig(loader);
+    EXPECT_FALSE(cfg == nullptr);
+
+    mfxStatus sts = SetConfigFilterProperty<mfxU32>(loader,
+                                                    cfg,
+                                                    "mfxImplDescription.Impl",
+                                                    MFX_IMPL_TYPE_HARDWARE);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    // no runtime supports this API version
+    sts = SetConfigFilterProperty<mfxU16>(loader, cfg, "mfxImplDescription.ApiVersion.Major", 99);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxImplDescription *implDesc = nullptr;
+    sts                          = MFXEnumImplementations(loader,
+                                 0,
+                                 MFX_IMPLCAPS_IMPLDESCSTRUCTURE,
+                                 reinterpret_cast<mfxHDL *>(&implDesc));
+    EXPECT_EQ(sts, MFX_ERR_NOT_FOUND);
+
+    // require 1.x RT
+    sts = SetConfigFilterProperty<mfxU16>(loader, cfg, "mfxImplDescription.ApiVersion.Major", 1);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    sts = MFXEnumImplementations(loader,
+                                 0,
+                                 MFX_IMPLCAPS_IMPLDESCSTRUCTURE,
+                                 reinterpret_cast<mfxHDL *>(&implDesc));
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    ASSERT_FALSE(implDesc == nullptr);
+    EXPECT_EQ(implDesc->ApiVersion.Major, 1);
+    MFXDispReleaseImplDescription(loader, implDesc);
+
+    MFXUnload(loader);
+
+    EnableLazyCaps(false);
+}
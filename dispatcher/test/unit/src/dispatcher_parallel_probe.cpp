@@ -0,0 +1,113 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+///
+/// Unit tests for parallel probing of libraries (ONEVPL_DISPATCHER_PROBE_THREADS).
+///
+/// @file
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "src/dispatcher_common.h"
+
+static void SetProbeThreads(const char *numThreads) {
+#if defined(_WIN32) || defined(_WIN64)
+    SetEnvironmentVariable("ONEVPL_DISPATCHER_PROBE_THREADS", numThreads);
+#else
+    if (numThreads)
+        setenv("ONEVPL_DISPATCHER_PROBE_THREADS", numThreads, 1);
+    else
+        unsetenv("ONEVPL_DISPATCHER_PROBE_THREADS");
+#endif
+}
+
+// enumerate all implementations (no filters) and save name and path of each, in order
+static void EnumAllImpls(std::vector<std::string> &implList) {
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    for (mfxU32 idx = 0;; idx++) {
+        mfxImplDescription *implDesc = nullptr;
+        mfxStatus sts                = MFXEnumImplementations(loader,
+                                               idx,
+                                               MFX_IMPLCAPS_IMPLDESCSTRUCTURE,
+                                               reinterpret_cast<mfxHDL *>(&implDesc));
+        if (sts != MFX_ERR_NONE)
+            break;
+
+        std::string implStr = implDesc->ImplName;
+        MFXDispReleaseImplDescription(loader, implDesc);
+
+        mfxHDL implPath = nullptr;
+        sts             = MFXEnumImplementations(loader, idx, MFX_IMPLCAPS_IMPLPATH, &implPath);
+        EXPECT_EQ(sts, MFX_ERR_NONE);
+        if (implPath) {
+            implStr += std::string(" : ") + reinterpret_cast<mfxChar *>(implPath);
+            MFXDispReleaseImplDescription(loader, implPath);
+        }
+
+        implList.push_back(implStr);
+    }
+
+    MFXUnload(loader);
+}
+
+TEST(Dispatcher_Stub_ParallelProbe, SameImplListAsSerial) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    std::vector<std::string> implListSerial, implListParallel;
+
+    SetProbeThreads(nullptr);
+    EnumAllImpls(implListSerial);
+
+    SetProbeThreads("4");
+    EnumAllImpls(implListParallel);
+    SetProbeThreads(nullptr);
+
+    EXPECT_FALSE(implListSerial.empty());
+    EXPECT_EQ(implListSerial, implListParallel);
+}
+
+TEST(Dispatcher_Stub_ParallelProbe, FilteredCreateSessionSucceeds) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    SetProbeThreads("4");
+
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxStatus sts = SetConfigImpl(loader, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxSession session = nullptr;
+    sts                = MFXCreateSession(loader, 0, &session);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    // free internal resources
+    if (session)
+        MFXClose(session);
+    MFXUnload(loader);
+
+    SetProbeThreads(nullptr);
+}
+
+TEST(Dispatcher_Stub_ParallelProbe, InvalidThreadCountIsIgnored) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    std::vector<std::string> implListSerial, implListInvalid;
+
+    SetProbeThreads(nullptr);
+    EnumAllImpls(implListSerial);
+
+    SetProbeThreads("not-a-number");
+    EnumAllImpls(implListInvalid);
+    SetProbeThreads(nullptr);
+
+    EXPECT_EQ(implListSerial, implListInvalid);
+}
@@ -1104,3 +1104,75 @@ TEST(Dispatcher_Stub_CreateSession, EncodeStatsTwoCodecsInvalid) {
 }
 
 #endif // ONEVPL_EXPERIMENTAL
+
+// helper - set CodecID (if nonzero), Profile, and ColorFormats in one config object
+static mfxStatus CreateSessionWithEncodeProps(mfxU32 codecID, mfxU32 profile, mfxU32 colorFormat) {
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxStatus sts = SetConfigImpl(loader, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxConfig cfg = MFXCreateConfig(loader);
+    EXPECT_FALSE(cfg == nullptr);
+
+    if (codecID) {
+        sts = SetConfigFilterProperty<mfxU32>(
+            loader,
+            cfg,
+            "mfxImplDescription.mfxEncoderDescription.encoder.CodecID",
+            codecID);
+        EXPECT_EQ(sts, MFX_ERR_NONE);
+    }
+
+    sts = SetConfigFilterProperty<mfxU32>(
+        loader,
+        cfg,
+        "mfxImplDescription.mfxEncoderDescription.encoder.encprofile.Profile",
+        profile);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    sts = SetConfigFilterProperty<mfxU32>(
+        loader,
+        cfg,
+        "mfxImplDescription.mfxEncoderDescription.encoder.encprofile.encmemdesc.ColorFormats",
+        colorFormat);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxSession session = nullptr;
+    sts                = MFXCreateSession(loader, 0, &session);
+
+    // free internal resources
+    if (session)
+        MFXClose(session);
+    MFXUnload(loader);
+
+    return sts;
+}
+
+TEST(Dispatcher_Stub_CreateSession, EncodeProfileColorFormatValid) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    mfxStatus sts =
+        CreateSessionWithEncodeProps(MFX_CODEC_AVC, MFX_PROFILE_AVC_MAIN, MFX_FOURCC_I010);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+}
+
+TEST(Dispatcher_Stub_CreateSession, EncodeProfileColorFormatMismatch) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    // profile and color format are each supported, but not in the same combination
+    mfxStatus sts =
+        CreateSessionWithEncodeProps(MFX_CODEC_AVC, MFX_PROFILE_AVC_BASELINE, MFX_FOURCC_I010);
+    EXPECT_EQ(sts, MFX_ERR_NOT_FOUND);
+}
+
+TEST(Dispatcher_Stub_CreateSession, EncodeProfileWithoutCodecIDValid) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    mfxStatus sts = CreateSessionWithEncodeProps(0, MFX_PROFILE_AVC_MAIN, MFX_FOURCC_I010);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    sts = CreateSessionWithEncodeProps(0, MFX_PROFILE_AVC_BASELINE, MFX_FOURCC_I010);
+    EXPECT_EQ(sts, MFX_ERR_NOT_FOUND);
+}
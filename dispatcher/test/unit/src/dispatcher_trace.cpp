@@ -0,0 +1,183 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+///
+/// Unit tests for dispatcher tracing (ONEVPL_DISPATCHER_TRACE_FILE).
+///
+/// @file
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+
+#include <string>
+
+#include "src/dispatcher_common.h"
+
+// test runs may be parallel, so each test has its own trace file
+static std::string TraceTestFile() {
+    const testing::TestInfo *info = testing::UnitTest::GetInstance()->current_test_info();
+    return std::string("vpl_dispatcher_trace_") + info->name() + ".json";
+}
+
+static void EnableTrace(bool bEnable) {
+#if defined(_WIN32) || defined(_WIN64)
+    SetEnvironmentVariable("ONEVPL_DISPATCHER_TRACE_FILE",
+                           bEnable ? TraceTestFile().c_str() : NULL);
+#else
+    if (bEnable)
+        setenv("ONEVPL_DISPATCHER_TRACE_FILE", TraceTestFile().c_str(), 1);
+    else
+        unsetenv("ONEVPL_DISPATCHER_TRACE_FILE");
+#endif
+}
+
+static std::string ReadTraceFile() {
+    std::string trace;
+
+    FILE *f = fopen(TraceTestFile().c_str(), "rb");
+    if (!f)
+        return trace;
+
+    char buf[4096];
+    size_t len;
+    while ((len = fread(buf, 1, sizeof(buf), f)) > 0)
+        trace.append(buf, len);
+    fclose(f);
+
+    return trace;
+}
+
+static size_t CountOccurrences(const std::string &str, const std::string &sub) {
+    size_t count = 0;
+    for (size_t pos = str.find(sub); pos != std::string::npos; pos = str.find(sub, pos + 1))
+        count++;
+    return count;
+}
+
+// load stub implementation and create a session
+static void LoadStubAndCreateSession() {
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxStatus sts = SetConfigImpl(loader, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxSession session = nullptr;
+    sts                = MFXCreateSession(loader, 0, &session);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    if (session)
+        MFXClose(session);
+    MFXUnload(loader);
+}
+
+TEST(Dispatcher_Stub_Trace, UnloadWritesAllPhases) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    remove(TraceTestFile().c_str());
+    EnableTrace(true);
+    LoadStubAndCreateSession();
+    EnableTrace(false);
+
+    std::string trace = ReadTraceFile();
+    remove(TraceTestFile().c_str());
+
+    // JSON array format
+    EXPECT_EQ(trace.find("[\n"), 0u);
+
+    EXPECT_NE(trace.find("\"name\":\"search dirs\",\"cat\":\"phase\""), std::string::npos);
+    EXPECT_NE(trace.find("\"name\":\"dlopen\",\"cat\":\"phase\""), std::string::npos);
+    EXPECT_NE(trace.find("\"name\":\"query caps\",\"cat\":\"phase\""), std::string::npos);
+    EXPECT_NE(trace.find("\"name\":\"filter\",\"cat\":\"phase\""), std::string::npos);
+    EXPECT_NE(trace.find("\"name\":\"create session\",\"cat\":\"phase\""), std::string::npos);
+
+    // dispatcher functions are traced too
+    EXPECT_NE(trace.find("\"cat\":\"function\""), std::string::npos);
+}
+
+TEST(Dispatcher_Stub_Trace, AppendsToExistingFile) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    remove(TraceTestFile().c_str());
+    EnableTrace(true);
+    LoadStubAndCreateSession();
+    LoadStubAndCreateSession();
+    EnableTrace(false);
+
+    std::string trace = ReadTraceFile();
+    remove(TraceTestFile().c_str());
+
+    // array is started only once
+    EXPECT_EQ(CountOccurrences(trace, "[\n"), 1u);
+    EXPECT_EQ(CountOccurrences(trace, "\"name\":\"create session\""), 2u);
+}
+
+TEST(Dispatcher_Stub_Trace, DisabledWritesNothing) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    remove(TraceTestFile().c_str());
+    EnableTrace(false);
+    LoadStubAndCreateSession();
+
+    std::string trace = ReadTraceFile();
+    EXPECT_TRUE(trace.empty());
+}
+
+#ifdef ONEVPL_EXPERIMENTAL
+TEST(Dispatcher_Stub_Trace, FlushOnDemand) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    remove(TraceTestFile().c_str());
+    EnableTrace(true);
+
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxStatus sts = SetConfigImpl(loader, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxSession session = nullptr;
+    sts                = MFXCreateSession(loader, 0, &session);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    sts = MFXDispFlushTrace(loader);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    std::string trace = ReadTraceFile();
+    EXPECT_EQ(CountOccurrences(trace, "\"name\":\"create session\""), 1u);
+
+    // events are written only once
+    sts = MFXDispFlushTrace(loader);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    EXPECT_EQ(ReadTraceFile(), trace);
+
+    if (session)
+        MFXClose(session);
+    MFXUnload(loader);
+    EnableTrace(false);
+
+    // MFXUnload writes only the remaining events
+    trace = ReadTraceFile();
+    remove(TraceTestFile().c_str());
+    EXPECT_EQ(CountOccurrences(trace, "\"name\":\"create session\""), 1u);
+    EXPECT_NE(trace.find("UnloadAllLibraries"), std::string::npos);
+}
+
+TEST(Dispatcher_Stub_Trace, FlushWithoutTraceReturnsNotInitialized) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    EnableTrace(false);
+
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    EXPECT_EQ(MFXDispFlushTrace(loader), MFX_ERR_NOT_INITIALIZED);
+    EXPECT_EQ(MFXDispFlushTrace(nullptr), MFX_ERR_NULL_PTR);
+
+    MFXUnload(loader);
+}
+#endif // ONEVPL_EXPERIMENTAL
@@ -0,0 +1,139 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+///
+/// Unit tests for the preview C++ API bitstream pool (oneapi::vpl::bitstream_pool).
+///
+/// @file
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "vpl/preview/bitstream_pool.hpp"
+
+using oneapi::vpl::bitstream_as_dst;
+using oneapi::vpl::bitstream_pool;
+using oneapi::vpl::bitstream_pool_stats;
+using oneapi::vpl::codec_format_fourcc;
+
+TEST(Preview_BitstreamPool, ReleasedBitstreamIsReused) {
+    auto pool = std::make_shared<bitstream_pool>(4, 1024);
+
+    std::shared_ptr<bitstream_as_dst> bs = pool->acquire();
+    ASSERT_NE(bs, nullptr);
+    EXPECT_EQ(bs->get_max_buffer_length(), 1024u);
+    bitstream_as_dst *first = bs.get();
+
+    bitstream_pool_stats stats = pool->stats();
+    EXPECT_EQ(stats.allocations, 1u);
+    EXPECT_EQ(stats.in_use, 1u);
+    EXPECT_EQ(stats.idle, 0u);
+
+    bs.reset();
+    stats = pool->stats();
+    EXPECT_EQ(stats.in_use, 0u);
+    EXPECT_EQ(stats.idle, 1u);
+
+    bs = pool->acquire();
+    EXPECT_EQ(bs.get(), first);
+
+    stats = pool->stats();
+    EXPECT_EQ(stats.allocations, 1u);
+    EXPECT_EQ(stats.reuses, 1u);
+    EXPECT_EQ(stats.in_use, 1u);
+    EXPECT_EQ(stats.idle, 0u);
+}
+
+TEST(Preview_BitstreamPool, ReusedBitstreamIsRecycled) {
+    auto pool = std::make_shared<bitstream_pool>(4, 1024);
+
+    std::shared_ptr<bitstream_as_dst> bs = pool->acquire(codec_format_fourcc::avc);
+    bs->set_DataOffset(16);
+    bs->set_DataLength(100);
+    bs->set_FrameType(MFX_FRAMETYPE_I);
+    bs.reset();
+
+    bs = pool->acquire(codec_format_fourcc::hevc);
+    EXPECT_EQ(bs->get_DataOffset(), 0u);
+    EXPECT_EQ(bs->get_DataLength(), 0u);
+    EXPECT_EQ(bs->get_FrameType(), 0u);
+    EXPECT_EQ(bs->get_CodecId(), codec_format_fourcc::hevc);
+}
+
+TEST(Preview_BitstreamPool, NewBitstreamGetsTwicePeakLength) {
+    auto pool = std::make_shared<bitstream_pool>(4, 1024);
+
+    std::shared_ptr<bitstream_as_dst> bs = pool->acquire();
+    bs->set_DataLength(1000);
+    bs.reset();
+    EXPECT_EQ(pool->stats().peak_data_length, 1000u);
+
+    // idle bitstream still fits the peak, so it is reused as is
+    std::shared_ptr<bitstream_as_dst> reused = pool->acquire();
+    EXPECT_EQ(reused->get_max_buffer_length(), 1024u);
+
+    std::shared_ptr<bitstream_as_dst> allocated = pool->acquire();
+    EXPECT_EQ(allocated->get_max_buffer_length(), 2000u);
+
+    bitstream_pool_stats stats = pool->stats();
+    EXPECT_EQ(stats.allocations, 2u);
+    EXPECT_EQ(stats.reuses, 1u);
+    EXPECT_EQ(stats.reallocations, 0u);
+}
+
+TEST(Preview_BitstreamPool, IdleBitstreamGrowsWhenPeakDoesNotFit) {
+    auto pool = std::make_shared<bitstream_pool>(4, 1024);
+
+    std::shared_ptr<bitstream_as_dst> small = pool->acquire();
+    std::shared_ptr<bitstream_as_dst> large = pool->acquire();
+    large->realloc(1024);
+    large->set_DataLength(1500);
+    large.reset();
+    small.reset();
+
+    // encoder enlarged the buffer of the second one
+    EXPECT_EQ(pool->stats().reallocations, 1u);
+    EXPECT_EQ(pool->stats().peak_data_length, 1500u);
+
+    // last released bitstream is taken first and has to grow to twice the peak
+    std::shared_ptr<bitstream_as_dst> bs = pool->acquire();
+    EXPECT_EQ(bs->get_max_buffer_length(), 3000u);
+
+    bitstream_pool_stats stats = pool->stats();
+    EXPECT_EQ(stats.reuses, 1u);
+    EXPECT_EQ(stats.reallocations, 2u);
+}
+
+TEST(Preview_BitstreamPool, BitstreamsOverMaxIdleAreDiscarded) {
+    auto pool = std::make_shared<bitstream_pool>(2, 1024);
+
+    std::vector<std::shared_ptr<bitstream_as_dst>> in_use;
+    for (int i = 0; i < 3; i++)
+        in_use.push_back(pool->acquire());
+    EXPECT_EQ(pool->stats().in_use, 3u);
+
+    in_use.clear();
+
+    bitstream_pool_stats stats = pool->stats();
+    EXPECT_EQ(stats.allocations, 3u);
+    EXPECT_EQ(stats.in_use, 0u);
+    EXPECT_EQ(stats.idle, 2u);
+    EXPECT_EQ(stats.discards, 1u);
+}
+
+TEST(Preview_BitstreamPool, BitstreamOutlivesPool) {
+    auto pool = std::make_shared<bitstream_pool>(4, 1024);
+
+    std::shared_ptr<bitstream_as_dst> bs = pool->acquire();
+    pool.reset();
+
+    // released bitstream is freed, not returned to the destroyed pool
+    bs->set_DataLength(10);
+    bs.reset();
+    SUCCEED();
+}
@@ -0,0 +1,178 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+///
+/// Unit tests for the preview C++ API extension buffer lists (oneapi::vpl::buffer_list).
+///
+/// @file
+
+#include <gtest/gtest.h>
+
+#include "vpl/preview/extension_buffer_list.hpp"
+
+namespace vpl = oneapi::vpl;
+
+TEST(Preview_BufferList, BuffersAreSortedById) {
+    vpl::ExtEncoderROI roi;
+    vpl::ExtCodingOption3 co3;
+    vpl::ExtCodingOption co;
+    vpl::ExtCodingOption2 co2;
+
+    vpl::buffer_list list;
+    list.add_buffer(&roi);
+    list.add_buffer(&co3);
+    list.add_buffer(&co);
+    list.add_buffer(&co2);
+    ASSERT_EQ(list.get_size(), 4u);
+
+    const auto &entries = list.get_buffers();
+    for (size_t i = 1; i < entries.size(); i++)
+        EXPECT_LT(entries[i - 1].id, entries[i].id);
+
+    auto [buffers, size] = list.get_raw_ext_buffers();
+    ASSERT_EQ(size, 4u);
+    for (size_t i = 0; i < size; i++)
+        EXPECT_EQ(buffers[i]->BufferId, entries[i].id);
+}
+
+TEST(Preview_BufferList, BufferWithSameIdIsReplaced) {
+    vpl::ExtCodingOption2 first;
+    vpl::ExtCodingOption2 second;
+
+    vpl::buffer_list list;
+    list.add_buffer(&first);
+    list.add_buffer(&second);
+    ASSERT_EQ(list.get_size(), 1u);
+
+    EXPECT_EQ(list.get_buffer<mfxExtCodingOption2>(MFX_EXTBUFF_CODING_OPTION2),
+              reinterpret_cast<mfxExtCodingOption2 *>(second.get_base_ptr()));
+    auto [buffers, size] = list.get_raw_ext_buffers();
+    ASSERT_EQ(size, 1u);
+    EXPECT_EQ(buffers[0], second.get_base_ptr());
+}
+
+TEST(Preview_BufferList, LookupByIdFindsOnlyAddedBuffers) {
+    vpl::ExtCodingOption co;
+    vpl::ExtCodingOption3 co3;
+
+    vpl::buffer_list list;
+    EXPECT_FALSE(list.has_buffer(MFX_EXTBUFF_CODING_OPTION));
+    list.add_buffer(&co3);
+    list.add_buffer(&co);
+
+    EXPECT_TRUE(list.has_buffer<MFX_EXTBUFF_CODING_OPTION>());
+    EXPECT_TRUE(list.has_buffer(MFX_EXTBUFF_CODING_OPTION3));
+    EXPECT_FALSE(list.has_buffer(MFX_EXTBUFF_CODING_OPTION2));
+    EXPECT_EQ((list.get_buffer<mfxExtCodingOption2, MFX_EXTBUFF_CODING_OPTION2>()), nullptr);
+    EXPECT_EQ((list.get_buffer<mfxExtCodingOption, MFX_EXTBUFF_CODING_OPTION>()),
+              reinterpret_cast<mfxExtCodingOption *>(co.get_base_ptr()));
+}
+
+TEST(Preview_BufferList, IgnoredBuffersAreNotPassedToRuntime) {
+    vpl::ExtVppAuxData aux(vpl::pic_struct::progressive);
+    vpl::ExtCodingOption co;
+
+    vpl::buffer_list list;
+    list.add_buffer(&aux);
+    EXPECT_EQ(list.get_size(), 1u);
+    auto [none, noneSize] = list.get_raw_ext_buffers();
+    EXPECT_EQ(none, nullptr);
+    EXPECT_EQ(noneSize, 0u);
+
+    list.add_buffer(&co);
+    EXPECT_EQ(list.get_size(), 2u);
+    auto [buffers, size] = list.get_raw_ext_buffers();
+    ASSERT_EQ(size, 1u);
+    EXPECT_EQ(buffers[0], co.get_base_ptr());
+}
+
+TEST(Preview_BufferList, RawArrayIsRebuiltOnlyWhenListChanges) {
+    vpl::ExtCodingOption co;
+    vpl::ExtCodingOption2 co2;
+
+    vpl::buffer_list list;
+    list.add_buffer(&co2);
+    auto [first, firstSize] = list.get_raw_ext_buffers();
+    auto [again, againSize] = list.get_raw_ext_buffers();
+    EXPECT_EQ(first, again);
+    EXPECT_EQ(firstSize, againSize);
+
+    // adding the same buffer again doesn't change the list
+    list.add_buffer(&co2);
+    auto [same, sameSize] = list.get_raw_ext_buffers();
+    EXPECT_EQ(same[0], co2.get_base_ptr());
+    EXPECT_EQ(sameSize, 1u);
+
+    list.add_buffer(&co);
+    auto [changed, changedSize] = list.get_raw_ext_buffers();
+    ASSERT_EQ(changedSize, 2u);
+    const auto &entries = list.get_buffers();
+    EXPECT_EQ(changed[0], entries[0].buffer->get_base_ptr());
+    EXPECT_EQ(changed[1], entries[1].buffer->get_base_ptr());
+    EXPECT_TRUE(changed[0] == co.get_base_ptr() || changed[1] == co.get_base_ptr());
+}
+
+TEST(Preview_BufferList, CopyHasItsOwnRawArray) {
+    vpl::ExtEncoderROI roi;
+    vpl::ExtInsertHeaders headers;
+    vpl::ExtPictureTimingSEI sei;
+
+    vpl::encoder_process_list list(&roi, &headers);
+    auto [buffers, size] = list.get_raw_ext_buffers();
+    ASSERT_EQ(size, 2u);
+
+    vpl::encoder_process_list copy(list);
+    auto [copyBuffers, copySize] = copy.get_raw_ext_buffers();
+    ASSERT_EQ(copySize, 2u);
+    EXPECT_NE(copyBuffers, buffers);
+    EXPECT_EQ(copyBuffers[0], buffers[0]);
+    EXPECT_EQ(copyBuffers[1], buffers[1]);
+
+    // changes of the copy don't reach the original
+    copy.add_buffer(&sei);
+    EXPECT_EQ(copy.get_raw_ext_buffers().second, 3u);
+    EXPECT_EQ(list.get_raw_ext_buffers().second, 2u);
+    EXPECT_FALSE(list.has_buffer(MFX_EXTBUFF_PICTURE_TIMING_SEI));
+}
+
+TEST(Preview_BufferList, ListRejectsBufferOfOtherStage) {
+    vpl::ExtCodingOption co;
+
+    // coding options are set at init, not per frame
+    vpl::encoder_process_list list;
+    EXPECT_THROW(list.add_buffer(&co), vpl::base_exception);
+    EXPECT_EQ(list.get_size(), 0u);
+}
+
+TEST(Preview_BufferList, ListGrowsPastInlineCapacity) {
+    vpl::ExtCodingOption2 co2;
+    vpl::ExtCodingOption3 co3;
+    vpl::ExtEncoderROI roi;
+    vpl::ExtInsertHeaders headers;
+    vpl::ExtPictureTimingSEI sei;
+    vpl::ExtMasteringDisplayColourVolume display;
+    vpl::ExtContentLightLevelInfo light;
+    vpl::ExtAVCEncodedFrameInfo info;
+    vpl::ExtPredWeightTable weights;
+    vpl::ExtDirtyRect dirty;
+    vpl::extension_buffer_base *all[] = { &dirty, &weights, &info, &light,   &display,
+                                          &sei,   &headers, &roi,  &co3,     &co2 };
+
+    vpl::encoder_process_list list;
+    for (auto b : all)
+        list.add_buffer(b);
+    ASSERT_EQ(list.get_size(), 10u);
+
+    const auto &entries = list.get_buffers();
+    for (size_t i = 1; i < entries.size(); i++)
+        EXPECT_LT(entries[i - 1].id, entries[i].id);
+
+    vpl::encoder_process_list copy(list);
+    auto [buffers, size] = copy.get_raw_ext_buffers();
+    ASSERT_EQ(size, 10u);
+    for (size_t i = 0; i < size; i++)
+        EXPECT_EQ(buffers[i]->BufferId, entries[i].id);
+}
@@ -0,0 +1,189 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+///
+/// Unit tests for the preview C++ API coroutine pipeline executor (oneapi::vpl::executor).
+///
+/// @file
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "vpl/preview/pipeline.hpp"
+
+#if defined(ONEVPL_PREVIEW_COROUTINES)
+
+namespace vpl = oneapi::vpl;
+
+// system memory surface whose sync point completes when the test says so
+class PendingSurface {
+public:
+    PendingSurface() : m_surface(), m_interface(), m_bReady(false), m_nSync(0), m_maxWait(0) {
+        m_interface.Context       = this;
+        m_interface.AddRef        = AddRef;
+        m_interface.Release       = Release;
+        m_interface.GetRefCounter = GetRefCounter;
+        m_interface.Synchronize   = Synchronize;
+        m_surface.FrameInterface  = &m_interface;
+    }
+
+    // takes the reference of the caller
+    std::shared_ptr<vpl::future_surface_t> MakeFuture(vpl::status sts) {
+        m_refCounter++;
+        auto surface = std::make_shared<vpl::frame_surface>();
+        surface->adopt(&m_surface);
+
+        auto f = std::make_shared<vpl::future_surface_t>(surface);
+        vpl::operation_status op(vpl::component::decoder, nullptr);
+        op.schedule_status_ = sts;
+        f->add_operation(op);
+        return f;
+    }
+
+    void Complete() {
+        m_bReady = true;
+    }
+    int GetSyncCalls() const {
+        return m_nSync;
+    }
+    mfxU32 GetMaxWait() const {
+        return m_maxWait;
+    }
+    mfxU32 GetRefs() const {
+        return m_refCounter;
+    }
+
+private:
+    static PendingSurface *Self(mfxFrameSurface1 *surface) {
+        return static_cast<PendingSurface *>(surface->FrameInterface->Context);
+    }
+    static mfxStatus MFX_CDECL AddRef(mfxFrameSurface1 *surface) {
+        Self(surface)->m_refCounter++;
+        return MFX_ERR_NONE;
+    }
+    static mfxStatus MFX_CDECL Release(mfxFrameSurface1 *surface) {
+        Self(surface)->m_refCounter--;
+        return MFX_ERR_NONE;
+    }
+    static mfxStatus MFX_CDECL GetRefCounter(mfxFrameSurface1 *surface, mfxU32 *counter) {
+        *counter = Self(surface)->m_refCounter;
+        return MFX_ERR_NONE;
+    }
+    static mfxStatus MFX_CDECL Synchronize(mfxFrameSurface1 *surface, mfxU32 wait) {
+        PendingSurface *self = Self(surface);
+        self->m_nSync++;
+        if (wait > self->m_maxWait)
+            self->m_maxWait = wait;
+        return self->m_bReady ? MFX_ERR_NONE : MFX_WRN_IN_EXECUTION;
+    }
+
+    mfxFrameSurface1 m_surface;
+    mfxFrameSurfaceInterface m_interface;
+    std::atomic<bool> m_bReady;
+    std::atomic<int> m_nSync;
+    std::atomic<mfxU32> m_maxWait;
+    std::atomic<mfxU32> m_refCounter{ 0 };
+};
+
+static vpl::task<int> Square(int value) {
+    co_return value * value;
+}
+
+static vpl::task<> SumOfSquares(int value, std::atomic<int> &sum) {
+    sum += co_await Square(value);
+}
+
+static vpl::task<> WaitForFrame(std::shared_ptr<vpl::future_surface_t> in, std::atomic<int> &step) {
+    auto out = co_await vpl::synchronized(std::move(in));
+    EXPECT_EQ(out->get_last_schedule_status(), vpl::status::Ok);
+    step++;
+}
+
+static vpl::task<> CompleteFrame(PendingSurface &surface, std::atomic<int> &step) {
+    // waiter was parked before this task started
+    EXPECT_EQ(step, 0);
+    surface.Complete();
+    co_return;
+}
+
+static vpl::task<> Fail() {
+    throw std::runtime_error("task failed");
+    co_return;
+}
+
+TEST(Preview_Executor, ZeroThreadsAreTreatedAsOne) {
+    vpl::executor ex(0);
+    EXPECT_EQ(ex.get_thread_count(), 1u);
+}
+
+TEST(Preview_Executor, SpawnedTasksRunToCompletion) {
+    vpl::executor ex(4);
+    std::atomic<int> sum(0);
+    int expected = 0;
+
+    for (int i = 0; i < 100; i++) {
+        ex.spawn(SumOfSquares(i, sum));
+        expected += i * i;
+    }
+    ex.join();
+
+    EXPECT_EQ(sum, expected);
+    EXPECT_EQ(ex.get_active_count(), 0u);
+}
+
+TEST(Preview_Executor, WaitingTaskDoesNotBlockThread) {
+    PendingSurface surface;
+    std::atomic<int> step(0);
+    {
+        // with one thread the second task runs only if the first one is parked
+        vpl::executor ex(1, std::chrono::microseconds(100));
+        ex.spawn(WaitForFrame(surface.MakeFuture(vpl::status::Ok), step));
+        ex.spawn(CompleteFrame(surface, step));
+        ex.join();
+    }
+
+    EXPECT_EQ(step, 1);
+    EXPECT_GE(surface.GetSyncCalls(), 2);
+    // sync point is polled, never waited for
+    EXPECT_EQ(surface.GetMaxWait(), 0u);
+    EXPECT_EQ(surface.GetRefs(), 0u);
+}
+
+TEST(Preview_Executor, FutureWithoutDataDoesNotSuspend) {
+    PendingSurface surface;
+    std::atomic<int> step(0);
+    {
+        vpl::executor ex(1);
+        auto buffered = surface.MakeFuture(vpl::status::NotEnoughData);
+        ex.spawn([](std::shared_ptr<vpl::future_surface_t> in) -> vpl::task<> {
+            auto out = co_await vpl::synchronized(std::move(in));
+            EXPECT_EQ(out->get_last_schedule_status(), vpl::status::NotEnoughData);
+        }(std::move(buffered)));
+        ex.join();
+    }
+
+    EXPECT_EQ(surface.GetSyncCalls(), 0);
+    EXPECT_EQ(surface.GetRefs(), 0u);
+}
+
+TEST(Preview_Executor, JoinRethrowsTaskException) {
+    vpl::executor ex(2);
+    std::atomic<int> sum(0);
+
+    ex.spawn(Fail());
+    ex.spawn(SumOfSquares(3, sum));
+    EXPECT_THROW(ex.join(), std::runtime_error);
+    EXPECT_EQ(sum, 9);
+
+    // exception is reported once
+    EXPECT_NO_THROW(ex.join());
+}
+
+#endif // ONEVPL_PREVIEW_COROUTINES
@@ -0,0 +1,455 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+///
+/// Unit tests for the preview C++ API raw frame copy kernels (oneapi::vpl::detail::frame_copy) and
+/// the bulk raw frame reader which uses them (oneapi::vpl::raw_frame_bulk_file_reader).
+///
+/// @file
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "vpl/preview/source_reader.hpp"
+
+namespace vpl = oneapi::vpl;
+namespace fc  = oneapi::vpl::detail::frame_copy;
+
+using oneapi::vpl::color_format_fourcc;
+
+static const uint8_t GUARD = 0xCD;
+
+static std::vector<uint8_t> RandomBytes(size_t size, uint32_t seed) {
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; i++) {
+        seed    = seed * 1103515245 + 12345;
+        data[i] = static_cast<uint8_t>(seed >> 16);
+    }
+    return data;
+}
+
+// 10-bit samples in the LSBs
+static std::vector<uint16_t> RandomSamples(size_t size, uint32_t seed) {
+    std::vector<uint8_t> bytes = RandomBytes(2 * size, seed);
+    std::vector<uint16_t> data(size);
+    for (size_t i = 0; i < size; i++)
+        data[i] = static_cast<uint16_t>((bytes[2 * i] | (bytes[2 * i + 1] << 8)) & 0x3FF);
+    return data;
+}
+
+#if defined(ONEVPL_PREVIEW_X86)
+
+typedef void (*Interleave8)(const uint8_t *, const uint8_t *, uint8_t *, uint32_t);
+typedef void (*Interleave16)(const uint16_t *, const uint16_t *, uint16_t *, uint32_t, int);
+typedef void (*Shift16)(const uint16_t *, uint16_t *, uint32_t, int);
+
+// all widths around the vector sizes, with unaligned source and destination
+static void CompareInterleave8(Interleave8 kernel) {
+    std::vector<uint8_t> u = RandomBytes(200, 1);
+    std::vector<uint8_t> v = RandomBytes(200, 2);
+    for (uint32_t n = 0; n <= 130; n++) {
+        for (uint32_t offset = 0; offset < 4; offset++) {
+            std::vector<uint8_t> expected(2 * n + 8, GUARD);
+            std::vector<uint8_t> actual(2 * n + 8, GUARD);
+            fc::interleave_row_8_c(&u[offset], &v[offset], &expected[offset], n);
+            kernel(&u[offset], &v[offset], &actual[offset], n);
+            ASSERT_EQ(actual, expected) << "n = " << n << ", offset = " << offset;
+        }
+    }
+}
+
+static void CompareInterleave16(Interleave16 kernel) {
+    std::vector<uint16_t> u = RandomSamples(200, 3);
+    std::vector<uint16_t> v = RandomSamples(200, 4);
+    for (uint32_t n = 0; n <= 70; n++) {
+        for (uint32_t offset = 0; offset < 4; offset++) {
+            std::vector<uint16_t> expected(2 * n + 8, GUARD);
+            std::vector<uint16_t> actual(2 * n + 8, GUARD);
+            fc::interleave_row_16_c(&u[offset], &v[offset], &expected[offset], n, 6);
+            kernel(&u[offset], &v[offset], &actual[offset], n, 6);
+            ASSERT_EQ(actual, expected) << "n = " << n << ", offset = " << offset;
+        }
+    }
+}
+
+static void CompareShift16(Shift16 kernel) {
+    std::vector<uint16_t> src = RandomSamples(200, 5);
+    for (uint32_t n = 0; n <= 70; n++) {
+        for (uint32_t offset = 0; offset < 4; offset++) {
+            std::vector<uint16_t> expected(n + 8, GUARD);
+            std::vector<uint16_t> actual(n + 8, GUARD);
+            fc::shift_row_16_c(&src[offset], &expected[offset], n, 6);
+            kernel(&src[offset], &actual[offset], n, 6);
+            ASSERT_EQ(actual, expected) << "n = " << n << ", offset = " << offset;
+        }
+    }
+}
+
+TEST(Preview_FrameCopy, SSE2InterleaveMatchesScalar) {
+    if (!fc::has_sse2())
+        GTEST_SKIP() << "CPU doesn't support SSE2";
+    CompareInterleave8(fc::interleave_row_8_sse2);
+    CompareInterleave16(fc::interleave_row_16_sse2);
+}
+
+TEST(Preview_FrameCopy, SSE2ShiftMatchesScalar) {
+    if (!fc::has_sse2())
+        GTEST_SKIP() << "CPU doesn't support SSE2";
+    CompareShift16(fc::shift_row_16_sse2);
+}
+
+TEST(Preview_FrameCopy, AVX2InterleaveMatchesScalar) {
+    if (!fc::has_avx2())
+        GTEST_SKIP() << "CPU doesn't support AVX2";
+    CompareInterleave8(fc::interleave_row_8_avx2);
+    CompareInterleave16(fc::interleave_row_16_avx2);
+}
+
+TEST(Preview_FrameCopy, AVX2ShiftMatchesScalar) {
+    if (!fc::has_avx2())
+        GTEST_SKIP() << "CPU doesn't support AVX2";
+    CompareShift16(fc::shift_row_16_avx2);
+}
+
+#endif // ONEVPL_PREVIEW_X86
+
+TEST(Preview_FrameCopy, CopyPlaneKeepsPadding) {
+    const uint32_t width = 37, rows = 5, srcPitch = 41, dstPitch = 45;
+    std::vector<uint8_t> src = RandomBytes(srcPitch * rows, 6);
+
+    std::vector<uint8_t> expected(dstPitch * rows, GUARD);
+    for (uint32_t y = 0; y < rows; y++)
+        for (uint32_t x = 0; x < width; x++)
+            expected[y * dstPitch + x] = src[y * srcPitch + x];
+
+    std::vector<uint8_t> actual(dstPitch * rows, GUARD);
+    fc::copy_plane(src.data(), srcPitch, actual.data(), dstPitch, width, rows);
+    EXPECT_EQ(actual, expected);
+}
+
+// system memory surface with the planes of the format one after another
+class SystemSurface {
+public:
+    SystemSurface(color_format_fourcc fourcc, uint32_t width, uint32_t height, uint32_t pitch)
+            : m_surface(),
+              m_interface(),
+              m_data(pitch * height * 3, GUARD),
+              m_refCounter(0) {
+        m_interface.Context       = this;
+        m_interface.AddRef        = AddRef;
+        m_interface.Release       = Release;
+        m_interface.GetRefCounter = GetRefCounter;
+        m_interface.Map           = Map;
+        m_interface.Unmap         = Unmap;
+        m_interface.Synchronize   = Synchronize;
+        m_surface.FrameInterface  = &m_interface;
+
+        uint32_t chromaHeight   = (height + 1) / 2;
+        m_surface.Info.FourCC   = static_cast<mfxU32>(fourcc);
+        m_surface.Info.Width    = static_cast<mfxU16>(width);
+        m_surface.Info.Height   = static_cast<mfxU16>(height);
+        m_surface.Data.PitchLow = static_cast<mfxU16>(pitch);
+        m_surface.Data.Y        = m_data.data();
+        switch (fourcc) {
+            case color_format_fourcc::i420:
+                m_surface.Data.U = m_data.data() + pitch * height;
+                m_surface.Data.V = m_surface.Data.U + pitch / 2 * chromaHeight;
+                break;
+            case color_format_fourcc::bgra:
+                m_surface.Data.B = m_data.data();
+                break;
+            default:
+                m_surface.Data.UV = m_data.data() + pitch * height;
+                break;
+        }
+    }
+
+    // handle holds the reference of the test
+    std::shared_ptr<vpl::frame_surface> Handle() {
+        m_refCounter++;
+        auto s = std::make_shared<vpl::frame_surface>();
+        s->adopt(&m_surface);
+        return s;
+    }
+
+    const std::vector<uint8_t> &Data() const {
+        return m_data;
+    }
+    mfxU32 GetRefs() const {
+        return m_refCounter;
+    }
+
+private:
+    static SystemSurface *Self(mfxFrameSurface1 *surface) {
+        return static_cast<SystemSurface *>(surface->FrameInterface->Context);
+    }
+    static mfxStatus MFX_CDECL AddRef(mfxFrameSurface1 *surface) {
+        Self(surface)->m_refCounter++;
+        return MFX_ERR_NONE;
+    }
+    static mfxStatus MFX_CDECL Release(mfxFrameSurface1 *surface) {
+        Self(surface)->m_refCounter--;
+        return MFX_ERR_NONE;
+    }
+    static mfxStatus MFX_CDECL GetRefCounter(mfxFrameSurface1 *surface, mfxU32 *counter) {
+        *counter = Self(surface)->m_refCounter;
+        return MFX_ERR_NONE;
+    }
+    static mfxStatus MFX_CDECL Map(mfxFrameSurface1 *, mfxU32) {
+        return MFX_ERR_NONE;
+    }
+    static mfxStatus MFX_CDECL Unmap(mfxFrameSurface1 *) {
+        return MFX_ERR_NONE;
+    }
+    static mfxStatus MFX_CDECL Synchronize(mfxFrameSurface1 *, mfxU32) {
+        return MFX_ERR_NONE;
+    }
+
+    mfxFrameSurface1 m_surface;
+    mfxFrameSurfaceInterface m_interface;
+    std::vector<uint8_t> m_data;
+    mfxU32 m_refCounter;
+};
+
+struct FrameFormat {
+    color_format_fourcc file;
+    color_format_fourcc surface;
+};
+
+static std::string FormatName(color_format_fourcc fourcc) {
+    mfxU32 f = static_cast<mfxU32>(fourcc);
+    return std::string{ static_cast<char>(f & 0xFF),
+                        static_cast<char>((f >> 8) & 0xFF),
+                        static_cast<char>((f >> 16) & 0xFF),
+                        static_cast<char>((f >> 24) & 0xFF) };
+}
+
+static void Put16(std::vector<uint8_t> &dst, size_t pos, uint16_t value) {
+    dst[pos]     = static_cast<uint8_t>(value & 0xFF);
+    dst[pos + 1] = static_cast<uint8_t>(value >> 8);
+}
+
+static uint16_t Get16(const std::vector<uint8_t> &src, size_t pos) {
+    return static_cast<uint16_t>(src[pos] | (src[pos + 1] << 8));
+}
+
+// writes the frame into the surface layout of SystemSurface with plain loops
+static std::vector<uint8_t> ExpectedSurface(FrameFormat format,
+                                            const std::vector<uint8_t> &file,
+                                            uint32_t w,
+                                            uint32_t h,
+                                            uint32_t pitch) {
+    std::vector<uint8_t> out(pitch * h * 3, GUARD);
+    uint32_t cw   = (w + 1) / 2;
+    uint32_t ch   = (h + 1) / 2;
+    size_t luma   = static_cast<size_t>(w) * h;
+    size_t chroma = static_cast<size_t>(cw) * ch;
+    size_t uvBase = static_cast<size_t>(pitch) * h;
+
+    switch (format.file) {
+        case color_format_fourcc::i420:
+            for (uint32_t y = 0; y < h; y++)
+                for (uint32_t x = 0; x < w; x++)
+                    out[y * pitch + x] = file[y * w + x];
+            for (uint32_t y = 0; y < ch; y++) {
+                for (uint32_t x = 0; x < cw; x++) {
+                    uint8_t u = file[luma + y * cw + x];
+                    uint8_t v = file[luma + chroma + y * cw + x];
+                    if (format.surface == color_format_fourcc::nv12) {
+                        out[uvBase + y * pitch + 2 * x]     = u;
+                        out[uvBase + y * pitch + 2 * x + 1] = v;
+                    }
+                    else {
+                        out[uvBase + y * (pitch / 2) + x]                    = u;
+                        out[uvBase + (pitch / 2) * ch + y * (pitch / 2) + x] = v;
+                    }
+                }
+            }
+            break;
+        case color_format_fourcc::nv12:
+            for (uint32_t y = 0; y < h; y++)
+                for (uint32_t x = 0; x < w; x++)
+                    out[y * pitch + x] = file[y * w + x];
+            for (uint32_t y = 0; y < ch; y++)
+                for (uint32_t x = 0; x < 2 * cw; x++)
+                    out[uvBase + y * pitch + x] = file[luma + y * 2 * cw + x];
+            break;
+        case color_format_fourcc::i010:
+            for (uint32_t y = 0; y < h; y++)
+                for (uint32_t x = 0; x < w; x++)
+                    Put16(out, y * pitch + 2 * x, Get16(file, 2 * (y * w + x)) << 6);
+            for (uint32_t y = 0; y < ch; y++) {
+                for (uint32_t x = 0; x < cw; x++) {
+                    uint16_t u = Get16(file, 2 * (luma + y * cw + x));
+                    uint16_t v = Get16(file, 2 * (luma + chroma + y * cw + x));
+                    Put16(out, uvBase + y * pitch + 4 * x, u << 6);
+                    Put16(out, uvBase + y * pitch + 4 * x + 2, v << 6);
+                }
+            }
+            break;
+        case color_format_fourcc::p010:
+            for (uint32_t y = 0; y < h; y++)
+                for (uint32_t x = 0; x < 2 * w; x++)
+                    out[y * pitch + x] = file[y * 2 * w + x];
+            for (uint32_t y = 0; y < ch; y++)
+                for (uint32_t x = 0; x < 4 * cw; x++)
+                    out[uvBase + y * pitch + x] = file[2 * luma + y * 4 * cw + x];
+            break;
+        case color_format_fourcc::yuy2:
+            for (uint32_t y = 0; y < h; y++)
+                for (uint32_t x = 0; x < 4 * cw; x++)
+                    out[y * pitch + x] = file[y * 4 * cw + x];
+            break;
+        default:
+            for (uint32_t y = 0; y < h; y++)
+                for (uint32_t x = 0; x < 4 * w; x++)
+                    out[y * pitch + x] = file[y * 4 * w + x];
+            break;
+    }
+    return out;
+}
+
+static size_t FrameSize(color_format_fourcc fourcc, uint32_t w, uint32_t h) {
+    size_t luma   = static_cast<size_t>(w) * h;
+    size_t chroma = static_cast<size_t>((w + 1) / 2) * ((h + 1) / 2);
+    switch (fourcc) {
+        case color_format_fourcc::i420:
+        case color_format_fourcc::nv12:
+            return luma + 2 * chroma;
+        case color_format_fourcc::i010:
+        case color_format_fourcc::p010:
+            return 2 * (luma + 2 * chroma);
+        case color_format_fourcc::yuy2:
+            return 4 * static_cast<size_t>((w + 1) / 2) * h;
+        default:
+            return 4 * luma;
+    }
+}
+
+// bytes in a row of the widest plane
+static uint32_t RowBytes(color_format_fourcc fourcc, uint32_t w) {
+    switch (fourcc) {
+        case color_format_fourcc::i420:
+        case color_format_fourcc::nv12:
+            return 2 * ((w + 1) / 2);
+        case color_format_fourcc::p010:
+            return 4 * ((w + 1) / 2);
+        case color_format_fourcc::yuy2:
+            return 4 * ((w + 1) / 2);
+        default:
+            return 4 * w;
+    }
+}
+
+static std::string TestFileName() {
+    const testing::TestInfo *info = testing::UnitTest::GetInstance()->current_test_info();
+    return std::string("vpl_preview_") + info->name() + ".yuv";
+}
+
+static std::vector<uint8_t> WriteFrame(const std::string &name,
+                                       FrameFormat format,
+                                       uint32_t w,
+                                       uint32_t h) {
+    size_t size = FrameSize(format.file, w, h);
+    std::vector<uint8_t> data;
+    if (format.file == color_format_fourcc::i010 || format.file == color_format_fourcc::p010) {
+        std::vector<uint16_t> samples = RandomSamples(size / 2, w * h);
+        data.resize(size);
+        for (size_t i = 0; i < samples.size(); i++)
+            Put16(data,
+                  2 * i,
+                  format.file == color_format_fourcc::p010 ? samples[i] << 6 : samples[i]);
+    }
+    else {
+        data = RandomBytes(size, w * h);
+    }
+
+    FILE *f = fopen(name.c_str(), "wb");
+    EXPECT_NE(f, nullptr);
+    if (f) {
+        fwrite(data.data(), 1, data.size(), f);
+        fclose(f);
+    }
+    return data;
+}
+
+TEST(Preview_FrameCopy, BulkReaderMatchesScalarForEachFormat) {
+    const FrameFormat formats[] = {
+        { color_format_fourcc::i420, color_format_fourcc::i420 },
+        { color_format_fourcc::i420, color_format_fourcc::nv12 },
+        { color_format_fourcc::nv12, color_format_fourcc::nv12 },
+        { color_format_fourcc::i010, color_format_fourcc::p010 },
+        { color_format_fourcc::p010, color_format_fourcc::p010 },
+        { color_format_fourcc::yuy2, color_format_fourcc::yuy2 },
+        { color_format_fourcc::bgra, color_format_fourcc::bgra },
+    };
+    // odd sizes leave the vector kernels with remainders, and odd pitches unalign the rows
+    const uint32_t sizes[][2] = { { 2, 2 }, { 37, 5 }, { 64, 4 }, { 129, 3 } };
+    std::string name          = TestFileName();
+
+    for (const FrameFormat &format : formats) {
+        for (const auto &size : sizes) {
+            uint32_t w     = size[0];
+            uint32_t h     = size[1];
+            uint32_t pitch = RowBytes(format.surface, w) + 7;
+            // 16-bit samples and I420 chroma at half the pitch need even pitch
+            if (format.surface != color_format_fourcc::nv12 &&
+                format.surface != color_format_fourcc::yuy2 &&
+                format.surface != color_format_fourcc::bgra)
+                pitch++;
+
+            std::vector<uint8_t> file = WriteFrame(name, format, w, h);
+            SystemSurface surface(format.surface, w, h, pitch);
+            {
+                vpl::raw_frame_bulk_file_reader rdr(static_cast<uint16_t>(w),
+                                                    static_cast<uint16_t>(h),
+                                                    format.file,
+                                                    format.surface,
+                                                    name);
+                EXPECT_TRUE(rdr.get_data(surface.Handle()));
+                EXPECT_FALSE(rdr.is_EOS());
+                EXPECT_FALSE(rdr.get_data(surface.Handle()));
+                EXPECT_TRUE(rdr.is_EOS());
+            }
+            EXPECT_EQ(surface.GetRefs(), 0u);
+            EXPECT_EQ(surface.Data(), ExpectedSurface(format, file, w, h, pitch))
+                << FormatName(format.file) << " -> " << FormatName(format.surface) << " " << w
+                << "x" << h << ", pitch " << pitch;
+        }
+    }
+    remove(name.c_str());
+}
+
+TEST(Preview_FrameCopy, ReadersAcceptBGRA) {
+    const uint32_t w = 37, h = 5, pitch = 4 * w + 7;
+    std::string name = TestFileName();
+    std::vector<uint8_t> file =
+        WriteFrame(name, { color_format_fourcc::bgra, color_format_fourcc::bgra }, w, h);
+
+    SystemSurface byName(color_format_fourcc::bgra, w, h, pitch);
+    {
+        vpl::raw_frame_file_reader_by_name rdr(w, h, color_format_fourcc::bgra, name);
+        EXPECT_NO_THROW(rdr.get_data(byName.Handle()));
+    }
+
+    SystemSurface bulk(color_format_fourcc::bgra, w, h, pitch);
+    {
+        vpl::raw_frame_bulk_file_reader rdr(w,
+                                            h,
+                                            color_format_fourcc::bgra,
+                                            color_format_fourcc::bgra,
+                                            name);
+        EXPECT_TRUE(rdr.get_data(bulk.Handle()));
+    }
+
+    EXPECT_EQ(byName.Data(), bulk.Data());
+    remove(name.c_str());
+}
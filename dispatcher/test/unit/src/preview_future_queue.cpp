@@ -0,0 +1,195 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+///
+/// Unit tests for the preview C++ API queue of operations in flight (oneapi::vpl::future_queue).
+///
+/// @file
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include "vpl/preview/future.hpp"
+
+using oneapi::vpl::component;
+using oneapi::vpl::frame_surface;
+using oneapi::vpl::future;
+using oneapi::vpl::future_queue;
+using oneapi::vpl::operation_status;
+using oneapi::vpl::status;
+
+typedef future<std::shared_ptr<frame_surface>> future_surface_t;
+
+// future of a scheduled operation, without data so nothing waits on the runtime
+static std::shared_ptr<future_surface_t> MakeFuture(status sts, bool fatal = false) {
+    auto f = std::make_shared<future_surface_t>(nullptr);
+    operation_status op(component::decoder, nullptr);
+    op.schedule_status_ = sts;
+    op.fatal_           = fatal;
+    f->add_operation(op);
+    return f;
+}
+
+TEST(Preview_FutureQueue, DepthOneHandsBackImmediately) {
+    future_queue<future_surface_t> q;
+    EXPECT_EQ(q.get_depth(), 1u);
+
+    auto f = MakeFuture(status::Ok);
+    EXPECT_EQ(q.pass(f), f);
+    EXPECT_EQ(q.size(), 0u);
+}
+
+TEST(Preview_FutureQueue, ZeroDepthIsTreatedAsOne) {
+    future_queue<future_surface_t> q(0);
+    EXPECT_EQ(q.get_depth(), 1u);
+
+    q.set_depth(0);
+    EXPECT_EQ(q.get_depth(), 1u);
+}
+
+TEST(Preview_FutureQueue, FuturesAreHandedBackInSubmissionOrder) {
+    future_queue<future_surface_t> q(3);
+
+    auto f1 = MakeFuture(status::Ok);
+    auto f2 = MakeFuture(status::Ok);
+    auto f3 = MakeFuture(status::Ok);
+    auto f4 = MakeFuture(status::Ok);
+
+    auto out = q.pass(f1);
+    EXPECT_NE(out, f1);
+    EXPECT_EQ(out->get_last_schedule_status(), status::NotEnoughData);
+    out = q.pass(f2);
+    EXPECT_EQ(out->get_last_schedule_status(), status::NotEnoughData);
+    EXPECT_EQ(q.size(), 2u);
+
+    EXPECT_EQ(q.pass(f3), f1);
+    EXPECT_EQ(q.pass(f4), f2);
+    EXPECT_EQ(q.size(), 2u);
+}
+
+TEST(Preview_FutureQueue, PlaceholderKeepsHistoryOfQueuedFuture) {
+    future_queue<future_surface_t> q(2);
+
+    auto f = MakeFuture(status::Ok);
+    operation_status op(component::vpp, nullptr);
+    op.schedule_status_ = status::Ok;
+    f->add_operation(op);
+
+    auto out = q.pass(f);
+    ASSERT_EQ(out->history_.size(), 2u);
+    EXPECT_EQ(out->history_.front().component_, component::decoder);
+    EXPECT_EQ(out->history_.back().component_, component::vpp);
+    EXPECT_EQ(out->history_.back().schedule_status_, status::NotEnoughData);
+
+    // queued future itself is not touched
+    EXPECT_EQ(f->get_last_schedule_status(), status::Ok);
+}
+
+TEST(Preview_FutureQueue, EndOfStreamDrainsOldestFirst) {
+    future_queue<future_surface_t> q(4);
+
+    auto f1 = MakeFuture(status::Ok);
+    auto f2 = MakeFuture(status::Ok);
+    q.pass(f1);
+    q.pass(f2);
+
+    auto eos = MakeFuture(status::EndOfStreamReached);
+    EXPECT_EQ(q.pass(eos), f1);
+    EXPECT_EQ(q.pass(eos), f2);
+    EXPECT_EQ(q.size(), 0u);
+    EXPECT_EQ(q.pass(eos), eos);
+}
+
+TEST(Preview_FutureQueue, OperationWithoutDataIsPassedThrough) {
+    future_queue<future_surface_t> q(2);
+
+    auto f1 = MakeFuture(status::Ok);
+    q.pass(f1);
+
+    // frame buffered inside the component, nothing to queue
+    auto more = MakeFuture(status::NotEnoughData);
+    EXPECT_EQ(q.pass(more), more);
+    EXPECT_EQ(q.size(), 1u);
+
+    auto f2 = MakeFuture(status::Ok);
+    EXPECT_EQ(q.pass(f2), f1);
+}
+
+TEST(Preview_FutureQueue, FatalErrorDropsQueuedFutures) {
+    future_queue<future_surface_t> q(4);
+
+    auto f1 = MakeFuture(status::Ok);
+    auto f2 = MakeFuture(status::Ok);
+    q.pass(f1);
+    q.pass(f2);
+    std::weak_ptr<future_surface_t> w1 = f1;
+    std::weak_ptr<future_surface_t> w2 = f2;
+    f1.reset();
+    f2.reset();
+
+    auto fatal = MakeFuture(status::Unknown, true);
+    EXPECT_EQ(q.pass(fatal), fatal);
+    EXPECT_EQ(q.size(), 0u);
+    EXPECT_TRUE(w1.expired());
+    EXPECT_TRUE(w2.expired());
+
+    // queue is usable again
+    auto f3 = MakeFuture(status::Ok);
+    EXPECT_EQ(q.pass(f3)->get_last_schedule_status(), status::NotEnoughData);
+    EXPECT_EQ(q.size(), 1u);
+}
+
+TEST(Preview_FutureQueue, RaisingDepthKeepsOrderOfWrappedQueue) {
+    future_queue<future_surface_t> q(2);
+
+    auto f1 = MakeFuture(status::Ok);
+    auto f2 = MakeFuture(status::Ok);
+    auto f3 = MakeFuture(status::Ok);
+    q.pass(f1);
+    EXPECT_EQ(q.pass(f2), f1);
+    // oldest queued future is at the end of the storage now
+    EXPECT_EQ(q.pass(f3), f2);
+
+    q.set_depth(4);
+    auto f4 = MakeFuture(status::Ok);
+    auto f5 = MakeFuture(status::Ok);
+    auto f6 = MakeFuture(status::Ok);
+    auto f7 = MakeFuture(status::Ok);
+    EXPECT_EQ(q.pass(f4)->get_last_schedule_status(), status::NotEnoughData);
+    EXPECT_EQ(q.pass(f5)->get_last_schedule_status(), status::NotEnoughData);
+    EXPECT_EQ(q.pass(f6), f3);
+    EXPECT_EQ(q.pass(f7), f4);
+
+    q.clear();
+    EXPECT_EQ(q.size(), 0u);
+}
+
+TEST(Preview_Future, FullHistoryKeepsLatestOperations) {
+    const size_t cap = oneapi::vpl::OPERATION_HISTORY_CAPACITY;
+
+    // upstream pipeline longer than the history
+    auto upstream = MakeFuture(status::Ok);
+    for (size_t i = 1; i < cap + 4; i++) {
+        operation_status op(i % 2 ? component::vpp : component::decoder, nullptr);
+        op.schedule_status_ = (i == cap + 3) ? status::NotEnoughData : status::Ok;
+        upstream->add_operation(op);
+    }
+    ASSERT_EQ(upstream->history_.size(), cap);
+    EXPECT_EQ(upstream->get_last_schedule_status(), status::NotEnoughData);
+
+    auto f = std::make_shared<future_surface_t>(nullptr);
+    operation_status last(component::encoder, nullptr);
+    last.schedule_status_ = status::Ok;
+    f->add_operation(last);
+    f->propagate_history(*upstream);
+
+    // oldest upstream statuses are dropped, own status stays the latest
+    ASSERT_EQ(f->history_.size(), cap);
+    EXPECT_EQ(f->history_.back().component_, component::encoder);
+    EXPECT_EQ(f->get_last_schedule_status(), status::Ok);
+    EXPECT_EQ(f->history_.rbegin()[1].schedule_status_, status::NotEnoughData);
+}
@@ -0,0 +1,239 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+///
+/// Unit tests for the preview C++ API session pool (oneapi::vpl::session_pool).
+///
+/// @file
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <stdexcept>
+
+#include "vpl/preview/vpl.hpp"
+
+#include "src/dispatcher_common.h"
+
+namespace vpl = oneapi::vpl;
+
+// encoder session which exposes its handle
+class PooledEncodeSession : public vpl::encode_session {
+public:
+    explicit PooledEncodeSession(const vpl::implementation_selector &sel) : encode_session(sel) {}
+
+    mfxSession GetHandle() const {
+        return session_;
+    }
+};
+
+static std::unique_ptr<vpl::default_selector<>> MakeStubSelector(
+    std::shared_ptr<vpl::session_pool> pool) {
+    auto sel = std::make_unique<vpl::default_selector<>>(
+        vpl::property_list{ vpl::dprops::impl_name("Stub Implementation") });
+    sel->set_session_pool(pool);
+    return sel;
+}
+
+TEST(Preview_Stub_SessionPool, DestroyedSessionIsReused) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    auto pool = std::make_shared<vpl::session_pool>(2);
+    auto sel  = MakeStubSelector(pool);
+
+    mfxSession first = nullptr;
+    {
+        PooledEncodeSession s(*sel);
+        first = s.GetHandle();
+        EXPECT_NE(first, nullptr);
+        EXPECT_EQ(pool->stats().misses, 1u);
+        EXPECT_EQ(pool->stats().idle, 0u);
+    }
+    EXPECT_EQ(pool->stats().idle, 1u);
+
+    {
+        PooledEncodeSession s(*sel);
+        EXPECT_EQ(s.GetHandle(), first);
+
+        vpl::session_pool_stats stats = pool->stats();
+        EXPECT_EQ(stats.hits, 1u);
+        EXPECT_EQ(stats.misses, 1u);
+        EXPECT_EQ(stats.idle, 0u);
+    }
+    EXPECT_EQ(pool->stats().idle, 1u);
+}
+
+TEST(Preview_Stub_SessionPool, FailedSessionIsClosed) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    auto pool = std::make_shared<vpl::session_pool>(2);
+    auto sel  = MakeStubSelector(pool);
+
+    {
+        PooledEncodeSession s(*sel);
+        s.set_failed();
+    }
+
+    vpl::session_pool_stats stats = pool->stats();
+    EXPECT_EQ(stats.evictions, 1u);
+    EXPECT_EQ(stats.idle, 0u);
+
+    PooledEncodeSession s(*sel);
+    EXPECT_EQ(pool->stats().misses, 2u);
+}
+
+TEST(Preview_Stub_SessionPool, SessionDestroyedByExceptionIsClosed) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    auto pool = std::make_shared<vpl::session_pool>(2);
+    auto sel  = MakeStubSelector(pool);
+
+    try {
+        PooledEncodeSession s(*sel);
+        throw std::runtime_error("pipeline failed");
+    }
+    catch (std::runtime_error &) {
+    }
+
+    vpl::session_pool_stats stats = pool->stats();
+    EXPECT_EQ(stats.evictions, 1u);
+    EXPECT_EQ(stats.idle, 0u);
+}
+
+TEST(Preview_Stub_SessionPool, SessionsOverMaxIdleAreClosed) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    auto pool = std::make_shared<vpl::session_pool>(1);
+    auto sel  = MakeStubSelector(pool);
+
+    {
+        PooledEncodeSession s1(*sel);
+        PooledEncodeSession s2(*sel);
+        EXPECT_NE(s1.GetHandle(), s2.GetHandle());
+    }
+
+    vpl::session_pool_stats stats = pool->stats();
+    EXPECT_EQ(stats.misses, 2u);
+    EXPECT_EQ(stats.idle, 1u);
+    EXPECT_EQ(stats.discards, 1u);
+}
+
+TEST(Preview_Stub_SessionPool, ClearClosesIdleSessions) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    auto pool = std::make_shared<vpl::session_pool>(2);
+    auto sel  = MakeStubSelector(pool);
+
+    {
+        PooledEncodeSession s(*sel);
+    }
+    EXPECT_EQ(pool->stats().idle, 1u);
+
+    pool->clear();
+    EXPECT_EQ(pool->stats().idle, 0u);
+
+    PooledEncodeSession s(*sel);
+    EXPECT_EQ(pool->stats().hits, 0u);
+    EXPECT_EQ(pool->stats().misses, 2u);
+}
+
+TEST(Preview_Stub_SessionPool, SessionsAreNotSharedBetweenLoaders) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    auto pool = std::make_shared<vpl::session_pool>(2);
+    auto sel  = MakeStubSelector(pool);
+
+    // other properties select the same implementation through another loader
+    vpl::default_selector<> other({ vpl::dprops::impl_name("Stub Implementation"),
+                                    vpl::dprops::impl(vpl::implementation_type::sw) });
+    other.set_session_pool(pool);
+
+    {
+        PooledEncodeSession s(*sel);
+    }
+    {
+        PooledEncodeSession s(other);
+        EXPECT_EQ(pool->stats().hits, 0u);
+    }
+    EXPECT_EQ(pool->stats().idle, 2u);
+
+    PooledEncodeSession s(*sel);
+    EXPECT_EQ(pool->stats().hits, 1u);
+}
+
+TEST(Preview_Stub_SessionPool, SessionWithoutPoolIsClosed) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    auto pool = std::make_shared<vpl::session_pool>(2);
+    auto sel  = MakeStubSelector(nullptr);
+
+    {
+        PooledEncodeSession s(*sel);
+    }
+    sel->set_session_pool(pool);
+    {
+        PooledEncodeSession s(*sel);
+    }
+
+    vpl::session_pool_stats stats = pool->stats();
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.idle, 1u);
+}
+
+static vpl::encoder_video_param MakeEncoderParams(uint16_t width, uint16_t height) {
+    mfxFrameInfo info = {};
+    info.FourCC       = MFX_FOURCC_NV12;
+    info.ChromaFormat = MFX_CHROMAFORMAT_YUV420;
+    info.Width        = width;
+    info.Height       = height;
+    info.CropW        = width;
+    info.CropH        = height;
+
+    vpl::encoder_video_param params;
+    params.set_frame_info(vpl::frame_info(info));
+    params.set_CodecId(vpl::codec_format_fourcc::hevc);
+    return params;
+}
+
+TEST(Preview_Stub_SessionPool, ReusedEncoderIsReset) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    auto pool = std::make_shared<vpl::session_pool>(2);
+    auto sel  = MakeStubSelector(pool);
+
+    vpl::encoder_video_param first = MakeEncoderParams(320, 240);
+    {
+        PooledEncodeSession s(*sel);
+        EXPECT_EQ(s.Init(&first), vpl::status::Ok);
+    }
+
+    // stub encoder fails Init while it is initialized, so only Reset succeeds here
+    vpl::encoder_video_param second = MakeEncoderParams(176, 144);
+    PooledEncodeSession s(*sel);
+    EXPECT_EQ(pool->stats().hits, 1u);
+    EXPECT_EQ(s.Init(&second), vpl::status::Ok);
+    EXPECT_EQ(s.working_params()->getMfx()->mfx.FrameInfo.Width, 176);
+}
+
+TEST(Preview_Stub_SessionPool, IncompatibleParamsReinitializeReusedEncoder) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    auto pool = std::make_shared<vpl::session_pool>(2);
+    auto sel  = MakeStubSelector(pool);
+
+    vpl::encoder_video_param first = MakeEncoderParams(176, 144);
+    {
+        PooledEncodeSession s(*sel);
+        EXPECT_EQ(s.Init(&first), vpl::status::Ok);
+    }
+
+    // larger frames don't fit the surfaces of the stub encoder, Reset fails
+    vpl::encoder_video_param second = MakeEncoderParams(320, 240);
+    PooledEncodeSession s(*sel);
+    EXPECT_EQ(pool->stats().hits, 1u);
+    EXPECT_EQ(s.Init(&second), vpl::status::Ok);
+    EXPECT_EQ(s.working_params()->getMfx()->mfx.FrameInfo.Width, 320);
+}
@@ -26,6 +26,10 @@ struct mfxDispatcherVersion {
 };
 
 static mfxStatus GetDispatcherVersion(mfxDispatcherVersion *dispatcherVersion);
+static mfxStatus RunStartupPass(const char *passName);
+static mfxStatus RunFilterUpdatePass(mfxU32 numUpdates);
+static mfxStatus RunProbePass(const char *probeThreads);
+static void SetEnv(const char *name, const char *value);
 
 static void SetDefaultParamsEncode(mfxVideoParam *par) {
     par->mfx.CodecId                  = MFX_CODEC_AVC;
@@ -60,8 +64,24 @@ int main(int argc, char *argv[]) {
     bool bUseFastLoad   = false;
     bool bPrintImplPath = false;
 
+    const char *cacheFile    = nullptr;
+    mfxU32 numFilterUpdates  = 0;
+    const char *probeThreads = nullptr;
+
     for (int i = 1; i < argc; i++) {
-        if (!strncmp(argv[i], "-e", 2)) {
+        if (!strncmp(argv[i], "-cache", 6) && i + 1 < argc) {
+            i++;
+            cacheFile = argv[i];
+        }
+        else if (!strncmp(argv[i], "-filters", 8) && i + 1 < argc) {
+            i++;
+            numFilterUpdates = atol(argv[i]);
+        }
+        else if (!strncmp(argv[i], "-probe", 6) && i + 1 < argc) {
+            i++;
+            probeThreads = argv[i];
+        }
+        else if (!strncmp(argv[i], "-e", 2)) {
             bEnumImpls = true;
         }
         else if (!strncmp(argv[i], "-f", 2)) {
@@ -81,8 +101,58 @@ int main(int argc, char *argv[]) {
             printf("       -f ................ enable fast loading\n");
             printf("       -p ................ print paths of loaded implementation\n");
             printf("       -adapterNum n ..... use device adapter number n (default = 0)\n");
+            printf("       -cache file ....... cold vs. warm startup with new caps cache file\n");
+            printf("       -filters n ........ time n updates of multi-property encoder filters\n");
+            printf("       -probe n .......... per-library probe time, serial vs. n probe threads\n");
+            return -1;
+        }
+    }
+
+    if (cacheFile) {
+        // cold pass needs a new file, don't overwrite anything the user has
+        FILE *existing = fopen(cacheFile, "rb");
+        if (existing) {
+            fclose(existing);
+            printf("Error - cache file %s already exists, choose a new file\n", cacheFile);
+            return -1;
+        }
+
+        // enable dispatcher caps cache for the cold and warm passes only
+        SetEnv("ONEVPL_DISPATCHER_CACHE_FILE", cacheFile);
+
+        // cold - all runtimes are loaded and queried, cache file is written
+        sts = RunStartupPass("Startup (cold cache)");
+        if (sts != MFX_ERR_NONE) {
+            printf("Error - cold startup pass returned %d\n", sts);
             return -1;
         }
+
+        // warm - caps are read from the cache file
+        sts = RunStartupPass("Startup (warm cache)");
+        SetEnv("ONEVPL_DISPATCHER_CACHE_FILE", nullptr);
+        if (sts != MFX_ERR_NONE) {
+            printf("Error - warm startup pass returned %d\n", sts);
+            return -1;
+        }
+        printf("\n");
+    }
+
+    if (probeThreads) {
+        sts = RunProbePass(probeThreads);
+        if (sts != MFX_ERR_NONE) {
+            printf("Error - probe pass returned %d\n", sts);
+            return -1;
+        }
+        printf("\n");
+    }
+
+    if (numFilterUpdates) {
+        sts = RunFilterUpdatePass(numFilterUpdates);
+        if (sts != MFX_ERR_NONE) {
+            printf("Error - filter update pass returned %d\n", sts);
+            return -1;
+        }
+        printf("\n");
     }
 
     VPL_LOG_TIME_START(totaltime, "Total time");
@@ -268,6 +338,233 @@ int main(int argc, char *argv[]) {
     return 0;
 }
 
+// time full startup sequence, from MFXLoad to first session
+static mfxStatus RunStartupPass(const char *passName) {
+    mfxStatus sts = MFX_ERR_NONE;
+
+    VPL_LOG_TIME_START(startup, passName);
+
+    mfxLoader loader = MFXLoad();
+    if (loader == NULL)
+        return MFX_ERR_NOT_FOUND;
+
+    mfxImplDescription *idesc = nullptr;
+    sts                       = MFXEnumImplementations(loader,
+                                 0,
+                                 MFX_IMPLCAPS_IMPLDESCSTRUCTURE,
+                                 reinterpret_cast<mfxHDL *>(&idesc));
+    if (sts != MFX_ERR_NONE) {
+        MFXUnload(loader);
+        return sts;
+    }
+    MFXDispReleaseImplDescription(loader, idesc);
+
+    mfxSession session = nullptr;
+    sts                = MFXCreateSession(loader, 0, &session);
+    if (sts != MFX_ERR_NONE) {
+        MFXUnload(loader);
+        return sts;
+    }
+
+    VPL_LOG_TIME_END(startup);
+
+    MFXClose(session);
+    MFXUnload(loader);
+
+    return MFX_ERR_NONE;
+}
+
+static mfxStatus SetFilterU32(mfxConfig config, const char *name, mfxU32 val) {
+    mfxVariant var      = {};
+    var.Version.Version = MFX_VARIANT_VERSION;
+    var.Type            = MFX_VARIANT_TYPE_U32;
+    var.Data.U32        = val;
+
+    return MFXSetConfigFilterProperty(config, (const mfxU8 *)name, var);
+}
+
+// time repeated filter updates - each update adds a config object with
+//   encoder CodecID, Profile, MemHandleType, and ColorFormat of the last
+//   encoder supported by implementation 0, then re-enumerates implementations
+//   (with the stub runtime in the search path, this exercises only the dispatcher)
+static mfxStatus RunFilterUpdatePass(mfxU32 numUpdates) {
+    mfxStatus sts = MFX_ERR_NONE;
+
+    mfxLoader loader = MFXLoad();
+    if (loader == NULL)
+        return MFX_ERR_NOT_FOUND;
+
+    // pick a supported encoder config so every update leaves a valid implementation
+    mfxImplDescription *idesc = nullptr;
+    sts                       = MFXEnumImplementations(loader,
+                                 0,
+                                 MFX_IMPLCAPS_IMPLDESCSTRUCTURE,
+                                 reinterpret_cast<mfxHDL *>(&idesc));
+    if (sts != MFX_ERR_NONE) {
+        MFXUnload(loader);
+        return sts;
+    }
+
+    if (idesc->Enc.NumCodecs == 0) {
+        printf("Error - implementation 0 does not support any encoders\n");
+        MFXDispReleaseImplDescription(loader, idesc);
+        MFXUnload(loader);
+        return MFX_ERR_UNSUPPORTED;
+    }
+
+    auto *codec = &idesc->Enc.Codecs[idesc->Enc.NumCodecs - 1];
+    if (codec->NumProfiles == 0) {
+        printf("Error - encoder %u does not report any profiles\n", codec->CodecID);
+        MFXDispReleaseImplDescription(loader, idesc);
+        MFXUnload(loader);
+        return MFX_ERR_UNSUPPORTED;
+    }
+
+    auto *profile = &codec->Profiles[codec->NumProfiles - 1];
+    if (profile->NumMemTypes == 0) {
+        printf("Error - encoder profile %u has no memory types\n", profile->Profile);
+        MFXDispReleaseImplDescription(loader, idesc);
+        MFXUnload(loader);
+        return MFX_ERR_UNSUPPORTED;
+    }
+
+    auto *memDesc = &profile->MemDesc[profile->NumMemTypes - 1];
+    if (memDesc->NumColorFormats == 0) {
+        printf("Error - encoder memory type %d has no color formats\n", memDesc->MemHandleType);
+        MFXDispReleaseImplDescription(loader, idesc);
+        MFXUnload(loader);
+        return MFX_ERR_UNSUPPORTED;
+    }
+
+    mfxU32 codecID     = codec->CodecID;
+    mfxU32 profileID   = profile->Profile;
+    mfxU32 memType     = memDesc->MemHandleType;
+    mfxU32 colorFormat = memDesc->ColorFormats[memDesc->NumColorFormats - 1];
+    MFXDispReleaseImplDescription(loader, idesc);
+
+    VPL_LOG_TIME_START(filterupdate, "Filter updates");
+
+    for (mfxU32 i = 0; i < numUpdates; i++) {
+        mfxConfig config = MFXCreateConfig(loader);
+
+        SetFilterU32(config, "mfxImplDescription.mfxEncoderDescription.encoder.CodecID", codecID);
+        SetFilterU32(config,
+                     "mfxImplDescription.mfxEncoderDescription.encoder.encprofile.Profile",
+                     profileID);
+        SetFilterU32(config,
+                     "mfxImplDescription.mfxEncoderDescription.encoder.encprofile.encmemdesc."
+                     "MemHandleType",
+                     memType);
+        SetFilterU32(config,
+                     "mfxImplDescription.mfxEncoderDescription.encoder.encprofile.encmemdesc."
+                     "ColorFormats",
+                     colorFormat);
+
+        idesc = nullptr;
+        sts   = MFXEnumImplementations(loader,
+                                     0,
+                                     MFX_IMPLCAPS_IMPLDESCSTRUCTURE,
+                                     reinterpret_cast<mfxHDL *>(&idesc));
+        if (sts != MFX_ERR_NONE) {
+            MFXUnload(loader);
+            return sts;
+        }
+        MFXDispReleaseImplDescription(loader, idesc);
+    }
+
+    VPL_LOG_TIME_END(filterupdate);
+
+    printf("  %u config objects with 4 encoder properties each\n", numUpdates);
+
+    MFXUnload(loader);
+
+    return MFX_ERR_NONE;
+}
+
+static void SetEnv(const char *name, const char *value) {
+#if defined(_WIN32) || defined(_WIN64)
+    _putenv_s(name, value ? value : "");
+#else
+    if (value)
+        setenv(name, value, 1);
+    else
+        unsetenv(name);
+#endif
+}
+
+// time MFXLoad and the first enumeration, which is where the dispatcher
+//   loads and queries (probes) every runtime library in the search path
+static mfxStatus RunLoadEnumPass(const char *passName, bool bPrintImplPath) {
+    mfxStatus sts = MFX_ERR_NONE;
+
+    VPL_LOG_TIME_START(loadenum, passName);
+
+    mfxLoader loader = MFXLoad();
+    if (loader == NULL)
+        return MFX_ERR_NOT_FOUND;
+
+    mfxHDL hImplPath = nullptr;
+    sts              = MFXEnumImplementations(loader, 0, MFX_IMPLCAPS_IMPLPATH, &hImplPath);
+    if (sts != MFX_ERR_NONE) {
+        MFXUnload(loader);
+        return sts;
+    }
+
+    VPL_LOG_TIME_END(loadenum);
+
+    MFXDispReleaseImplDescription(loader, hImplPath);
+
+    if (bPrintImplPath) {
+        for (mfxU32 idx = 0;; idx++) {
+            hImplPath = nullptr;
+            if (MFXEnumImplementations(loader, idx, MFX_IMPLCAPS_IMPLPATH, &hImplPath) !=
+                    MFX_ERR_NONE ||
+                hImplPath == nullptr)
+                break;
+
+            printf("  Probed implementation path[%d]: %s\n",
+                   idx,
+                   reinterpret_cast<mfxChar *>(hImplPath));
+            MFXDispReleaseImplDescription(loader, hImplPath);
+        }
+    }
+
+    MFXUnload(loader);
+
+    return MFX_ERR_NONE;
+}
+
+// compare probing of the runtime libraries (MFXLoad + first enumeration)
+//   and full startup with serial vs. parallel probing
+//   (ONEVPL_DISPATCHER_PROBE_THREADS)
+static mfxStatus RunProbePass(const char *probeThreads) {
+    mfxStatus sts = MFX_ERR_NONE;
+
+    SetEnv("ONEVPL_DISPATCHER_PROBE_THREADS", nullptr);
+
+    sts = RunLoadEnumPass("Probe (serial)", true);
+    if (sts != MFX_ERR_NONE)
+        return sts;
+
+    sts = RunStartupPass("Startup (serial probe)");
+    if (sts != MFX_ERR_NONE)
+        return sts;
+
+    SetEnv("ONEVPL_DISPATCHER_PROBE_THREADS", probeThreads);
+
+    char passName[256] = {};
+    snprintf(passName, sizeof(passName), "Probe (%s probe threads)", probeThreads);
+    sts = RunLoadEnumPass(passName, false);
+    if (sts == MFX_ERR_NONE) {
+        snprintf(passName, sizeof(passName), "Startup (%s probe threads)", probeThreads);
+        sts = RunStartupPass(passName);
+    }
+
+    SetEnv("ONEVPL_DISPATCHER_PROBE_THREADS", nullptr);
+
+    return sts;
+}
+
 static mfxStatus GetDispatcherVersion(mfxDispatcherVersion *ver) {
 #if defined(_WIN32) || defined(_WIN64)
     std::vector<char> fileInfoBuf;
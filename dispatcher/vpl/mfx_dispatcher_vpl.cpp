@@ -24,6 +24,18 @@ mfxLoader MFXLoad() {
     // initialize logging if appropriate environment variables are set
     loaderCtx->InitDispatcherLog();
 
+    // enable tracing if appropriate environment variable is set
+    loaderCtx->InitDispatcherTrace();
+
+    // enable persistent caps cache if appropriate environment variable is set
+    loaderCtx->InitCapsCache();
+
+    // enable parallel probing of libraries if appropriate environment variable is set
+    loaderCtx->InitParallelProbe();
+
+    // enable lazy caps query if appropriate environment variable is set
+    loaderCtx->InitLazyCaps();
+
     return (mfxLoader)loaderCtx;
 }
 
@@ -32,10 +44,16 @@ void MFXUnload(mfxLoader loader) {
     if (loader) {
         LoaderCtxVPL *loaderCtx = (LoaderCtxVPL *)loader;
 
+        // block until background load started by MFXLoadAsync() is complete
+        loaderCtx->WaitAsyncLoad(MFX_INFINITE);
+
         loaderCtx->UnloadAllLibraries();
 
         loaderCtx->FreeConfigFilters();
 
+        // write any remaining trace events
+        loaderCtx->GetLogger()->FlushTrace();
+
         delete loaderCtx;
     }
 
@@ -100,6 +118,9 @@ mfxStatus MFXEnumImplementations(mfxLoader loader,
     DispatcherLogVPL *dispLog = loaderCtx->GetLogger();
     DISP_LOG_FUNCTION(dispLog);
 
+    // block until background load started by MFXLoadAsync() is complete
+    loaderCtx->WaitAsyncLoad(MFX_INFINITE);
+
     mfxStatus sts = MFX_ERR_NONE;
 
     // load and query all libraries
@@ -138,6 +159,9 @@ mfxStatus MFXCreateSession(mfxLoader loader, mfxU32 i, mfxSession *session) {
     DispatcherLogVPL *dispLog = loaderCtx->GetLogger();
     DISP_LOG_FUNCTION(dispLog);
 
+    // block until background load started by MFXLoadAsync() is complete
+    loaderCtx->WaitAsyncLoad(MFX_INFINITE);
+
     mfxStatus sts = MFX_ERR_NONE;
 
     if (loaderCtx->m_bLowLatency) {
@@ -189,7 +213,90 @@ mfxStatus MFXDispReleaseImplDescription(mfxLoader loader, mfxHDL hdl) {
     DispatcherLogVPL *dispLog = loaderCtx->GetLogger();
     DISP_LOG_FUNCTION(dispLog);
 
+    // block until background load started by MFXLoadAsync() is complete
+    loaderCtx->WaitAsyncLoad(MFX_INFINITE);
+
     mfxStatus sts = loaderCtx->ReleaseImpl(hdl);
 
     return sts;
 }
+
+#ifdef ONEVPL_EXPERIMENTAL
+// start search and query of all implementations on a background thread
+mfxStatus MFXLoadAsync(mfxLoader loader, mfxLoadReadyCallback callback, mfxHDL userData) {
+    if (!loader)
+        return MFX_ERR_NULL_PTR;
+
+    LoaderCtxVPL *loaderCtx = (LoaderCtxVPL *)loader;
+
+    DispatcherLogVPL *dispLog = loaderCtx->GetLogger();
+    DISP_LOG_FUNCTION(dispLog);
+
+    mfxStatus sts = loaderCtx->StartAsyncLoad([loader, callback, userData](mfxStatus loadSts) {
+        if (callback)
+            callback(loader, loadSts, userData);
+    });
+
+    return sts;
+}
+
+// wait for (or poll) result of background load
+mfxStatus MFXLoadWait(mfxLoader loader, mfxU32 wait) {
+    if (!loader)
+        return MFX_ERR_NULL_PTR;
+
+    LoaderCtxVPL *loaderCtx = (LoaderCtxVPL *)loader;
+
+    mfxStatus sts = loaderCtx->WaitAsyncLoad(wait);
+
+    return sts;
+}
+
+// write trace events recorded so far to the trace file
+mfxStatus MFXDispFlushTrace(mfxLoader loader) {
+    if (!loader)
+        return MFX_ERR_NULL_PTR;
+
+    LoaderCtxVPL *loaderCtx = (LoaderCtxVPL *)loader;
+
+    mfxStatus sts = loaderCtx->GetLogger()->FlushTrace();
+
+    return sts;
+}
+#else
+// experimental functions are listed in libvpl.map and libmfx.def in all builds,
+//   without ONEVPL_EXPERIMENTAL they are exported as stubs
+extern "C" {
+typedef void(MFX_CDECL *mfxLoadReadyCallback)(mfxLoader loader, mfxStatus sts, mfxHDL userData);
+
+mfxStatus MFX_CDECL MFXLoadAsync(mfxLoader loader, mfxLoadReadyCallback callback, mfxHDL userData);
+mfxStatus MFX_CDECL MFXLoadWait(mfxLoader loader, mfxU32 wait);
+mfxStatus MFX_CDECL MFXDispFlushTrace(mfxLoader loader);
+}
+
+mfxStatus MFXLoadAsync(mfxLoader loader, mfxLoadReadyCallback callback, mfxHDL userData) {
+    (void)callback;
+    (void)userData;
+
+    if (!loader)
+        return MFX_ERR_NULL_PTR;
+
+    return MFX_ERR_UNSUPPORTED;
+}
+
+mfxStatus MFXLoadWait(mfxLoader loader, mfxU32 wait) {
+    (void)wait;
+
+    if (!loader)
+        return MFX_ERR_NULL_PTR;
+
+    return MFX_ERR_UNSUPPORTED;
+}
+
+mfxStatus MFXDispFlushTrace(mfxLoader loader) {
+    if (!loader)
+        return MFX_ERR_NULL_PTR;
+
+    return MFX_ERR_UNSUPPORTED;
+}
+#endif
@@ -8,11 +8,18 @@
 #define DISPATCHER_VPL_MFX_DISPATCHER_VPL_H_
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <cstdlib>
+#include <functional>
 #include <list>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <unordered_set>
 #include <vector>
 
 #include "vpl/mfxdispatcher.h"
@@ -220,6 +227,21 @@ struct VPPConfig {
     mfxU32 OutFormat;
 };
 
+// flattened dec/enc/vpp configs of a single implementation
+// built on first use by ValidateConfig() and reused every time the filters
+//   are updated (implementation caps do not change after they are queried)
+// each list is sorted by the keys which are compared first: codec (filter) ID,
+//   profile, memory type, and color format, so matching configs are found
+//   with a binary search instead of a scan of the whole list
+struct ImplConfigIndex {
+    bool bBuilt;
+    std::vector<DecConfig> decConfigList;
+    std::vector<EncConfig> encConfigList;
+    std::vector<VPPConfig> vppConfigList;
+
+    ImplConfigIndex() : bBuilt(false), decConfigList(), encConfigList(), vppConfigList() {}
+};
+
 // special props which are passed in via MFXSetConfigProperty()
 // these are updated with every call to ValidateConfig() and may
 //   be used in MFXCreateSession()
@@ -262,15 +284,28 @@ public:
                                       SpecialConfig *specialConfig);
 
     // compare library caps vs. set of configuration filters
+    // configIndex is built from libImplDesc on first use, pass the same
+    //   object for every call with this implementation (may be null)
     static mfxStatus ValidateConfig(const mfxImplDescription *libImplDesc,
                                     const mfxImplementedFunctions *libImplFuncs,
 #ifdef ONEVPL_EXPERIMENTAL
                                     const mfxExtendedDeviceId *libImplExtDevID,
 #endif
+                                    ImplConfigIndex *configIndex,
                                     std::list<ConfigCtxVPL *> configCtxList,
                                     LibType libType,
                                     SpecialConfig *specialConfig);
 
+    // lazy caps mode - check which optional caps formats are used by the filters
+    static void GetRequiredCapsFormats(std::list<ConfigCtxVPL *> configCtxList,
+                                       bool &bImplFuncs,
+                                       bool &bExtDeviceID);
+
+    // lazy caps mode - compare the top-level properties which are known before
+    //   querying caps (Impl, VendorID, ImplName, License, Keywords, ApiVersion)
+    static mfxStatus ValidateKnownProps(const mfxImplDescription *knownDesc,
+                                        std::list<ConfigCtxVPL *> configCtxList);
+
     // parse deviceID for x86 devices
     static bool ParseDeviceIDx86(mfxChar *cDeviceID, mfxU32 &deviceID, mfxU32 &adapterIdx);
 
@@ -294,25 +329,28 @@ private:
     mfxStatus SetFilterPropertyVPP(std::list<std::string> &propParsedString, mfxVariant value);
 
     static mfxStatus GetFlatDescriptionsDec(const mfxImplDescription *libImplDesc,
-                                            std::list<DecConfig> &decConfigList);
+                                            std::vector<DecConfig> &decConfigList);
 
     static mfxStatus GetFlatDescriptionsEnc(const mfxImplDescription *libImplDesc,
-                                            std::list<EncConfig> &encConfigList);
+                                            std::vector<EncConfig> &encConfigList);
 
     static mfxStatus GetFlatDescriptionsVPP(const mfxImplDescription *libImplDesc,
-                                            std::list<VPPConfig> &vppConfigList);
+                                            std::vector<VPPConfig> &vppConfigList);
+
+    static void BuildConfigIndex(const mfxImplDescription *libImplDesc,
+                                 ImplConfigIndex *configIndex);
 
     static mfxStatus CheckPropsGeneral(const mfxVariant cfgPropsAll[],
                                        const mfxImplDescription *libImplDesc);
 
     static mfxStatus CheckPropsDec(const mfxVariant cfgPropsAll[],
-                                   std::list<DecConfig> decConfigList);
+                                   const std::vector<DecConfig> &decConfigList);
 
     static mfxStatus CheckPropsEnc(const mfxVariant cfgPropsAll[],
-                                   std::list<EncConfig> encConfigList);
+                                   const std::vector<EncConfig> &encConfigList);
 
     static mfxStatus CheckPropsVPP(const mfxVariant cfgPropsAll[],
-                                   std::list<VPPConfig> vppConfigList);
+                                   const std::vector<VPPConfig> &vppConfigList);
 
     static mfxStatus CheckPropString(const mfxChar *implString, const std::string filtString);
 
@@ -384,6 +422,9 @@ public:
 
     static mfxStatus QueryAPIVersion(STRING_TYPE libNameFull, mfxVersion *msdkVersion);
 
+    // fill in the top-level properties which are the same for every MSDK adapter
+    static void GetKnownDescription(mfxVersion msdkVersion, mfxImplDescription *knownDesc);
+
 #ifdef ONEVPL_EXPERIMENTAL
     static mfxStatus QueryExtDeviceID(mfxExtendedDeviceId *extDeviceID,
                                       mfxU32 adapterID,
@@ -434,6 +475,140 @@ private:
     }
 };
 
+/* oneVPL Dispatcher Capabilities Cache
+ * Full loading mode opens every candidate runtime and calls MFXQueryImplsDescription() on it.
+ * To avoid this cost on each process startup, set the ONEVPL_DISPATCHER_CACHE_FILE environment
+ *   variable with the name of a file where the dispatcher may store the capabilities reported
+ *   by each oneVPL (API >= 2.0) runtime.
+ *
+ * Entries are keyed on the full path, file size, modification time and (Linux) GNU build ID of
+ *   the runtime library. If any of these change, the entry is discarded and the library is
+ *   queried again. Legacy MSDK runtimes and low-latency mode always bypass the cache.
+ */
+#if defined(_WIN32) || defined(_WIN64)
+    #define ONEVPL_CACHE_FILE_VAR L"ONEVPL_DISPATCHER_CACHE_FILE"
+#else
+    #define ONEVPL_CACHE_FILE_VAR "ONEVPL_DISPATCHER_CACHE_FILE"
+#endif
+
+// capabilities of a single implementation, as stored in the cache
+struct CapsCacheImpl {
+    mfxU32 libImplIdx;
+    mfxImplDescription *implDesc;
+    mfxImplementedFunctions *implFuncs;
+#ifdef ONEVPL_EXPERIMENTAL
+    mfxExtendedDeviceId *implExtDeviceID;
+#endif
+};
+
+class CapsCacheVPL {
+public:
+    CapsCacheVPL();
+    ~CapsCacheVPL();
+
+    // enable cache with the given file name (empty string = disabled)
+    mfxStatus Init(const STRING_TYPE &cacheFileName);
+    bool IsEnabled() const {
+        return !m_cacheFileName.empty();
+    }
+
+    // read cache file from disk (only once per loader)
+    mfxStatus Load();
+
+    // return true and fill implList if a valid entry exists for this library
+    // memory for the descriptors is owned by the cache until ReleaseDecoded()
+    bool LookupLibrary(const STRING_TYPE &libNameFull, std::vector<CapsCacheImpl> &implList);
+
+    // save caps reported by a library which was loaded and queried
+    mfxStatus UpdateLibrary(const STRING_TYPE &libNameFull,
+                            const std::vector<CapsCacheImpl> &implList);
+
+    // write cache file to disk if any entries were added or removed
+    mfxStatus Flush();
+
+    // free memory for descriptors returned by LookupLibrary()
+    void ReleaseDecoded();
+
+private:
+    struct CacheKey {
+        mfxU64 fileSize;
+        mfxU64 modTime;
+        std::string buildID;
+    };
+
+    struct CacheEntry {
+        CacheKey key;
+        std::vector<mfxU8> data;
+    };
+
+    static bool GetLibraryKey(const STRING_TYPE &libNameFull, CacheKey &key);
+
+    STRING_TYPE m_cacheFileName;
+    std::map<STRING_TYPE, CacheEntry> m_entries;
+    std::list<std::vector<mfxU8>> m_decoded;
+    bool m_bLoaded;
+    bool m_bDirty;
+};
+
+/* oneVPL Dispatcher Parallel Probing
+ * In full loading mode each candidate runtime is loaded and queried one at a time.
+ * Set the ONEVPL_DISPATCHER_PROBE_THREADS environment variable to a value > 1 to load candidate
+ *   runtimes and call MFXQueryImplsDescription() (or create the legacy MSDK test session) on up
+ *   to that many threads at once.
+ *
+ * Results are merged in the original candidate order, so the list of implementations reported
+ *   by MFXEnumImplementations() is the same as with serial probing.
+ */
+#if defined(_WIN32) || defined(_WIN64)
+    #define ONEVPL_PROBE_THREADS_VAR L"ONEVPL_DISPATCHER_PROBE_THREADS"
+#else
+    #define ONEVPL_PROBE_THREADS_VAR "ONEVPL_DISPATCHER_PROBE_THREADS"
+#endif
+
+#define MAX_PROBE_THREADS 16
+
+/* oneVPL Dispatcher Lazy Caps Query
+ * Set the ONEVPL_DISPATCHER_LAZY_CAPS environment variable to "ON" to query capabilities only
+ *   when they are needed, instead of all at once in full loading mode:
+ *   - MFX_IMPLCAPS_IMPLEMENTEDFUNCTIONS and MFX_IMPLCAPS_DEVICE_ID_EXTENDED are queried
+ *     from a 2.x runtime only if a filter uses them, or the application requests that
+ *     format from MFXEnumImplementations()
+ *   - legacy MSDK runtimes are not opened with test sessions if filters on the properties
+ *     which are known in advance (Impl, VendorID, ImplName, License, Keywords, ApiVersion)
+ *     already exclude them
+ *
+ * MFX_IMPLCAPS_IMPLDESCSTRUCTURE is still queried from every 2.x runtime, since it is required
+ *   to sort implementations by priority. Has no effect on runtimes in the caps cache, or on
+ *   formats which must be saved in the cache.
+ */
+#define ONEVPL_LAZY_CAPS_VAR "ONEVPL_DISPATCHER_LAZY_CAPS"
+
+// result of loading a candidate library (see LoaderCtxVPL::ProbeLibrary)
+// may be filled in on a worker thread, and is then used by CheckValidLibraries()
+//   and QueryLibraryCaps() in candidate order
+struct LibProbeResult {
+    bool bProbed;
+    mfxStatus loadSts;
+
+    // legacy MSDK runtime - number of required exports and result of version query
+    mfxU32 numMSDKFunctions;
+    mfxStatus msdkVersionSts;
+
+    // 2.x runtime - handles returned by MFXQueryImplsDescription(), if already queried
+    bool bCapsQueried;
+    mfxHDL *hImplDesc;
+    mfxU32 numImplDesc;
+    mfxHDL *hImplFuncs;
+    mfxU32 numImplFuncs;
+#ifdef ONEVPL_EXPERIMENTAL
+    mfxHDL *hImplExtDeviceID;
+    mfxU32 numImplExtDeviceID;
+#endif
+
+    // time spent in probe, msec
+    double probeTime;
+};
+
 struct LibInfo {
     // during search store candidate file names
     //   and priority based on rules in spec
@@ -455,6 +630,18 @@ struct LibInfo {
     // user-friendly version of path for MFX_IMPLCAPS_IMPLPATH query
     mfxChar implCapsPath[MAX_VPL_SEARCH_PATH];
 
+    // if true, caps were restored from the cache and library is not loaded
+    bool bCapsCached;
+    std::vector<CapsCacheImpl> cachedImplList;
+
+    // result of loading this library and (optionally) querying its caps
+    LibProbeResult probe;
+
+    // lazy caps mode - caps which have not been queried yet
+    bool bCapsPending;
+    bool bImplFuncsPending;
+    bool bExtDeviceIDPending;
+
     // avoid warnings
     LibInfo()
             : libNameFull(),
@@ -464,7 +651,13 @@ struct LibInfo {
               vplFuncTable(),
               msdkCtx(),
               msdkVersion(),
-              implCapsPath() {}
+              implCapsPath(),
+              bCapsCached(false),
+              cachedImplList(),
+              probe(),
+              bCapsPending(false),
+              bImplFuncsPending(false),
+              bExtDeviceIDPending(false) {}
 
 private:
     // make this class non-copyable
@@ -502,6 +695,9 @@ struct ImplInfo {
     // index of valid libraries - updates with every call to MFXSetConfigFilterProperty()
     mfxI32 validImplIdx;
 
+    // flattened caps used for filtering, built on first call to ValidateConfig()
+    ImplConfigIndex configIndex;
+
     // avoid warnings
     ImplInfo()
             : libInfo(nullptr),
@@ -515,7 +711,8 @@ struct ImplInfo {
               msdkImplIdx(0),
               adapterIdx(ADAPTER_IDX_UNKNOWN),
               libImplIdx(0),
-              validImplIdx(-1) {
+              validImplIdx(-1),
+              configIndex() {
     }
 };
 
@@ -549,15 +746,35 @@ public:
 
     // manage logging
     mfxStatus InitDispatcherLog();
+    mfxStatus InitDispatcherTrace();
     DispatcherLogVPL *GetLogger();
 
+    // manage persistent capabilities cache
+    mfxStatus InitCapsCache();
+
+    // set number of threads for probing candidate libraries
+    mfxStatus InitParallelProbe();
+
+    // enable lazy caps query mode
+    mfxStatus InitLazyCaps();
+
     // low latency initialization
     mfxStatus LoadLibsLowLatency();
     mfxStatus UpdateLowLatency();
 
-    bool m_bLowLatency;
-    bool m_bNeedUpdateValidImpls;
-    bool m_bNeedFullQuery;
+    // run FullLoadAndQuery() on a background thread (MFXLoadAsync)
+    // onReady is called from the background thread when loading is complete
+    mfxStatus StartAsyncLoad(std::function<void(mfxStatus)> onReady);
+
+    // wait up to waitMs for background load to complete
+    // returns MFX_WRN_IN_EXECUTION on timeout, MFX_ERR_NOT_INITIALIZED if not started
+    mfxStatus WaitAsyncLoad(mfxU32 waitMs);
+
+    // written by the background load (MFXLoadAsync) while the application may
+    //   still create configs and set filter properties
+    std::atomic<bool> m_bLowLatency;
+    std::atomic<bool> m_bNeedUpdateValidImpls;
+    std::atomic<bool> m_bNeedFullQuery;
     bool m_bNeedLowLatencyQuery;
     bool m_bPriorityPathEnabled;
 
@@ -577,6 +794,7 @@ private:
     mfxU32 ParseEnvSearchPaths(const CHAR_TYPE *envVarName, std::list<STRING_TYPE> &searchDirs);
     mfxU32 ParseLegacySearchPaths(std::list<STRING_TYPE> &searchDirs);
 
+    // m_libNameSet must contain the names of libraries already in libInfoList
     mfxStatus SearchDirForLibs(STRING_TYPE searchDir,
                                std::list<LibInfo *> &libInfoList,
                                mfxU32 priority,
@@ -586,6 +804,15 @@ private:
     mfxStatus ValidateAPIExports(VPLFunctionPtr *vplFuncTable, mfxVersion reportedVersion);
     bool IsValidX86GPU(ImplInfo *implInfo, mfxU32 &deviceID, mfxU32 &adapterIdx);
     mfxStatus UpdateImplPath(LibInfo *libInfo);
+    mfxStatus AddCachedImplementations(LibInfo *libInfo);
+    void ProbeLibrary(LibInfo *libInfo, bool bQueryCaps);
+    void ProbeLibrariesParallel(mfxU32 numThreads);
+
+    mfxStatus QueryLibraryCapsMSDK(LibInfo *libInfo);
+    mfxStatus UpdateImplListAfterQuery();
+    bool IsCapsFormatDeferred();
+    mfxStatus QueryDeferredCaps(LibInfo *libInfo, mfxImplCapsDeliveryFormat format);
+    mfxStatus QueryPendingLibraries();
 
     mfxStatus LoadLibsFromDriverStore(mfxU32 numAdapters,
                                       const std::vector<DXGI1DeviceInfo> &adapterInfo,
@@ -598,6 +825,9 @@ private:
 
     std::list<LibInfo *> m_libInfoList;
     std::list<ImplInfo *> m_implInfoList;
+
+    // full names of libraries in m_libInfoList while searching for candidates
+    std::unordered_set<STRING_TYPE> m_libNameSet;
     std::list<ConfigCtxVPL *> m_configCtxList;
     std::vector<DXGI1DeviceInfo> m_gpuAdapterInfo;
 
@@ -609,6 +839,24 @@ private:
 
     // logger object - enabled with ONEVPL_DISPATCHER_LOG environment variable
     DispatcherLogVPL m_dispLog;
+
+    // caps cache object - enabled with ONEVPL_DISPATCHER_CACHE_FILE environment variable
+    CapsCacheVPL m_capsCache;
+
+    // number of threads for probing libraries - set with ONEVPL_DISPATCHER_PROBE_THREADS
+    mfxU32 m_probeThreads;
+
+    // query caps only when needed - enabled with ONEVPL_DISPATCHER_LAZY_CAPS
+    bool m_bLazyCaps;
+
+    // background load state (MFXLoadAsync)
+    // m_bAsyncLoadDone and m_asyncLoadSts are protected by m_asyncLoadMutex
+    bool m_bAsyncLoad;
+    bool m_bAsyncLoadDone;
+    mfxStatus m_asyncLoadSts;
+    std::thread m_asyncLoadThread;
+    std::mutex m_asyncLoadMutex;
+    std::condition_variable m_asyncLoadCond;
 };
 
 #endif // DISPATCHER_VPL_MFX_DISPATCHER_VPL_H_
@@ -0,0 +1,749 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "vpl/mfx_dispatcher_vpl.h"
+
+#if !defined(_WIN32) && !defined(_WIN64)
+    #include <unistd.h>
+#endif
+
+#if defined(__linux__)
+    #include <elf.h>
+#endif
+
+// cache file layout (all values in native byte order):
+//   header  - magic, format version, struct layout signature
+//   entries - numEntries x { libNameFull, fileSize, modTime, buildID, data }
+//   data    - numImpls x { libImplIdx, implDesc, implFuncs, implExtDeviceID }
+// implDesc is stored as the raw struct followed by each pointed-to array in tree order,
+//   pointers are fixed up when the entry is decoded
+#define CACHE_FILE_MAGIC   "VPLCAPS"
+#define CACHE_FILE_VERSION 1
+
+// sanity limits for decoding untrusted input
+#define CACHE_MAX_ENTRIES  1024
+#define CACHE_MAX_STRLEN   (1 << 16)
+#define CACHE_MAX_FILESIZE (64 << 20)
+
+namespace {
+
+// any change to the layout of the description structs invalidates the whole file
+struct CacheLayout {
+    mfxU32 ptrSize;
+    mfxU32 implDescSize;
+    mfxU32 decCodecSize;
+    mfxU32 encCodecSize;
+    mfxU32 vppFilterSize;
+    mfxU32 implFuncsSize;
+    mfxU32 extDeviceIDSize;
+    mfxU32 charSize;
+};
+
+CacheLayout GetCacheLayout() {
+    CacheLayout layout     = {};
+    layout.ptrSize         = (mfxU32)sizeof(void *);
+    layout.implDescSize    = (mfxU32)sizeof(mfxImplDescription);
+    layout.decCodecSize    = (mfxU32)sizeof(DecCodec);
+    layout.encCodecSize    = (mfxU32)sizeof(EncCodec);
+    layout.vppFilterSize   = (mfxU32)sizeof(VPPFilter);
+    layout.implFuncsSize   = (mfxU32)sizeof(mfxImplementedFunctions);
+    layout.extDeviceIDSize = 0;
+#ifdef ONEVPL_EXPERIMENTAL
+    layout.extDeviceIDSize = (mfxU32)sizeof(mfxExtendedDeviceId);
+#endif
+    layout.charSize = (mfxU32)sizeof(CHAR_TYPE);
+
+    return layout;
+}
+
+class CacheWriter {
+public:
+    explicit CacheWriter(std::vector<mfxU8> &buf) : m_buf(buf) {}
+
+    void Write(const void *src, size_t size) {
+        const mfxU8 *p = reinterpret_cast<const mfxU8 *>(src);
+        m_buf.insert(m_buf.end(), p, p + size);
+    }
+
+    void WriteU32(mfxU32 val) {
+        Write(&val, sizeof(val));
+    }
+
+    void WriteU64(mfxU64 val) {
+        Write(&val, sizeof(val));
+    }
+
+    template <typename T>
+    void WriteString(const std::basic_string<T> &str) {
+        WriteU32((mfxU32)str.size());
+        Write(str.data(), str.size() * sizeof(T));
+    }
+
+    // element count is written first, null array is stored as empty
+    template <typename T>
+    void WriteArray(const T *arr, mfxU32 count) {
+        mfxU32 n = (arr ? count : 0);
+        WriteU32(n);
+        if (n)
+            Write(arr, n * sizeof(T));
+    }
+
+private:
+    std::vector<mfxU8> &m_buf;
+};
+
+class CacheReader {
+public:
+    CacheReader(const mfxU8 *data, size_t size, std::list<std::vector<mfxU8>> *mem = nullptr)
+            : m_pos(data),
+              m_end(data + size),
+              m_mem(mem) {}
+
+    bool Read(void *dst, size_t size) {
+        if ((size_t)(m_end - m_pos) < size)
+            return false;
+        memcpy(dst, m_pos, size);
+        m_pos += size;
+        return true;
+    }
+
+    bool ReadU32(mfxU32 &val) {
+        return Read(&val, sizeof(val));
+    }
+
+    bool ReadU64(mfxU64 &val) {
+        return Read(&val, sizeof(val));
+    }
+
+    template <typename T>
+    bool ReadString(std::basic_string<T> &str) {
+        mfxU32 len = 0;
+        if (!ReadU32(len) || len > CACHE_MAX_STRLEN || (size_t)(m_end - m_pos) < len * sizeof(T))
+            return false;
+        str.assign(reinterpret_cast<const T *>(m_pos), len);
+        m_pos += len * sizeof(T);
+        return true;
+    }
+
+    bool ReadBlob(std::vector<mfxU8> &blob) {
+        mfxU32 len = 0;
+        if (!ReadU32(len) || (size_t)(m_end - m_pos) < len)
+            return false;
+        blob.assign(m_pos, m_pos + len);
+        m_pos += len;
+        return true;
+    }
+
+    // allocate array from decoded memory list and set count in parent struct
+    template <typename T, typename C>
+    bool ReadArray(T *&arr, C &count) {
+        mfxU32 n = 0;
+
+        arr   = nullptr;
+        count = 0;
+        if (!ReadU32(n) || (mfxU32)(C)n != n || (size_t)(m_end - m_pos) / sizeof(T) < n)
+            return false;
+
+        if (n == 0)
+            return true;
+
+        m_mem->emplace_back(n * sizeof(T));
+        arr = reinterpret_cast<T *>(m_mem->back().data());
+        if (!Read(arr, n * sizeof(T))) {
+            arr = nullptr;
+            return false;
+        }
+        count = (C)n;
+
+        return true;
+    }
+
+    // returned memory is zero-initialized
+    template <typename T>
+    T *AllocArray(size_t n) {
+        m_mem->emplace_back(n * sizeof(T));
+        return reinterpret_cast<T *>(m_mem->back().data());
+    }
+
+    bool IsEmpty() const {
+        return m_pos == m_end;
+    }
+
+private:
+    const mfxU8 *m_pos;
+    const mfxU8 *m_end;
+    std::list<std::vector<mfxU8>> *m_mem;
+};
+
+void WriteImplDesc(CacheWriter &wr, const mfxImplDescription *desc) {
+    wr.Write(desc, sizeof(mfxImplDescription));
+
+    // mfxDeviceDescription::SubDevices added with struct version 1.1
+    if (desc->Dev.Version.Version >= MFX_STRUCT_VERSION(1, 1))
+        wr.WriteArray(desc->Dev.SubDevices, desc->Dev.NumSubDevices);
+    else
+        wr.WriteU32(0);
+
+    wr.WriteArray(desc->AccelerationModeDescription.Mode,
+                  desc->AccelerationModeDescription.NumAccelerationModes);
+
+    // mfxPoolAllocationPolicy added with struct version 1.2
+    if (desc->Version.Version >= MFX_STRUCT_VERSION(1, 2))
+        wr.WriteArray(desc->PoolPolicies.Policy, desc->PoolPolicies.NumPoolPolicies);
+    else
+        wr.WriteU32(0);
+
+    const mfxDecoderDescription *Dec = &(desc->Dec);
+    wr.WriteArray(Dec->Codecs, Dec->NumCodecs);
+    for (mfxU32 codecIdx = 0; Dec->Codecs && codecIdx < Dec->NumCodecs; codecIdx++) {
+        const DecCodec *decCodec = &(Dec->Codecs[codecIdx]);
+        wr.WriteArray(decCodec->Profiles, decCodec->NumProfiles);
+        for (mfxU32 profIdx = 0; decCodec->Profiles && profIdx < decCodec->NumProfiles;
+             profIdx++) {
+            const DecProfile *decProfile = &(decCodec->Profiles[profIdx]);
+            wr.WriteArray(decProfile->MemDesc, decProfile->NumMemTypes);
+            for (mfxU32 memIdx = 0; decProfile->MemDesc && memIdx < decProfile->NumMemTypes;
+                 memIdx++) {
+                const DecMemDesc *decMemDesc = &(decProfile->MemDesc[memIdx]);
+                wr.WriteArray(decMemDesc->ColorFormats, decMemDesc->NumColorFormats);
+            }
+        }
+    }
+
+    const mfxEncoderDescription *Enc = &(desc->Enc);
+    wr.WriteArray(Enc->Codecs, Enc->NumCodecs);
+    for (mfxU32 codecIdx = 0; Enc->Codecs && codecIdx < Enc->NumCodecs; codecIdx++) {
+        const EncCodec *encCodec = &(Enc->Codecs[codecIdx]);
+        wr.WriteArray(encCodec->Profiles, encCodec->NumProfiles);
+        for (mfxU32 profIdx = 0; encCodec->Profiles && profIdx < encCodec->NumProfiles;
+             profIdx++) {
+            const EncProfile *encProfile = &(encCodec->Profiles[profIdx]);
+            wr.WriteArray(encProfile->MemDesc, encProfile->NumMemTypes);
+            for (mfxU32 memIdx = 0; encProfile->MemDesc && memIdx < encProfile->NumMemTypes;
+                 memIdx++) {
+                const EncMemDesc *encMemDesc = &(encProfile->MemDesc[memIdx]);
+                wr.WriteArray(encMemDesc->ColorFormats, encMemDesc->NumColorFormats);
+            }
+        }
+    }
+
+    const mfxVPPDescription *VPP = &(desc->VPP);
+    wr.WriteArray(VPP->Filters, VPP->NumFilters);
+    for (mfxU32 filterIdx = 0; VPP->Filters && filterIdx < VPP->NumFilters; filterIdx++) {
+        const VPPFilter *vppFilter = &(VPP->Filters[filterIdx]);
+        wr.WriteArray(vppFilter->MemDesc, vppFilter->NumMemTypes);
+        for (mfxU32 memIdx = 0; vppFilter->MemDesc && memIdx < vppFilter->NumMemTypes; memIdx++) {
+            const VPPMemDesc *vppMemDesc = &(vppFilter->MemDesc[memIdx]);
+            wr.WriteArray(vppMemDesc->Formats, vppMemDesc->NumInFormats);
+            for (mfxU32 fmtIdx = 0; vppMemDesc->Formats && fmtIdx < vppMemDesc->NumInFormats;
+                 fmtIdx++) {
+                const VPPFormat *vppFormat = &(vppMemDesc->Formats[fmtIdx]);
+                wr.WriteArray(vppFormat->OutFormats, vppFormat->NumOutFormat);
+            }
+        }
+    }
+}
+
+// array reads are done in the same order as WriteImplDesc()
+// all pointers in the raw struct are stale and must be replaced
+bool ReadImplDesc(CacheReader &rd, mfxImplDescription *desc) {
+    if (!rd.Read(desc, sizeof(mfxImplDescription)))
+        return false;
+
+    // extension buffers are reserved and never stored
+    desc->NumExtParam        = 0;
+    desc->ExtParams.ExtParam = nullptr;
+
+    if (!rd.ReadArray(desc->Dev.SubDevices, desc->Dev.NumSubDevices))
+        return false;
+
+    if (!rd.ReadArray(desc->AccelerationModeDescription.Mode,
+                      desc->AccelerationModeDescription.NumAccelerationModes))
+        return false;
+
+    if (!rd.ReadArray(desc->PoolPolicies.Policy, desc->PoolPolicies.NumPoolPolicies))
+        return false;
+
+    mfxDecoderDescription *Dec = &(desc->Dec);
+    if (!rd.ReadArray(Dec->Codecs, Dec->NumCodecs))
+        return false;
+    for (mfxU32 codecIdx = 0; codecIdx < Dec->NumCodecs; codecIdx++) {
+        DecCodec *decCodec = &(Dec->Codecs[codecIdx]);
+        if (!rd.ReadArray(decCodec->Profiles, decCodec->NumProfiles))
+            return false;
+        for (mfxU32 profIdx = 0; profIdx < decCodec->NumProfiles; profIdx++) {
+            DecProfile *decProfile = &(decCodec->Profiles[profIdx]);
+            if (!rd.ReadArray(decProfile->MemDesc, decProfile->NumMemTypes))
+                return false;
+            for (mfxU32 memIdx = 0; memIdx < decProfile->NumMemTypes; memIdx++) {
+                DecMemDesc *decMemDesc = &(decProfile->MemDesc[memIdx]);
+                if (!rd.ReadArray(decMemDesc->ColorFormats, decMemDesc->NumColorFormats))
+                    return false;
+            }
+        }
+    }
+
+    mfxEncoderDescription *Enc = &(desc->Enc);
+    if (!rd.ReadArray(Enc->Codecs, Enc->NumCodecs))
+        return false;
+    for (mfxU32 codecIdx = 0; codecIdx < Enc->NumCodecs; codecIdx++) {
+        EncCodec *encCodec = &(Enc->Codecs[codecIdx]);
+        if (!rd.ReadArray(encCodec->Profiles, encCodec->NumProfiles))
+            return false;
+        for (mfxU32 profIdx = 0; profIdx < encCodec->NumProfiles; profIdx++) {
+            EncProfile *encProfile = &(encCodec->Profiles[profIdx]);
+            if (!rd.ReadArray(encProfile->MemDesc, encProfile->NumMemTypes))
+                return false;
+            for (mfxU32 memIdx = 0; memIdx < encProfile->NumMemTypes; memIdx++) {
+                EncMemDesc *encMemDesc = &(encProfile->MemDesc[memIdx]);
+                if (!rd.ReadArray(encMemDesc->ColorFormats, encMemDesc->NumColorFormats))
+                    return false;
+            }
+        }
+    }
+
+    mfxVPPDescription *VPP = &(desc->VPP);
+    if (!rd.ReadArray(VPP->Filters, VPP->NumFilters))
+        return false;
+    for (mfxU32 filterIdx = 0; filterIdx < VPP->NumFilters; filterIdx++) {
+        VPPFilter *vppFilter = &(VPP->Filters[filterIdx]);
+        if (!rd.ReadArray(vppFilter->MemDesc, vppFilter->NumMemTypes))
+            return false;
+        for (mfxU32 memIdx = 0; memIdx < vppFilter->NumMemTypes; memIdx++) {
+            VPPMemDesc *vppMemDesc = &(vppFilter->MemDesc[memIdx]);
+            if (!rd.ReadArray(vppMemDesc->Formats, vppMemDesc->NumInFormats))
+                return false;
+            for (mfxU32 fmtIdx = 0; fmtIdx < vppMemDesc->NumInFormats; fmtIdx++) {
+                VPPFormat *vppFormat = &(vppMemDesc->Formats[fmtIdx]);
+                if (!rd.ReadArray(vppFormat->OutFormats, vppFormat->NumOutFormat))
+                    return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void WriteImplFuncs(CacheWriter &wr, const mfxImplementedFunctions *implFuncs) {
+    mfxU32 numFunctions = (implFuncs->FunctionsName ? implFuncs->NumFunctions : 0);
+
+    wr.WriteU32(numFunctions);
+    for (mfxU32 i = 0; i < numFunctions; i++) {
+        const mfxChar *fnName = implFuncs->FunctionsName[i];
+        wr.WriteString(std::string(fnName ? fnName : ""));
+    }
+}
+
+bool ReadImplFuncs(CacheReader &rd, mfxImplementedFunctions *implFuncs) {
+    mfxU32 numFunctions = 0;
+
+    implFuncs->NumFunctions  = 0;
+    implFuncs->FunctionsName = nullptr;
+    if (!rd.ReadU32(numFunctions) || numFunctions > 0xffff)
+        return false;
+
+    if (numFunctions == 0)
+        return true;
+
+    mfxChar **fnNames = rd.AllocArray<mfxChar *>(numFunctions);
+
+    std::string fnName;
+    for (mfxU32 i = 0; i < numFunctions; i++) {
+        if (!rd.ReadString(fnName))
+            return false;
+
+        // copy including null terminator
+        fnNames[i] = rd.AllocArray<mfxChar>(fnName.size() + 1);
+        memcpy(fnNames[i], fnName.c_str(), fnName.size() + 1);
+    }
+
+    implFuncs->NumFunctions  = (mfxU16)numFunctions;
+    implFuncs->FunctionsName = fnNames;
+
+    return true;
+}
+
+#if defined(__linux__)
+// return contents of the NT_GNU_BUILD_ID note as a hex string
+template <typename Ehdr, typename Phdr, typename Nhdr>
+bool ReadElfBuildID(FILE *f, std::string &buildID) {
+    Ehdr ehdr = {};
+    if (fseek(f, 0, SEEK_SET) || fread(&ehdr, sizeof(ehdr), 1, f) != 1)
+        return false;
+
+    if (ehdr.e_phentsize != sizeof(Phdr))
+        return false;
+
+    for (mfxU32 i = 0; i < ehdr.e_phnum; i++) {
+        Phdr phdr = {};
+        if (fseek(f, (long)(ehdr.e_phoff + i * sizeof(Phdr)), SEEK_SET) ||
+            fread(&phdr, sizeof(phdr), 1, f) != 1)
+            return false;
+
+        if (phdr.p_type != PT_NOTE || phdr.p_filesz == 0 || phdr.p_filesz > CACHE_MAX_STRLEN)
+            continue;
+
+        std::vector<mfxU8> notes((size_t)phdr.p_filesz);
+        if (fseek(f, (long)phdr.p_offset, SEEK_SET) ||
+            fread(notes.data(), notes.size(), 1, f) != 1)
+            continue;
+
+        // name and desc are each padded to 4 bytes
+        size_t pos = 0;
+        while (pos + sizeof(Nhdr) <= notes.size()) {
+            Nhdr nhdr = {};
+            memcpy(&nhdr, notes.data() + pos, sizeof(Nhdr));
+            pos += sizeof(Nhdr);
+
+            size_t nameSz = ((size_t)nhdr.n_namesz + 3) & ~(size_t)3;
+            size_t descSz = ((size_t)nhdr.n_descsz + 3) & ~(size_t)3;
+            if (nameSz > notes.size() - pos || descSz > notes.size() - pos - nameSz)
+                break;
+
+            if (nhdr.n_type == NT_GNU_BUILD_ID && nhdr.n_namesz == 4 &&
+                memcmp(notes.data() + pos, "GNU", 4) == 0) {
+                static const char hexDigits[] = "0123456789abcdef";
+
+                const mfxU8 *desc = notes.data() + pos + nameSz;
+                buildID.clear();
+                for (mfxU32 j = 0; j < nhdr.n_descsz; j++) {
+                    buildID += hexDigits[desc[j] >> 4];
+                    buildID += hexDigits[desc[j] & 0x0f];
+                }
+                return true;
+            }
+            pos += nameSz + descSz;
+        }
+    }
+
+    return false;
+}
+#endif
+
+FILE *OpenCacheFile(const STRING_TYPE &fileName, bool bWrite) {
+    FILE *f = nullptr;
+#if defined(_WIN32) || defined(_WIN64)
+    if (_wfopen_s(&f, fileName.c_str(), bWrite ? L"wb" : L"rb"))
+        return nullptr;
+#else
+    f = fopen(fileName.c_str(), bWrite ? "wb" : "rb");
+#endif
+    return f;
+}
+
+} // namespace
+
+CapsCacheVPL::CapsCacheVPL()
+        : m_cacheFileName(),
+          m_entries(),
+          m_decoded(),
+          m_bLoaded(false),
+          m_bDirty(false) {}
+
+CapsCacheVPL::~CapsCacheVPL() {
+    ReleaseDecoded();
+}
+
+mfxStatus CapsCacheVPL::Init(const STRING_TYPE &cacheFileName) {
+    m_cacheFileName = cacheFileName;
+    m_bLoaded       = false;
+    m_bDirty        = false;
+    m_entries.clear();
+
+    return MFX_ERR_NONE;
+}
+
+// return key for the current version of this library on disk
+bool CapsCacheVPL::GetLibraryKey(const STRING_TYPE &libNameFull, CacheKey &key) {
+    key.buildID.clear();
+
+#if defined(_WIN32) || defined(_WIN64)
+    struct _stat64 st;
+    if (_wstat64(libNameFull.c_str(), &st))
+        return false;
+
+    key.fileSize = (mfxU64)st.st_size;
+    key.modTime  = (mfxU64)st.st_mtime;
+#else
+    struct stat st;
+    if (stat(libNameFull.c_str(), &st))
+        return false;
+
+    key.fileSize = (mfxU64)st.st_size;
+    key.modTime  = (mfxU64)st.st_mtim.tv_sec * 1000000000 + (mfxU64)st.st_mtim.tv_nsec;
+
+    #if defined(__linux__)
+    // build ID is optional - if not present, rely on size and mtime
+    FILE *f = fopen(libNameFull.c_str(), "rb");
+    if (f) {
+        unsigned char ident[EI_NIDENT] = {};
+        if (fread(ident, sizeof(ident), 1, f) == 1 && memcmp(ident, ELFMAG, SELFMAG) == 0) {
+            if (ident[EI_CLASS] == ELFCLASS64)
+                ReadElfBuildID<Elf64_Ehdr, Elf64_Phdr, Elf64_Nhdr>(f, key.buildID);
+            else if (ident[EI_CLASS] == ELFCLASS32)
+                ReadElfBuildID<Elf32_Ehdr, Elf32_Phdr, Elf32_Nhdr>(f, key.buildID);
+        }
+        fclose(f);
+    }
+    #endif
+#endif
+
+    return true;
+}
+
+mfxStatus CapsCacheVPL::Load() {
+    if (!IsEnabled())
+        return MFX_ERR_NOT_INITIALIZED;
+
+    if (m_bLoaded)
+        return MFX_ERR_NONE;
+    m_bLoaded = true;
+
+    FILE *f = OpenCacheFile(m_cacheFileName, false);
+    if (!f)
+        return MFX_ERR_NOT_FOUND; // nothing cached yet
+
+    std::vector<mfxU8> fileData;
+
+    long fileSize = -1;
+    if (fseek(f, 0, SEEK_END) == 0)
+        fileSize = ftell(f);
+
+    if (fileSize > 0 && fileSize <= CACHE_MAX_FILESIZE && fseek(f, 0, SEEK_SET) == 0) {
+        fileData.resize((size_t)fileSize);
+        if (fread(fileData.data(), fileData.size(), 1, f) != 1)
+            fileData.clear();
+    }
+    fclose(f);
+
+    CacheReader rd(fileData.data(), fileData.size());
+
+    char magic[sizeof(CACHE_FILE_MAGIC)] = {};
+    mfxU32 version                       = 0;
+    CacheLayout layout = {}, expectedLayout = GetCacheLayout();
+    mfxU32 numEntries = 0;
+
+    bool bValid = rd.Read(magic, sizeof(magic)) && rd.ReadU32(version) &&
+                  rd.Read(&layout, sizeof(layout)) && rd.ReadU32(numEntries);
+
+    bValid = bValid && !memcmp(magic, CACHE_FILE_MAGIC, sizeof(magic)) &&
+             version == CACHE_FILE_VERSION && !memcmp(&layout, &expectedLayout, sizeof(layout)) &&
+             numEntries <= CACHE_MAX_ENTRIES;
+
+    for (mfxU32 i = 0; bValid && i < numEntries; i++) {
+        STRING_TYPE libNameFull;
+        CacheEntry entry;
+
+        bValid = rd.ReadString(libNameFull) && rd.ReadU64(entry.key.fileSize) &&
+                 rd.ReadU64(entry.key.modTime) && rd.ReadString(entry.key.buildID) &&
+                 rd.ReadBlob(entry.data);
+
+        if (bValid)
+            m_entries[libNameFull] = entry;
+    }
+
+    if (!bValid || !rd.IsEmpty()) {
+        // corrupt or incompatible file - start over and overwrite on next Flush()
+        m_entries.clear();
+        m_bDirty = true;
+        return MFX_ERR_UNSUPPORTED;
+    }
+
+    return MFX_ERR_NONE;
+}
+
+bool CapsCacheVPL::LookupLibrary(const STRING_TYPE &libNameFull,
+                                 std::vector<CapsCacheImpl> &implList) {
+    implList.clear();
+
+    auto it = m_entries.find(libNameFull);
+    if (it == m_entries.end())
+        return false;
+
+    // library was replaced or removed since the entry was saved
+    CacheKey key;
+    CacheEntry &entry = it->second;
+    if (!GetLibraryKey(libNameFull, key) || key.fileSize != entry.key.fileSize ||
+        key.modTime != entry.key.modTime || key.buildID != entry.key.buildID) {
+        m_entries.erase(it);
+        m_bDirty = true;
+        return false;
+    }
+
+    // decode into temporary list, only keep memory if the whole entry is valid
+    std::list<std::vector<mfxU8>> mem;
+    CacheReader rd(entry.data.data(), entry.data.size(), &mem);
+
+    mfxU32 numImpls = 0;
+    bool bValid     = rd.ReadU32(numImpls) && numImpls > 0 && numImpls <= CACHE_MAX_ENTRIES;
+
+    for (mfxU32 i = 0; bValid && i < numImpls; i++) {
+        CapsCacheImpl impl = {};
+
+        mfxU32 hasImplFuncs = 0, hasExtDeviceID = 0;
+        bValid = rd.ReadU32(impl.libImplIdx) && rd.ReadU32(hasImplFuncs) &&
+                 rd.ReadU32(hasExtDeviceID);
+
+        if (bValid) {
+            impl.implDesc = rd.AllocArray<mfxImplDescription>(1);
+            bValid        = ReadImplDesc(rd, impl.implDesc);
+        }
+
+        if (bValid && hasImplFuncs) {
+            impl.implFuncs = rd.AllocArray<mfxImplementedFunctions>(1);
+            bValid         = ReadImplFuncs(rd, impl.implFuncs);
+        }
+
+        if (bValid && hasExtDeviceID) {
+#ifdef ONEVPL_EXPERIMENTAL
+            impl.implExtDeviceID = rd.AllocArray<mfxExtendedDeviceId>(1);
+            bValid               = rd.Read(impl.implExtDeviceID, sizeof(mfxExtendedDeviceId));
+#else
+            bValid = false;
+#endif
+        }
+
+        if (bValid)
+            implList.push_back(impl);
+    }
+
+    if (!bValid || !rd.IsEmpty()) {
+        implList.clear();
+        m_entries.erase(it);
+        m_bDirty = true;
+        return false;
+    }
+
+    m_decoded.splice(m_decoded.end(), mem);
+
+    return true;
+}
+
+mfxStatus CapsCacheVPL::UpdateLibrary(const STRING_TYPE &libNameFull,
+                                      const std::vector<CapsCacheImpl> &implList) {
+    if (!IsEnabled())
+        return MFX_ERR_NOT_INITIALIZED;
+
+    if (implList.empty())
+        return MFX_ERR_UNSUPPORTED;
+
+    CacheEntry entry;
+    if (!GetLibraryKey(libNameFull, entry.key))
+        return MFX_ERR_NOT_FOUND;
+
+    CacheWriter wr(entry.data);
+    wr.WriteU32((mfxU32)implList.size());
+    for (const CapsCacheImpl &impl : implList) {
+        if (!impl.implDesc)
+            return MFX_ERR_NULL_PTR;
+
+        mfxU32 hasExtDeviceID = 0;
+#ifdef ONEVPL_EXPERIMENTAL
+        hasExtDeviceID = (impl.implExtDeviceID ? 1 : 0);
+#endif
+
+        wr.WriteU32(impl.libImplIdx);
+        wr.WriteU32(impl.implFuncs ? 1 : 0);
+        wr.WriteU32(hasExtDeviceID);
+
+        WriteImplDesc(wr, impl.implDesc);
+
+        if (impl.implFuncs)
+            WriteImplFuncs(wr, impl.implFuncs);
+
+#ifdef ONEVPL_EXPERIMENTAL
+        if (impl.implExtDeviceID)
+            wr.Write(impl.implExtDeviceID, sizeof(mfxExtendedDeviceId));
+#endif
+    }
+
+    m_entries[libNameFull] = entry;
+    m_bDirty               = true;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CapsCacheVPL::Flush() {
+    if (!IsEnabled())
+        return MFX_ERR_NOT_INITIALIZED;
+
+    if (!m_bDirty)
+        return MFX_ERR_NONE;
+
+    // drop entries for libraries which were removed or replaced,
+    //   entries for libraries not searched in this process are kept
+    auto it = m_entries.begin();
+    while (it != m_entries.end()) {
+        CacheKey key;
+        if (!GetLibraryKey(it->first, key) || key.fileSize != it->second.key.fileSize ||
+            key.modTime != it->second.key.modTime || key.buildID != it->second.key.buildID) {
+            it = m_entries.erase(it);
+            continue;
+        }
+        it++;
+    }
+
+    std::vector<mfxU8> fileData;
+    CacheWriter wr(fileData);
+
+    CacheLayout layout = GetCacheLayout();
+    wr.Write(CACHE_FILE_MAGIC, sizeof(CACHE_FILE_MAGIC));
+    wr.WriteU32(CACHE_FILE_VERSION);
+    wr.Write(&layout, sizeof(layout));
+    wr.WriteU32((mfxU32)m_entries.size());
+
+    for (const auto &e : m_entries) {
+        wr.WriteString(e.first);
+        wr.WriteU64(e.second.key.fileSize);
+        wr.WriteU64(e.second.key.modTime);
+        wr.WriteString(e.second.key.buildID);
+        wr.WriteU32((mfxU32)e.second.data.size());
+        wr.Write(e.second.data.data(), e.second.data.size());
+    }
+
+    // write to temporary file and rename, so that other processes
+    //   never see a partially written cache
+#if defined(_WIN32) || defined(_WIN64)
+    STRING_TYPE tmpFileName = m_cacheFileName + L".tmp" + std::to_wstring(GetCurrentProcessId());
+#else
+    STRING_TYPE tmpFileName = m_cacheFileName + ".tmp" + std::to_string(getpid());
+#endif
+
+    FILE *f = OpenCacheFile(tmpFileName, true);
+    if (!f)
+        return MFX_ERR_UNKNOWN;
+
+    bool bWriteOK = (fwrite(fileData.data(), fileData.size(), 1, f) == 1);
+    bWriteOK      = (fclose(f) == 0) && bWriteOK;
+
+#if defined(_WIN32) || defined(_WIN64)
+    bWriteOK = bWriteOK && MoveFileExW(tmpFileName.c_str(),
+                                       m_cacheFileName.c_str(),
+                                       MOVEFILE_REPLACE_EXISTING);
+    if (!bWriteOK)
+        _wremove(tmpFileName.c_str());
+#else
+    bWriteOK = bWriteOK && (rename(tmpFileName.c_str(), m_cacheFileName.c_str()) == 0);
+    if (!bWriteOK)
+        remove(tmpFileName.c_str());
+#endif
+
+    if (!bWriteOK)
+        return MFX_ERR_UNKNOWN;
+
+    m_bDirty = false;
+
+    return MFX_ERR_NONE;
+}
+
+void CapsCacheVPL::ReleaseDecoded() {
+    m_decoded.clear();
+}
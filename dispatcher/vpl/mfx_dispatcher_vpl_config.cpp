@@ -654,7 +654,7 @@ mfxStatus ConfigCtxVPL::SetFilterProperty(const mfxU8 *name, mfxVariant value) {
     }
 
 mfxStatus ConfigCtxVPL::GetFlatDescriptionsDec(const mfxImplDescription *libImplDesc,
-                                               std::list<DecConfig> &decConfigList) {
+                                               std::vector<DecConfig> &decConfigList) {
     mfxU32 codecIdx   = 0;
     mfxU32 profileIdx = 0;
     mfxU32 memIdx     = 0;
@@ -696,7 +696,7 @@ mfxStatus ConfigCtxVPL::GetFlatDescriptionsDec(const mfxImplDescription *libImpl
 }
 
 mfxStatus ConfigCtxVPL::GetFlatDescriptionsEnc(const mfxImplDescription *libImplDesc,
-                                               std::list<EncConfig> &encConfigList) {
+                                               std::vector<EncConfig> &encConfigList) {
     mfxU32 codecIdx   = 0;
     mfxU32 profileIdx = 0;
     mfxU32 memIdx     = 0;
@@ -758,7 +758,7 @@ mfxStatus ConfigCtxVPL::GetFlatDescriptionsEnc(const mfxImplDescription *libImpl
 }
 
 mfxStatus ConfigCtxVPL::GetFlatDescriptionsVPP(const mfxImplDescription *libImplDesc,
-                                               std::list<VPPConfig> &vppConfigList) {
+                                               std::vector<VPPConfig> &vppConfigList) {
     mfxU32 filterIdx = 0;
     mfxU32 memIdx    = 0;
     mfxU32 inFmtIdx  = 0;
@@ -799,6 +799,102 @@ mfxStatus ConfigCtxVPL::GetFlatDescriptionsVPP(const mfxImplDescription *libImpl
     return MFX_ERR_NONE;
 }
 
+// keys used to sort flattened configs, most selective first
+#define NUM_CONFIG_SORT_KEYS 4
+
+static void GetSortKeys(const DecConfig &dc, mfxU32 keys[NUM_CONFIG_SORT_KEYS]) {
+    keys[0] = dc.CodecID;
+    keys[1] = dc.Profile;
+    keys[2] = (mfxU32)dc.MemHandleType;
+    keys[3] = dc.ColorFormat;
+}
+
+static void GetSortKeys(const EncConfig &ec, mfxU32 keys[NUM_CONFIG_SORT_KEYS]) {
+    keys[0] = ec.CodecID;
+    keys[1] = ec.Profile;
+    keys[2] = (mfxU32)ec.MemHandleType;
+    keys[3] = ec.ColorFormat;
+}
+
+static void GetSortKeys(const VPPConfig &vc, mfxU32 keys[NUM_CONFIG_SORT_KEYS]) {
+    keys[0] = vc.FilterFourCC;
+    keys[1] = (mfxU32)vc.MemHandleType;
+    keys[2] = vc.InFormat;
+    keys[3] = vc.OutFormat;
+}
+
+// compare the first numKeys sort keys of config vs. keys (-1, 0, +1)
+template <typename T>
+static int CompareSortKeys(const T &config, const mfxU32 *keys, mfxU32 numKeys) {
+    mfxU32 configKeys[NUM_CONFIG_SORT_KEYS];
+    GetSortKeys(config, configKeys);
+
+    for (mfxU32 i = 0; i < numKeys; i++) {
+        if (configKeys[i] != keys[i])
+            return (configKeys[i] < keys[i]) ? -1 : 1;
+    }
+    return 0;
+}
+
+template <typename T>
+static void SortConfigList(std::vector<T> &configList) {
+    std::stable_sort(configList.begin(), configList.end(), [](const T &a, const T &b) {
+        mfxU32 keys[NUM_CONFIG_SORT_KEYS];
+        GetSortKeys(b, keys);
+        return CompareSortKeys(a, keys, NUM_CONFIG_SORT_KEYS) < 0;
+    });
+}
+
+// return range of configs which may match the filter
+// sort keys which are set in the filter, up to the first unset one, select a
+//   contiguous range of the sorted list - everything outside of it can be skipped
+template <typename T>
+static void FindCandidateConfigs(const mfxVariant cfgPropsAll[],
+                                 const mfxI32 keyProps[NUM_CONFIG_SORT_KEYS],
+                                 const std::vector<T> &configList,
+                                 typename std::vector<T>::const_iterator &first,
+                                 typename std::vector<T>::const_iterator &last) {
+    mfxU32 keys[NUM_CONFIG_SORT_KEYS] = {};
+    mfxU32 numKeys                    = 0;
+
+    while (numKeys < NUM_CONFIG_SORT_KEYS &&
+           cfgPropsAll[keyProps[numKeys]].Type != MFX_VARIANT_TYPE_UNSET) {
+        keys[numKeys] = cfgPropsAll[keyProps[numKeys]].Data.U32;
+        numKeys++;
+    }
+
+    first = configList.begin();
+    last  = configList.end();
+    if (numKeys == 0)
+        return;
+
+    first = std::lower_bound(configList.begin(), configList.end(), 0, [&](const T &c, int) {
+        return CompareSortKeys(c, keys, numKeys) < 0;
+    });
+    last  = std::upper_bound(first, configList.end(), 0, [&](int, const T &c) {
+        return CompareSortKeys(c, keys, numKeys) > 0;
+    });
+}
+
+void ConfigCtxVPL::BuildConfigIndex(const mfxImplDescription *libImplDesc,
+                                    ImplConfigIndex *configIndex) {
+    configIndex->decConfigList.clear();
+    configIndex->encConfigList.clear();
+    configIndex->vppConfigList.clear();
+
+    // generate "flat" descriptions of each combination
+    //   (e.g. multiple profiles from the same codec)
+    GetFlatDescriptionsDec(libImplDesc, configIndex->decConfigList);
+    GetFlatDescriptionsEnc(libImplDesc, configIndex->encConfigList);
+    GetFlatDescriptionsVPP(libImplDesc, configIndex->vppConfigList);
+
+    SortConfigList(configIndex->decConfigList);
+    SortConfigList(configIndex->encConfigList);
+    SortConfigList(configIndex->vppConfigList);
+
+    configIndex->bBuilt = true;
+}
+
 #define CHECK_PROP(idx, type, val)                             \
     if ((cfgPropsAll[(idx)].Type != MFX_VARIANT_TYPE_UNSET) && \
         (cfgPropsAll[(idx)].Data.type != val))                 \
@@ -921,10 +1017,19 @@ mfxStatus ConfigCtxVPL::CheckPropsGeneral(const mfxVariant cfgPropsAll[],
 }
 
 mfxStatus ConfigCtxVPL::CheckPropsDec(const mfxVariant cfgPropsAll[],
-                                      std::list<DecConfig> decConfigList) {
-    auto it = decConfigList.begin();
-    while (it != decConfigList.end()) {
-        DecConfig dc      = (DecConfig)(*it);
+                                      const std::vector<DecConfig> &decConfigList) {
+    const mfxI32 keyProps[NUM_CONFIG_SORT_KEYS] = {
+        ePropDec_CodecID,
+        ePropDec_Profile,
+        ePropDec_MemHandleType,
+        ePropDec_ColorFormats,
+    };
+
+    std::vector<DecConfig>::const_iterator it, itEnd;
+    FindCandidateConfigs(cfgPropsAll, keyProps, decConfigList, it, itEnd);
+
+    while (it != itEnd) {
+        const DecConfig &dc = (*it);
         bool isCompatible = true;
 
         // check if this decode description includes
@@ -966,10 +1071,19 @@ mfxStatus ConfigCtxVPL::CheckPropsDec(const mfxVariant cfgPropsAll[],
 }
 
 mfxStatus ConfigCtxVPL::CheckPropsEnc(const mfxVariant cfgPropsAll[],
-                                      std::list<EncConfig> encConfigList) {
-    auto it = encConfigList.begin();
-    while (it != encConfigList.end()) {
-        EncConfig ec      = (EncConfig)(*it);
+                                      const std::vector<EncConfig> &encConfigList) {
+    const mfxI32 keyProps[NUM_CONFIG_SORT_KEYS] = {
+        ePropEnc_CodecID,
+        ePropEnc_Profile,
+        ePropEnc_MemHandleType,
+        ePropEnc_ColorFormats,
+    };
+
+    std::vector<EncConfig>::const_iterator it, itEnd;
+    FindCandidateConfigs(cfgPropsAll, keyProps, encConfigList, it, itEnd);
+
+    while (it != itEnd) {
+        const EncConfig &ec = (*it);
         bool isCompatible = true;
 
         // check if this encode description includes
@@ -1020,10 +1134,19 @@ mfxStatus ConfigCtxVPL::CheckPropsEnc(const mfxVariant cfgPropsAll[],
 }
 
 mfxStatus ConfigCtxVPL::CheckPropsVPP(const mfxVariant cfgPropsAll[],
-                                      std::list<VPPConfig> vppConfigList) {
-    auto it = vppConfigList.begin();
-    while (it != vppConfigList.end()) {
-        VPPConfig vc      = (VPPConfig)(*it);
+                                      const std::vector<VPPConfig> &vppConfigList) {
+    const mfxI32 keyProps[NUM_CONFIG_SORT_KEYS] = {
+        ePropVPP_FilterFourCC,
+        ePropVPP_MemHandleType,
+        ePropVPP_InFormat,
+        ePropVPP_OutFormat,
+    };
+
+    std::vector<VPPConfig>::const_iterator it, itEnd;
+    FindCandidateConfigs(cfgPropsAll, keyProps, vppConfigList, it, itEnd);
+
+    while (it != itEnd) {
+        const VPPConfig &vc = (*it);
         bool isCompatible = true;
 
         // check if this filter description includes
@@ -1168,6 +1291,7 @@ mfxStatus ConfigCtxVPL::ValidateConfig(const mfxImplDescription *libImplDesc,
 #ifdef ONEVPL_EXPERIMENTAL
                                        const mfxExtendedDeviceId *libImplExtDevID,
 #endif
+                                       ImplConfigIndex *configIndex,
                                        std::list<ConfigCtxVPL *> configCtxList,
                                        LibType libType,
                                        SpecialConfig *specialConfig) {
@@ -1182,15 +1306,10 @@ mfxStatus ConfigCtxVPL::ValidateConfig(const mfxImplDescription *libImplDesc,
     if (!libImplDesc)
         return MFX_ERR_NULL_PTR;
 
-    std::list<DecConfig> decConfigList;
-    std::list<EncConfig> encConfigList;
-    std::list<VPPConfig> vppConfigList;
-
-    // generate "flat" descriptions of each combination
-    //   (e.g. multiple profiles from the same codec)
-    GetFlatDescriptionsDec(libImplDesc, decConfigList);
-    GetFlatDescriptionsEnc(libImplDesc, encConfigList);
-    GetFlatDescriptionsVPP(libImplDesc, vppConfigList);
+    // flat descriptions are only generated if dec/enc/vpp filters are set
+    ImplConfigIndex localConfigIndex;
+    if (!configIndex)
+        configIndex = &localConfigIndex;
 
     // list of functions required to be implemented
     std::list<std::string> implFunctionList;
@@ -1263,13 +1382,16 @@ mfxStatus ConfigCtxVPL::ValidateConfig(const mfxImplDescription *libImplDesc,
             // MSDK RT compatibility mode (1.x) does not provide Dec/Enc/VPP caps
             // ignore these filters if set (do not use them to _exclude_ the library)
             if (libType != LibTypeMSDK) {
-                if (decRequested && CheckPropsDec(cfgPropsAll, decConfigList))
+                if ((decRequested || encRequested || vppRequested) && !configIndex->bBuilt)
+                    BuildConfigIndex(libImplDesc, configIndex);
+
+                if (decRequested && CheckPropsDec(cfgPropsAll, configIndex->decConfigList))
                     bImplValid = false;
 
-                if (encRequested && CheckPropsEnc(cfgPropsAll, encConfigList))
+                if (encRequested && CheckPropsEnc(cfgPropsAll, configIndex->encConfigList))
                     bImplValid = false;
 
-                if (vppRequested && CheckPropsVPP(cfgPropsAll, vppConfigList))
+                if (vppRequested && CheckPropsVPP(cfgPropsAll, configIndex->vppConfigList))
                     bImplValid = false;
             }
         }
@@ -1373,6 +1495,84 @@ mfxStatus ConfigCtxVPL::ValidateConfig(const mfxImplDescription *libImplDesc,
     return MFX_ERR_NONE;
 }
 
+void ConfigCtxVPL::GetRequiredCapsFormats(std::list<ConfigCtxVPL *> configCtxList,
+                                          bool &bImplFuncs,
+                                          bool &bExtDeviceID) {
+    bImplFuncs   = false;
+    bExtDeviceID = false;
+
+    for (ConfigCtxVPL *config : configCtxList) {
+        if (config->m_propVar[ePropFunc_FunctionName].Type != MFX_VARIANT_TYPE_UNSET)
+            bImplFuncs = true;
+
+        for (mfxU32 idx = ePropExtDev_VendorID; idx <= ePropExtDev_DeviceName; idx++) {
+            if (config->m_propVar[idx].Type != MFX_VARIANT_TYPE_UNSET)
+                bExtDeviceID = true;
+        }
+    }
+}
+
+mfxStatus ConfigCtxVPL::ValidateKnownProps(const mfxImplDescription *knownDesc,
+                                           std::list<ConfigCtxVPL *> configCtxList) {
+    mfxVersion reqVersion = {};
+    bool bVerSetMajor     = false;
+    bool bVerSetMinor     = false;
+
+    for (ConfigCtxVPL *config : configCtxList) {
+        const mfxVariant *cfgPropsAll = config->m_propVar;
+        bool isCompatible             = true;
+
+        CHECK_PROP(ePropMain_Impl, U32, knownDesc->Impl);
+        CHECK_PROP(ePropMain_VendorID, U32, knownDesc->VendorID);
+
+        if (cfgPropsAll[ePropMain_ImplName].Type != MFX_VARIANT_TYPE_UNSET) {
+            std::string filtName = *(std::string *)(cfgPropsAll[ePropMain_ImplName].Data.Ptr);
+            if (filtName != knownDesc->ImplName)
+                isCompatible = false;
+        }
+
+        if (cfgPropsAll[ePropMain_License].Type != MFX_VARIANT_TYPE_UNSET) {
+            std::string license = *(std::string *)(cfgPropsAll[ePropMain_License].Data.Ptr);
+            if (CheckPropString(knownDesc->License, license) != MFX_ERR_NONE)
+                isCompatible = false;
+        }
+
+        if (cfgPropsAll[ePropMain_Keywords].Type != MFX_VARIANT_TYPE_UNSET) {
+            std::string keywords = *(std::string *)(cfgPropsAll[ePropMain_Keywords].Data.Ptr);
+            if (CheckPropString(knownDesc->Keywords, keywords) != MFX_ERR_NONE)
+                isCompatible = false;
+        }
+
+        if (isCompatible == false)
+            return MFX_ERR_UNSUPPORTED;
+
+        // same rules as in ValidateConfig() - Major and Minor may be set in separate cfg objects
+        if (cfgPropsAll[ePropMain_ApiVersion].Type != MFX_VARIANT_TYPE_UNSET) {
+            reqVersion.Version = (mfxU32)cfgPropsAll[ePropMain_ApiVersion].Data.U32;
+            bVerSetMajor       = true;
+            bVerSetMinor       = true;
+        }
+        else {
+            if (cfgPropsAll[ePropMain_ApiVersion_Major].Type != MFX_VARIANT_TYPE_UNSET) {
+                reqVersion.Major = (mfxU32)cfgPropsAll[ePropMain_ApiVersion_Major].Data.U16;
+                bVerSetMajor     = true;
+            }
+
+            if (cfgPropsAll[ePropMain_ApiVersion_Minor].Type != MFX_VARIANT_TYPE_UNSET) {
+                reqVersion.Minor = (mfxU32)cfgPropsAll[ePropMain_ApiVersion_Minor].Data.U16;
+                bVerSetMinor     = true;
+            }
+        }
+    }
+
+    if (bVerSetMajor && bVerSetMinor) {
+        if (knownDesc->ApiVersion.Version < reqVersion.Version)
+            return MFX_ERR_UNSUPPORTED;
+    }
+
+    return MFX_ERR_NONE;
+}
+
 bool ConfigCtxVPL::CheckLowLatencyConfig(std::list<ConfigCtxVPL *> configCtxList,
                                          SpecialConfig *specialConfig) {
     mfxU32 idx;
@@ -5,11 +5,17 @@
   ############################################################################*/
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
 
 #include "vpl/mfx_dispatcher_vpl.h"
 
 #if defined(_WIN32) || defined(_WIN64)
     #include "vpl/mfx_dispatcher_vpl_win.h"
+#else
+    #include <sys/stat.h>
+    #include <time.h>
 #endif
 
 // leave table formatting alone
@@ -47,13 +53,23 @@ static const VPLFunctionDesc MSDKCompatFunctions[NumMSDKFunctions] = {
 LoaderCtxVPL::LoaderCtxVPL()
         : m_libInfoList(),
           m_implInfoList(),
+          m_libNameSet(),
           m_configCtxList(),
           m_gpuAdapterInfo(),
           m_specialConfig(),
           m_implIdxNext(0),
           m_bKeepCapsUntilUnload(true),
           m_envVar(),
-          m_dispLog() {
+          m_dispLog(),
+          m_capsCache(),
+          m_probeThreads(0),
+          m_bLazyCaps(false),
+          m_bAsyncLoad(false),
+          m_bAsyncLoadDone(false),
+          m_asyncLoadSts(MFX_ERR_NONE),
+          m_asyncLoadThread(),
+          m_asyncLoadMutex(),
+          m_asyncLoadCond() {
     // allow loader to distinguish between property value of 0
     //   and property not set
     m_specialConfig.bIsSet_deviceHandleType = false;
@@ -76,6 +92,14 @@ LoaderCtxVPL::LoaderCtxVPL()
 }
 
 LoaderCtxVPL::~LoaderCtxVPL() {
+    // background thread may still be running the ready callback
+    if (m_asyncLoadThread.joinable()) {
+        if (m_asyncLoadThread.get_id() == std::this_thread::get_id())
+            m_asyncLoadThread.detach();
+        else
+            m_asyncLoadThread.join();
+    }
+
     return;
 }
 
@@ -91,6 +115,10 @@ mfxStatus LoaderCtxVPL::FullLoadAndQuery() {
 
     // prune libraries which are not actually implementations, filling function
     // ptr table for each library which is
+    // libraries with valid entries in the caps cache are not loaded
+    if (m_capsCache.IsEnabled())
+        m_capsCache.Load();
+
     mfxU32 numLibs = CheckValidLibraries();
     if (numLibs == 0)
         return MFX_ERR_UNSUPPORTED;
@@ -98,6 +126,11 @@ mfxStatus LoaderCtxVPL::FullLoadAndQuery() {
     // query capabilities of each implementation
     // may be more than one implementation per library
     sts = QueryLibraryCaps();
+
+    // save any new or updated entries, even if no implementation was found
+    if (m_capsCache.IsEnabled())
+        m_capsCache.Flush();
+
     if (MFX_ERR_NONE != sts)
         return MFX_ERR_NOT_FOUND;
 
@@ -142,6 +175,92 @@ mfxU32 LoaderCtxVPL::ParseEnvSearchPaths(const CHAR_TYPE *envVarName,
     return (mfxU32)searchDirs.size();
 }
 
+#if !defined(_WIN32) && !defined(_WIN64)
+// names of candidate libraries in one directory, saved by SearchDirForLibs()
+// shared by all loaders in the process, and valid as long as mtime of the directory does not change
+// only the directory entries are cached - links are resolved again on every search, since they
+//   may be retargeted (e.g. libfoo.so -> libfoo.so.2.x on upgrade) without modifying this directory
+struct DirScanEntry {
+    struct timespec mtime;
+    std::vector<std::string> libNames;
+};
+
+static std::mutex g_dirScanMutex;
+static std::map<std::pair<dev_t, ino_t>, DirScanEntry> g_dirScanCache;
+
+// directory which was modified within this many seconds may be modified again
+//   without changing mtime (coarse timestamps), so it is not cached
+#define DIR_SCAN_MIN_AGE 2
+
+static bool GetCachedDirScan(const struct stat &dirStat, std::vector<std::string> &libNames) {
+    std::lock_guard<std::mutex> lock(g_dirScanMutex);
+
+    auto it = g_dirScanCache.find(std::make_pair(dirStat.st_dev, dirStat.st_ino));
+    if (it == g_dirScanCache.end())
+        return false;
+
+    const DirScanEntry &entry = it->second;
+    if (entry.mtime.tv_sec != dirStat.st_mtim.tv_sec ||
+        entry.mtime.tv_nsec != dirStat.st_mtim.tv_nsec) {
+        g_dirScanCache.erase(it);
+        return false;
+    }
+
+    libNames = entry.libNames;
+    return true;
+}
+
+static void SaveDirScan(const struct stat &dirStat, const std::vector<std::string> &libNames) {
+    time_t now = time(nullptr);
+    if (dirStat.st_mtim.tv_sec > now || now - dirStat.st_mtim.tv_sec < DIR_SCAN_MIN_AGE)
+        return;
+
+    std::lock_guard<std::mutex> lock(g_dirScanMutex);
+
+    try {
+        DirScanEntry &entry = g_dirScanCache[std::make_pair(dirStat.st_dev, dirStat.st_ino)];
+        entry.mtime         = dirStat.st_mtim;
+        entry.libNames      = libNames;
+    }
+    catch (...) {
+        // not cached - directory will be scanned again next time
+    }
+}
+
+// return names of candidate libraries in searchDir, in directory order
+// returns false if the directory could not be read
+static bool ScanDirForLibs(const std::string &searchDir, std::vector<std::string> &libNames) {
+    DIR *pSearchDir = opendir(searchDir.c_str());
+    if (!pSearchDir)
+        return false;
+
+    struct dirent *currFile;
+    while ((currFile = readdir(pSearchDir)) != nullptr) {
+        const char *name = currFile->d_name;
+
+        // library names must begin with "libvpl*" or "libmfx*"
+        // check the prefix first since most files in system directories do not match
+        if (strncmp(name, "libvpl", 6) != 0 && strcmp(name, "libmfx-gen.so.1.2") != 0 &&
+            strcmp(name, "libmfxhw64.so.1") != 0)
+            continue;
+
+        // save files with ".so" (including .so.1, etc.)
+        if (!strstr(name, ".so"))
+            continue;
+
+        // special case: do not include dispatcher itself (libmfx.so*, libvpl.so*) or tracer library
+        if (strstr(name, "libmfx.so") || strstr(name, "libvpl.so") ||
+            strstr(name, "libmfx-tracer"))
+            continue;
+
+        libNames.push_back(name);
+    }
+    closedir(pSearchDir);
+
+    return true;
+}
+#endif
+
 #define NUM_LIB_PREFIXES 3
 
 mfxStatus LoaderCtxVPL::SearchDirForLibs(STRING_TYPE searchDir,
@@ -201,11 +320,7 @@ mfxStatus LoaderCtxVPL::SearchDirForLibs(STRING_TYPE searchDir,
                     continue;
 
                 // skip duplicates
-                auto libFound =
-                    std::find_if(libInfoList.begin(), libInfoList.end(), [&](LibInfo *li) {
-                        return (li->libNameFull == libNameFull);
-                    });
-                if (libFound != libInfoList.end())
+                if (!m_libNameSet.insert(libNameFull).second)
                     continue;
 
                 LibInfo *libInfo = new LibInfo;
@@ -228,67 +343,50 @@ mfxStatus LoaderCtxVPL::SearchDirForLibs(STRING_TYPE searchDir,
         SetCurrentDirectoryW(currDir);
 
 #else
-    DIR *pSearchDir;
-    struct dirent *currFile;
+    struct stat dirStat;
+    if (stat(searchDir.c_str(), &dirStat) != 0 || !S_ISDIR(dirStat.st_mode))
+        return MFX_ERR_NONE;
 
-    pSearchDir = opendir(searchDir.c_str());
-    if (pSearchDir) {
-        while (1) {
-            currFile = readdir(pSearchDir);
-            if (!currFile)
-                break;
-
-            // save files with ".so" (including .so.1, etc.)
-            if (strstr(currFile->d_name, ".so")) {
-                // library names must begin with "libvpl*" or "libmfx*"
-                if ((strstr(currFile->d_name, "libvpl") != currFile->d_name) &&
-                    (strcmp(currFile->d_name, "libmfx-gen.so.1.2") != 0) &&
-                    (strcmp(currFile->d_name, "libmfxhw64.so.1") != 0))
-                    continue;
+    // directory listing is reused as long as the directory is not modified
+    std::vector<std::string> libNames;
+    if (GetCachedDirScan(dirStat, libNames)) {
+        DISP_LOG_MESSAGE(&m_dispLog,
+                         "message:  directory unchanged, using cached list of libraries: %s",
+                         searchDir.c_str());
+    }
+    else if (ScanDirForLibs(searchDir, libNames)) {
+        SaveDirScan(dirStat, libNames);
+    }
 
-                // special case: do not include dispatcher itself (libmfx.so*, libvpl.so*) or tracer library
-                if (strstr(currFile->d_name, "libmfx.so") ||
-                    strstr(currFile->d_name, "libvpl.so") ||
-                    strstr(currFile->d_name, "libmfx-tracer"))
-                    continue;
+    std::string filePath = searchDir + "/";
+    size_t dirLen        = filePath.size();
 
-                char filePathC[MAX_VPL_SEARCH_PATH];
+    for (const std::string &libName : libNames) {
+        // get full path to found library
+        filePath.resize(dirLen);
+        filePath += libName;
+        char *fullPath = realpath(filePath.c_str(), NULL);
 
-                // get full path to found library
-                snprintf(filePathC,
-                         MAX_VPL_SEARCH_PATH,
-                         "%s/%s",
-                         searchDir.c_str(),
-                         currFile->d_name);
-                char *fullPath = realpath(filePathC, NULL);
+        // unknown error (e.g. broken link) - skip it and move on to next file
+        if (!fullPath)
+            continue;
 
-                // unknown error - skip it and move on to next file
-                if (!fullPath)
-                    continue;
+        std::string libNameFull = fullPath;
+        free(fullPath);
 
-                // skip duplicates
-                auto libFound =
-                    std::find_if(libInfoList.begin(), libInfoList.end(), [&](LibInfo *li) {
-                        return (li->libNameFull == fullPath);
-                    });
-                if (libFound != libInfoList.end()) {
-                    free(fullPath);
-                    continue;
-                }
+        // skip duplicates
+        if (!m_libNameSet.insert(libNameFull).second)
+            continue;
 
-                LibInfo *libInfo = new LibInfo;
-                if (!libInfo)
-                    return MFX_ERR_MEMORY_ALLOC;
+        LibInfo *libInfo = new LibInfo;
+        if (!libInfo)
+            return MFX_ERR_MEMORY_ALLOC;
 
-                libInfo->libNameFull = fullPath;
-                libInfo->libPriority = priority;
-                free(fullPath);
+        libInfo->libNameFull = libNameFull;
+        libInfo->libPriority = priority;
 
-                // add to list
-                libInfoList.push_back(libInfo);
-            }
-        }
-        closedir(pSearchDir);
+        // add to list
+        libInfoList.push_back(libInfo);
     }
 #endif
 
@@ -431,9 +529,15 @@ mfxU32 LoaderCtxVPL::GetSearchPathsSystemDefault(std::list<STRING_TYPE> &searchD
 //   according to the rules in the spec
 mfxStatus LoaderCtxVPL::BuildListOfCandidateLibs() {
     DISP_LOG_FUNCTION(&m_dispLog);
+    DISP_TRACE_PHASE(&m_dispLog, "search dirs");
 
     mfxStatus sts = MFX_ERR_NONE;
 
+    // full names of libraries which are already in the list, to skip duplicates
+    m_libNameSet.clear();
+    for (LibInfo *libInfo : m_libInfoList)
+        m_libNameSet.insert(libInfo->libNameFull);
+
     STRING_TYPE emptyPath; // default construction = empty
     std::list<STRING_TYPE> searchDirList;
     std::list<STRING_TYPE>::iterator it;
@@ -583,9 +687,111 @@ mfxStatus LoaderCtxVPL::BuildListOfCandidateLibs() {
     }
 #endif
 
+    m_libNameSet.clear();
+
     return sts;
 }
 
+// load candidate library and the exports which are used to classify it
+// if bQueryCaps is true, caps of a 2.x runtime are also queried here instead of
+//   in QueryLibraryCaps()
+// only libInfo is modified, so this may be called for several libraries at once
+void LoaderCtxVPL::ProbeLibrary(LibInfo *libInfo, bool bQueryCaps) {
+    LibProbeResult *probe = &(libInfo->probe);
+
+    auto tStart = std::chrono::steady_clock::now();
+
+    // load DLL
+    probe->loadSts = LoadSingleLibrary(libInfo);
+
+    // load video functions: pointers to exposed functions
+    // not all function pointers may be filled in (depends on API version)
+    if (probe->loadSts == MFX_ERR_NONE && libInfo->hModuleVPL)
+        LoadAPIExports(libInfo, LibTypeVPL);
+
+    if (libInfo->vplFuncTable[IdxMFXInitialize] &&
+        libInfo->libPriority < LIB_PRIORITY_LEGACY_DRIVERSTORE) {
+        if (bQueryCaps && libInfo->vplFuncTable[IdxMFXQueryImplsDescription]) {
+            DISP_TRACE_PHASE(&m_dispLog, "query caps");
+
+            VPLFunctionPtr pFunc = libInfo->vplFuncTable[IdxMFXQueryImplsDescription];
+
+            probe->hImplDesc = (*(mfxHDL * (MFX_CDECL *)(mfxImplCapsDeliveryFormat, mfxU32 *))
+                                    pFunc)(MFX_IMPLCAPS_IMPLDESCSTRUCTURE, &probe->numImplDesc);
+
+            // in lazy caps mode the other formats are queried later (see QueryDeferredCaps)
+            if (!IsCapsFormatDeferred()) {
+#ifdef ONEVPL_EXPERIMENTAL
+                probe->hImplExtDeviceID =
+                    (*(mfxHDL * (MFX_CDECL *)(mfxImplCapsDeliveryFormat, mfxU32 *))
+                         pFunc)(MFX_IMPLCAPS_DEVICE_ID_EXTENDED, &probe->numImplExtDeviceID);
+#endif
+                probe->hImplFuncs =
+                    (*(mfxHDL * (MFX_CDECL *)(mfxImplCapsDeliveryFormat, mfxU32 *))
+                         pFunc)(MFX_IMPLCAPS_IMPLEMENTEDFUNCTIONS, &probe->numImplFuncs);
+            }
+
+            probe->bCapsQueried = true;
+        }
+    }
+    else if (probe->loadSts == MFX_ERR_NONE && libInfo->hModuleVPL) {
+        // not a valid 2.x runtime - check for 1.x API (legacy caps query)
+        if (libInfo->libNameFull.find(MSDK_LIB_NAME) != std::string::npos) {
+            // legacy runtime must be named libmfxhw64 (or 32)
+            // MSDK must export all of the required functions
+            probe->numMSDKFunctions = LoadAPIExports(libInfo, LibTypeMSDK);
+        }
+
+        // check that this is valid library (can create session, query version)
+        if (probe->numMSDKFunctions == NumMSDKFunctions) {
+            probe->msdkVersionSts =
+                LoaderCtxMSDK::QueryAPIVersion(libInfo->libNameFull, &(libInfo->msdkVersion));
+        }
+    }
+
+    auto tEnd = std::chrono::steady_clock::now();
+
+    probe->probeTime = std::chrono::duration<double, std::milli>(tEnd - tStart).count();
+    probe->bProbed   = true;
+}
+
+// probe all candidate libraries which were not restored from the caps cache
+// worker threads take the next library from the list until all are done,
+//   calling thread also takes part
+void LoaderCtxVPL::ProbeLibrariesParallel(mfxU32 numThreads) {
+    std::vector<LibInfo *> libList;
+    for (LibInfo *libInfo : m_libInfoList) {
+        if (!libInfo->bCapsCached)
+            libList.push_back(libInfo);
+    }
+
+    if (numThreads > libList.size())
+        numThreads = (mfxU32)libList.size();
+
+    std::atomic<size_t> nextLib(0);
+    auto probeWorker = [&]() {
+        size_t idx;
+        while ((idx = nextLib++) < libList.size())
+            ProbeLibrary(libList[idx], true);
+    };
+
+    std::vector<std::thread> workers;
+    for (mfxU32 i = 1; i < numThreads; i++) {
+        try {
+            workers.emplace_back(probeWorker);
+        }
+        catch (...) {
+            // failed to start thread - remaining libraries are probed by the others
+            break;
+        }
+    }
+
+    probeWorker();
+
+    for (auto &t : workers)
+        t.join();
+}
+
 // return number of valid libraries found
 mfxU32 LoaderCtxVPL::CheckValidLibraries() {
     DISP_LOG_FUNCTION(&m_dispLog);
@@ -593,19 +799,48 @@ mfxU32 LoaderCtxVPL::CheckValidLibraries() {
     LibInfo *msdkLibBest   = nullptr;
     LibInfo *msdkLibBestDS = nullptr;
 
+    std::list<LibInfo *>::iterator it;
+
+    // caps for these runtimes were saved by a previous process and the file has not
+    //   changed since then, so skip loading them (see QueryLibraryCaps)
+    // only 2.x runtimes are added to the cache, so the same priority rule applies
+    if (m_capsCache.IsEnabled()) {
+        for (it = m_libInfoList.begin(); it != m_libInfoList.end(); it++) {
+            LibInfo *libInfo = (*it);
+
+            if (libInfo->libPriority < LIB_PRIORITY_LEGACY_DRIVERSTORE &&
+                m_capsCache.LookupLibrary(libInfo->libNameFull, libInfo->cachedImplList)) {
+                DISP_LOG_MESSAGE(&m_dispLog, "message:  caps cache hit, library not loaded");
+                libInfo->libType     = LibTypeVPL;
+                libInfo->bCapsCached = true;
+            }
+        }
+    }
+
+    if (m_probeThreads > 1) {
+        DISP_LOG_MESSAGE(&m_dispLog, "message:  probing libraries on %d threads", m_probeThreads);
+        ProbeLibrariesParallel(m_probeThreads);
+    }
+
     // load all libraries
-    std::list<LibInfo *>::iterator it = m_libInfoList.begin();
+    it = m_libInfoList.begin();
     while (it != m_libInfoList.end()) {
         LibInfo *libInfo = (*it);
-        mfxStatus sts    = MFX_ERR_NONE;
 
-        // load DLL
-        sts = LoadSingleLibrary(libInfo);
+        if (libInfo->bCapsCached) {
+            it++;
+            continue;
+        }
+
+        // load library and exports, unless already done in parallel above
+        if (!libInfo->probe.bProbed)
+            ProbeLibrary(libInfo, false);
 
-        // load video functions: pointers to exposed functions
-        // not all function pointers may be filled in (depends on API version)
-        if (sts == MFX_ERR_NONE && libInfo->hModuleVPL)
-            LoadAPIExports(libInfo, LibTypeVPL);
+        UpdateImplPath(libInfo);
+        DISP_LOG_MESSAGE(&m_dispLog,
+                         "message:  library probe time = %.3f msec: %s",
+                         libInfo->probe.probeTime,
+                         libInfo->implCapsPath);
 
         // all runtime libraries with API >= 2.0 must export MFXInitialize()
         // validation of additional functions vs. API version takes place
@@ -618,22 +853,10 @@ mfxU32 LoaderCtxVPL::CheckValidLibraries() {
             continue;
         }
 
-        // not a valid 2.x runtime - check for 1.x API (legacy caps query)
-        mfxU32 numFunctions = 0;
-        if (sts == MFX_ERR_NONE && libInfo->hModuleVPL) {
-            if (libInfo->libNameFull.find(MSDK_LIB_NAME) != std::string::npos) {
-                // legacy runtime must be named libmfxhw64 (or 32)
-                // MSDK must export all of the required functions
-                numFunctions = LoadAPIExports(libInfo, LibTypeMSDK);
-            }
-        }
-
         // check if all of the required MSDK functions were found
         //   and this is valid library (can create session, query version)
-        if (numFunctions == NumMSDKFunctions) {
-            sts = LoaderCtxMSDK::QueryAPIVersion(libInfo->libNameFull, &(libInfo->msdkVersion));
-
-            if (sts == MFX_ERR_NONE) {
+        if (libInfo->probe.numMSDKFunctions == NumMSDKFunctions) {
+            if (libInfo->probe.msdkVersionSts == MFX_ERR_NONE) {
                 libInfo->libType = LibTypeMSDK;
                 if (msdkLibBest == nullptr ||
                     (libInfo->msdkVersion.Version > msdkLibBest->msdkVersion.Version)) {
@@ -709,6 +932,8 @@ mfxStatus LoaderCtxVPL::LoadSingleLibrary(LibInfo *libInfo) {
     if (!libInfo)
         return MFX_ERR_NULL_PTR;
 
+    DISP_TRACE_PHASE(&m_dispLog, "dlopen");
+
 #if defined(_WIN32) || defined(_WIN64)
     libInfo->hModuleVPL = MFX::mfx_dll_load(libInfo->libNameFull.c_str());
 #else
@@ -769,6 +994,9 @@ mfxStatus LoaderCtxVPL::UnloadAllLibraries() {
     m_libInfoList.clear();
     m_implIdxNext = 0;
 
+    // descriptors for cached libraries are owned by the cache
+    m_capsCache.ReleaseDecoded();
+
     return MFX_ERR_NONE;
 }
 
@@ -783,7 +1011,8 @@ mfxStatus LoaderCtxVPL::UnloadSingleImplementation(ImplInfo *implInfo) {
         //   was never called by the application
         // this is a valid scenario, e.g. app did not call MFXEnumImplementations()
         //   and just used the first available implementation provided by dispatcher
-        if (libInfo->libType == LibTypeVPL) {
+        // cached caps were not allocated by the runtime, so nothing to release
+        if (libInfo->libType == LibTypeVPL && libInfo->bCapsCached == false) {
             if (implInfo->implDesc) {
                 // MFX_IMPLCAPS_IMPLDESCSTRUCTURE;
                 (*(mfxStatus(MFX_CDECL *)(mfxHDL))pFunc)(implInfo->implDesc);
@@ -897,6 +1126,7 @@ bool LoaderCtxVPL::IsValidX86GPU(ImplInfo *implInfo, mfxU32 &deviceID, mfxU32 &a
 // assume MFX_IMPLCAPS_IMPLDESCSTRUCTURE is the only format supported
 mfxStatus LoaderCtxVPL::QueryLibraryCaps() {
     DISP_LOG_FUNCTION(&m_dispLog);
+    DISP_TRACE_PHASE(&m_dispLog, "query caps");
 
     mfxStatus sts = MFX_ERR_NONE;
 
@@ -904,7 +1134,12 @@ mfxStatus LoaderCtxVPL::QueryLibraryCaps() {
     while (it != m_libInfoList.end()) {
         LibInfo *libInfo = (*it);
 
-        if (libInfo->libType == LibTypeVPL) {
+        if (libInfo->libType == LibTypeVPL && libInfo->bCapsCached) {
+            sts = AddCachedImplementations(libInfo);
+            if (sts != MFX_ERR_NONE)
+                return sts;
+        }
+        else if (libInfo->libType == LibTypeVPL) {
             VPLFunctionPtr pFunc = libInfo->vplFuncTable[IdxMFXQueryImplsDescription];
 
             // handle to implDesc structure, null in low-latency mode (no query)
@@ -916,11 +1151,23 @@ mfxStatus LoaderCtxVPL::QueryLibraryCaps() {
             mfxU32 numImplsExtDeviceID = 0;
 #endif
 
+            // caps may have already been queried while probing libraries in parallel
+            LibProbeResult *probe = &(libInfo->probe);
+
+            // lazy caps mode - only the description structure is queried now
+            bool bDeferCaps = IsCapsFormatDeferred();
+
             if (m_bLowLatency == false) {
                 // call MFXQueryImplsDescription() for this implementation
                 // return handle to description in requested format
-                hImpl = (*(mfxHDL * (MFX_CDECL *)(mfxImplCapsDeliveryFormat, mfxU32 *))
-                             pFunc)(MFX_IMPLCAPS_IMPLDESCSTRUCTURE, &numImpls);
+                if (probe->bCapsQueried) {
+                    hImpl    = probe->hImplDesc;
+                    numImpls = probe->numImplDesc;
+                }
+                else {
+                    hImpl = (*(mfxHDL * (MFX_CDECL *)(mfxImplCapsDeliveryFormat, mfxU32 *))
+                                 pFunc)(MFX_IMPLCAPS_IMPLDESCSTRUCTURE, &numImpls);
+                }
 
                 // validate description pointer for each implementation
                 bool b_isValidDesc = true;
@@ -945,9 +1192,18 @@ mfxStatus LoaderCtxVPL::QueryLibraryCaps() {
                 }
 
 #ifdef ONEVPL_EXPERIMENTAL
-                hImplExtDeviceID =
-                    (*(mfxHDL * (MFX_CDECL *)(mfxImplCapsDeliveryFormat, mfxU32 *))
-                         pFunc)(MFX_IMPLCAPS_DEVICE_ID_EXTENDED, &numImplsExtDeviceID);
+                if (bDeferCaps) {
+                    libInfo->bExtDeviceIDPending = true;
+                }
+                else if (probe->bCapsQueried) {
+                    hImplExtDeviceID    = probe->hImplExtDeviceID;
+                    numImplsExtDeviceID = probe->numImplExtDeviceID;
+                }
+                else {
+                    hImplExtDeviceID =
+                        (*(mfxHDL * (MFX_CDECL *)(mfxImplCapsDeliveryFormat, mfxU32 *))
+                             pFunc)(MFX_IMPLCAPS_DEVICE_ID_EXTENDED, &numImplsExtDeviceID);
+                }
 #endif
             }
 
@@ -956,8 +1212,17 @@ mfxStatus LoaderCtxVPL::QueryLibraryCaps() {
             //   so we need to check whether the returned handle is valid before attempting to use it
             mfxHDL *hImplFuncs   = nullptr;
             mfxU32 numImplsFuncs = 0;
-            hImplFuncs           = (*(mfxHDL * (MFX_CDECL *)(mfxImplCapsDeliveryFormat, mfxU32 *))
-                              pFunc)(MFX_IMPLCAPS_IMPLEMENTEDFUNCTIONS, &numImplsFuncs);
+            if (bDeferCaps) {
+                libInfo->bImplFuncsPending = true;
+            }
+            else if (probe->bCapsQueried) {
+                hImplFuncs    = probe->hImplFuncs;
+                numImplsFuncs = probe->numImplFuncs;
+            }
+            else {
+                hImplFuncs = (*(mfxHDL * (MFX_CDECL *)(mfxImplCapsDeliveryFormat, mfxU32 *))
+                                 pFunc)(MFX_IMPLCAPS_IMPLEMENTEDFUNCTIONS, &numImplsFuncs);
+            }
 
             // only report single impl, but application may still attempt to create session using
             //    any of VendorImplID via the DXGIAdapterIndex filter property
@@ -967,6 +1232,9 @@ mfxStatus LoaderCtxVPL::QueryLibraryCaps() {
             // save user-friendly path for MFX_IMPLCAPS_IMPLPATH query (API >= 2.4)
             UpdateImplPath(libInfo);
 
+            // caps of valid implementations, to be saved in the cache
+            std::vector<CapsCacheImpl> cacheImplList;
+
             for (mfxU32 i = 0; i < numImpls; i++) {
                 ImplInfo *implInfo = new ImplInfo;
                 if (!implInfo)
@@ -1037,238 +1305,434 @@ mfxStatus LoaderCtxVPL::QueryLibraryCaps() {
 
                 // add implementation to overall list
                 m_implInfoList.push_back(implInfo);
+
+                if (m_bLowLatency == false) {
+                    CapsCacheImpl cacheImpl = {};
+                    cacheImpl.libImplIdx    = implInfo->libImplIdx;
+                    cacheImpl.implDesc      = (mfxImplDescription *)implInfo->implDesc;
+                    cacheImpl.implFuncs     = (mfxImplementedFunctions *)implInfo->implFuncs;
+#ifdef ONEVPL_EXPERIMENTAL
+                    cacheImpl.implExtDeviceID = (mfxExtendedDeviceId *)implInfo->implExtDeviceID;
+#endif
+                    cacheImplList.push_back(cacheImpl);
+                }
             }
+
+            if (m_capsCache.IsEnabled() && !cacheImplList.empty())
+                m_capsCache.UpdateLibrary(libInfo->libNameFull, cacheImplList);
         }
         else if (libInfo->libType == LibTypeMSDK) {
-            // save user-friendly path for MFX_IMPLCAPS_IMPLPATH query (API >= 2.4)
-            UpdateImplPath(libInfo);
-
-            mfxU32 maxImplMSDK = MAX_NUM_IMPL_MSDK;
+            // lazy caps mode - test sessions are only created if filters do not already
+            //   exclude this library (see QueryPendingLibraries)
+            if (m_bLazyCaps && m_bLowLatency == false) {
+                libInfo->bCapsPending = true;
+                it++;
+                continue;
+            }
 
-            // call once on adapter 0 to get MSDK API version (same for any adapter)
-            mfxVersion queryVersion = {};
-            if (m_bLowLatency) {
-                sts = LoaderCtxMSDK::QueryAPIVersion(libInfo->libNameFull, &queryVersion);
-                if (sts != MFX_ERR_NONE)
-                    queryVersion.Version = 0;
+            sts = QueryLibraryCapsMSDK(libInfo);
+            if (sts == MFX_ERR_MEMORY_ALLOC)
+                return sts;
 
-                // only report single impl, but application may still attempt to create session using
-                //    any of MFX_IMPL_HARDWAREx via the DXGIAdapterIndex filter property
-                maxImplMSDK = 1;
+            if (sts != MFX_ERR_NONE) {
+                // error loading MSDK library in compatibility mode - remove from list
+                UnloadSingleLibrary(libInfo);
+                it = m_libInfoList.erase(it);
+                continue;
             }
+        }
+        it++;
+    }
 
-            mfxU32 numImplMSDK = 0;
-            for (mfxU32 i = 0; i < maxImplMSDK; i++) {
-                mfxImplDescription *implDesc       = nullptr;
-                mfxImplementedFunctions *implFuncs = nullptr;
+    if (m_bLowLatency == false && !m_implInfoList.empty()) {
+        sts = UpdateImplListAfterQuery();
+        if (sts != MFX_ERR_NONE)
+            return sts;
+    }
+
+    // lazy caps mode - implementations of pending libraries may be added later
+    for (LibInfo *libInfo : m_libInfoList) {
+        if (libInfo->bCapsPending)
+            return MFX_ERR_NONE;
+    }
+
+    return m_implInfoList.empty() ? MFX_ERR_UNSUPPORTED : MFX_ERR_NONE;
+}
+
+// add implementations of a legacy MSDK library, one for each supported adapter
+// return MFX_ERR_UNSUPPORTED if no adapter is supported
+mfxStatus LoaderCtxVPL::QueryLibraryCapsMSDK(LibInfo *libInfo) {
+    mfxStatus sts = MFX_ERR_NONE;
+
+    // save user-friendly path for MFX_IMPLCAPS_IMPLPATH query (API >= 2.4)
+    UpdateImplPath(libInfo);
+
+    mfxU32 maxImplMSDK = MAX_NUM_IMPL_MSDK;
+
+    // call once on adapter 0 to get MSDK API version (same for any adapter)
+    mfxVersion queryVersion = {};
+    if (m_bLowLatency) {
+        sts = LoaderCtxMSDK::QueryAPIVersion(libInfo->libNameFull, &queryVersion);
+        if (sts != MFX_ERR_NONE)
+            queryVersion.Version = 0;
+
+        // only report single impl, but application may still attempt to create session using
+        //    any of MFX_IMPL_HARDWAREx via the DXGIAdapterIndex filter property
+        maxImplMSDK = 1;
+    }
+
+    mfxU32 numImplMSDK = 0;
+    for (mfxU32 i = 0; i < maxImplMSDK; i++) {
+        mfxImplDescription *implDesc       = nullptr;
+        mfxImplementedFunctions *implFuncs = nullptr;
 #ifdef ONEVPL_EXPERIMENTAL
-                mfxExtendedDeviceId *implExtDeviceID = nullptr;
+        mfxExtendedDeviceId *implExtDeviceID = nullptr;
 #endif
 
-                LoaderCtxMSDK *msdkCtx = &(libInfo->msdkCtx[i]);
-                if (m_bLowLatency == false) {
-                    // perf. optimization: if app requested bIsSet_accelerationMode other than D3D9, don't test whether MSDK supports D3D9
-                    bool bSkipD3D9Check = false;
-                    if (m_specialConfig.bIsSet_accelerationMode &&
-                        m_specialConfig.accelerationMode != MFX_ACCEL_MODE_VIA_D3D9) {
-                        bSkipD3D9Check = true;
-                    }
+        LoaderCtxMSDK *msdkCtx = &(libInfo->msdkCtx[i]);
+        if (m_bLowLatency == false) {
+            // perf. optimization: if app requested bIsSet_accelerationMode other than D3D9, don't test whether MSDK supports D3D9
+            bool bSkipD3D9Check = false;
+            if (m_specialConfig.bIsSet_accelerationMode &&
+                m_specialConfig.accelerationMode != MFX_ACCEL_MODE_VIA_D3D9) {
+                bSkipD3D9Check = true;
+            }
 
-                    sts = msdkCtx->QueryMSDKCaps(libInfo->libNameFull,
-                                                 &implDesc,
-                                                 &implFuncs,
-                                                 i,
-                                                 bSkipD3D9Check);
+            sts = msdkCtx->QueryMSDKCaps(libInfo->libNameFull,
+                                         &implDesc,
+                                         &implFuncs,
+                                         i,
+                                         bSkipD3D9Check);
 
-                    if (sts || !implDesc || !implFuncs) {
-                        // this adapter (i) is not supported
-                        continue;
-                    }
+            if (sts || !implDesc || !implFuncs) {
+                // this adapter (i) is not supported
+                continue;
+            }
 
 #ifdef ONEVPL_EXPERIMENTAL
-                    sts = LoaderCtxMSDK::QueryExtDeviceID(&(msdkCtx->m_extDeviceID),
-                                                          i,
-                                                          msdkCtx->m_deviceID,
-                                                          msdkCtx->m_luid);
-                    if (sts == MFX_ERR_NONE)
-                        implExtDeviceID = &(msdkCtx->m_extDeviceID);
+            sts = LoaderCtxMSDK::QueryExtDeviceID(&(msdkCtx->m_extDeviceID),
+                                                  i,
+                                                  msdkCtx->m_deviceID,
+                                                  msdkCtx->m_luid);
+            if (sts == MFX_ERR_NONE)
+                implExtDeviceID = &(msdkCtx->m_extDeviceID);
 
 #endif
-                }
-                else {
-                    // unknown API - unable to create session on any adapter
-                    if (queryVersion.Version == 0)
-                        continue;
+        }
+        else {
+            // unknown API - unable to create session on any adapter
+            if (queryVersion.Version == 0)
+                continue;
 
-                    // these are the only values filled in for msdkCtx in low latency mode
-                    // used during CreateSession
-                    msdkCtx->m_msdkAdapter     = msdkImplTab[i];
-                    msdkCtx->m_msdkAdapterD3D9 = msdkImplTab[i];
-                }
+            // these are the only values filled in for msdkCtx in low latency mode
+            // used during CreateSession
+            msdkCtx->m_msdkAdapter     = msdkImplTab[i];
+            msdkCtx->m_msdkAdapterD3D9 = msdkImplTab[i];
+        }
 
-                ImplInfo *implInfo = new ImplInfo;
-                if (!implInfo)
-                    return MFX_ERR_MEMORY_ALLOC;
+        ImplInfo *implInfo = new ImplInfo;
+        if (!implInfo)
+            return MFX_ERR_MEMORY_ALLOC;
 
-                // library which contains this implementation
-                implInfo->libInfo = libInfo;
+        // library which contains this implementation
+        implInfo->libInfo = libInfo;
 
-                // implemented function description, if available
-                implInfo->implFuncs = implFuncs;
+        // implemented function description, if available
+        implInfo->implFuncs = implFuncs;
 
 #ifdef ONEVPL_EXPERIMENTAL
-                // extended device ID description, if available
-                implInfo->implExtDeviceID = implExtDeviceID;
+        // extended device ID description, if available
+        implInfo->implExtDeviceID = implExtDeviceID;
 #endif
-                // fill out mfxInitializationParam for use in CreateSession (MFXInitialize path)
-                memset(&(implInfo->vplParam), 0, sizeof(mfxInitializationParam));
+        // fill out mfxInitializationParam for use in CreateSession (MFXInitialize path)
+        memset(&(implInfo->vplParam), 0, sizeof(mfxInitializationParam));
 
-                if (m_bLowLatency == false) {
-                    // implementation descriptor returned from runtime
-                    implInfo->implDesc = implDesc;
+        if (m_bLowLatency == false) {
+            // implementation descriptor returned from runtime
+            implInfo->implDesc = implDesc;
 
-                    // default mode for this impl
-                    // this may be changed later by MFXSetConfigFilterProperty(AccelerationMode)
-                    implInfo->vplParam.AccelerationMode = implDesc->AccelerationMode;
+            // default mode for this impl
+            // this may be changed later by MFXSetConfigFilterProperty(AccelerationMode)
+            implInfo->vplParam.AccelerationMode = implDesc->AccelerationMode;
 
-                    implInfo->version = implDesc->ApiVersion;
-                }
-                else {
-                    implInfo->implDesc = nullptr;
+            implInfo->version = implDesc->ApiVersion;
+        }
+        else {
+            implInfo->implDesc = nullptr;
 
-                    // application must set requested mode using MFXSetConfigFilterProperty()
-                    // will be updated during CreateSession
-                    implInfo->vplParam.AccelerationMode = MFX_ACCEL_MODE_NA;
+            // application must set requested mode using MFXSetConfigFilterProperty()
+            // will be updated during CreateSession
+            implInfo->vplParam.AccelerationMode = MFX_ACCEL_MODE_NA;
 
-                    // save API version from creating test MSDK session above
-                    implInfo->version.Version = queryVersion.Version;
-                }
+            // save API version from creating test MSDK session above
+            implInfo->version.Version = queryVersion.Version;
+        }
 
-                // adapter number
-                implInfo->msdkImplIdx = i;
+        // adapter number
+        implInfo->msdkImplIdx = i;
 
-                // save local index for this library
-                implInfo->libImplIdx = 0;
+        // save local index for this library
+        implInfo->libImplIdx = 0;
 
-                // initially all libraries have a valid, sequential value (>= 0)
-                // list of valid libraries is updated with every call to MFXSetConfigFilterProperty()
-                //   (see UpdateValidImplList)
-                // libraries that do not support all the required props get a value of -1, and
-                //   indexing of the valid libs is recalculated from 0,1,...
-                implInfo->validImplIdx = m_implIdxNext++;
+        // initially all libraries have a valid, sequential value (>= 0)
+        // list of valid libraries is updated with every call to MFXSetConfigFilterProperty()
+        //   (see UpdateValidImplList)
+        // libraries that do not support all the required props get a value of -1, and
+        //   indexing of the valid libs is recalculated from 0,1,...
+        implInfo->validImplIdx = m_implIdxNext++;
 
-                // add implementation to overall list
-                m_implInfoList.push_back(implInfo);
+        // add implementation to overall list
+        m_implInfoList.push_back(implInfo);
+
+        // update number of valid MSDK adapters
+        numImplMSDK++;
+    }
 
-                // update number of valid MSDK adapters
-                numImplMSDK++;
+    return (numImplMSDK > 0) ? MFX_ERR_NONE : MFX_ERR_UNSUPPORTED;
+}
+
+// set adapter index of each implementation and hide duplicate MSDK implementations,
+//   then sort by priority
+// called after caps are queried, may be called again if implementations are added later
+mfxStatus LoaderCtxVPL::UpdateImplListAfterQuery() {
+    mfxStatus sts = MFX_ERR_NONE;
+
+    bool bD3D9Requested = (m_specialConfig.bIsSet_accelerationMode &&
+                           m_specialConfig.accelerationMode == MFX_ACCEL_MODE_VIA_D3D9);
+
+    std::list<ImplInfo *>::iterator it2 = m_implInfoList.begin();
+    while (it2 != m_implInfoList.end()) {
+        ImplInfo *implInfo = (*it2);
+
+        mfxU32 deviceID   = 0;
+        mfxU32 adapterIdx = 0;
+        if (IsValidX86GPU(implInfo, deviceID, adapterIdx)) {
+            // save the adapterIdx for any x86 GPU devices (may be used later for filtering)
+            implInfo->adapterIdx = adapterIdx;
+        }
+
+        // per spec: if both VPL (HW) and MSDK are installed for the same accelerator, only load
+        //   the VPL implementation (mark MSDK as invalid)
+        // exception: if application requests D3D9, load MSDK if available
+        if (implInfo->libInfo->libType == LibTypeMSDK) {
+            mfxImplDescription *msdkImplDesc = (mfxImplDescription *)(implInfo->implDesc);
+            std::string msdkDeviceID         = (msdkImplDesc ? msdkImplDesc->Dev.DeviceID : "");
+
+            // check if VPL impl also exists for this deviceID
+            auto vplIdx = std::find_if(
+                m_implInfoList.begin(),
+                m_implInfoList.end(),
+
+                [&](const ImplInfo *t) {
+                    mfxImplDescription *implDesc = (mfxImplDescription *)(t->implDesc);
+
+                    bool bMatchingDeviceID = false;
+                    if (implDesc) {
+                        std::string vplDeviceID = implDesc->Dev.DeviceID;
+                        if (vplDeviceID == msdkDeviceID)
+                            bMatchingDeviceID = true;
+                    }
+
+                    return (t->libInfo->libType == LibTypeVPL && implDesc != nullptr &&
+                            implDesc->Impl == MFX_IMPL_TYPE_HARDWARE && bMatchingDeviceID);
+                });
+
+            if (vplIdx != m_implInfoList.end() && bD3D9Requested == false)
+                implInfo->validImplIdx = -1;
+
+            // avoid loading VPL RT via compatibility entrypoint
+            if (msdkImplDesc && msdkImplDesc->ApiVersion.Major == 1 &&
+                msdkImplDesc->ApiVersion.Minor == 255)
+                implInfo->validImplIdx = -1;
+        }
+
+        if (implInfo->libInfo->libType == LibTypeVPL && !implInfo->implDesc) {
+            //library was loaded in low-delay mode, need to query caps for it
+            mfxU32 numImpls      = 0;
+            VPLFunctionPtr pFunc = implInfo->libInfo->vplFuncTable[IdxMFXQueryImplsDescription];
+            mfxHDL *hImpl = (*(mfxHDL * (MFX_CDECL *)(mfxImplCapsDeliveryFormat, mfxU32 *))
+                                 pFunc)(MFX_IMPLCAPS_IMPLDESCSTRUCTURE, &numImpls);
+
+            //only single impl was reported
+            implInfo->implDesc = reinterpret_cast<mfxImplDescription *>(hImpl[0]);
+        }
+        else if (implInfo->libInfo->libType == LibTypeMSDK && !implInfo->implDesc) {
+            mfxImplDescription *implDesc       = nullptr;
+            mfxImplementedFunctions *implFuncs = nullptr;
+
+            LoaderCtxMSDK *msdkCtx = &(implInfo->libInfo->msdkCtx[0]);
+
+            // perf. optimization: if app requested bIsSet_accelerationMode other than D3D9, don't test whether MSDK supports D3D9
+            bool bSkipD3D9Check = false;
+            if (m_specialConfig.bIsSet_accelerationMode &&
+                m_specialConfig.accelerationMode != MFX_ACCEL_MODE_VIA_D3D9) {
+                bSkipD3D9Check = true;
             }
 
-            if (numImplMSDK == 0) {
-                // error loading MSDK library in compatibility mode - remove from list
-                UnloadSingleLibrary(libInfo);
-                it = m_libInfoList.erase(it);
+            sts = msdkCtx->QueryMSDKCaps(implInfo->libInfo->libNameFull,
+                                         &implDesc,
+                                         &implFuncs,
+                                         0,
+                                         bSkipD3D9Check);
+
+            if (sts || !implDesc || !implFuncs) {
+                // this adapter (i) is not supported
                 continue;
             }
+            implInfo->implDesc  = implDesc;
+            implInfo->implFuncs = implFuncs;
         }
-        it++;
+
+        it2++;
     }
 
-    if (m_bLowLatency == false && !m_implInfoList.empty()) {
-        bool bD3D9Requested = (m_specialConfig.bIsSet_accelerationMode &&
-                               m_specialConfig.accelerationMode == MFX_ACCEL_MODE_VIA_D3D9);
-
-        std::list<ImplInfo *>::iterator it2 = m_implInfoList.begin();
-        while (it2 != m_implInfoList.end()) {
-            ImplInfo *implInfo = (*it2);
-
-            mfxU32 deviceID   = 0;
-            mfxU32 adapterIdx = 0;
-            if (IsValidX86GPU(implInfo, deviceID, adapterIdx)) {
-                // save the adapterIdx for any x86 GPU devices (may be used later for filtering)
-                implInfo->adapterIdx = adapterIdx;
-            }
+    // sort valid implementations according to priority rules in spec
+    PrioritizeImplList();
 
-            // per spec: if both VPL (HW) and MSDK are installed for the same accelerator, only load
-            //   the VPL implementation (mark MSDK as invalid)
-            // exception: if application requests D3D9, load MSDK if available
-            if (implInfo->libInfo->libType == LibTypeMSDK) {
-                mfxImplDescription *msdkImplDesc = (mfxImplDescription *)(implInfo->implDesc);
-                std::string msdkDeviceID         = (msdkImplDesc ? msdkImplDesc->Dev.DeviceID : "");
-
-                // check if VPL impl also exists for this deviceID
-                auto vplIdx = std::find_if(
-                    m_implInfoList.begin(),
-                    m_implInfoList.end(),
-
-                    [&](const ImplInfo *t) {
-                        mfxImplDescription *implDesc = (mfxImplDescription *)(t->implDesc);
-
-                        bool bMatchingDeviceID = false;
-                        if (implDesc) {
-                            std::string vplDeviceID = implDesc->Dev.DeviceID;
-                            if (vplDeviceID == msdkDeviceID)
-                                bMatchingDeviceID = true;
-                        }
+    return MFX_ERR_NONE;
+}
 
-                        return (t->libInfo->libType == LibTypeVPL && implDesc != nullptr &&
-                                implDesc->Impl == MFX_IMPL_TYPE_HARDWARE && bMatchingDeviceID);
-                    });
+// lazy caps mode - formats other than MFX_IMPLCAPS_IMPLDESCSTRUCTURE are queried on demand
+// caps cache entries must be complete, so nothing is deferred if the cache is enabled
+bool LoaderCtxVPL::IsCapsFormatDeferred() {
+    return (m_bLazyCaps && m_bLowLatency == false && m_capsCache.IsEnabled() == false);
+}
 
-                if (vplIdx != m_implInfoList.end() && bD3D9Requested == false)
-                    implInfo->validImplIdx = -1;
+// query caps in the requested format for all implementations of this library,
+//   if they were deferred in QueryLibraryCaps()
+mfxStatus LoaderCtxVPL::QueryDeferredCaps(LibInfo *libInfo, mfxImplCapsDeliveryFormat format) {
+    bool *bPending = nullptr;
+    if (format == MFX_IMPLCAPS_IMPLEMENTEDFUNCTIONS)
+        bPending = &(libInfo->bImplFuncsPending);
+#ifdef ONEVPL_EXPERIMENTAL
+    else if (format == MFX_IMPLCAPS_DEVICE_ID_EXTENDED)
+        bPending = &(libInfo->bExtDeviceIDPending);
+#endif
 
-                // avoid loading VPL RT via compatibility entrypoint
-                if (msdkImplDesc && msdkImplDesc->ApiVersion.Major == 1 &&
-                    msdkImplDesc->ApiVersion.Minor == 255)
-                    implInfo->validImplIdx = -1;
-            }
+    // already queried, or not a deferred format
+    if (!bPending || *bPending == false)
+        return MFX_ERR_NONE;
+    *bPending = false;
 
-            if (implInfo->libInfo->libType == LibTypeVPL && !implInfo->implDesc) {
-                //library was loaded in low-delay mode, need to query caps for it
-                mfxU32 numImpls      = 0;
-                VPLFunctionPtr pFunc = implInfo->libInfo->vplFuncTable[IdxMFXQueryImplsDescription];
-                mfxHDL *hImpl = (*(mfxHDL * (MFX_CDECL *)(mfxImplCapsDeliveryFormat, mfxU32 *))
-                                     pFunc)(MFX_IMPLCAPS_IMPLDESCSTRUCTURE, &numImpls);
+    DISP_LOG_MESSAGE(&m_dispLog, "message:  deferred caps query, format = %d", format);
+    DISP_TRACE_PHASE(&m_dispLog, "query caps");
 
-                //only single impl was reported
-                implInfo->implDesc = reinterpret_cast<mfxImplDescription *>(hImpl[0]);
-            }
-            else if (implInfo->libInfo->libType == LibTypeMSDK && !implInfo->implDesc) {
-                mfxImplDescription *implDesc       = nullptr;
-                mfxImplementedFunctions *implFuncs = nullptr;
+    VPLFunctionPtr pFunc = libInfo->vplFuncTable[IdxMFXQueryImplsDescription];
 
-                LoaderCtxMSDK *msdkCtx = &(implInfo->libInfo->msdkCtx[0]);
+    // prior to API 2.2 MFX_IMPLCAPS_IMPLEMENTEDFUNCTIONS is not defined, so this may return null
+    mfxU32 numImpls = 0;
+    mfxHDL *hImpl =
+        (*(mfxHDL * (MFX_CDECL *)(mfxImplCapsDeliveryFormat, mfxU32 *)) pFunc)(format, &numImpls);
+    if (!hImpl)
+        return MFX_ERR_UNSUPPORTED;
 
-                // perf. optimization: if app requested bIsSet_accelerationMode other than D3D9, don't test whether MSDK supports D3D9
-                bool bSkipD3D9Check = false;
-                if (m_specialConfig.bIsSet_accelerationMode &&
-                    m_specialConfig.accelerationMode != MFX_ACCEL_MODE_VIA_D3D9) {
-                    bSkipD3D9Check = true;
-                }
+    std::vector<bool> bUsed(numImpls, false);
 
-                sts = msdkCtx->QueryMSDKCaps(implInfo->libInfo->libNameFull,
-                                             &implDesc,
-                                             &implFuncs,
-                                             0,
-                                             bSkipD3D9Check);
+    for (ImplInfo *implInfo : m_implInfoList) {
+        if (implInfo->libInfo != libInfo || implInfo->libImplIdx >= numImpls)
+            continue;
 
-                if (sts || !implDesc || !implFuncs) {
-                    // this adapter (i) is not supported
-                    continue;
-                }
-                implInfo->implDesc  = implDesc;
-                implInfo->implFuncs = implFuncs;
-            }
+        if (format == MFX_IMPLCAPS_IMPLEMENTEDFUNCTIONS)
+            implInfo->implFuncs = hImpl[implInfo->libImplIdx];
+#ifdef ONEVPL_EXPERIMENTAL
+        else if (format == MFX_IMPLCAPS_DEVICE_ID_EXTENDED)
+            implInfo->implExtDeviceID = hImpl[implInfo->libImplIdx];
+#endif
+        bUsed[implInfo->libImplIdx] = true;
+    }
+
+    // release handles of implementations which were removed from the list
+    VPLFunctionPtr pFuncRelease = libInfo->vplFuncTable[IdxMFXReleaseImplDescription];
+    for (mfxU32 i = 0; i < numImpls; i++) {
+        if (!bUsed[i] && hImpl[i])
+            (*(mfxStatus(MFX_CDECL *)(mfxHDL))pFuncRelease)(hImpl[i]);
+    }
+
+    return MFX_ERR_NONE;
+}
+
+// lazy caps mode - add implementations of legacy MSDK libraries which were deferred
+//   in QueryLibraryCaps(), unless the current filters already exclude them
+// excluded libraries stay pending and are checked again on every update, since
+//   MFXSetConfigFilterProperty() may overwrite the property which excluded them
+mfxStatus LoaderCtxVPL::QueryPendingLibraries() {
+    mfxStatus sts = MFX_ERR_NONE;
+
+    bool bAddedImpls = false;
 
-            it2++;
+    std::list<LibInfo *>::iterator it = m_libInfoList.begin();
+    while (it != m_libInfoList.end()) {
+        LibInfo *libInfo = (*it);
+
+        if (libInfo->bCapsPending == false) {
+            it++;
+            continue;
         }
 
-        // sort valid implementations according to priority rules in spec
-        PrioritizeImplList();
+        mfxImplDescription knownDesc;
+        LoaderCtxMSDK::GetKnownDescription(libInfo->msdkVersion, &knownDesc);
+
+        if (ConfigCtxVPL::ValidateKnownProps(&knownDesc, m_configCtxList) != MFX_ERR_NONE) {
+            DISP_LOG_MESSAGE(&m_dispLog,
+                             "message:  legacy runtime excluded by filters, caps not queried");
+            it++;
+            continue;
+        }
+        libInfo->bCapsPending = false;
+
+        DISP_TRACE_PHASE(&m_dispLog, "query caps");
+        sts = QueryLibraryCapsMSDK(libInfo);
+        if (sts == MFX_ERR_MEMORY_ALLOC)
+            return sts;
+
+        if (sts != MFX_ERR_NONE) {
+            // error loading MSDK library in compatibility mode - remove from list
+            UnloadSingleLibrary(libInfo);
+            it = m_libInfoList.erase(it);
+            continue;
+        }
+
+        bAddedImpls = true;
+        it++;
     }
 
-    return m_implInfoList.empty() ? MFX_ERR_UNSUPPORTED : MFX_ERR_NONE;
+    if (bAddedImpls)
+        return UpdateImplListAfterQuery();
+
+    return MFX_ERR_NONE;
+}
+
+// add implementations of a library whose caps were restored from the cache
+// the library itself is only loaded later by MFXCreateSession()
+mfxStatus LoaderCtxVPL::AddCachedImplementations(LibInfo *libInfo) {
+    // save user-friendly path for MFX_IMPLCAPS_IMPLPATH query (API >= 2.4)
+    UpdateImplPath(libInfo);
+
+    for (const CapsCacheImpl &cacheImpl : libInfo->cachedImplList) {
+        ImplInfo *implInfo = new ImplInfo;
+        if (!implInfo)
+            return MFX_ERR_MEMORY_ALLOC;
+
+        implInfo->libInfo   = libInfo;
+        implInfo->implDesc  = cacheImpl.implDesc;
+        implInfo->implFuncs = cacheImpl.implFuncs;
+#ifdef ONEVPL_EXPERIMENTAL
+        implInfo->implExtDeviceID = cacheImpl.implExtDeviceID;
+#endif
+
+        memset(&(implInfo->vplParam), 0, sizeof(mfxInitializationParam));
+        implInfo->vplParam.AccelerationMode = cacheImpl.implDesc->AccelerationMode;
+
+        implInfo->version    = cacheImpl.implDesc->ApiVersion;
+        implInfo->libImplIdx = cacheImpl.libImplIdx;
+
+        // exports were validated against the reported API version before the entry was saved
+        implInfo->validImplIdx = m_implIdxNext++;
+
+        m_implInfoList.push_back(implInfo);
+    }
+
+    return MFX_ERR_NONE;
 }
 
 // query implementation i
@@ -1281,6 +1745,9 @@ mfxStatus LoaderCtxVPL::QueryImpl(mfxU32 idx, mfxImplCapsDeliveryFormat format,
     while (it != m_implInfoList.end()) {
         ImplInfo *implInfo = (*it);
         if (implInfo->validImplIdx == (mfxI32)idx) {
+            // lazy caps mode - query this format now if it was deferred
+            QueryDeferredCaps(implInfo->libInfo, format);
+
             if (format == MFX_IMPLCAPS_IMPLDESCSTRUCTURE) {
                 *idesc = implInfo->implDesc;
             }
@@ -1358,8 +1825,8 @@ mfxStatus LoaderCtxVPL::ReleaseImpl(mfxHDL idesc) {
         if (m_bKeepCapsUntilUnload)
             return MFX_ERR_NONE;
 
-        // LibTypeMSDK does not require calling a release function
-        if (implInfo->libInfo->libType == LibTypeVPL) {
+        // LibTypeMSDK and cached caps do not require calling a release function
+        if (implInfo->libInfo->libType == LibTypeVPL && implInfo->libInfo->bCapsCached == false) {
             // call MFXReleaseImplDescription() for this implementation
             VPLFunctionPtr pFunc = implInfo->libInfo->vplFuncTable[IdxMFXReleaseImplDescription];
 
@@ -1389,6 +1856,11 @@ mfxStatus LoaderCtxVPL::ReleaseImpl(mfxHDL idesc) {
 }
 
 mfxStatus LoaderCtxVPL::UpdateLowLatency() {
+    // background load always uses full loading mode, and special config is
+    //   updated in UpdateValidImplList() when it is complete
+    if (m_bAsyncLoad)
+        return MFX_ERR_NONE;
+
     m_bLowLatency = false;
 
     m_bLowLatency = ConfigCtxVPL::CheckLowLatencyConfig(m_configCtxList, &m_specialConfig);
@@ -1396,13 +1868,85 @@ mfxStatus LoaderCtxVPL::UpdateLowLatency() {
     return MFX_ERR_NONE;
 }
 
+mfxStatus LoaderCtxVPL::StartAsyncLoad(std::function<void(mfxStatus)> onReady) {
+    DISP_LOG_FUNCTION(&m_dispLog);
+
+    // only one background load per loader, and only before any libraries are loaded
+    if (m_bAsyncLoad || !m_bNeedFullQuery || !m_bNeedLowLatencyQuery)
+        return MFX_ERR_UNDEFINED_BEHAVIOR;
+
+    m_bAsyncLoad     = true;
+    m_bAsyncLoadDone = false;
+    m_bLowLatency    = false;
+
+    try {
+        m_asyncLoadThread = std::thread([this, onReady]() {
+            mfxStatus sts = FullLoadAndQuery();
+
+            // do not search again if nothing was found - filters are applied
+            //   to the (empty) list when the application waits for the result
+            m_bNeedFullQuery = false;
+
+            sts = (sts == MFX_ERR_NONE) ? MFX_ERR_NONE : MFX_ERR_NOT_FOUND;
+            {
+                std::lock_guard<std::mutex> lock(m_asyncLoadMutex);
+                m_asyncLoadSts   = sts;
+                m_bAsyncLoadDone = true;
+            }
+            m_asyncLoadCond.notify_all();
+
+            if (onReady)
+                onReady(sts);
+        });
+    }
+    catch (...) {
+        m_bAsyncLoad = false;
+        return MFX_ERR_MEMORY_ALLOC;
+    }
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus LoaderCtxVPL::WaitAsyncLoad(mfxU32 waitMs) {
+    if (!m_bAsyncLoad)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    std::unique_lock<std::mutex> lock(m_asyncLoadMutex);
+
+    auto bDone = [this]() {
+        return m_bAsyncLoadDone;
+    };
+
+    if (waitMs == MFX_INFINITE)
+        m_asyncLoadCond.wait(lock, bDone);
+    else
+        m_asyncLoadCond.wait_for(lock, std::chrono::milliseconds(waitMs), bDone);
+
+    if (!m_bAsyncLoadDone)
+        return MFX_WRN_IN_EXECUTION;
+
+    return m_asyncLoadSts;
+}
+
 mfxStatus LoaderCtxVPL::UpdateValidImplList(void) {
     DISP_LOG_FUNCTION(&m_dispLog);
+    DISP_TRACE_PHASE(&m_dispLog, "filter");
 
     mfxStatus sts = MFX_ERR_NONE;
 
     mfxI32 validImplIdx = 0;
 
+    // lazy caps mode - query any caps which are needed by the current filters
+    bool bNeedImplFuncs   = false;
+    bool bNeedExtDeviceID = false;
+    if (m_bLazyCaps) {
+        sts = QueryPendingLibraries();
+        if (sts != MFX_ERR_NONE)
+            return sts;
+
+        ConfigCtxVPL::GetRequiredCapsFormats(m_configCtxList, bNeedImplFuncs, bNeedExtDeviceID);
+    }
+
     // iterate over all libraries and update list of those that
     //   meet current current set of config props
     std::list<ImplInfo *>::iterator it = m_implInfoList.begin();
@@ -1415,12 +1959,20 @@ mfxStatus LoaderCtxVPL::UpdateValidImplList(void) {
             continue;
         }
 
+        if (bNeedImplFuncs)
+            QueryDeferredCaps(implInfo->libInfo, MFX_IMPLCAPS_IMPLEMENTEDFUNCTIONS);
+#ifdef ONEVPL_EXPERIMENTAL
+        if (bNeedExtDeviceID)
+            QueryDeferredCaps(implInfo->libInfo, MFX_IMPLCAPS_DEVICE_ID_EXTENDED);
+#endif
+
         // compare caps from this library vs. config filters
         sts = ConfigCtxVPL::ValidateConfig((mfxImplDescription *)implInfo->implDesc,
                                            (mfxImplementedFunctions *)implInfo->implFuncs,
 #ifdef ONEVPL_EXPERIMENTAL
                                            (mfxExtendedDeviceId *)implInfo->implExtDeviceID,
 #endif
+                                           &implInfo->configIndex,
                                            m_configCtxList,
                                            implInfo->libInfo->libType,
                                            &m_specialConfig);
@@ -1540,6 +2092,7 @@ mfxStatus LoaderCtxVPL::PrioritizeImplList(void) {
 
 mfxStatus LoaderCtxVPL::CreateSession(mfxU32 idx, mfxSession *session) {
     DISP_LOG_FUNCTION(&m_dispLog);
+    DISP_TRACE_PHASE(&m_dispLog, "create session");
 
     mfxStatus sts = MFX_ERR_NONE;
 
@@ -1730,6 +2283,95 @@ mfxStatus LoaderCtxVPL::InitDispatcherLog() {
     return m_dispLog.Init(1, strLogFile);
 }
 
+mfxStatus LoaderCtxVPL::InitDispatcherTrace() {
+    std::string strTraceFile;
+
+#if defined(_WIN32) || defined(_WIN64)
+    DWORD err;
+
+    char traceFile[MAX_VPL_SEARCH_PATH] = "";
+    err = GetEnvironmentVariable("ONEVPL_DISPATCHER_TRACE_FILE", traceFile, MAX_VPL_SEARCH_PATH);
+    if (err == 0 || err >= MAX_VPL_SEARCH_PATH)
+        return MFX_ERR_UNSUPPORTED; // environment variable not defined or string too long
+
+    strTraceFile = traceFile;
+#else
+    const char *traceFile = std::getenv("ONEVPL_DISPATCHER_TRACE_FILE");
+    if (!traceFile)
+        return MFX_ERR_UNSUPPORTED;
+
+    strTraceFile = traceFile;
+#endif
+
+    return m_dispLog.InitTrace(strTraceFile);
+}
+
+mfxStatus LoaderCtxVPL::InitCapsCache() {
+#if defined(_WIN32) || defined(_WIN64)
+    DWORD err;
+
+    wchar_t cacheFile[MAX_VPL_SEARCH_PATH] = L"";
+    err = GetEnvironmentVariableW(ONEVPL_CACHE_FILE_VAR, cacheFile, MAX_VPL_SEARCH_PATH);
+    if (err == 0 || err >= MAX_VPL_SEARCH_PATH)
+        return MFX_ERR_UNSUPPORTED; // environment variable not defined or string too long
+#else
+    const char *cacheFile = std::getenv(ONEVPL_CACHE_FILE_VAR);
+    if (!cacheFile || cacheFile[0] == 0)
+        return MFX_ERR_UNSUPPORTED;
+#endif
+
+    return m_capsCache.Init(cacheFile);
+}
+
+mfxStatus LoaderCtxVPL::InitParallelProbe() {
+#if defined(_WIN32) || defined(_WIN64)
+    DWORD err;
+
+    wchar_t probeThreads[16] = L"";
+    err = GetEnvironmentVariableW(ONEVPL_PROBE_THREADS_VAR, probeThreads, 16);
+    if (err == 0 || err >= 16)
+        return MFX_ERR_UNSUPPORTED; // environment variable not defined or string too long
+
+    long numThreads = wcstol(probeThreads, nullptr, 10);
+#else
+    const char *probeThreads = std::getenv(ONEVPL_PROBE_THREADS_VAR);
+    if (!probeThreads || probeThreads[0] == 0)
+        return MFX_ERR_UNSUPPORTED;
+
+    long numThreads = strtol(probeThreads, nullptr, 10);
+#endif
+
+    // 0 or 1 - probe libraries one at a time (default)
+    if (numThreads <= 1)
+        return MFX_ERR_UNSUPPORTED;
+
+    m_probeThreads = (mfxU32)std::min(numThreads, (long)MAX_PROBE_THREADS);
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus LoaderCtxVPL::InitLazyCaps() {
+#if defined(_WIN32) || defined(_WIN64)
+    DWORD err;
+    char lazyCaps[4] = "";
+
+    err = GetEnvironmentVariableA(ONEVPL_LAZY_CAPS_VAR, lazyCaps, sizeof(lazyCaps));
+    if (err == 0 || err >= sizeof(lazyCaps))
+        return MFX_ERR_UNSUPPORTED; // environment variable not defined or string too long
+#else
+    const char *lazyCaps = std::getenv(ONEVPL_LAZY_CAPS_VAR);
+    if (!lazyCaps)
+        return MFX_ERR_UNSUPPORTED;
+#endif
+
+    if (std::string(lazyCaps) != "ON")
+        return MFX_ERR_UNSUPPORTED;
+
+    m_bLazyCaps = true;
+
+    return MFX_ERR_NONE;
+}
+
 // public function to return logger object
 // allows logging from C API functions outside of loaderCtx
 DispatcherLogVPL *LoaderCtxVPL::GetLogger() {
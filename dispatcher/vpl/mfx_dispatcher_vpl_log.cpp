@@ -6,12 +6,188 @@
 
 #include "vpl/mfx_dispatcher_vpl_log.h"
 
-DispatcherLogVPL::DispatcherLogVPL() : m_logLevel(0), m_logFileName(), m_logFile(nullptr) {}
+#if defined(_WIN32) || defined(_WIN64)
+    #include <windows.h>
+#else
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+static mfxU32 GetTraceProcessId() {
+#if defined(_WIN32) || defined(_WIN64)
+    return (mfxU32)GetCurrentProcessId();
+#else
+    return (mfxU32)getpid();
+#endif
+}
+
+static mfxU32 GetTraceThreadId() {
+    // cache OS thread ID to avoid a system call per event
+    static thread_local mfxU32 tid = 0;
+    if (!tid) {
+#if defined(_WIN32) || defined(_WIN64)
+        tid = (mfxU32)GetCurrentThreadId();
+#else
+        tid = (mfxU32)syscall(SYS_gettid);
+#endif
+    }
+    return tid;
+}
+
+// append event name as JSON string
+static void AppendTraceName(std::string &out, const char *name) {
+    out += '"';
+    for (const char *c = name; *c; c++) {
+        if (*c == '"' || *c == '\\')
+            out += '\\';
+        out += *c;
+    }
+    out += '"';
+}
+
+DispatcherTraceVPL::DispatcherTraceVPL(const std::string &traceFileName)
+        : m_traceFileName(traceFileName),
+          m_pid(GetTraceProcessId()),
+          m_events(new Event[DISP_TRACE_RING_SIZE]),
+          m_nextEvent(0),
+          m_flushMutex(),
+          m_flushedEvent(0) {
+    for (mfxU32 i = 0; i < DISP_TRACE_RING_SIZE; i++)
+        m_events[i].seq.store(0, std::memory_order_relaxed);
+}
+
+void DispatcherTraceVPL::Record(const char *name,
+                                DispatcherTraceCategory cat,
+                                mfxU64 tsBegin,
+                                mfxU64 tsEnd) {
+    mfxU64 idx = m_nextEvent.fetch_add(1, std::memory_order_relaxed);
+    Event &ev  = m_events[idx & (DISP_TRACE_RING_SIZE - 1)];
+
+    // mark slot as incomplete while it is being written
+    ev.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    ev.name.store(name, std::memory_order_relaxed);
+    ev.cat.store((mfxU32)cat, std::memory_order_relaxed);
+    ev.tid.store(GetTraceThreadId(), std::memory_order_relaxed);
+    ev.tsBegin.store(tsBegin, std::memory_order_relaxed);
+    ev.tsEnd.store(tsEnd, std::memory_order_relaxed);
+
+    ev.seq.store(idx + 1, std::memory_order_release);
+}
+
+// write all complete events recorded since the last flush to the trace file
+mfxStatus DispatcherTraceVPL::Flush() {
+    std::lock_guard<std::mutex> lock(m_flushMutex);
+
+    mfxU64 lastEvent  = m_nextEvent.load(std::memory_order_acquire);
+    mfxU64 numDropped = 0;
+
+    // events which were overwritten before they were flushed
+    if (lastEvent - m_flushedEvent > DISP_TRACE_RING_SIZE) {
+        numDropped     = lastEvent - DISP_TRACE_RING_SIZE - m_flushedEvent;
+        m_flushedEvent = lastEvent - DISP_TRACE_RING_SIZE;
+    }
+
+    std::string out;
+    char buf[256];
+
+    mfxU64 idx;
+    for (idx = m_flushedEvent; idx < lastEvent; idx++) {
+        Event &ev  = m_events[idx & (DISP_TRACE_RING_SIZE - 1)];
+        mfxU64 seq = ev.seq.load(std::memory_order_acquire);
+
+        // event is still being written - flush it next time
+        if (seq < idx + 1)
+            break;
+
+        // slot was already reused for a newer event
+        if (seq > idx + 1) {
+            numDropped++;
+            continue;
+        }
+
+        const char *name = ev.name.load(std::memory_order_relaxed);
+        mfxU32 cat       = ev.cat.load(std::memory_order_relaxed);
+        mfxU32 tid       = ev.tid.load(std::memory_order_relaxed);
+        mfxU64 tsBegin   = ev.tsBegin.load(std::memory_order_relaxed);
+        mfxU64 tsEnd     = ev.tsEnd.load(std::memory_order_relaxed);
+
+        // slot was reused while reading it
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (ev.seq.load(std::memory_order_relaxed) != seq) {
+            numDropped++;
+            continue;
+        }
+
+        // complete event, timestamps in microseconds
+        mfxU64 dur = tsEnd - tsBegin;
+        out += "{\"name\":";
+        AppendTraceName(out, name);
+        snprintf(buf,
+                 sizeof(buf),
+                 ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%llu.%03llu,\"dur\":%llu.%03llu,"
+                 "\"pid\":%u,\"tid\":%u},\n",
+                 (cat == DispTracePhase ? "phase" : "function"),
+                 (unsigned long long)(tsBegin / 1000),
+                 (unsigned long long)(tsBegin % 1000),
+                 (unsigned long long)(dur / 1000),
+                 (unsigned long long)(dur % 1000),
+                 m_pid,
+                 tid);
+        out += buf;
+    }
+    m_flushedEvent = idx;
+
+    if (numDropped) {
+        snprintf(buf,
+                 sizeof(buf),
+                 "{\"name\":\"dropped events\",\"ph\":\"i\",\"s\":\"p\",\"ts\":%llu,"
+                 "\"pid\":%u,\"tid\":%u,\"args\":{\"count\":%llu}},\n",
+                 (unsigned long long)(GetTimestamp() / 1000),
+                 m_pid,
+                 GetTraceThreadId(),
+                 (unsigned long long)numDropped);
+        out += buf;
+    }
+
+    if (out.empty())
+        return MFX_ERR_NONE;
+
+    FILE *traceFile = nullptr;
+#if defined(_WIN32) || defined(_WIN64)
+    fopen_s(&traceFile, m_traceFileName.c_str(), "ab");
+#else
+    traceFile = fopen(m_traceFileName.c_str(), "ab");
+#endif
+    if (!traceFile)
+        return MFX_ERR_UNKNOWN;
+
+    // start JSON array in a new file
+    // closing bracket is optional in the Chrome trace format, so more events may be appended later
+    fseek(traceFile, 0, SEEK_END);
+    if (ftell(traceFile) == 0)
+        fputs("[\n", traceFile);
+
+    size_t len = fwrite(out.data(), 1, out.size(), traceFile);
+    fclose(traceFile);
+
+    return (len == out.size() ? MFX_ERR_NONE : MFX_ERR_UNKNOWN);
+}
+
+DispatcherLogVPL::DispatcherLogVPL()
+        : m_logLevel(0),
+          m_trace(nullptr),
+          m_logFileName(),
+          m_logFile(nullptr) {}
 
 DispatcherLogVPL::~DispatcherLogVPL() {
     if (!m_logFileName.empty() && m_logFile)
         fclose(m_logFile);
     m_logFile = nullptr;
+
+    delete m_trace;
+    m_trace = nullptr;
 }
 
 mfxStatus DispatcherLogVPL::Init(mfxU32 logLevel, const std::string &logFileName) {
@@ -57,7 +233,32 @@ mfxStatus DispatcherLogVPL::LogMessage(const char *msg, ...) {
     vfprintf(m_logFile, msg, args);
     va_end(args);
 
-    fprintf(m_logFile, "\n");
+    fputc('\n', m_logFile);
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus DispatcherLogVPL::InitTrace(const std::string &traceFileName) {
+    if (m_trace)
+        return MFX_ERR_UNSUPPORTED;
+
+    if (traceFileName.empty())
+        return MFX_ERR_UNSUPPORTED;
+
+    try {
+        m_trace = new DispatcherTraceVPL(traceFileName);
+    }
+    catch (...) {
+        return MFX_ERR_MEMORY_ALLOC;
+    }
 
     return MFX_ERR_NONE;
 }
+
+// write recorded trace events to the trace file
+mfxStatus DispatcherLogVPL::FlushTrace() {
+    if (!m_trace)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    return m_trace->Flush();
+}
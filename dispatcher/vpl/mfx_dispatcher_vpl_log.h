@@ -16,9 +16,27 @@
  *   variable with the file name of the log file.
  */
 
+/* oneVPL Dispatcher Trace
+ * Set the ONEVPL_DISPATCHER_TRACE_FILE environment variable with the file name of the trace file
+ *   to record the duration of each phase of loading (search dirs, dlopen, query caps, filter,
+ *   create session) and of each dispatcher function.
+ *
+ * Events are kept in a fixed-size ring buffer in memory, and are written to the trace file
+ *   as Chrome trace events (JSON array format, viewable in chrome://tracing or Perfetto) at
+ *   MFXUnload() or when MFXDispFlushTrace() is called. If more than DISP_TRACE_RING_SIZE events
+ *   are recorded between flushes, the oldest ones are dropped.
+ *
+ * Events are appended to the file if it already exists, so several loaders and processes may
+ *   share one trace file.
+ */
+
 #include <stdarg.h>
 #include <stdio.h>
 
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
 #include <string>
 
 #include "vpl/mfxdispatcher.h"
@@ -32,6 +50,54 @@
     #endif
 #endif
 
+#define DISP_TRACE_RING_SIZE 4096 // must be a power of 2
+
+// category of trace event
+enum DispatcherTraceCategory {
+    DispTraceFunction = 0,
+    DispTracePhase,
+};
+
+// ring buffer of completed trace events
+// Record() may be called from several threads at once, and does not block
+// name must be a string with static storage duration (literal or __FUNC_NAME__)
+class DispatcherTraceVPL {
+public:
+    explicit DispatcherTraceVPL(const std::string &traceFileName);
+
+    void Record(const char *name, DispatcherTraceCategory cat, mfxU64 tsBegin, mfxU64 tsEnd);
+    mfxStatus Flush();
+
+    // timestamp in nanoseconds
+    static mfxU64 GetTimestamp() {
+        return (mfxU64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+private:
+    // event slot, seq is set to (event index + 1) when the event is complete
+    // fields are atomic so that Flush() can read a slot while it is being overwritten
+    struct Event {
+        std::atomic<mfxU64> seq;
+        std::atomic<const char *> name;
+        std::atomic<mfxU32> cat;
+        std::atomic<mfxU32> tid;
+        std::atomic<mfxU64> tsBegin;
+        std::atomic<mfxU64> tsEnd;
+    };
+
+    std::string m_traceFileName;
+    mfxU32 m_pid;
+
+    std::unique_ptr<Event[]> m_events;
+    std::atomic<mfxU64> m_nextEvent;
+
+    // protects m_flushedEvent and serializes writing to the file
+    std::mutex m_flushMutex;
+    mfxU64 m_flushedEvent;
+};
+
 class DispatcherLogVPL {
 public:
     DispatcherLogVPL();
@@ -40,8 +106,14 @@ public:
     mfxStatus Init(mfxU32 logLevel, const std::string &logFileName);
     mfxStatus LogMessage(const char *msdk, ...);
 
+    mfxStatus InitTrace(const std::string &traceFileName);
+    mfxStatus FlushTrace();
+
     mfxU32 m_logLevel;
 
+    // null unless tracing is enabled
+    DispatcherTraceVPL *m_trace;
+
 private:
     std::string m_logFileName;
     FILE *m_logFile;
@@ -51,26 +123,70 @@ class DispatcherLogVPLFunction {
 public:
     DispatcherLogVPLFunction(DispatcherLogVPL *dispLog, const char *fnName)
             : m_dispLog(),
-              m_fnName() {
+              m_fnName(),
+              m_tsBegin(0) {
         m_dispLog = dispLog;
 
-        if (m_dispLog && m_dispLog->m_logLevel) {
+        if (m_dispLog && (m_dispLog->m_logLevel || m_dispLog->m_trace)) {
             m_fnName = fnName;
-            m_dispLog->LogMessage("function: %s (enter)", m_fnName.c_str());
+            if (m_dispLog->m_logLevel)
+                m_dispLog->LogMessage("function: %s (enter)", m_fnName);
+            if (m_dispLog->m_trace)
+                m_tsBegin = DispatcherTraceVPL::GetTimestamp();
         }
     }
 
     ~DispatcherLogVPLFunction() {
-        if (m_dispLog && m_dispLog->m_logLevel)
-            m_dispLog->LogMessage("function: %s (return)", m_fnName.c_str());
+        if (m_dispLog && m_fnName) {
+            if (m_dispLog->m_logLevel)
+                m_dispLog->LogMessage("function: %s (return)", m_fnName);
+            if (m_dispLog->m_trace)
+                m_dispLog->m_trace->Record(m_fnName,
+                                           DispTraceFunction,
+                                           m_tsBegin,
+                                           DispatcherTraceVPL::GetTimestamp());
+        }
     }
 
 private:
     DispatcherLogVPL *m_dispLog;
-    std::string m_fnName;
+    const char *m_fnName;
+    mfxU64 m_tsBegin;
 };
 
+// records duration of one phase of loading, if tracing is enabled
+class DispatcherTraceVPLPhase {
+public:
+    DispatcherTraceVPLPhase(DispatcherLogVPL *dispLog, const char *phaseName)
+            : m_trace(),
+              m_phaseName(phaseName),
+              m_tsBegin(0) {
+        if (dispLog && dispLog->m_trace) {
+            m_trace   = dispLog->m_trace;
+            m_tsBegin = DispatcherTraceVPL::GetTimestamp();
+        }
+    }
+
+    ~DispatcherTraceVPLPhase() {
+        if (m_trace)
+            m_trace->Record(m_phaseName,
+                            DispTracePhase,
+                            m_tsBegin,
+                            DispatcherTraceVPL::GetTimestamp());
+    }
+
+private:
+    DispatcherTraceVPL *m_trace;
+    const char *m_phaseName;
+    mfxU64 m_tsBegin;
+};
+
+#define DISP_TRACE_CONCAT_(a, b) a##b
+#define DISP_TRACE_CONCAT(a, b)  DISP_TRACE_CONCAT_(a, b)
+
 #define DISP_LOG_FUNCTION(dispLog) DispatcherLogVPLFunction _dispLogFn(dispLog, __FUNC_NAME__);
+#define DISP_TRACE_PHASE(dispLog, phaseName) \
+    DispatcherTraceVPLPhase DISP_TRACE_CONCAT(_dispTracePhase, __LINE__)(dispLog, phaseName);
 #define DISP_LOG_MESSAGE(dispLog, ...)          \
     {                                           \
         if (dispLog) {                          \
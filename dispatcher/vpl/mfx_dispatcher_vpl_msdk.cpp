@@ -233,6 +233,20 @@ mfxStatus LoaderCtxMSDK::QueryAPIVersion(STRING_TYPE libNameFull, mfxVersion *ms
     return MFX_ERR_UNSUPPORTED;
 }
 
+void LoaderCtxMSDK::GetKnownDescription(mfxVersion msdkVersion, mfxImplDescription *knownDesc) {
+    memset(knownDesc, 0, sizeof(mfxImplDescription));
+
+    // must match values filled in by QueryMSDKCaps()
+    knownDesc->Version.Version = MFX_IMPLDESCRIPTION_VERSION;
+    knownDesc->Impl            = MFX_IMPL_TYPE_HARDWARE;
+    knownDesc->ApiVersion      = msdkVersion;
+    knownDesc->VendorID        = 0x8086;
+
+    strncpy_s(knownDesc->ImplName, sizeof(knownDesc->ImplName), strImplName, sizeof(strImplName));
+    strncpy_s(knownDesc->License, sizeof(knownDesc->License), strLicense, sizeof(strLicense));
+    strncpy_s(knownDesc->Keywords, sizeof(knownDesc->Keywords), strKeywords, sizeof(strKeywords));
+}
+
 mfxStatus LoaderCtxMSDK::QueryMSDKCaps(STRING_TYPE libNameFull,
                                        mfxImplDescription **implDesc,
                                        mfxImplementedFunctions **implFuncs,
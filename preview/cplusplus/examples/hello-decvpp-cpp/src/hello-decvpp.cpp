@@ -0,0 +1,253 @@
+//==============================================================================
+// Copyright Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+//==============================================================================
+
+///
+/// A minimal oneAPI Video Processing Library (oneVPL) decode+VPP application,
+/// which produces an ABR ladder from a single decode, using oneVPL internal
+/// memory management
+///
+/// @file
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "util.hpp"
+#include "vpl/preview/option_tree.hpp"
+
+namespace vpl = oneapi::vpl;
+
+// Output resolutions of the ladder, one VPP channel per rung
+static const std::pair<uint16_t, uint16_t> ladder[] = { { 1280, 720 }, { 640, 360 }, { 320, 180 } };
+
+std::ofstream &operator<<(std::ofstream &f, std::pair<vpl::frame_info, vpl::frame_data> frame);
+
+void Usage(void) {
+    std::cout << std::endl;
+    std::cout << "   Usage  :  hello-decvpp \n\n";
+    std::cout << "     -sw     use software implementation\n";
+    std::cout << "     -hw     use hardware implementation\n";
+    std::cout << "     -i      input file name (HEVC elementary stream)\n";
+    std::cout << "     -vmem   use video memory\n\n";
+    std::cout << "   Example:  hello-decvpp -sw  -i in.h265\n";
+    std::cout << "   To view:  ffplay -f rawvideo -pixel_format yuv420p -video_size [width]x[height] "
+              << "out_[width]x[height].raw\n\n";
+    std::cout << " * Decode HEVC/H265 elementary stream and scale each frame to every rung of the ladder\n";
+    std::cout << "   in one call. Frames of each rung go to out_[width]x[height].raw\n\n";
+    std::cout << "   CPU native color format is I420/yuv420p.  GPU native color format is NV12\n";
+    return;
+}
+
+int main(int argc, char *argv[]) {
+    Params cliParams = {};
+
+    //Parse command line args to cliParams
+    if (ParseArgsAndValidate(argc, argv, &cliParams, PARAMS_DECODE) == false) {
+        Usage();
+        return 1; // return 1 as error code
+    }
+
+    std::ifstream source;
+    const uint32_t rungs = sizeof(ladder) / sizeof(ladder[0]);
+    std::vector<std::ofstream> sinks(rungs + 1);
+    std::vector<uint32_t> frame_num(rungs + 1, 0);
+    bool is_stillgoing = true;
+
+    // Default implementation selector. Selects first impl based on property list.
+    oneapi::vpl::properties opts;
+    opts.impl             = cliParams.implValue;
+    opts.api_version      = { 2, 5 };
+    opts.decoder.codec_id = { vpl::codec_format_fourcc::hevc };
+    std::cout << opts;
+    vpl::default_selector impl_sel(opts);
+
+    // Setup input file
+    source.open(cliParams.infileName, std::ios_base::in | std::ios_base::binary);
+    if (!source) {
+        std::cout << "Couldn't open input file" << std::endl;
+        return 1;
+    }
+
+    // File reader
+    vpl::bitstream_file_reader fr(source);
+
+    // Load session
+    vpl::io_pattern out_pattern = (cliParams.useVideoMemory) ? vpl::io_pattern::out_device_memory
+                                                             : vpl::io_pattern::out_system_memory;
+    vpl::decoder_video_param param;
+    param.set_IOPattern(out_pattern);
+    param.set_CodecId(vpl::codec_format_fourcc::hevc);
+
+    std::shared_ptr<vpl::decode_vpp_session<vpl::bitstream_file_reader>> decvpp(nullptr);
+    try {
+        decvpp = std::make_shared<vpl::decode_vpp_session<vpl::bitstream_file_reader>>(impl_sel,
+                                                                                       param,
+                                                                                       &fr);
+    }
+    catch (vpl::base_exception &e) {
+        std::cout << "Decode+VPP session create failed: " << e.what() << std::endl;
+        return -1;
+    }
+
+    // Add one VPP channel per rung
+    vpl::color_format_fourcc fourcc = (cliParams.implValue == vpl::implementation_type::sw)
+                                          ? vpl::color_format_fourcc::i420
+                                          : vpl::color_format_fourcc::nv12;
+    for (auto [w, h] : ladder) {
+        vpl::frame_info info;
+        info.set_FourCC(fourcc)
+            .set_ChromaFormat(vpl::chroma_format_idc::yuv420)
+            .set_PicStruct(vpl::pic_struct::progressive)
+            .set_frame_rate({ 30, 1 })
+            .set_frame_size({ static_cast<uint32_t>(ALIGN16(w)), static_cast<uint32_t>(ALIGN16(h)) })
+            .set_ROI({ { 0, 0 }, { w, h } });
+
+        vpl::vpp_channel_param channel(info);
+        channel.set_IOPattern(out_pattern);
+        uint16_t id = decvpp->add_channel(channel);
+
+        std::string name = "out_" + std::to_string(w) + "x" + std::to_string(h) + ".raw";
+        sinks[id].open(name, std::ios_base::out | std::ios_base::binary);
+        if (!sinks[id]) {
+            std::cout << "Couldn't open output file " << name << std::endl;
+            return 1;
+        }
+        std::cout << "Channel " << id << " -> " << name << std::endl;
+    }
+
+    // Initialize decoder and all channels
+    vpl::status ret = vpl::status::Ok;
+    try {
+        ret = decvpp->init_by_header();
+    }
+    catch (vpl::base_exception &e) {
+        std::cout << "Decode+VPP init failed: " << e.what() << std::endl;
+        return -1;
+    }
+
+    if (ret != vpl::status::Ok) {
+        std::cout << "Unknown status: " << static_cast<int>(ret) << std::endl;
+        return 1;
+    }
+
+    std::cout << "Decoding " << cliParams.infileName << std::endl;
+
+    // main decode+VPP loop
+    while (is_stillgoing == true) {
+        std::cout << "Decoding " << frame_num[0] << " frame"
+                  << "\r";
+        // One future per channel, channel 0 holds the decoded frame
+        vpl::decode_vpp_session<vpl::bitstream_file_reader>::channel_futures outputs =
+            decvpp->process();
+
+        if (outputs[0]->had_fatal()) {
+            std::cout << "Error happened: " << static_cast<int>(outputs[0]->get_last_schedule_status())
+                      << std::endl;
+            return -1;
+        }
+
+        switch (outputs[0]->get_last_schedule_status()) {
+            case vpl::status::Ok:
+            case vpl::status::NotEnoughData:
+                // channels are synchronized independently, some of them may have no output yet
+                for (uint32_t id = 0; id < outputs.size(); id++) {
+                    if (outputs[id]->get_last_schedule_status() != vpl::status::Ok)
+                        continue;
+                    try {
+                        std::shared_ptr<vpl::frame_surface> surface = outputs[id]->get();
+                        frame_num[id]++;
+                        // decoded frame isn't a rung of the ladder
+                        if (id == 0)
+                            continue;
+                        sinks[id] << surface->map(vpl::memory_access::read);
+                        surface->unmap();
+                    }
+                    catch (vpl::base_exception &e) {
+                        std::cout << "Got exception: " << e.what() << std::endl;
+                    }
+                }
+                break;
+            // Source reader reported EOS
+            case vpl::status::EndOfStreamReached:
+                std::cout << "All input data is processed." << std::endl;
+                is_stillgoing = false;
+                break;
+            case vpl::status::DeviceBusy:
+                // For non-CPU implementations
+                // Wait a few milliseconds then try again
+                break;
+            default:
+                std::cout << "Unknown status: "
+                          << static_cast<int>(outputs[0]->get_last_schedule_status()) << std::endl;
+                is_stillgoing = false;
+                break;
+        }
+    }
+
+    std::cout << "Decoded " << frame_num[0] << " frames" << std::endl;
+    for (uint32_t id = 1; id <= rungs; id++) {
+        std::shared_ptr<vpl::vpp_channel_param> p = decvpp->get_channel_param(id);
+        auto [w, h] = ladder[id - 1];
+        std::cout << "Channel " << id << " [" << w << "x" << h << "]: " << frame_num[id]
+                  << " frames" << std::endl;
+        std::cout << *(p.get()) << std::endl;
+    }
+
+    return 0;
+}
+
+// Write raw I420 or NV12 frame to file
+std::ofstream &operator<<(std::ofstream &f, std::pair<vpl::frame_info, vpl::frame_data> frame) {
+    auto [info, data] = frame;
+
+    uint16_t i, pitch;
+
+    // write visible area only
+    auto [w, h] = std::get<1>(info.get_ROI());
+
+    switch (info.get_FourCC()) {
+        case vpl::color_format_fourcc::i420: {
+            auto [Y, U, V] = data.get_plane_ptrs_3();
+            // Y
+            pitch = data.get_pitch();
+            for (i = 0; i < h; i++) {
+                f.write(reinterpret_cast<const char *>(Y + i * pitch), w);
+            }
+            // U
+            pitch /= 2;
+            h /= 2;
+            w /= 2;
+            for (i = 0; i < h; i++) {
+                f.write(reinterpret_cast<const char *>(U + i * pitch), w);
+            }
+            // V
+            for (i = 0; i < h; i++) {
+                f.write(reinterpret_cast<const char *>(V + i * pitch), w);
+            }
+            break;
+        }
+        case vpl::color_format_fourcc::nv12: {
+            auto [Y, UV] = data.get_plane_ptrs_2();
+            // Y
+            pitch = data.get_pitch();
+            for (i = 0; i < h; i++) {
+                f.write(reinterpret_cast<const char *>(Y + i * pitch), w);
+            }
+            // UV
+            h /= 2;
+            for (i = 0; i < h; i++) {
+                f.write(reinterpret_cast<const char *>(UV + i * pitch), w);
+            }
+            break;
+        }
+        default:
+            std::cout << "Unsupported FourCC code, skip writing" << std::endl;
+            break;
+    }
+
+    return f;
+}
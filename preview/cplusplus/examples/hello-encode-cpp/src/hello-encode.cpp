@@ -132,7 +132,7 @@ int main(int argc, char *argv[]) {
     while (is_stillgoing == true) {
         vpl::status wrn = vpl::status::Ok;
 
-        std::shared_ptr<vpl::bitstream_as_dst> b = std::make_shared<vpl::bitstream_as_dst>();
+        std::shared_ptr<vpl::bitstream_as_dst> b = encoder->alloc_output();
         try {
             wrn = encoder->encode_frame(b);
         }
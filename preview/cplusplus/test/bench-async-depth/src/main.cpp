@@ -0,0 +1,275 @@
+//==============================================================================
+// Copyright Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+//==============================================================================
+
+///
+/// Measures encode and decode throughput of the session's process() API
+/// for async depth 1..N. Synthetic raw frames are encoded to HEVC, then the
+/// produced stream is decoded. Futures are synced in the order they are
+/// handed back by the session, so with depth N up to N operations are in
+/// flight in the runtime.
+///
+/// @file
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "vpl/preview/vpl.hpp"
+
+namespace vpl = oneapi::vpl;
+
+#define RAW_FILE_NAME    "bench-async-depth.yuv"
+#define STREAM_FILE_NAME "bench-async-depth.h265"
+#define FRAMERATE        30
+#define ALIGN16(value)   (((value + 15) >> 4) << 4)
+
+void Usage(void) {
+    std::cout << std::endl;
+    std::cout << "   Usage  :  bench-async-depth\n\n";
+    std::cout << "     -hw      use hardware implementation\n";
+    std::cout << "     -sw      use software implementation (default)\n";
+    std::cout << "     -w N     frame width (default 1280)\n";
+    std::cout << "     -h N     frame height (default 720)\n";
+    std::cout << "     -n N     number of frames (default 120)\n";
+    std::cout << "     -d N     maximum async depth (default 8)\n";
+    return;
+}
+
+// moving gradient, so the encoder has some work to do
+static bool GenerateFile(const std::string &name,
+                         uint16_t width,
+                         uint16_t height,
+                         vpl::color_format_fourcc format,
+                         uint32_t frames) {
+    std::ofstream out(name, std::ios_base::out | std::ios_base::binary);
+    if (!out)
+        return false;
+
+    uint32_t cw = (width + 1) / 2;
+    uint32_t ch = (height + 1) / 2;
+    std::vector<uint8_t> frame(static_cast<size_t>(width) * height + 2 * cw * ch);
+    for (uint32_t n = 0; n < frames; n++) {
+        uint8_t *p = frame.data();
+        for (uint32_t y = 0; y < height; y++)
+            for (uint32_t x = 0; x < width; x++)
+                *p++ = static_cast<uint8_t>(x + y + 4 * n);
+        if (format == vpl::color_format_fourcc::nv12) {
+            for (uint32_t i = 0; i < cw * ch; i++) {
+                *p++ = static_cast<uint8_t>(128 + n);
+                *p++ = static_cast<uint8_t>(128 - n);
+            }
+        }
+        else {
+            memset(p, 128 + n, cw * ch);
+            memset(p + cw * ch, 128 - n, cw * ch);
+        }
+        out.write(reinterpret_cast<char *>(frame.data()), frame.size());
+    }
+    return out.good();
+}
+
+// encodes all frames of the raw file, returns number of encoded frames
+static uint32_t Encode(const vpl::implementation_selector &sel,
+                       vpl::implementation_type impl,
+                       uint16_t width,
+                       uint16_t height,
+                       uint32_t depth,
+                       std::ofstream *sink,
+                       double &ms) {
+    vpl::color_format_fourcc format = (impl == vpl::implementation_type::sw)
+                                          ? vpl::color_format_fourcc::i420
+                                          : vpl::color_format_fourcc::nv12;
+    vpl::raw_frame_bulk_file_reader reader(width, height, format, format, RAW_FILE_NAME);
+    vpl::encode_session encoder(sel);
+
+    vpl::encoder_video_param params;
+    vpl::frame_info info;
+    info.set_frame_rate({ FRAMERATE, 1 });
+    info.set_frame_size({ static_cast<uint16_t>(ALIGN16(width)),
+                          static_cast<uint16_t>(ALIGN16(height)) });
+    info.set_FourCC(format);
+    info.set_ChromaFormat(vpl::chroma_format_idc::yuv420);
+    info.set_ROI({ { 0, 0 }, { width, height } });
+    info.set_PicStruct(vpl::pic_struct::progressive);
+
+    params.set_RateControlMethod(vpl::rate_control_method::cqp);
+    params.set_frame_info(info);
+    params.set_CodecId(vpl::codec_format_fourcc::hevc);
+    params.set_IOPattern(vpl::io_pattern::in_system_memory);
+    params.set_AsyncDepth(static_cast<uint16_t>(depth));
+
+    encoder.Init(&params);
+    encoder.set_async_depth(depth);
+
+    uint32_t frames = 0;
+    auto start      = std::chrono::high_resolution_clock::now();
+    while (1) {
+        std::shared_ptr<vpl::future_surface_t> in;
+        vpl::operation_status op(vpl::component::unknown, nullptr);
+        if (!reader.is_EOS()) {
+            std::shared_ptr<vpl::frame_surface> surface = encoder.alloc_input();
+            if (reader.get_data(surface)) {
+                in                  = std::make_shared<vpl::future_surface_t>(surface);
+                op.schedule_status_ = vpl::status::Ok;
+            }
+        }
+        if (!in) {
+            in                  = std::make_shared<vpl::future_surface_t>(nullptr);
+            op.schedule_status_ = vpl::status::EndOfStreamReached;
+        }
+        in->add_operation(op);
+
+        std::shared_ptr<vpl::future_bitstream_t> out = encoder.process(in);
+        if (out->had_fatal())
+            throw vpl::base_exception("encoder failed", MFX_ERR_UNKNOWN);
+
+        vpl::status sts = out->get_last_schedule_status();
+        if (sts == vpl::status::Ok) {
+            std::shared_ptr<vpl::bitstream_as_dst> bits = out->get();
+            if (sink) {
+                auto [ptr, len] = bits->get_valid_data();
+                sink->write(reinterpret_cast<char *>(ptr), len);
+            }
+            frames++;
+        }
+        else if (sts == vpl::status::EndOfStreamReached) {
+            break;
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    ms = std::chrono::duration<double, std::milli>(end - start).count();
+    return frames;
+}
+
+// decodes the encoded stream, returns number of decoded frames
+static uint32_t Decode(const vpl::implementation_selector &sel, uint32_t depth, double &ms) {
+    std::string name(STREAM_FILE_NAME);
+    vpl::bitstream_file_reader_name reader(name);
+    vpl::decode_session<vpl::bitstream_file_reader_name> decoder(sel,
+                                                                 vpl::codec_format_fourcc::hevc,
+                                                                 &reader);
+    decoder.set_async_depth(depth);
+    decoder.init_by_header();
+
+    uint32_t frames = 0;
+    auto start      = std::chrono::high_resolution_clock::now();
+    while (1) {
+        std::shared_ptr<vpl::future_surface_t> out = decoder.process();
+        if (out->had_fatal())
+            throw vpl::base_exception("decoder failed", MFX_ERR_UNKNOWN);
+
+        vpl::status sts = out->get_last_schedule_status();
+        if (sts == vpl::status::Ok) {
+            out->wait();
+            frames++;
+        }
+        else if (sts == vpl::status::EndOfStreamReached) {
+            break;
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    ms = std::chrono::duration<double, std::milli>(end - start).count();
+    return frames;
+}
+
+static void PrintResult(const char *name, uint32_t depth, double ms, uint32_t frames) {
+    double fps = (ms > 0) ? frames / (ms / 1000.0) : 0;
+    printf("bench-async-depth -- %s, depth %u = % 9.2f msec, %u frames, % 8.1f fps\n",
+           name,
+           depth,
+           ms,
+           frames,
+           fps);
+}
+
+int main(int argc, char *argv[]) {
+    vpl::implementation_type impl = vpl::implementation_type::sw;
+    uint16_t width                = 1280;
+    uint16_t height               = 720;
+    uint32_t frames               = 120;
+    uint32_t maxDepth             = 8;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-hw")) {
+            impl = vpl::implementation_type::hw;
+        }
+        else if (!strcmp(argv[i], "-sw")) {
+            impl = vpl::implementation_type::sw;
+        }
+        else if (!strcmp(argv[i], "-w") && i + 1 < argc) {
+            width = static_cast<uint16_t>(atoi(argv[++i]));
+        }
+        else if (!strcmp(argv[i], "-h") && i + 1 < argc) {
+            height = static_cast<uint16_t>(atoi(argv[++i]));
+        }
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            frames = static_cast<uint32_t>(atoi(argv[++i]));
+        }
+        else if (!strcmp(argv[i], "-d") && i + 1 < argc) {
+            maxDepth = static_cast<uint32_t>(atoi(argv[++i]));
+        }
+        else {
+            Usage();
+            return 1;
+        }
+    }
+
+    if (!width || !height || !frames || !maxDepth) {
+        Usage();
+        return 1;
+    }
+
+    vpl::color_format_fourcc format = (impl == vpl::implementation_type::sw)
+                                          ? vpl::color_format_fourcc::i420
+                                          : vpl::color_format_fourcc::nv12;
+    if (!GenerateFile(RAW_FILE_NAME, width, height, format, frames)) {
+        std::cout << "Error - unable to create " << RAW_FILE_NAME << std::endl;
+        return 1;
+    }
+
+    int ret = 0;
+    try {
+        vpl::default_selector encSel({ vpl::dprops::impl(impl),
+                                       vpl::dprops::api_version(2, 5),
+                                       vpl::dprops::encoder({ vpl::dprops::codec_id(
+                                           vpl::codec_format_fourcc::hevc) }) });
+        vpl::default_selector decSel({ vpl::dprops::impl(impl),
+                                       vpl::dprops::api_version(2, 5),
+                                       vpl::dprops::decoder({ vpl::dprops::codec_id(
+                                           vpl::codec_format_fourcc::hevc) }) });
+
+        double ms = 0;
+        for (uint32_t depth = 1; depth <= maxDepth; depth++) {
+            // keep the stream of the first pass for the decode passes
+            std::ofstream sink;
+            if (depth == 1)
+                sink.open(STREAM_FILE_NAME, std::ios_base::out | std::ios_base::binary);
+            uint32_t n = Encode(encSel, impl, width, height, depth, (depth == 1) ? &sink : nullptr, ms);
+            PrintResult("encode", depth, ms, n);
+        }
+
+        for (uint32_t depth = 1; depth <= maxDepth; depth++) {
+            uint32_t n = Decode(decSel, depth, ms);
+            PrintResult("decode", depth, ms, n);
+        }
+    }
+    catch (vpl::base_exception &e) {
+        std::cout << "Error - " << e.what() << std::endl;
+        ret = 1;
+    }
+
+    remove(RAW_FILE_NAME);
+    remove(STREAM_FILE_NAME);
+
+    return ret;
+}
@@ -0,0 +1,116 @@
+//==============================================================================
+// Copyright Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+//==============================================================================
+
+///
+/// Measures cost of output bitstream allocation in the encode loop: a new
+/// bitstream per frame vs. bitstreams taken from a bitstream pool. Each frame
+/// the "encoder" writes frame data into the bitstream, and the application keeps
+/// a few frames in flight before dropping them, like with async encode.
+///
+/// @file
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+
+#include "vpl/preview/vpl.hpp"
+
+namespace vpl = oneapi::vpl;
+
+void Usage(void) {
+    std::cout << std::endl;
+    std::cout << "   Usage  :  bench-bitstream-pool\n\n";
+    std::cout << "     -n N     number of frames (default 2000)\n";
+    std::cout << "     -f N     frame size in KB (default 64)\n";
+    std::cout << "     -d N     frames in flight (default 4)\n";
+    return;
+}
+
+// write frame into the bitstream the way an encoder would
+static void WriteFrame(vpl::bitstream_as_dst &bits, uint32_t frameSize, uint32_t frame) {
+    mfxBitstream *bs = bits();
+    uint32_t n       = (std::min)(frameSize, bs->MaxLength);
+    memset(bs->Data, static_cast<int>(frame), n);
+    bs->DataOffset = 0;
+    bs->DataLength = n;
+}
+
+template <typename F>
+static double EncodeLoop(F alloc, uint32_t numFrames, uint32_t frameSize, uint32_t depth) {
+    std::deque<std::shared_ptr<vpl::bitstream_as_dst>> inFlight;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < numFrames; i++) {
+        std::shared_ptr<vpl::bitstream_as_dst> b = alloc();
+        WriteFrame(*b, frameSize, i);
+        inFlight.push_back(b);
+        if (inFlight.size() > depth)
+            inFlight.pop_front();
+    }
+    inFlight.clear();
+    auto end = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static void PrintResult(const char *name, double ms, uint32_t numFrames) {
+    double fps = (ms > 0) ? numFrames / (ms / 1000.0) : 0;
+    printf("bench-bitstream-pool -- %-20s = % 9.2f msec, % 11.1f frames/s\n", name, ms, fps);
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t numFrames = 2000;
+    uint32_t frameSize = 64 * 1024;
+    uint32_t depth     = 4;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            numFrames = static_cast<uint32_t>(atoi(argv[++i]));
+        }
+        else if (!strcmp(argv[i], "-f") && i + 1 < argc) {
+            frameSize = static_cast<uint32_t>(atoi(argv[++i])) * 1024;
+        }
+        else if (!strcmp(argv[i], "-d") && i + 1 < argc) {
+            depth = static_cast<uint32_t>(atoi(argv[++i]));
+        }
+        else {
+            Usage();
+            return 1;
+        }
+    }
+
+    double ms = EncodeLoop(
+        []() {
+            return std::make_shared<vpl::bitstream_as_dst>();
+        },
+        numFrames,
+        frameSize,
+        depth);
+    PrintResult("new bitstream", ms, numFrames);
+
+    auto pool = std::make_shared<vpl::bitstream_pool>();
+    ms        = EncodeLoop(
+        [&pool]() {
+            return pool->acquire();
+        },
+        numFrames,
+        frameSize,
+        depth);
+    PrintResult("bitstream pool", ms, numFrames);
+
+    vpl::bitstream_pool_stats stats = pool->stats();
+    printf("bench-bitstream-pool -- pool: %llu allocations, %llu reuses, %llu reallocations, "
+           "peak frame %u bytes\n",
+           static_cast<unsigned long long>(stats.allocations),
+           static_cast<unsigned long long>(stats.reuses),
+           static_cast<unsigned long long>(stats.reallocations),
+           stats.peak_data_length);
+
+    return 0;
+}
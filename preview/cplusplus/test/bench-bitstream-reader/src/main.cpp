@@ -0,0 +1,192 @@
+//==============================================================================
+// Copyright Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+//==============================================================================
+
+///
+/// Measures throughput of the bitstream source readers: ifstream based readers,
+/// which copy data into the bitstream buffer, vs. the memory mapped reader, which
+/// points the bitstream into the mapping. ifstream based readers are measured with
+/// both the plain buffer, which moves unconsumed data on every refill, and the ring
+/// buffer. Each call consumes one "frame" of data like a decoder would.
+///
+/// @file
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "vpl/preview/vpl.hpp"
+
+namespace vpl = oneapi::vpl;
+
+#define DEFAULT_FILE_NAME "bench-bitstream-reader.bin"
+
+void Usage(void) {
+    std::cout << std::endl;
+    std::cout << "   Usage  :  bench-bitstream-reader\n\n";
+    std::cout << "     -i file  input elementary stream (default: generate test file)\n";
+    std::cout << "     -s N     size of generated test file in MB (default 256)\n";
+    std::cout << "     -f N     bytes consumed per call in KB (default 64)\n";
+    std::cout << "     -w N     window of memory mapped reader in MB (default 16)\n";
+    return;
+}
+
+static bool GenerateFile(const std::string &name, uint32_t sizeMB) {
+    std::ofstream out(name, std::ios_base::out | std::ios_base::binary);
+    if (!out)
+        return false;
+
+    std::vector<uint8_t> block(1024 * 1024);
+    uint32_t x = 12345;
+    for (uint32_t i = 0; i < sizeMB; i++) {
+        for (auto &b : block) {
+            x = x * 1103515245 + 12345;
+            b = static_cast<uint8_t>(x >> 16);
+        }
+        out.write(reinterpret_cast<char *>(block.data()), block.size());
+    }
+    return out.good();
+}
+
+// consume the stream like a decoder: frameSize bytes per call, touching every byte
+// returns elapsed time in msec
+static double ConsumeStream(vpl::bitstream_source_reader &reader,
+                            uint32_t frameSize,
+                            uint64_t &totalBytes,
+                            uint64_t &checksum,
+                            bool useRing = false) {
+    vpl::bitstream_as_src bits;
+    if (useRing && !bits.use_ring_buffer())
+        std::cout << "Warning - ring buffer is not supported, using plain buffer" << std::endl;
+
+    totalBytes = 0;
+    checksum   = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    while (1) {
+        reader.get_data(&bits);
+
+        mfxBitstream *bs = bits();
+        if (bs->DataLength == 0 && reader.is_EOS())
+            break;
+
+        uint32_t n      = (bs->DataLength < frameSize) ? bs->DataLength : frameSize;
+        const uint8_t *p = bs->Data + bs->DataOffset;
+        for (uint32_t i = 0; i < n; i++)
+            checksum += p[i];
+
+        bs->DataOffset += n;
+        bs->DataLength -= n;
+        totalBytes += n;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static void PrintResult(const char *name, double ms, uint64_t bytes, uint64_t checksum) {
+    double mbps = (ms > 0) ? (static_cast<double>(bytes) / (1024.0 * 1024.0)) / (ms / 1000.0) : 0;
+    printf("bench-bitstream-reader -- %-24s = % 9.2f msec, % 9.1f MB/s (checksum %llu)\n",
+           name,
+           ms,
+           mbps,
+           static_cast<unsigned long long>(checksum));
+}
+
+int main(int argc, char *argv[]) {
+    std::string fileName;
+    uint32_t sizeMB    = 256;
+    uint32_t frameSize = 64 * 1024;
+    uint32_t windowMB  = 16;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-i") && i + 1 < argc) {
+            fileName = argv[++i];
+        }
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+            sizeMB = static_cast<uint32_t>(atoi(argv[++i]));
+        }
+        else if (!strcmp(argv[i], "-f") && i + 1 < argc) {
+            frameSize = static_cast<uint32_t>(atoi(argv[++i])) * 1024;
+        }
+        else if (!strcmp(argv[i], "-w") && i + 1 < argc) {
+            windowMB = static_cast<uint32_t>(atoi(argv[++i]));
+        }
+        else {
+            Usage();
+            return 1;
+        }
+    }
+
+    if (!frameSize) {
+        Usage();
+        return 1;
+    }
+
+    bool bGenerated = false;
+    if (fileName.empty()) {
+        fileName = DEFAULT_FILE_NAME;
+        if (!GenerateFile(fileName, sizeMB)) {
+            std::cout << "Error - unable to create " << fileName << std::endl;
+            return 1;
+        }
+        bGenerated = true;
+    }
+
+    uint64_t bytes = 0, checksum = 0;
+    double ms = 0;
+
+    try {
+        // warm up page cache so all readers see the same file state
+        {
+            vpl::bitstream_file_reader_name warmup(fileName);
+            ConsumeStream(warmup, frameSize, bytes, checksum);
+        }
+
+        {
+            std::ifstream ifl(fileName, std::ios_base::in | std::ios_base::binary);
+            vpl::bitstream_file_reader reader(ifl);
+            ms = ConsumeStream(reader, frameSize, bytes, checksum);
+            PrintResult("ifstream reader", ms, bytes, checksum);
+        }
+
+        {
+            vpl::bitstream_file_reader_name reader(fileName);
+            ms = ConsumeStream(reader, frameSize, bytes, checksum);
+            PrintResult("ifstream reader by name", ms, bytes, checksum);
+        }
+
+        {
+            std::ifstream ifl(fileName, std::ios_base::in | std::ios_base::binary);
+            vpl::bitstream_file_reader reader(ifl);
+            ms = ConsumeStream(reader, frameSize, bytes, checksum, true);
+            PrintResult("ifstream reader, ring", ms, bytes, checksum);
+        }
+
+        {
+            vpl::bitstream_file_reader_name reader(fileName);
+            ms = ConsumeStream(reader, frameSize, bytes, checksum, true);
+            PrintResult("ifstream by name, ring", ms, bytes, checksum);
+        }
+
+        {
+            vpl::bitstream_mapped_file_reader reader(fileName, windowMB * 1024 * 1024);
+            ms = ConsumeStream(reader, frameSize, bytes, checksum);
+            PrintResult("memory mapped reader", ms, bytes, checksum);
+        }
+    }
+    catch (vpl::base_exception &e) {
+        std::cout << "Error - " << e.what() << std::endl;
+    }
+
+    if (bGenerated)
+        remove(fileName.c_str());
+
+    return 0;
+}
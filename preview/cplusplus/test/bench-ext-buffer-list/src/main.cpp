@@ -0,0 +1,163 @@
+//==============================================================================
+// Copyright Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+//==============================================================================
+
+///
+/// Measures cost of attaching per-frame encode controls (ROI, SEI, header
+/// insertion) through an extension buffer list: the flat list with the cached
+/// raw pointer array vs. the previous std::map based list, which rebuilt the
+/// raw array on every call. Each frame copies the list like passing it to
+/// encode_frame() by value does, then takes the raw array.
+///
+/// @file
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <utility>
+
+#include "vpl/preview/vpl.hpp"
+
+namespace vpl = oneapi::vpl;
+
+void Usage(void) {
+    std::cout << std::endl;
+    std::cout << "   Usage  :  bench-ext-buffer-list\n\n";
+    std::cout << "     -n N     number of frames (default 1000000)\n";
+    return;
+}
+
+// previous implementation, kept for reference
+class MapBufferList {
+public:
+    MapBufferList() : m_buffers(), m_raw(nullptr) {}
+    MapBufferList(const MapBufferList &other) : m_buffers(other.m_buffers), m_raw(nullptr) {}
+    ~MapBufferList() {
+        delete[] m_raw;
+    }
+
+    void add_buffer(vpl::extension_buffer_base *o) {
+        m_buffers[o->get_ID()] = o;
+    }
+
+    bool has_buffer(uint32_t id) {
+        return m_buffers.find(id) != m_buffers.end();
+    }
+
+    std::pair<mfxExtBuffer **, size_t> get_raw_ext_buffers() {
+        uint32_t ignoreNum = 0;
+        std::for_each(vpl::ignore_ID_list,
+                      vpl::ignore_ID_list + IGNORE_LIST_LEN,
+                      [&](uint32_t id) {
+                          if (has_buffer(id))
+                              ignoreNum++;
+                      });
+
+        delete[] m_raw;
+        m_raw = new mfxExtBuffer *[m_buffers.size() - ignoreNum];
+        int i = 0;
+        for (const auto &buf : m_buffers) {
+            auto id = buf.first;
+            if (std::any_of(vpl::ignore_ID_list,
+                            vpl::ignore_ID_list + IGNORE_LIST_LEN,
+                            [&id](uint32_t ignore_id) {
+                                return id == ignore_id;
+                            }))
+                continue;
+            m_raw[i++] = buf.second->get_base_ptr();
+        }
+        return std::pair(m_raw, m_buffers.size() - ignoreNum);
+    }
+
+private:
+    std::map<uint32_t, vpl::extension_buffer_base *> m_buffers;
+    mfxExtBuffer **m_raw;
+};
+
+// attaches the list to n frames; returns elapsed time in msec
+template <typename List>
+static double AttachReused(List &list, uint32_t n, uint64_t &checksum) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < n; i++) {
+        List frameList(list);
+        auto [buffers, size] = frameList.get_raw_ext_buffers();
+        checksum += size + buffers[size - 1]->BufferId;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// builds a new list for each of n frames; returns elapsed time in msec
+template <typename List>
+static double AttachRebuilt(vpl::extension_buffer_base *const *controls,
+                            uint32_t numControls,
+                            uint32_t n,
+                            uint64_t &checksum) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < n; i++) {
+        List list;
+        for (uint32_t c = 0; c < numControls; c++)
+            list.add_buffer(controls[c]);
+        List frameList(list);
+        auto [buffers, size] = frameList.get_raw_ext_buffers();
+        checksum += size + buffers[size - 1]->BufferId;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static void PrintResult(const char *name, double ms, uint32_t n, uint64_t checksum) {
+    double ns = (n > 0) ? ms * 1000000.0 / n : 0;
+    printf("bench-ext-buffer-list -- %-24s = % 9.2f msec, % 7.1f ns/frame (checksum %llu)\n",
+           name,
+           ms,
+           ns,
+           static_cast<unsigned long long>(checksum));
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t n = 1000000;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            n = static_cast<uint32_t>(atoi(argv[++i]));
+        }
+        else {
+            Usage();
+            return 1;
+        }
+    }
+
+    vpl::ExtEncoderROI roi;
+    vpl::ExtPictureTimingSEI sei;
+    vpl::ExtInsertHeaders headers;
+    vpl::extension_buffer_base *controls[] = { &roi, &sei, &headers };
+    const uint32_t numControls             = sizeof(controls) / sizeof(controls[0]);
+
+    vpl::encoder_process_list flat;
+    MapBufferList map;
+    for (auto c : controls) {
+        flat.add_buffer(c);
+        map.add_buffer(c);
+    }
+
+    uint64_t checksum = 0;
+    double ms         = 0;
+
+    ms = AttachReused(map, n, checksum = 0);
+    PrintResult("map list, reused", ms, n, checksum);
+    ms = AttachReused(flat, n, checksum = 0);
+    PrintResult("flat list, reused", ms, n, checksum);
+
+    ms = AttachRebuilt<MapBufferList>(controls, numControls, n, checksum = 0);
+    PrintResult("map list, per frame", ms, n, checksum);
+    ms = AttachRebuilt<vpl::encoder_process_list>(controls, numControls, n, checksum = 0);
+    PrintResult("flat list, per frame", ms, n, checksum);
+
+    return 0;
+}
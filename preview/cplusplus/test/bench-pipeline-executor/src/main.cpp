@@ -0,0 +1,233 @@
+//==============================================================================
+// Copyright Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+//==============================================================================
+
+///
+/// Drives many low-rate streams with the coroutine pipeline executor and
+/// compares it with one blocking thread per stream. Each stream schedules
+/// a frame, waits for its sync point and schedules the next one. Frames are
+/// system memory surfaces whose sync point completes after a fixed latency,
+/// so no runtime is needed.
+///
+/// @file
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "vpl/preview/vpl.hpp"
+
+namespace vpl = oneapi::vpl;
+
+void Usage(void) {
+    std::cout << std::endl;
+    std::cout << "   Usage  :  bench-pipeline-executor\n\n";
+    std::cout << "     -s N     number of streams (default 256)\n";
+    std::cout << "     -n N     frames per stream (default 60)\n";
+    std::cout << "     -l N     latency of one frame in msec (default 5)\n";
+    std::cout << "     -t N     executor threads (default 4)\n";
+    return;
+}
+
+// surface whose sync point completes after the given latency
+class DelayedSurface {
+public:
+    explicit DelayedSurface(std::chrono::milliseconds latency)
+            : m_surface(),
+              m_interface(),
+              m_deadline(std::chrono::steady_clock::now() + latency),
+              m_refCounter(0) {
+        m_interface.Context       = this;
+        m_interface.AddRef        = AddRef;
+        m_interface.Release       = Release;
+        m_interface.GetRefCounter = GetRefCounter;
+        m_interface.Map           = Map;
+        m_interface.Unmap         = Unmap;
+        m_interface.Synchronize   = Synchronize;
+        m_surface.FrameInterface  = &m_interface;
+    }
+
+    mfxFrameSurface1 *get() {
+        return &m_surface;
+    }
+
+private:
+    static DelayedSurface *Self(mfxFrameSurface1 *surface) {
+        return static_cast<DelayedSurface *>(surface->FrameInterface->Context);
+    }
+    static mfxStatus MFX_CDECL AddRef(mfxFrameSurface1 *surface) {
+        Self(surface)->m_refCounter++;
+        return MFX_ERR_NONE;
+    }
+    static mfxStatus MFX_CDECL Release(mfxFrameSurface1 *surface) {
+        if (--Self(surface)->m_refCounter == 0)
+            delete Self(surface);
+        return MFX_ERR_NONE;
+    }
+    static mfxStatus MFX_CDECL GetRefCounter(mfxFrameSurface1 *surface, mfxU32 *counter) {
+        *counter = Self(surface)->m_refCounter;
+        return MFX_ERR_NONE;
+    }
+    static mfxStatus MFX_CDECL Map(mfxFrameSurface1 *, mfxU32) {
+        return MFX_ERR_NONE;
+    }
+    static mfxStatus MFX_CDECL Unmap(mfxFrameSurface1 *) {
+        return MFX_ERR_NONE;
+    }
+    static mfxStatus MFX_CDECL Synchronize(mfxFrameSurface1 *surface, mfxU32 wait) {
+        auto deadline = Self(surface)->m_deadline;
+        auto now      = std::chrono::steady_clock::now();
+        if (now < deadline && wait) {
+            auto limit = now + std::chrono::milliseconds(wait);
+            std::this_thread::sleep_until((deadline < limit) ? deadline : limit);
+            now = std::chrono::steady_clock::now();
+        }
+        return (now < deadline) ? MFX_WRN_IN_EXECUTION : MFX_ERR_NONE;
+    }
+
+    mfxFrameSurface1 m_surface;
+    mfxFrameSurfaceInterface m_interface;
+    std::chrono::steady_clock::time_point m_deadline;
+    std::atomic<mfxU32> m_refCounter;
+};
+
+// schedules one frame like process() does
+static std::shared_ptr<vpl::future_surface_t> Schedule(std::chrono::milliseconds latency) {
+    auto surface = std::make_shared<vpl::frame_surface>((new DelayedSurface(latency))->get());
+    auto f       = std::make_shared<vpl::future_surface_t>(surface);
+    vpl::operation_status op(vpl::component::decoder, nullptr);
+    op.schedule_status_ = vpl::status::Ok;
+    f->add_operation(op);
+    return f;
+}
+
+static vpl::task<std::shared_ptr<vpl::future_surface_t>> NextFrame(std::chrono::milliseconds latency) {
+    co_return co_await vpl::synchronized(Schedule(latency));
+}
+
+static vpl::task<> Stream(uint32_t frames,
+                          std::chrono::milliseconds latency,
+                          std::atomic<uint64_t> &done) {
+    for (uint32_t i = 0; i < frames; i++) {
+        std::shared_ptr<vpl::future_surface_t> f = co_await NextFrame(latency);
+        f->get();
+        done++;
+    }
+}
+
+static double RunThreads(uint32_t streams,
+                         uint32_t frames,
+                         std::chrono::milliseconds latency,
+                         uint64_t &done) {
+    std::atomic<uint64_t> counter(0);
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t s = 0; s < streams; s++) {
+        threads.emplace_back([&]() {
+            for (uint32_t i = 0; i < frames; i++) {
+                Schedule(latency)->get();
+                counter++;
+            }
+        });
+    }
+    for (auto &t : threads)
+        t.join();
+    auto end = std::chrono::high_resolution_clock::now();
+
+    done = counter;
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static double RunExecutor(uint32_t streams,
+                          uint32_t frames,
+                          std::chrono::milliseconds latency,
+                          uint32_t threads,
+                          uint64_t &done) {
+    std::atomic<uint64_t> counter(0);
+    vpl::executor ex(threads);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t s = 0; s < streams; s++)
+        ex.spawn(Stream(frames, latency, counter));
+    ex.join();
+    auto end = std::chrono::high_resolution_clock::now();
+
+    done = counter;
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static void PrintResult(const char *name, uint32_t threads, double ms, uint64_t frames) {
+    double fps = (ms > 0) ? frames / (ms / 1000.0) : 0;
+    printf("bench-pipeline-executor -- %-18s %4u threads = % 9.2f msec, %llu frames, % 9.1f fps\n",
+           name,
+           threads,
+           ms,
+           static_cast<unsigned long long>(frames),
+           fps);
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t streams   = 256;
+    uint32_t frames    = 60;
+    uint32_t latencyMs = 5;
+    uint32_t threads   = 4;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+            streams = static_cast<uint32_t>(atoi(argv[++i]));
+        }
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            frames = static_cast<uint32_t>(atoi(argv[++i]));
+        }
+        else if (!strcmp(argv[i], "-l") && i + 1 < argc) {
+            latencyMs = static_cast<uint32_t>(atoi(argv[++i]));
+        }
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+            threads = static_cast<uint32_t>(atoi(argv[++i]));
+        }
+        else {
+            Usage();
+            return 1;
+        }
+    }
+
+    if (!streams || !frames) {
+        Usage();
+        return 1;
+    }
+
+    std::chrono::milliseconds latency(latencyMs);
+    uint64_t expected = static_cast<uint64_t>(streams) * frames;
+    uint64_t done     = 0;
+    double ms         = 0;
+
+    try {
+        ms = RunThreads(streams, frames, latency, done);
+        PrintResult("thread per stream", streams, ms, done);
+        if (done != expected) {
+            std::cout << "Error - frame count mismatch" << std::endl;
+            return 1;
+        }
+
+        ms = RunExecutor(streams, frames, latency, threads, done);
+        PrintResult("executor", threads, ms, done);
+        if (done != expected) {
+            std::cout << "Error - frame count mismatch" << std::endl;
+            return 1;
+        }
+    }
+    catch (vpl::base_exception &e) {
+        std::cout << "Error - " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
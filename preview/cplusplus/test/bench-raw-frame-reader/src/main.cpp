@@ -0,0 +1,340 @@
+//==============================================================================
+// Copyright Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+//==============================================================================
+
+///
+/// Measures throughput of the raw frame readers: the row by row ifstream
+/// readers vs. the bulk reader, which reads each frame with one call and
+/// copies or converts it into the surface with SIMD kernels. Surfaces are
+/// system memory surfaces with padded pitch, so no runtime is needed. Output
+/// of the bulk reader is verified against a scalar reference.
+///
+/// @file
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "vpl/preview/vpl.hpp"
+
+namespace vpl = oneapi::vpl;
+
+#define DEFAULT_FILE_NAME "bench-raw-frame-reader.yuv"
+
+void Usage(void) {
+    std::cout << std::endl;
+    std::cout << "   Usage  :  bench-raw-frame-reader\n\n";
+    std::cout << "     -w N     frame width (default 1920)\n";
+    std::cout << "     -h N     frame height (default 1080)\n";
+    std::cout << "     -n N     number of frames (default 60)\n";
+    return;
+}
+
+// system memory surface with the minimal frame interface used by the readers
+class SystemSurface {
+public:
+    SystemSurface(uint16_t width, uint16_t height, vpl::color_format_fourcc format)
+            : m_surface(),
+              m_interface(),
+              m_buffer(),
+              m_refCounter(0) {
+        uint32_t bpp   = 1;
+        uint32_t lines = height + (height + 1) / 2;
+        switch (format) {
+            case vpl::color_format_fourcc::p010:
+                bpp = 2;
+                break;
+            case vpl::color_format_fourcc::yuy2:
+                bpp   = 2;
+                lines = height;
+                break;
+            case vpl::color_format_fourcc::bgra:
+                bpp   = 4;
+                lines = height;
+                break;
+            default:
+                break;
+        }
+
+        // padded pitch like video memory surfaces have
+        uint32_t pitch = ((width * bpp + 63) / 64) * 64 + 64;
+        m_buffer.resize(static_cast<size_t>(pitch) * lines);
+        uint8_t *base = m_buffer.data();
+
+        mfxFrameData &data = m_surface.Data;
+        data.PitchHigh     = static_cast<mfxU16>(pitch >> 16);
+        data.PitchLow      = static_cast<mfxU16>(pitch & 0xFFFF);
+        switch (format) {
+            case vpl::color_format_fourcc::i420:
+                data.Y = base;
+                data.U = data.Y + static_cast<size_t>(pitch) * height;
+                data.V = data.U + static_cast<size_t>(pitch / 2) * ((height + 1) / 2);
+                break;
+            case vpl::color_format_fourcc::nv12:
+            case vpl::color_format_fourcc::p010:
+                data.Y  = base;
+                data.UV = data.Y + static_cast<size_t>(pitch) * height;
+                break;
+            case vpl::color_format_fourcc::yuy2:
+                data.Y = base;
+                data.U = base + 1;
+                data.V = base + 3;
+                break;
+            default:
+                data.B = base;
+                data.G = base + 1;
+                data.R = base + 2;
+                data.A = base + 3;
+                break;
+        }
+        m_surface.Info.FourCC = static_cast<mfxU32>(format);
+
+        m_interface.Context       = this;
+        m_interface.AddRef        = AddRef;
+        m_interface.Release       = Release;
+        m_interface.GetRefCounter = GetRefCounter;
+        m_interface.Map           = Map;
+        m_interface.Unmap         = Unmap;
+        m_interface.Synchronize   = Synchronize;
+        m_surface.FrameInterface  = &m_interface;
+    }
+
+    mfxFrameSurface1 *get() {
+        return &m_surface;
+    }
+
+    const std::vector<uint8_t> &buffer() const {
+        return m_buffer;
+    }
+
+    uint32_t pitch() const {
+        return (static_cast<uint32_t>(m_surface.Data.PitchHigh) << 16) | m_surface.Data.PitchLow;
+    }
+
+private:
+    static SystemSurface *Self(mfxFrameSurface1 *surface) {
+        return static_cast<SystemSurface *>(surface->FrameInterface->Context);
+    }
+    static mfxStatus MFX_CDECL AddRef(mfxFrameSurface1 *surface) {
+        Self(surface)->m_refCounter++;
+        return MFX_ERR_NONE;
+    }
+    static mfxStatus MFX_CDECL Release(mfxFrameSurface1 *surface) {
+        Self(surface)->m_refCounter--;
+        return MFX_ERR_NONE;
+    }
+    static mfxStatus MFX_CDECL GetRefCounter(mfxFrameSurface1 *surface, mfxU32 *counter) {
+        *counter = Self(surface)->m_refCounter;
+        return MFX_ERR_NONE;
+    }
+    static mfxStatus MFX_CDECL Map(mfxFrameSurface1 *, mfxU32) {
+        return MFX_ERR_NONE;
+    }
+    static mfxStatus MFX_CDECL Unmap(mfxFrameSurface1 *) {
+        return MFX_ERR_NONE;
+    }
+    static mfxStatus MFX_CDECL Synchronize(mfxFrameSurface1 *, mfxU32) {
+        return MFX_ERR_NONE;
+    }
+
+    mfxFrameSurface1 m_surface;
+    mfxFrameSurfaceInterface m_interface;
+    std::vector<uint8_t> m_buffer;
+    mfxU32 m_refCounter;
+};
+
+static bool GenerateFile(const std::string &name, uint64_t frameSize, uint32_t numFrames) {
+    std::ofstream out(name, std::ios_base::out | std::ios_base::binary);
+    if (!out)
+        return false;
+
+    std::vector<uint8_t> frame(frameSize);
+    uint32_t x = 12345;
+    for (uint32_t i = 0; i < numFrames; i++) {
+        for (size_t j = 0; j < frame.size(); j += 2) {
+            x = x * 1103515245 + 12345;
+            // keep 16-bit samples within 10 bits, so shifted samples are valid P010
+            frame[j] = static_cast<uint8_t>(x >> 16);
+            if (j + 1 < frame.size())
+                frame[j + 1] = static_cast<uint8_t>((x >> 24) & 0x3);
+        }
+        out.write(reinterpret_cast<char *>(frame.data()), frame.size());
+    }
+    return out.good();
+}
+
+// reads all frames, returns elapsed time in msec
+template <typename Reader>
+static double ReadAll(Reader &reader, SystemSurface &surface, uint32_t numFrames) {
+    auto frame = std::make_shared<vpl::frame_surface>(surface.get());
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < numFrames; i++) {
+        if (!reader.get_data(frame))
+            break;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// compares first frame in the bulk reader surface with the scalar reference
+static bool VerifyFirstFrame(const std::string &name,
+                             uint16_t width,
+                             uint16_t height,
+                             vpl::color_format_fourcc fileFormat,
+                             vpl::color_format_fourcc surfaceFormat,
+                             SystemSurface &surface) {
+    vpl::raw_frame_bulk_file_reader reader(width, height, fileFormat, surfaceFormat, name);
+    ReadAll(reader, surface, 1);
+
+    std::vector<uint8_t> src(reader.get_frame_size());
+    std::ifstream in(name, std::ios_base::in | std::ios_base::binary);
+    in.read(reinterpret_cast<char *>(src.data()), src.size());
+
+    uint32_t pitch = surface.pitch();
+    uint32_t cw    = (width + 1) / 2;
+    uint32_t ch    = (height + 1) / 2;
+    std::vector<uint8_t> row(static_cast<size_t>(pitch));
+    const uint8_t *dst = surface.buffer().data();
+
+    if (fileFormat == vpl::color_format_fourcc::i420 && surfaceFormat == vpl::color_format_fourcc::nv12) {
+        const uint8_t *U = src.data() + static_cast<size_t>(width) * height;
+        const uint8_t *V = U + static_cast<size_t>(cw) * ch;
+        for (uint32_t y = 0; y < ch; y++) {
+            vpl::detail::frame_copy::interleave_row_8_c(U + y * cw, V + y * cw, row.data(), cw);
+            const uint8_t *uv = dst + static_cast<size_t>(pitch) * height + static_cast<size_t>(y) * pitch;
+            if (memcmp(uv, row.data(), 2 * cw))
+                return false;
+        }
+    }
+    else if (fileFormat == vpl::color_format_fourcc::i010) {
+        for (uint32_t y = 0; y < height; y++) {
+            vpl::detail::frame_copy::shift_row_16_c(
+                reinterpret_cast<const uint16_t *>(src.data() + static_cast<size_t>(y) * 2 * width),
+                reinterpret_cast<uint16_t *>(row.data()),
+                width,
+                6);
+            if (memcmp(dst + static_cast<size_t>(y) * pitch, row.data(), 2 * width))
+                return false;
+        }
+        const uint8_t *U = src.data() + static_cast<size_t>(width) * height * 2;
+        const uint8_t *V = U + static_cast<size_t>(cw) * ch * 2;
+        for (uint32_t y = 0; y < ch; y++) {
+            vpl::detail::frame_copy::interleave_row_16_c(
+                reinterpret_cast<const uint16_t *>(U + static_cast<size_t>(y) * 2 * cw),
+                reinterpret_cast<const uint16_t *>(V + static_cast<size_t>(y) * 2 * cw),
+                reinterpret_cast<uint16_t *>(row.data()),
+                cw,
+                6);
+            const uint8_t *uv = dst + static_cast<size_t>(pitch) * height + static_cast<size_t>(y) * pitch;
+            if (memcmp(uv, row.data(), 4 * cw))
+                return false;
+        }
+    }
+    return true;
+}
+
+static void PrintResult(const char *name, double ms, uint64_t bytes) {
+    double mbps = (ms > 0) ? (static_cast<double>(bytes) / (1024.0 * 1024.0)) / (ms / 1000.0) : 0;
+    printf("bench-raw-frame-reader -- %-28s = % 9.2f msec, % 9.1f MB/s\n", name, ms, mbps);
+}
+
+struct BenchCase {
+    const char *name;
+    vpl::color_format_fourcc fileFormat;
+    vpl::color_format_fourcc surfaceFormat;
+    bool hasRowReader; // format is supported by the row by row reader
+};
+
+int main(int argc, char *argv[]) {
+    uint16_t width     = 1920;
+    uint16_t height    = 1080;
+    uint32_t numFrames = 60;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-w") && i + 1 < argc) {
+            width = static_cast<uint16_t>(atoi(argv[++i]));
+        }
+        else if (!strcmp(argv[i], "-h") && i + 1 < argc) {
+            height = static_cast<uint16_t>(atoi(argv[++i]));
+        }
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            numFrames = static_cast<uint32_t>(atoi(argv[++i]));
+        }
+        else {
+            Usage();
+            return 1;
+        }
+    }
+
+    if (!width || !height || !numFrames) {
+        Usage();
+        return 1;
+    }
+
+    printf("bench-raw-frame-reader -- %ux%u, %u frames, AVX2 %s\n",
+           width,
+           height,
+           numFrames,
+           vpl::detail::frame_copy::has_avx2() ? "yes" : "no");
+
+    const BenchCase cases[] = {
+        { "I420 -> I420", vpl::color_format_fourcc::i420, vpl::color_format_fourcc::i420, true },
+        { "I420 -> NV12", vpl::color_format_fourcc::i420, vpl::color_format_fourcc::nv12, false },
+        { "NV12 -> NV12", vpl::color_format_fourcc::nv12, vpl::color_format_fourcc::nv12, true },
+        { "I010 -> P010", vpl::color_format_fourcc::i010, vpl::color_format_fourcc::p010, false },
+        { "P010 -> P010", vpl::color_format_fourcc::p010, vpl::color_format_fourcc::p010, false },
+        { "YUY2 -> YUY2", vpl::color_format_fourcc::yuy2, vpl::color_format_fourcc::yuy2, false },
+        { "BGRA -> BGRA", vpl::color_format_fourcc::bgra, vpl::color_format_fourcc::bgra, true },
+    };
+
+    std::string fileName = DEFAULT_FILE_NAME;
+    int result           = 0;
+
+    try {
+        for (auto &c : cases) {
+            uint64_t frameSize =
+                vpl::raw_frame_bulk_file_reader(width, height, c.fileFormat, c.surfaceFormat, "/dev/null")
+                    .get_frame_size();
+            if (!GenerateFile(fileName, frameSize, numFrames)) {
+                std::cout << "Error - unable to create " << fileName << std::endl;
+                return 1;
+            }
+            uint64_t bytes = frameSize * numFrames;
+            SystemSurface surface(width, height, c.surfaceFormat);
+
+            if (!VerifyFirstFrame(fileName, width, height, c.fileFormat, c.surfaceFormat, surface)) {
+                printf("bench-raw-frame-reader -- %s: output mismatch\n", c.name);
+                result = 1;
+            }
+
+            std::string name;
+            if (c.hasRowReader) {
+                vpl::raw_frame_file_reader_by_name reader(width, height, c.fileFormat, fileName);
+                name = std::string(c.name) + ", row reader";
+                PrintResult(name.c_str(), ReadAll(reader, surface, numFrames), bytes);
+            }
+
+            vpl::raw_frame_bulk_file_reader reader(width, height, c.fileFormat, c.surfaceFormat, fileName);
+            name = std::string(c.name) + ", bulk reader";
+            PrintResult(name.c_str(), ReadAll(reader, surface, numFrames), bytes);
+
+            remove(fileName.c_str());
+        }
+    }
+    catch (vpl::base_exception &e) {
+        std::cout << "Error - " << e.what() << std::endl;
+        remove(fileName.c_str());
+        return 1;
+    }
+
+    return result;
+}
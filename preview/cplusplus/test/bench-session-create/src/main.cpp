@@ -0,0 +1,170 @@
+//==============================================================================
+// Copyright Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+//==============================================================================
+
+///
+/// Measures time to create N sessions with one loader per session (each session
+/// searches and queries all libraries) vs. the shared loader used by the C++ API.
+/// Also measures N create/destroy cycles (short jobs) with and without a session pool.
+///
+/// @file
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "vpl/preview/vpl.hpp"
+
+namespace vpl = oneapi::vpl;
+
+void Usage(void) {
+    std::cout << std::endl;
+    std::cout << "   Usage  :  bench-session-create\n\n";
+    std::cout << "     -n N    number of sessions to create (default 64)\n";
+    std::cout << "     -p N    max idle sessions in the session pool (default 4)\n";
+    std::cout << "     -hw     use hardware implementation\n";
+    std::cout << "     -sw     use software implementation (default)\n";
+    return;
+}
+
+// one loader per session - what each C++ session did before loaders were shared
+static double CreateWithPrivateLoaders(uint32_t n, vpl::implementation_type impl) {
+    std::vector<std::pair<mfxLoader, mfxSession>> sessions;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < n; i++) {
+        mfxLoader loader = MFXLoad();
+        mfxConfig cfg    = MFXCreateConfig(loader);
+
+        mfxVariant var      = {};
+        var.Version.Version = MFX_VARIANT_VERSION;
+        var.Type            = MFX_VARIANT_TYPE_U32;
+        var.Data.U32        = static_cast<mfxU32>(impl);
+        MFXSetConfigFilterProperty(cfg, (const mfxU8 *)"mfxImplDescription.Impl", var);
+
+        mfxImplDescription *desc = nullptr;
+        if (MFXEnumImplementations(loader,
+                                   0,
+                                   MFX_IMPLCAPS_IMPLDESCSTRUCTURE,
+                                   reinterpret_cast<mfxHDL *>(&desc)) != MFX_ERR_NONE) {
+            MFXUnload(loader);
+            break;
+        }
+        MFXDispReleaseImplDescription(loader, desc);
+
+        mfxSession session = nullptr;
+        if (MFXCreateSession(loader, 0, &session) != MFX_ERR_NONE) {
+            MFXUnload(loader);
+            break;
+        }
+        sessions.push_back({ loader, session });
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    if (sessions.size() != n)
+        std::cout << "Warning - created " << sessions.size() << " of " << n << " sessions\n";
+
+    for (auto &s : sessions) {
+        MFXClose(s.second);
+        MFXUnload(s.first);
+    }
+
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// all sessions share one loader
+static double CreateWithSharedLoader(uint32_t n, vpl::implementation_type impl) {
+    std::vector<std::unique_ptr<vpl::encode_session>> sessions;
+    vpl::default_selector impl_sel({ vpl::dprops::impl(impl) });
+
+    auto start = std::chrono::high_resolution_clock::now();
+    try {
+        for (uint32_t i = 0; i < n; i++)
+            sessions.push_back(std::make_unique<vpl::encode_session>(impl_sel));
+    }
+    catch (vpl::base_exception &e) {
+        std::cout << "Session create failed: " << e.what() << std::endl;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    if (sessions.size() != n)
+        std::cout << "Warning - created " << sessions.size() << " of " << n << " sessions\n";
+
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// create and destroy one session at a time, optionally with a session pool
+static double CreateDestroyCycles(uint32_t n,
+                                  vpl::implementation_type impl,
+                                  std::shared_ptr<vpl::session_pool> pool) {
+    vpl::default_selector impl_sel({ vpl::dprops::impl(impl) });
+    impl_sel.set_session_pool(pool);
+
+    // keep one session alive so the shared loader is not unloaded between cycles
+    vpl::encode_session keep_loader(vpl::default_selector({ vpl::dprops::impl(impl) }));
+
+    uint32_t i = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    try {
+        for (i = 0; i < n; i++)
+            vpl::encode_session s(impl_sel);
+    }
+    catch (vpl::base_exception &e) {
+        std::cout << "Session create failed: " << e.what() << std::endl;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    if (i != n)
+        std::cout << "Warning - created " << i << " of " << n << " sessions\n";
+
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t n                    = 64;
+    uint32_t max_idle             = 4;
+    vpl::implementation_type impl = vpl::implementation_type::sw;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            n = static_cast<uint32_t>(atoi(argv[++i]));
+        }
+        else if (!strcmp(argv[i], "-p") && i + 1 < argc) {
+            max_idle = static_cast<uint32_t>(atoi(argv[++i]));
+        }
+        else if (!strcmp(argv[i], "-hw")) {
+            impl = vpl::implementation_type::hw;
+        }
+        else if (!strcmp(argv[i], "-sw")) {
+            impl = vpl::implementation_type::sw;
+        }
+        else {
+            Usage();
+            return 1;
+        }
+    }
+
+    double msPrivate = CreateWithPrivateLoaders(n, impl);
+    double msShared  = CreateWithSharedLoader(n, impl);
+
+    printf("bench-session-create -- %-32s = % 8.2f msec\n", "private loader per session", msPrivate);
+    printf("bench-session-create -- %-32s = % 8.2f msec\n", "shared loader", msShared);
+
+    auto pool         = std::make_shared<vpl::session_pool>(max_idle);
+    double msNoPool   = CreateDestroyCycles(n, impl, nullptr);
+    double msWithPool = CreateDestroyCycles(n, impl, pool);
+
+    auto stats = pool->stats();
+    printf("bench-session-create -- %-32s = % 8.2f msec\n", "create/destroy, no pool", msNoPool);
+    printf("bench-session-create -- %-32s = % 8.2f msec\n", "create/destroy, session pool", msWithPool);
+    printf("bench-session-create -- pool hits = %llu, misses = %llu, evictions = %llu\n",
+           static_cast<unsigned long long>(stats.hits),
+           static_cast<unsigned long long>(stats.misses),
+           static_cast<unsigned long long>(stats.evictions));
+
+    return 0;
+}
@@ -0,0 +1,349 @@
+//==============================================================================
+// Copyright Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+//==============================================================================
+
+///
+/// Counts heap allocations done per frame by process() of decode_session,
+/// vpp_session and encode_session chained into a decode->vpp->encode pipeline.
+/// Sessions run on the stub runtime (ONEVPL_SEARCH_PATH has to point to
+/// vplstubrt), which hands out surfaces of its internal pools with a reference
+/// counter like a real runtime does. Checks that steady state frames don't
+/// allocate, that all frames come out in order, and that frame_surface holds
+/// exactly one reference to each surface.
+///
+/// @file
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "vpl/preview/vpl.hpp"
+
+namespace vpl = oneapi::vpl;
+
+// bytes the stub decoder takes for one frame
+static const uint32_t STUB_FRAME_SIZE = 1024;
+
+static std::atomic<uint64_t> g_allocations(0);
+
+// all forms of the global operator new and delete are replaced, so memory from any
+// new expression is counted and goes back to the allocator it came from
+
+static void *Allocate(std::size_t size, std::size_t alignment) {
+    g_allocations++;
+    if (!size)
+        size = 1;
+#if defined(_WIN32) || defined(_WIN64)
+    return _aligned_malloc(size, alignment);
+#else
+    void *p = nullptr;
+    if (alignment < sizeof(void *))
+        alignment = sizeof(void *);
+    if (posix_memalign(&p, alignment, size) != 0)
+        return nullptr;
+    return p;
+#endif
+}
+
+static void Free(void *p) noexcept {
+#if defined(_WIN32) || defined(_WIN64)
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+static void *AllocateOrThrow(std::size_t size, std::size_t alignment) {
+    if (void *p = Allocate(size, alignment))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size) {
+    return AllocateOrThrow(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void *operator new[](std::size_t size) {
+    return AllocateOrThrow(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void *operator new(std::size_t size, std::align_val_t alignment) {
+    return AllocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+    return AllocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    return Allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    return Allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return Allocate(size, static_cast<std::size_t>(alignment));
+}
+void *operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return Allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void *p) noexcept {
+    Free(p);
+}
+void operator delete[](void *p) noexcept {
+    Free(p);
+}
+void operator delete(void *p, std::size_t) noexcept {
+    Free(p);
+}
+void operator delete[](void *p, std::size_t) noexcept {
+    Free(p);
+}
+void operator delete(void *p, std::align_val_t) noexcept {
+    Free(p);
+}
+void operator delete[](void *p, std::align_val_t) noexcept {
+    Free(p);
+}
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+    Free(p);
+}
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept {
+    Free(p);
+}
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+    Free(p);
+}
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+    Free(p);
+}
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept {
+    Free(p);
+}
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept {
+    Free(p);
+}
+
+static mfxU32 RefCounter(mfxFrameSurface1 *surface) {
+    mfxU32 counter = 0;
+    if (surface->FrameInterface->GetRefCounter(surface, &counter) != MFX_ERR_NONE)
+        return 0xFFFFFFFF;
+    return counter;
+}
+
+static bool Report(const char *name, bool ok) {
+    printf("Test %s", name);
+    if (!ok)
+        printf("\n   Error!\n");
+    else
+        printf(" ... OK\n");
+    return ok;
+}
+
+class Pipeline {
+public:
+    Pipeline(const vpl::implementation_selector &sel, std::string &input)
+            : m_reader(input),
+              m_dec(sel, vpl::codec_format_fourcc::hevc, &m_reader),
+              m_vpp(sel),
+              m_enc(sel),
+              m_surfaces(),
+              m_encoded(0),
+              m_inOrder(true),
+              m_eos(false) {
+        // surfaces of the stub pools, the vector must not grow while frames are counted
+        m_surfaces.reserve(256);
+    }
+
+    bool Init(uint32_t depth) {
+        if (m_dec.init_by_header() != vpl::status::Ok)
+            return false;
+        vpl::frame_info info = m_dec.working_params()->get_frame_info();
+
+        vpl::vpp_video_param vppParams;
+        vppParams.set_in_frame_info(info);
+        vppParams.set_out_frame_info(info);
+        if (m_vpp.Init(&vppParams) != vpl::status::Ok)
+            return false;
+
+        vpl::encoder_video_param encParams;
+        encParams.set_frame_info(info);
+        encParams.set_CodecId(vpl::codec_format_fourcc::hevc);
+        encParams.set_AsyncDepth(static_cast<uint16_t>(depth));
+        if (m_enc.Init(&encParams) != vpl::status::Ok)
+            return false;
+
+        m_enc.set_async_depth(depth);
+        return true;
+    }
+
+    // runs up to n frames through the pipeline, stops when the encoder is drained
+    void Run(uint32_t n) {
+        for (uint32_t i = 0; i < n && !m_eos; i++) {
+            auto dec = m_dec.process();
+            if (dec->get_last_schedule_status() == vpl::status::Ok)
+                Track(dec->get()->get_raw_ptr());
+
+            auto vpp = m_vpp.process(dec);
+            if (vpp->get_last_schedule_status() == vpl::status::Ok)
+                Track(vpp->get()->get_raw_ptr());
+
+            auto enc = m_enc.process(vpp);
+            switch (enc->get_last_schedule_status()) {
+                case vpl::status::Ok: {
+                    std::shared_ptr<vpl::bitstream_as_dst> bits = enc->get();
+                    // encoder keeps one frame, so the bitstream of frame k comes with frame k + 1
+                    auto [data, length] = bits->get_valid_data();
+                    if (enc->history_.size() != 3 ||
+                        enc->history_.front().component_ != vpl::component::decoder ||
+                        length != 100 || data[0] != static_cast<uint8_t>(m_encoded))
+                        m_inOrder = false;
+                    m_encoded++;
+                } break;
+                case vpl::status::EndOfStreamReached:
+                    m_eos = true;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    vpl::encode_session &Encoder() {
+        return m_enc;
+    }
+    uint32_t Encoded() const {
+        return m_encoded;
+    }
+    bool InOrder() const {
+        return m_inOrder;
+    }
+    bool EndOfStream() const {
+        return m_eos;
+    }
+
+    // every surface has to be back in the stub pool
+    bool Released() const {
+        for (mfxFrameSurface1 *s : m_surfaces) {
+            if (RefCounter(s) != 0)
+                return false;
+        }
+        return true;
+    }
+
+private:
+    void Track(mfxFrameSurface1 *surface) {
+        for (mfxFrameSurface1 *s : m_surfaces) {
+            if (s == surface)
+                return;
+        }
+        m_surfaces.push_back(surface);
+    }
+
+    vpl::bitstream_file_reader_name m_reader;
+    vpl::decode_session<vpl::bitstream_file_reader_name> m_dec;
+    vpl::vpp_session m_vpp;
+    vpl::encode_session m_enc;
+    std::vector<mfxFrameSurface1 *> m_surfaces;
+    uint32_t m_encoded;
+    bool m_inOrder;
+    bool m_eos;
+};
+
+// frame_surface takes over the reference handed out by the runtime, and holds exactly one
+static bool CheckAdopt(vpl::encode_session &enc) {
+    std::shared_ptr<vpl::frame_surface> s = enc.alloc_input();
+    mfxFrameSurface1 *raw                 = s->get_raw_ptr();
+    bool ok                               = (RefCounter(raw) == 1);
+
+    // shared pointers share the reference of the handle
+    std::shared_ptr<vpl::frame_surface> shared = s;
+    ok &= (RefCounter(raw) == 1);
+
+    {
+        // copy of the handle has its own reference
+        vpl::frame_surface copy(*s);
+        ok &= (RefCounter(raw) == 2);
+    }
+    ok &= (RefCounter(raw) == 1);
+
+    // handle which already has a surface keeps it, and doesn't take the other reference
+    std::shared_ptr<vpl::frame_surface> other = enc.alloc_input();
+    s->adopt(other->get_raw_ptr());
+    ok &= (s->get_raw_ptr() == raw);
+    ok &= (RefCounter(other->get_raw_ptr()) == 1);
+    other.reset();
+
+    s.reset();
+    ok &= (RefCounter(raw) == 1);
+    shared.reset();
+    ok &= (RefCounter(raw) == 0);
+
+    // released surface goes back to the runtime's pool
+    std::shared_ptr<vpl::frame_surface> again = enc.alloc_input();
+    ok &= (again->get_raw_ptr() == raw);
+    return ok;
+}
+
+int main(int argc, char *argv[]) {
+    const uint32_t warmup = 64;
+    const uint32_t frames = 1000;
+    const uint32_t depth  = 4;
+    const uint32_t total  = warmup + frames + 16;
+    bool ok               = true;
+
+    std::string input = "test-alloc-cpp.bin";
+    {
+        std::vector<uint8_t> data(static_cast<size_t>(total) * STUB_FRAME_SIZE);
+        FILE *f = fopen(input.c_str(), "wb");
+        if (!f || fwrite(data.data(), 1, data.size(), f) != data.size()) {
+            printf("Error: can't write %s\n", input.c_str());
+            return -1;
+        }
+        fclose(f);
+    }
+
+    try {
+        vpl::default_selector<> sel({ vpl::dprops::impl_name("Stub Implementation") });
+        Pipeline pipeline(sel, input);
+        if (!pipeline.Init(depth)) {
+            printf("Error: can't initialize the pipeline\n");
+            return -1;
+        }
+
+        pipeline.Run(warmup);
+
+        uint64_t before = g_allocations;
+        pipeline.Run(frames);
+        uint64_t allocations = g_allocations - before;
+
+        printf("Steady state allocations: %llu allocations in %u frames\n",
+               static_cast<unsigned long long>(allocations),
+               frames);
+        ok &= Report("steady state allocations", allocations == 0);
+
+        // drain: leftover frames, frame kept by the encoder, and the futures in flight
+        pipeline.Run(2 * total);
+        ok &= Report("end of stream", pipeline.EndOfStream());
+        printf("%u of %u frames encoded\n", pipeline.Encoded(), total);
+        ok &= Report("in-order completion", pipeline.InOrder() && pipeline.Encoded() == total);
+        ok &= Report("surface references released", pipeline.Released());
+        ok &= Report("frame_surface adopts the reference", CheckAdopt(pipeline.Encoder()));
+    }
+    catch (vpl::base_exception &e) {
+        printf("Error: %s\n", e.what());
+        ok = false;
+    }
+    remove(input.c_str());
+
+    if (!ok) {
+        printf("\nErrors in allocation test\n");
+        return -1;
+    }
+    printf("\nSuccess!\n");
+    return 0;
+}
@@ -0,0 +1,397 @@
+//==============================================================================
+// Copyright Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+//==============================================================================
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+    #include <sys/eventfd.h>
+    #include <unistd.h>
+#elif !defined(_WIN32)
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+#include "vpl/preview/exception.hpp"
+#include "vpl_python.hpp"
+
+namespace vpl = oneapi::vpl;
+
+// Delivers completions from the waiter thread to the event loop through a
+// file descriptor which the loop watches with add_reader(): eventfd on
+// Linux, pipe on other POSIX systems.
+class completion_port {
+public:
+    completion_port() : mutex_(), completed_(), read_fd_(-1), write_fd_(-1) {
+#if defined(__linux__)
+        read_fd_ = write_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (read_fd_ < 0)
+            throw std::runtime_error("eventfd creation failed");
+#elif !defined(_WIN32)
+        int fds[2];
+        if (pipe(fds) != 0)
+            throw std::runtime_error("pipe creation failed");
+        for (int fd : fds) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+        read_fd_  = fds[0];
+        write_fd_ = fds[1];
+#else
+        throw std::runtime_error("async iteration needs an event loop which can watch file descriptors");
+#endif
+    }
+
+    ~completion_port() {
+#if !defined(_WIN32)
+        close(read_fd_);
+        if (write_fd_ != read_fd_)
+            close(write_fd_);
+#endif
+    }
+
+    completion_port(const completion_port &) = delete;
+    completion_port &operator=(const completion_port &) = delete;
+
+    int fd() const {
+        return read_fd_;
+    }
+
+    // Called by the waiter thread when the operation completed
+    void post(uint64_t id, mfxStatus sts) {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            completed_.emplace_back(id, sts);
+        }
+#if defined(__linux__)
+        uint64_t one = 1;
+        [[maybe_unused]] auto n = write(write_fd_, &one, sizeof(one));
+#elif !defined(_WIN32)
+        char one = 1;
+        [[maybe_unused]] auto n = write(write_fd_, &one, sizeof(one));
+#endif
+    }
+
+    // Called by the event loop when the descriptor is readable
+    std::vector<std::pair<uint64_t, mfxStatus>> drain() {
+#if !defined(_WIN32)
+        char buf[64];
+        while (read(read_fd_, buf, sizeof(buf)) > 0) {
+        }
+#endif
+        std::vector<std::pair<uint64_t, mfxStatus>> completed;
+        std::lock_guard<std::mutex> guard(mutex_);
+        completed.swap(completed_);
+        return completed;
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::pair<uint64_t, mfxStatus>> completed_;
+    int read_fd_;
+    int write_fd_;
+};
+
+// Single thread which polls the sync points of all pending operations of all
+// async iterators, so sessions don't need a thread each. The module stops it
+// at interpreter exit; the thread is started again if more operations come.
+class completion_waiter {
+public:
+    // Returns status of the operation, timeout while it is in progress
+    using poll_t = std::function<vpl::async_op_status()>;
+
+    static completion_waiter &instance() {
+        static completion_waiter waiter;
+        return waiter;
+    }
+
+    ~completion_waiter() {
+        stop();
+    }
+
+    void add(poll_t poll, std::shared_ptr<completion_port> port, uint64_t id) {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            if (stop_) {
+                port->post(id, MFX_ERR_ABORTED);
+                return;
+            }
+            added_.push_back({ std::move(poll), std::move(port), id });
+            if (!thread_.joinable())
+                thread_ = std::thread(&completion_waiter::run, this);
+        }
+        cv_.notify_one();
+    }
+
+    // Joins the thread. Operations still pending are dropped, their futures
+    // are never resolved.
+    void stop() {
+        std::thread thread;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            stop_ = true;
+            thread.swap(thread_);
+        }
+        cv_.notify_one();
+        if (thread.joinable())
+            thread.join();
+
+        std::lock_guard<std::mutex> guard(mutex_);
+        added_.clear();
+        stop_ = false;
+    }
+
+protected:
+    completion_waiter() : mutex_(), cv_(), added_(), thread_(), stop_(false) {}
+
+    completion_waiter(const completion_waiter &) = delete;
+    completion_waiter &operator=(const completion_waiter &) = delete;
+
+    struct pending {
+        poll_t poll;
+        std::shared_ptr<completion_port> port;
+        uint64_t id;
+    };
+
+    void run() {
+        std::list<pending> active;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (active.empty())
+                    cv_.wait(lock, [this] {
+                        return !added_.empty() || stop_;
+                    });
+                if (stop_)
+                    return;
+                active.splice(active.end(), added_);
+            }
+
+            bool progress = false;
+            for (auto it = active.begin(); it != active.end();) {
+                mfxStatus sts = MFX_ERR_NONE;
+                try {
+                    switch (it->poll()) {
+                        case vpl::async_op_status::timeout:
+                            ++it;
+                            continue;
+                        case vpl::async_op_status::ready:
+                            break;
+                        case vpl::async_op_status::aborted:
+                            sts = MFX_ERR_ABORTED;
+                            break;
+                        default:
+                            sts = MFX_ERR_UNKNOWN;
+                            break;
+                    }
+                }
+                catch (vpl::base_exception &e) {
+                    sts = e.get_status();
+                }
+                catch (...) {
+                    sts = MFX_ERR_UNKNOWN;
+                }
+                it->port->post(it->id, sts);
+                it       = active.erase(it);
+                progress = true;
+            }
+
+            if (!progress && !active.empty())
+                std::this_thread::sleep_for(poll_interval);
+        }
+    }
+
+    static constexpr std::chrono::microseconds poll_interval{ 500 };
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::list<pending> added_;
+    std::thread thread_;
+    bool stop_;
+};
+
+// Async iterator over the session output. Each __anext__ schedules the next
+// operation right away and returns an asyncio future, which is resolved by
+// the event loop once the waiter thread reports the sync point completion.
+// If the device is busy, the waiter thread retries the scheduling instead of
+// the event loop, and later operations of the iterator are scheduled after it.
+// The loop watches the completion port only while futures are pending, so an
+// abandoned iterator isn't kept alive by the loop.
+template <typename Session, typename Result>
+class async_iterator : public std::enable_shared_from_this<async_iterator<Session, Result>> {
+public:
+    // Schedules the next operation; returns its status and the result container.
+    // Returns DeviceBusy instead of retrying, so the caller decides where to wait.
+    using schedule_t = std::function<std::pair<vpl::status, Result>(Session &)>;
+
+    async_iterator(std::shared_ptr<Session> session, schedule_t schedule)
+            : session_(session),
+              schedule_(std::move(schedule)),
+              port_(std::make_shared<completion_port>()),
+              order_(std::make_shared<schedule_order>()),
+              loop_(),
+              pending_(),
+              next_id_(0),
+              watching_(false) {}
+
+    py::object anext() {
+        py::object loop = py::module::import("asyncio").attr("get_running_loop")();
+        py::object fut  = loop.attr("create_future")();
+
+        auto op = std::make_shared<operation>();
+        // schedules left to the waiter thread go first, so operations stay in order
+        bool deferred = order_->issued != order_->done;
+        if (!deferred) {
+            std::pair<vpl::status, Result> scheduled;
+            {
+                py::gil_scoped_release release;
+                scheduled = schedule_(*session_);
+            }
+            if (scheduled.first == vpl::status::DeviceBusy) {
+                deferred = true;
+            }
+            else if (scheduled.first != vpl::status::Ok) {
+                fut.attr("set_exception")(py::module::import("builtins").attr("StopAsyncIteration")());
+                return fut;
+            }
+            else {
+                op->result = scheduled.second;
+            }
+        }
+
+        uint64_t id = next_id_++;
+        pending_.emplace(id, std::make_pair(fut, op));
+        if (!watching_) {
+            auto self = this->shared_from_this();
+            loop_     = loop;
+            loop_.attr("add_reader")(port_->fd(), py::cpp_function([self]() {
+                                         self->on_ready();
+                                     }));
+            watching_ = true;
+        }
+
+        if (!deferred) {
+            Result result = op->result;
+            completion_waiter::instance().add(
+                [result]() {
+                    return poll_result(result);
+                },
+                port_,
+                id);
+            return fut;
+        }
+
+        // runs on the waiter thread, which polls it again after a pause while the device is busy
+        completion_waiter::instance().add(
+            [session   = session_,
+             schedule  = schedule_,
+             order     = order_,
+             op,
+             ticket    = order_->issued++,
+             scheduled = false]() mutable {
+                if (!scheduled) {
+                    if (order->done != ticket)
+                        return vpl::async_op_status::timeout;
+                    std::pair<vpl::status, Result> s;
+                    try {
+                        s = schedule(*session);
+                    }
+                    catch (...) {
+                        order->done++;
+                        throw;
+                    }
+                    if (s.first == vpl::status::DeviceBusy)
+                        return vpl::async_op_status::timeout;
+                    order->done++;
+                    scheduled  = true;
+                    op->status = s.first;
+                    op->result = s.second;
+                    if (s.first != vpl::status::Ok)
+                        return vpl::async_op_status::ready;
+                }
+                return poll_result(op->result);
+            },
+            port_,
+            id);
+        return fut;
+    }
+
+protected:
+    // Result of one __anext__, filled in by the waiter thread when the scheduling was deferred
+    struct operation {
+        operation() : status(vpl::status::Ok), result() {}
+
+        vpl::status status;
+        Result result;
+    };
+
+    // Tickets of the schedules deferred to the waiter thread
+    struct schedule_order {
+        schedule_order() : issued(0), done(0) {}
+
+        std::atomic<uint64_t> issued;
+        std::atomic<uint64_t> done;
+    };
+
+    static vpl::async_op_status poll_result(const Result &result) {
+        vpl::async_op_status st = result->wait_for(std::chrono::milliseconds(0));
+        if (st == vpl::async_op_status::ready)
+            result->wait(); // marks the data valid, returns at once
+        return st;
+    }
+
+    void on_ready() {
+        for (auto [id, sts] : port_->drain()) {
+            auto it = pending_.find(id);
+            if (it == pending_.end())
+                continue;
+            py::object fut                 = it->second.first;
+            std::shared_ptr<operation> op = it->second.second;
+            pending_.erase(it);
+
+            if (fut.attr("done")().cast<bool>())
+                continue;
+            if (sts == MFX_ERR_NONE && op->status != vpl::status::Ok) {
+                fut.attr("set_exception")(py::module::import("builtins").attr("StopAsyncIteration")());
+            }
+            else if (sts == MFX_ERR_NONE) {
+                fut.attr("set_result")(py::cast(op->result));
+            }
+            else {
+                vpl::base_exception e(sts);
+                fut.attr("set_exception")(
+                    py::module::import("pyvpl").attr("base_exception")(e.what()));
+            }
+        }
+
+        if (pending_.empty() && watching_) {
+            watching_ = false;
+            loop_.attr("remove_reader")(port_->fd());
+            loop_ = py::object();
+        }
+    }
+
+    std::shared_ptr<Session> session_;
+    schedule_t schedule_;
+    std::shared_ptr<completion_port> port_;
+    std::shared_ptr<schedule_order> order_;
+    py::object loop_;
+    std::map<uint64_t, std::pair<py::object, std::shared_ptr<operation>>> pending_;
+    uint64_t next_id_;
+    bool watching_;
+};
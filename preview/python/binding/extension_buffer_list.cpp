@@ -3,6 +3,8 @@
 //
 // SPDX-License-Identifier: MIT
 //==============================================================================
+#include <map>
+
 #include "vpl/preview/extension_buffer_list.hpp"
 #include "vpl_python.hpp"
 namespace vpl = oneapi::vpl;
@@ -12,8 +14,13 @@ void init_extension_buffer_list(const py::module &m) {
         .def(py::init<>())
         .def_property_readonly(
             "buffers",
-            &vpl::buffer_list::get_buffers,
-            "reference to the map with extension buffers. Key is buffer ID in the form of FourCC codes. Value is the pointer to the extension buffer.")
+            [](const vpl::buffer_list &self) {
+                std::map<uint32_t, vpl::extension_buffer_base *> buffers;
+                for (const auto &e : self.get_buffers())
+                    buffers[e.id] = e.buffer;
+                return buffers;
+            },
+            "map with extension buffers. Key is buffer ID in the form of FourCC codes. Value is the pointer to the extension buffer.")
         .def_property_readonly("size",
                                &vpl::buffer_list::get_size,
                                "number of extension buffers in the map.")
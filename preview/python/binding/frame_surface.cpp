@@ -4,9 +4,44 @@
 // SPDX-License-Identifier: MIT
 //==============================================================================
 #include "vpl/preview/frame_surface.hpp"
+#include "image_plane.hpp"
 #include "vpl_python.hpp"
 namespace vpl = oneapi::vpl;
 
+// Keeps the surface mapped while plane views made from it are alive
+class surface_mapping {
+public:
+    surface_mapping(std::shared_ptr<vpl::frame_surface> surface, vpl::memory_access access)
+            : surface_(surface),
+              info_(),
+              data_() {
+        auto [info, data] = surface_->map(access);
+        info_             = info;
+        data_             = data;
+    }
+
+    ~surface_mapping() {
+        try {
+            surface_->unmap();
+        }
+        catch (...) {
+        }
+    }
+
+    vpl::frame_info &info() {
+        return info_;
+    }
+
+    vpl::frame_data *data() {
+        return &data_;
+    }
+
+private:
+    std::shared_ptr<vpl::frame_surface> surface_;
+    vpl::frame_info info_;
+    vpl::frame_data data_;
+};
+
 void init_frame_surface(const py::module &m) {
     py::class_<vpl::frame_surface, std::shared_ptr<vpl::frame_surface>>(m, "frame_surface")
         .def(py::init<>())
@@ -14,13 +49,17 @@ void init_frame_surface(const py::module &m) {
             "inject",
             &vpl::frame_surface::inject,
             "Inject mfxFrameSurface1 object to take care of it. This is temporal method until VPL RT will support all functions for the internal memory allocation")
-        .def("wait", &vpl::frame_surface::wait, "Indefinitely wait for operation completion.")
+        .def("wait",
+             &vpl::frame_surface::wait,
+             py::call_guard<py::gil_scoped_release>(),
+             "Indefinitely wait for operation completion.")
         .def(
             "wait_for",
             [](vpl::frame_surface &s, int milliseconds) {
                 std::chrono::duration<int, std::milli> waitduration(milliseconds);
                 return s.wait_for(waitduration);
             },
+            py::call_guard<py::gil_scoped_release>(),
             "Waits for the operation completion. Waits for the result to become available. Blocks until specified timeout_duration has elapsed or the result becomes available, whichever comes first. Returns value identifying the state of the result.")
         .def_property_readonly("frame_info",
                                &vpl::frame_surface::get_frame_info,
@@ -28,8 +67,26 @@ void init_frame_surface(const py::module &m) {
         .def_property_readonly("frame_data",
                                &vpl::frame_surface::get_frame_data,
                                "Provide frame data information.")
-        .def("map", &vpl::frame_surface::map, "Maps data to the system memory.")
-        .def("unmap", &vpl::frame_surface::unmap, "Unmaps data to the system memory.")
+        .def("map",
+             &vpl::frame_surface::map,
+             py::call_guard<py::gil_scoped_release>(),
+             "Maps data to the system memory.")
+        .def("unmap",
+             &vpl::frame_surface::unmap,
+             py::call_guard<py::gil_scoped_release>(),
+             "Unmaps data to the system memory.")
+        .def(
+            "planes",
+            [](std::shared_ptr<vpl::frame_surface> self, vpl::memory_access access) {
+                std::shared_ptr<surface_mapping> mapping;
+                {
+                    py::gil_scoped_release release;
+                    mapping = std::make_shared<surface_mapping>(self, access);
+                }
+                return get_image_planes(mapping->data(), mapping->info(), mapping);
+            },
+            py::arg("access") = vpl::memory_access::read,
+            "Maps data to the system memory and returns zero-copy views of the planes, which support the buffer protocol, e.g. numpy.asarray(plane) has the rows x cols shape and the surface pitch. Data stays mapped until all views and arrays made from them are released. Don't call unmap() for such mapping.")
         .def_property_readonly("native_handle",
                                &vpl::frame_surface::get_native_handle,
                                "native surface handle of the surface.")
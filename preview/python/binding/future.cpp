@@ -3,8 +3,59 @@
 //
 // SPDX-License-Identifier: MIT
 //==============================================================================
+#include <chrono>
+#include <memory>
+#include <sstream>
+#include <string>
+
 #include "vpl/preview/future.hpp"
 #include "vpl_python.hpp"
 namespace vpl = oneapi::vpl;
 
-void init_future(const py::module &m) {}
\ No newline at end of file
+template <typename Future>
+class future_template {
+public:
+    using Class   = Future;
+    using PyClass = py::class_<Class, std::shared_ptr<Class>>;
+    PyClass pyclass;
+    future_template(const py::module &m, const std::string &typestr)
+            : pyclass(m, typestr.c_str()) {
+        pyclass
+            .def("wait",
+                 &Class::wait,
+                 py::call_guard<py::gil_scoped_release>(),
+                 "Indefinitely waits for operation completion.")
+            .def(
+                "get",
+                [](Class &self) {
+                    return self.get();
+                },
+                py::call_guard<py::gil_scoped_release>(),
+                "Provides syncronized data. Waits indefinitely for the synchronization.")
+            .def(
+                "wait_for",
+                [](Class &self, int milliseconds) {
+                    std::chrono::duration<int, std::milli> waitduration(milliseconds);
+                    return self.wait_for(waitduration);
+                },
+                py::call_guard<py::gil_scoped_release>(),
+                "Waits for the operation completion. Blocks until specified timeout_duration has elapsed or the result becomes available, whichever comes first.")
+            .def_property_readonly("last_schedule_status",
+                                   &Class::get_last_schedule_status,
+                                   "Last operation scheduling status")
+            .def_property_readonly("last_exec_status",
+                                   &Class::get_last_exec_status,
+                                   "Last operation exec status")
+            .def_property_readonly("had_fatal", &Class::had_fatal, "True if fatal error happened")
+            .def("__str__", [](const Class *self) {
+                std::stringstream strs;
+                strs << *self;
+                return strs.str();
+            });
+    }
+};
+
+void init_future(const py::module &m) {
+    future_template<vpl::future_surface_t>(m, "future_surface");
+    future_template<vpl::future_bitstream_t>(m, "future_bitstream");
+}
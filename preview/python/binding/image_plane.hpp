@@ -0,0 +1,71 @@
+//==============================================================================
+// Copyright Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+//==============================================================================
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "vpl/preview/video_param.hpp"
+#include "vpl_python.hpp"
+
+// Zero-copy view of one plane of the mapped frame. Exposed through the buffer
+// protocol as a rows x cols array with the row pitch of the surface, so
+// numpy.asarray() doesn't copy. Owner keeps the memory mapped while the view,
+// or any array made from it, is alive.
+class image_plane {
+public:
+    image_plane(void *base,
+                py::ssize_t item_size,
+                py::ssize_t cols,
+                py::ssize_t rows,
+                py::ssize_t sample_pitch,
+                py::ssize_t row_pitch,
+                std::string format,
+                std::string desc)
+            : base(base),
+              item_size(item_size),
+              rows(rows),
+              cols(cols),
+              row_pitch(row_pitch),
+              sample_pitch(sample_pitch),
+              format(format),
+              desc(desc),
+              owner(nullptr) {}
+
+    py::buffer_info buffer_info() {
+        return py::buffer_info(base,
+                               item_size,
+                               format,
+                               2,
+                               { rows, cols },
+                               { row_pitch, sample_pitch * item_size });
+    }
+
+    std::string get_desc() {
+        return desc;
+    }
+
+    void set_owner(std::shared_ptr<void> o) {
+        owner = o;
+    }
+
+private:
+    void *base;
+    py::ssize_t item_size;
+    py::ssize_t rows;
+    py::ssize_t cols;
+    py::ssize_t row_pitch;
+    py::ssize_t sample_pitch;
+    std::string format;
+    std::string desc;
+    std::shared_ptr<void> owner;
+};
+
+// Returns views of the planes of the mapped frame, each of them holds the owner
+std::vector<image_plane> get_image_planes(vpl::frame_data *data,
+                                          vpl::frame_info &info,
+                                          std::shared_ptr<void> owner);
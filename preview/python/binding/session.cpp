@@ -4,6 +4,7 @@
 // SPDX-License-Identifier: MIT
 //==============================================================================
 #include "vpl/preview/session.hpp"
+#include "async_iterator.hpp"
 #include "vpl_python.hpp"
 namespace vpl = oneapi::vpl;
 
@@ -20,8 +21,14 @@ public:
                 "Verify",
                 &Class::Verify,
                 "Verifies that implementation supports such capabilities. On output, corrected capabilities are returned.")
-            .def("Init", &Class::Init, "Initializes the session by using provided parameters.")
-            .def("Reset", &Class::Reset, "Resets the session by using provided parameters.")
+            .def("Init",
+                 &Class::Init,
+                 py::call_guard<py::gil_scoped_release>(),
+                 "Initializes the session by using provided parameters.")
+            .def("Reset",
+                 &Class::Reset,
+                 py::call_guard<py::gil_scoped_release>(),
+                 "Resets the session by using provided parameters.")
             .def("working_params", &Class::working_params, "Retrieves current session parameters.")
             .def_property_readonly("component_domain",
                                    &Class::get_component_domain,
@@ -44,11 +51,41 @@ public:
     using Base    = vpl::session<vpl::decoder_video_param,
                               vpl::decoder_init_reset_list,
                               vpl::decoder_init_reset_list>;
-    using Class   = vpl::decode_session<Reader>;
-    using PyClass = py::class_<Class, Base, std::shared_ptr<Class>>;
+    using Class         = vpl::decode_session<Reader>;
+    using PyClass       = py::class_<Class, Base, std::shared_ptr<Class>>;
+    using AsyncIterator = async_iterator<Class, std::shared_ptr<vpl::frame_surface>>;
     PyClass pyclass;
+
+    // Decodes until a frame is scheduled, the stream ends or the device is busy, doesn't wait for the frame
+    static std::pair<vpl::status, std::shared_ptr<vpl::frame_surface>> schedule_frame(Class &self) {
+        // decode_frame() sets the surface only when a frame is scheduled, so one handle does for the retries
+        std::shared_ptr<vpl::frame_surface> surface = std::make_shared<vpl::frame_surface>();
+        while (true) {
+            vpl::status ret = self.decode_frame(surface);
+            switch (ret) {
+                case vpl::status::Ok:
+                    return { ret, surface };
+                case vpl::status::NotEnoughData:
+                    break;
+                default:
+                    return { ret, nullptr };
+            }
+        }
+    }
+
     decode_session_template(const py::module &m, const std::string &typestr)
             : pyclass(m, typestr.c_str()) {
+        py::class_<AsyncIterator, std::shared_ptr<AsyncIterator>>(
+            m,
+            (typestr + "_async_iterator").c_str())
+            .def("__aiter__",
+                 [](std::shared_ptr<AsyncIterator> self) {
+                     return self;
+                 })
+            .def("__anext__",
+                 &AsyncIterator::anext,
+                 "Schedules next frame and returns asyncio future which gets the frame once it is decoded");
+
         pyclass
             .def(py::init<vpl::implementation_selector &,
                           const vpl::decoder_video_param &,
@@ -57,16 +94,30 @@ public:
             .def(
                 "init_by_header",
                 &Class::init_by_header,
+                py::call_guard<py::gil_scoped_release>(),
                 "Initialize the session by using bitream portion. This step can be omitted if the codec ID is known or we don't need to get SSP or PPS data from the bitstream.")
-            .def("decode_frame", &Class::decode_frame, "Decodes frame")
-            .def("process", &Class::process, "Decodes frame")
+            .def("decode_frame",
+                 &Class::decode_frame,
+                 py::call_guard<py::gil_scoped_release>(),
+                 "Decodes frame")
+            .def("process",
+                 &Class::process,
+                 py::call_guard<py::gil_scoped_release>(),
+                 "Decodes frame")
             .def_property_readonly("Stat", &Class::getStat, "Retrieve decoder statistic")
             .def_property_readonly("Params", &Class::getParams, "Get video params")
             .def("__iter__",
                  [](Class *self) -> Class & {
                      return *self;
                  })
+            .def(
+                "__aiter__",
+                [](std::shared_ptr<Class> self) {
+                    return std::make_shared<AsyncIterator>(self, &schedule_frame);
+                },
+                "Async iterator over decoded frames. Frames are waited for by the shared waiter thread and delivered to the running event loop through a file descriptor, so one loop can drive many sessions.")
             .def("__next__", [](Class *self) {
+                py::gil_scoped_release release;
                 bool is_stillgoing = true;
                 while (is_stillgoing == true) {
                     std::shared_ptr<vpl::frame_surface> dec_surface_out =
@@ -100,17 +151,129 @@ public:
     }
 };
 
+template <typename Reader>
+class decode_vpp_session_template {
+public:
+    using Base    = vpl::session<vpl::decoder_video_param,
+                              vpl::decoder_init_reset_list,
+                              vpl::decoder_init_reset_list>;
+    using Class   = vpl::decode_vpp_session<Reader>;
+    using PyClass = py::class_<Class, Base, std::shared_ptr<Class>>;
+    PyClass pyclass;
+    decode_vpp_session_template(const py::module &m, const std::string &typestr)
+            : pyclass(m, typestr.c_str()) {
+        pyclass
+            .def(py::init<vpl::implementation_selector &,
+                          const vpl::decoder_video_param &,
+                          Reader *>())
+            .def(py::init<vpl::implementation_selector &, vpl::codec_format_fourcc, Reader *>())
+            .def("add_channel",
+                 &Class::add_channel,
+                 py::arg("channel"),
+                 py::arg("list") = vpl::vpp_init_reset_list{},
+                 "Adds VPP channel and returns its ID. Channels must be added before initialization.")
+            .def_property_readonly("channel_count",
+                                   &Class::get_channel_count,
+                                   "Number of VPP channels, not counting the decoder output")
+            .def("skip_channel",
+                 &Class::skip_channel,
+                 py::arg("id"),
+                 py::arg("skip") = true,
+                 "Stops or resumes output of the channel")
+            .def("get_channel_param", &Class::get_channel_param, "Returns actual channel params")
+            .def("Init",
+                 &Class::Init,
+                 py::call_guard<py::gil_scoped_release>(),
+                 "Initializes the decoder and all added VPP channels.")
+            .def("Reset",
+                 &Class::Reset,
+                 py::call_guard<py::gil_scoped_release>(),
+                 "Resets the decoder and all added VPP channels.")
+            .def(
+                "init_by_header",
+                &Class::init_by_header,
+                py::call_guard<py::gil_scoped_release>(),
+                "Initialize the decoder by using bitream portion and all added VPP channels.")
+            .def(
+                "decode_frame",
+                [](Class *self, vpl::decoder_process_list list) {
+                    std::vector<std::shared_ptr<vpl::frame_surface>> surfaces;
+                    vpl::status sts = self->decode_frame(surfaces, list);
+                    return std::pair(sts, surfaces);
+                },
+                py::arg("list") = vpl::decoder_process_list{},
+                py::call_guard<py::gil_scoped_release>(),
+                "Decodes frame. Returns status and the list of surfaces indexed by channel ID, None for channels without output.")
+            .def(
+                "process",
+                &Class::process,
+                py::arg("list") = vpl::decoder_process_list{},
+                py::call_guard<py::gil_scoped_release>(),
+                "Decodes frame. Returns the list of future objects indexed by channel ID.")
+            .def_property_readonly("Stat", &Class::getStat, "Retrieve decoder statistic")
+            .def_property_readonly("Params", &Class::getParams, "Get video params")
+            .def("__iter__",
+                 [](Class *self) -> Class & {
+                     return *self;
+                 })
+            .def("__next__", [](Class *self) {
+                py::gil_scoped_release release;
+                while (true) {
+                    std::vector<std::shared_ptr<vpl::frame_surface>> surfaces;
+                    vpl::status ret = self->decode_frame(surfaces);
+                    switch (ret) {
+                        case vpl::status::Ok:
+                            for (auto &s : surfaces) {
+                                if (!s)
+                                    continue;
+                                vpl::async_op_status st;
+                                do {
+                                    std::chrono::duration<int, std::milli> waitduration(100);
+                                    st = s->wait_for(waitduration);
+                                } while (st == vpl::async_op_status::timeout);
+                            }
+                            return surfaces;
+                        case vpl::status::NotEnoughData:
+                        case vpl::status::DeviceBusy:
+                            break;
+                        default:
+                            throw py::stop_iteration();
+                    }
+                }
+            });
+    }
+};
+
 void init_session(const py::module &m) {
+    // waiter thread of the async iterators polls the sessions, join it before they go away
+    py::module::import("atexit").attr("register")(py::cpp_function([]() {
+        py::gil_scoped_release release;
+        completion_waiter::instance().stop();
+    }));
+
     session_template<vpl::decoder_video_param,
                      vpl::decoder_init_reset_list,
                      vpl::decoder_init_reset_list>(m, "decode_session_base");
 
     decode_session_template<vpl::bitstream_source_reader>(m, "decode_session");
 
+    decode_vpp_session_template<vpl::bitstream_source_reader>(m, "decode_vpp_session");
+
     session_template<vpl::encoder_video_param, vpl::encoder_init_list, vpl::encoder_reset_list>(
         m,
         "encode_session_base");
 
+    using EncodeAsyncIterator = async_iterator<vpl::encode_session, std::shared_ptr<vpl::bitstream_as_dst>>;
+    py::class_<EncodeAsyncIterator, std::shared_ptr<EncodeAsyncIterator>>(m,
+                                                                         "encode_session_async_iterator")
+        .def("__aiter__",
+             [](std::shared_ptr<EncodeAsyncIterator> self) {
+                 return self;
+             })
+        .def("__anext__",
+             &EncodeAsyncIterator::anext,
+             "Schedules next frame and returns asyncio future which gets the bitstream once it is encoded");
+
     py::class_<
         vpl::encode_session,
         vpl::session<vpl::encoder_video_param, vpl::encoder_init_list, vpl::encoder_reset_list>,
@@ -125,22 +288,39 @@ void init_session(const py::module &m) {
              py::overload_cast<std::shared_ptr<vpl::frame_surface>,
                                std::shared_ptr<vpl::bitstream_as_dst>,
                                vpl::encoder_process_list>(&vpl::encode_session::encode_frame),
+             py::call_guard<py::gil_scoped_release>(),
              "Encodes frame")
         .def("encode_frame",
              py::overload_cast<std::shared_ptr<vpl::bitstream_as_dst>, vpl::encoder_process_list>(
                  &vpl::encode_session::encode_frame),
+             py::call_guard<py::gil_scoped_release>(),
              "Encodes frame by using provided source reader to get data to encode")
         .def(
             "process",
             &vpl::encode_session::process,
+            py::call_guard<py::gil_scoped_release>(),
             "Encode frame. Function returns the future object with the bitstream which will hold processed data. User needs to sync up the future object before accessing.")
         .def_property_readonly("Stat", &vpl::encode_session::getStat, "Retrieve encoder statistic")
         .def("__iter__",
              [](vpl::encode_session *self) -> vpl::encode_session & {
                  return *self;
              })
+        .def(
+            "__aiter__",
+            [](std::shared_ptr<vpl::encode_session> self) {
+                return std::make_shared<EncodeAsyncIterator>(self, [](vpl::encode_session &s) {
+                    // schedules one frame, doesn't wait for the bitstream
+                    std::shared_ptr<vpl::bitstream_as_dst> bits = s.alloc_output();
+                    vpl::status ret                             = s.encode_frame(bits);
+                    if (ret != vpl::status::Ok)
+                        bits.reset();
+                    return std::pair(ret, bits);
+                });
+            },
+            "Async iterator over encoded bitstreams. Bitstreams are waited for by the shared waiter thread and delivered to the running event loop through a file descriptor, so one loop can drive many sessions.")
         .def("__next__", [](vpl::encode_session *self) -> std::shared_ptr<vpl::bitstream_as_dst> {
-            std::shared_ptr<vpl::bitstream_as_dst> bits = std::make_shared<vpl::bitstream_as_dst>();
+            py::gil_scoped_release release;
+            std::shared_ptr<vpl::bitstream_as_dst> bits = self->alloc_output();
             while (true) {
                 vpl::status wrn = vpl::status::Ok;
                 wrn             = self->encode_frame(bits);
@@ -178,6 +358,7 @@ void init_session(const py::module &m) {
              "Allocate internal raw surface and attach it to the output surface")
         .def("Init",
              &vpl::vpp_session::Init,
+             py::call_guard<py::gil_scoped_release>(),
              "Initializes session with given parameters and extention buffers.")
         //.def("sync", &vpl::vpp_session::sync)
         .def(
@@ -185,15 +366,18 @@ void init_session(const py::module &m) {
             py::overload_cast<std::shared_ptr<vpl::frame_surface>,
                               std::shared_ptr<vpl::frame_surface> &>(
                 &vpl::vpp_session::process_frame),
+            py::call_guard<py::gil_scoped_release>(),
             "Process frame. Function returns the surface which will hold processed data. User need to sync up the surface data before accessing.")
         .def(
             "process_frame",
             py::overload_cast<std::shared_ptr<vpl::frame_surface> &>(
                 &vpl::vpp_session::process_frame),
+            py::call_guard<py::gil_scoped_release>(),
             "Process frame. Function returns the surface which will hold processed data. User need to sync up the surface data before accessing.")
         .def(
             "process",
             &vpl::vpp_session::process,
+            py::call_guard<py::gil_scoped_release>(),
             "Process frame. Function returns the future object with the surface which will hold processed data. User need to sync up the future object before accessing.")
         .def_property_readonly("Stat", &vpl::vpp_session::getStat, "Retrieve vpp statistic")
         .def("__iter__",
@@ -201,6 +385,7 @@ void init_session(const py::module &m) {
                  return *self;
              })
         .def("__next__", [](vpl::vpp_session *self) -> std::shared_ptr<vpl::frame_surface> {
+            py::gil_scoped_release release;
             std::shared_ptr<vpl::frame_surface> proc_surface_out =
                 std::make_shared<vpl::frame_surface>();
             oneapi::vpl::status wrn = oneapi::vpl::status::Ok;
@@ -110,6 +110,24 @@ void init_source_reader(const py::module &m) {
                                &vpl::raw_frame_file_reader_by_name::get_data,
                                "Read and store portion of data into the @p bitstream object");
 
+    py::class_<vpl::raw_frame_bulk_file_reader,
+               vpl::frame_source_reader,
+               std::shared_ptr<vpl::raw_frame_bulk_file_reader>>(m, "raw_frame_bulk_file_reader")
+        .def(py::init<uint16_t,
+                      uint16_t,
+                      vpl::color_format_fourcc,
+                      vpl::color_format_fourcc,
+                      std::string &>())
+        .def_static("is_supported",
+                    &vpl::raw_frame_bulk_file_reader::is_supported,
+                    "Checks whether the pair of file format and surface format is supported.")
+        .def_property_readonly("frame_size",
+                               &vpl::raw_frame_bulk_file_reader::get_frame_size,
+                               "Size of the frame in the file.")
+        .def_property_readonly("data",
+                               &vpl::raw_frame_bulk_file_reader::get_data,
+                               "Reads next frame and stores it into the @p frame object");
+
     py::class_<vpl::bitstream_source_reader,
                vpl::source_reader,
                std::shared_ptr<vpl::bitstream_source_reader>>(m, "bitstream_source_reader")
@@ -0,0 +1,135 @@
+# pylint: disable=import-error,invalid-name
+# ==============================================================================
+#  Copyright Intel Corporation
+#
+#  SPDX-License-Identifier: MIT
+# ==============================================================================
+#
+#  Measures how decode throughput scales with the number of Python threads.
+#  Each thread runs its own decode session on the same input. Session calls
+#  release the GIL while the runtime works, so threads overlap.
+"""
+Example:  bench-decode-threads -sw -i in.h265 -t 4
+
+* Decode HEVC/H265 elementary stream in 1, 2, 4 ... N threads and print
+  the total frame rate for each thread count.
+
+  With -touch every frame is read through numpy views of its planes, which
+  don't copy the frame data.
+"""
+
+import argparse
+import os
+import threading
+import time
+import pyvpl
+
+
+def read_command_line():
+    """
+    Read command line arguments
+    """
+    parser = argparse.ArgumentParser(
+        description=globals()['__doc__'],
+        formatter_class=argparse.RawTextHelpFormatter)
+    parser.add_argument('--impl',
+                        action="store",
+                        dest='impl',
+                        default='',
+                        help=argparse.SUPPRESS)
+    parser.add_argument('-sw',
+                        action="store_const",
+                        const='sw',
+                        dest='impl',
+                        help='Use software implementation.')
+    parser.add_argument('-hw',
+                        action="store_const",
+                        const='hw',
+                        dest='impl',
+                        help='Use hardware implementation.')
+    parser.add_argument('-i',
+                        action="store",
+                        dest='input',
+                        required=True,
+                        help='input file name (HEVC elementary stream).')
+    parser.add_argument('-t',
+                        action="store",
+                        dest='threads',
+                        type=int,
+                        default=4,
+                        help='maximum number of threads (default 4).')
+    parser.add_argument('-touch',
+                        action="store_true",
+                        dest='touch',
+                        help='read every frame through numpy plane views.')
+    args = parser.parse_args()
+    args.input = os.path.abspath(args.input)
+    return args
+
+
+def decode_stream(args, frames, index):
+    """Decodes the whole input in a session of its own"""
+    count = 0
+    if args.touch:
+        import numpy  # pylint: disable=import-outside-toplevel
+    with pyvpl.bitstream_file_reader_name(args.input) as source:
+        opts = pyvpl.properties()
+        opts.api_version = (2, 5)
+        opts.decoder.codec_id = [pyvpl.codec_format_fourcc.hevc]
+        if args.impl == 'sw':
+            opts.impl = pyvpl.implementation_type.sw
+        elif args.impl == 'hw':
+            opts.impl = pyvpl.implementation_type.hw
+        sel_default = pyvpl.default_selector(opts)
+
+        params = pyvpl.decoder_video_param()
+        params.IOPattern = pyvpl.io_pattern.out_system_memory
+        params.CodecId = pyvpl.codec_format_fourcc.hevc
+        decoder = pyvpl.decode_session(sel_default, params, source)
+        decoder.init_by_header(pyvpl.decoder_init_header_list(),
+                               pyvpl.decoder_init_reset_list())
+
+        for frame in decoder:
+            if args.touch:
+                # views stay mapped while they are referenced
+                planes = frame.planes(pyvpl.memory_access.read)
+                for plane in planes:
+                    numpy.asarray(plane).max()
+                planes = None
+            frame = None
+            count += 1
+    frames[index] = count
+
+
+def run(args, threads):
+    """Runs given number of decode threads, returns frames and seconds"""
+    frames = [0] * threads
+    workers = [
+        threading.Thread(target=decode_stream, args=(args, frames, i))
+        for i in range(threads)
+    ]
+    start = time.perf_counter()
+    for worker in workers:
+        worker.start()
+    for worker in workers:
+        worker.join()
+    return sum(frames), time.perf_counter() - start
+
+
+def main(args):
+    """Main benchmark"""
+    threads = 1
+    base_fps = 0
+    while threads <= args.threads:
+        frames, seconds = run(args, threads)
+        fps = frames / seconds if seconds > 0 else 0
+        if threads == 1:
+            base_fps = fps
+        scaling = fps / base_fps if base_fps > 0 else 0
+        print(f"bench-decode-threads -- {threads:3} threads = {seconds * 1000:9.2f} msec, "
+              f"{frames} frames, {fps:9.1f} fps, x{scaling:.2f}")
+        threads *= 2
+
+
+if __name__ == '__main__':
+    main(read_command_line())
@@ -7,9 +7,11 @@
 """
 Test basic use cases
 """
+import asyncio
 import unittest
 import os
 import math
+import numpy
 import pyvpl
 
 # Folder this script is in
@@ -77,6 +79,37 @@ class TestUseCases(unittest.TestCase):
                     frame = None
         self.assertEqual(frame_count, 30)
 
+    def test_decode_async(self):
+        """Test Decode of several streams driven by one event loop"""
+        streams = 8
+
+        async def decode_stream():
+            frame_count = 0
+            with pyvpl.bitstream_file_reader_name(HEVC_CLIP) as source:
+                opts = pyvpl.properties()
+                opts.impl = pyvpl.implementation_type.sw
+                opts.api_version = (2, 5)
+                opts.decoder.codec_id = [pyvpl.codec_format_fourcc.hevc]
+                sel_default = pyvpl.default_selector(opts)
+
+                params = pyvpl.decoder_video_param()
+                params.IOPattern = pyvpl.io_pattern.out_system_memory
+                params.CodecId = pyvpl.codec_format_fourcc.hevc
+                decoder = pyvpl.decode_session(sel_default, params, source)
+                decoder.init_by_header(pyvpl.decoder_init_header_list(),
+                                       pyvpl.decoder_init_reset_list())
+
+                async for frame in decoder:
+                    frame_count += 1
+                    frame = None
+            return frame_count
+
+        async def decode_all():
+            return await asyncio.gather(
+                *[decode_stream() for _ in range(streams)])
+
+        self.assertEqual(asyncio.run(decode_all()), [30] * streams)
+
     def test_encode(self):
         """Test Encode"""
         frame_count = 0
@@ -175,6 +208,76 @@ class TestUseCases(unittest.TestCase):
                         frame.unmap()
         self.assertEqual(frame_count, 30)
 
+    def check_vpp_planes(self, fourcc):
+        """Compare plane views of VPP output frames with the frames of the clip"""
+        width, height = 320, 240
+        y_size = width * height
+        c_size = y_size // 4
+        with open(I420_CLIP, "rb") as clip:
+            content = numpy.frombuffer(clip.read(), dtype=numpy.uint8)
+
+        with pyvpl.raw_frame_file_reader_by_name(
+                width, height, pyvpl.color_format_fourcc.i420,
+                I420_CLIP) as source:
+            opts = [pyvpl.dprops.impl(pyvpl.implementation_type.sw)]
+            sel_default = pyvpl.default_selector(pyvpl.property_list(opts))
+            params = pyvpl.vpp_video_param()
+            in_frame = pyvpl.frame_info()
+            in_frame.FourCC = pyvpl.color_format_fourcc.i420
+            in_frame.ChromaFormat = pyvpl.chroma_format_idc.yuv420
+            in_frame.PicStruct = pyvpl.pic_struct.progressive
+            in_frame.frame_rate = (30, 1)
+            in_frame.ROI = ((0, 0), (width, height))
+            in_frame.frame_size = (width, height)
+            params.in_frame_info = in_frame
+            out_frame = pyvpl.frame_info()
+            out_frame.FourCC = fourcc
+            out_frame.ChromaFormat = pyvpl.chroma_format_idc.yuv420
+            out_frame.PicStruct = pyvpl.pic_struct.progressive
+            out_frame.frame_rate = (30, 1)
+            out_frame.ROI = ((0, 0), (width, height))
+            out_frame.frame_size = (width, height)
+            params.out_frame_info = out_frame
+            params.IOPattern = pyvpl.io_pattern.io_system_memory
+            session = pyvpl.vpp_session(sel_default, source)
+            session.Init(params, pyvpl.vpp_init_reset_list())
+
+            frame_count = 0
+            for frame in session:
+                offset = frame_count * (y_size + 2 * c_size)
+                y = content[offset:offset + y_size].reshape(height, width)
+                offset += y_size
+                u = content[offset:offset + c_size].reshape(
+                    height // 2, width // 2)
+                offset += c_size
+                v = content[offset:offset + c_size].reshape(
+                    height // 2, width // 2)
+
+                planes = [numpy.asarray(p) for p in frame.planes(
+                    pyvpl.memory_access.read)]
+                numpy.testing.assert_array_equal(planes[0], y)
+                if fourcc == pyvpl.color_format_fourcc.nv12:
+                    self.assertEqual(len(planes), 2)
+                    numpy.testing.assert_array_equal(planes[1][:, 0::2], u)
+                    numpy.testing.assert_array_equal(planes[1][:, 1::2], v)
+                else:
+                    self.assertEqual(len(planes), 3)
+                    numpy.testing.assert_array_equal(planes[1], u)
+                    numpy.testing.assert_array_equal(planes[2], v)
+
+                planes = None
+                frame = None
+                frame_count += 1
+        self.assertEqual(frame_count, 30)
+
+    def test_planes_i420(self):
+        """Test I420 plane views"""
+        self.check_vpp_planes(pyvpl.color_format_fourcc.i420)
+
+    def test_planes_nv12(self):
+        """Test NV12 plane views"""
+        self.check_vpp_planes(pyvpl.color_format_fourcc.nv12)
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -8,6 +8,7 @@
 #define __SAMPLE_UTILS_H__
 
 #include <stdio.h>
+#include <string.h>
 #include <algorithm>
 #include <fstream>
 #include <map>
@@ -31,6 +32,7 @@
 #include "vpl/mfxstructures.h"
 #include "vpl/mfxvideo++.h"
 #include "vpl/mfxvideo.h"
+#include "vpl/preview/detail/mirrored_buffer.hpp"
 
 #include "vm/atomic_defs.h"
 #include "vm/file_defs.h"
@@ -740,15 +742,19 @@ class mfxBitstreamWrapper : public ExtBufHolder<mfxBitstream> {
     typedef ExtBufHolder<mfxBitstream> base;
 
 public:
-    mfxBitstreamWrapper() : base(), m_data() {}
+    mfxBitstreamWrapper() : base(), m_data(), m_ring() {}
 
-    mfxBitstreamWrapper(mfxU32 n_bytes) : base(), m_data() {
+    mfxBitstreamWrapper(mfxU32 n_bytes) : base(), m_data(), m_ring() {
         Extend(n_bytes);
     }
 
+    // copy of ring buffer is a plain buffer
     mfxBitstreamWrapper(const mfxBitstreamWrapper& bs_wrapper)
             : base(bs_wrapper),
-              m_data(bs_wrapper.m_data) {
+              m_data(bs_wrapper.m_data),
+              m_ring() {
+        if (bs_wrapper.m_ring)
+            m_data.assign(bs_wrapper.Data, bs_wrapper.Data + bs_wrapper.MaxLength);
         Data = m_data.data();
     }
 
@@ -768,14 +774,76 @@ public:
         if (MaxLength >= n_bytes)
             return;
 
+        if (m_ring) {
+            if (MoveToRing(n_bytes))
+                return;
+
+            // keep valid data at the same offset in a plain buffer
+            m_data.assign(Data, Data + DataOffset + DataLength);
+            m_ring.reset();
+        }
+
         m_data.resize(n_bytes);
 
         Data      = m_data.data();
         MaxLength = n_bytes;
     }
 
+    // Switches storage to a ring buffer which is mapped twice into the address space, so Rebase()
+    // never moves data. Returns false if the platform can't provide it, then the plain buffer stays in use.
+    bool UseRingBuffer() {
+        if (m_ring)
+            return true;
+        if (!MoveToRing(MaxLength))
+            return false;
+
+        std::vector<mfxU8>().swap(m_data);
+        return true;
+    }
+
+    bool IsRingBuffer() const {
+        return m_ring != nullptr;
+    }
+
+    // Makes Data + DataOffset the start of the buffer, so all free space follows the valid data.
+    // Ring buffer moves the start of the buffer, plain buffer moves valid data to the beginning.
+    void Rebase() {
+        if (!DataOffset)
+            return;
+
+        if (m_ring) {
+            mfxU8* start = Data + DataOffset;
+            if (start >= m_ring->data() + m_ring->size())
+                start -= m_ring->size();
+            Data = start;
+        }
+        else {
+            memmove(Data, Data + DataOffset, DataLength);
+        }
+        DataOffset = 0;
+    }
+
 private:
+    // copies valid data to the beginning of a new ring buffer of at least n_bytes
+    bool MoveToRing(mfxU32 n_bytes) {
+        std::unique_ptr<oneapi::vpl::detail::mirrored_buffer> ring(
+            new oneapi::vpl::detail::mirrored_buffer(n_bytes));
+        if (!ring->valid())
+            return false;
+
+        if (DataLength)
+            memcpy(ring->data(), Data + DataOffset, DataLength);
+        m_ring.swap(ring);
+
+        // MaxLength bytes are mapped after any start in the first copy of the ring
+        Data       = m_ring->data();
+        DataOffset = 0;
+        MaxLength  = m_ring->size();
+        return true;
+    }
+
     std::vector<mfxU8> m_data;
+    std::unique_ptr<oneapi::vpl::detail::mirrored_buffer> m_ring;
 };
 
 class CSmplYUVReader {
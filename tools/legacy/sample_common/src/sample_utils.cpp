@@ -700,8 +700,11 @@ mfxStatus CSmplBitstreamReader::ReadNextFrame(mfxBitstream* pBS) {
     if (pBS->MaxLength == pBS->DataLength)
         return MFX_ERR_NOT_ENOUGH_BUFFER;
 
-    memmove(pBS->Data, pBS->Data + pBS->DataOffset, pBS->DataLength);
-    pBS->DataOffset = 0;
+    // nothing to move if the caller already did mfxBitstreamWrapper::Rebase()
+    if (pBS->DataOffset) {
+        memmove(pBS->Data, pBS->Data + pBS->DataOffset, pBS->DataLength);
+        pBS->DataOffset = 0;
+    }
     mfxU32 nBytesRead =
         (mfxU32)fread(pBS->Data + pBS->DataLength, 1, pBS->MaxLength - pBS->DataLength, m_fSource);
 
@@ -362,6 +362,9 @@ mfxStatus CDecodingPipeline::Init(sInputParams* pParams) {
     }
     MSDK_CHECK_STATUS(sts, "m_FileReader->Init failed");
 
+    // refills don't move unconsumed data if the platform supports it
+    m_mfxBS.UseRingBuffer();
+
     mfxInitParamlWrap initPar;
     auto threadsPar = initPar.AddExtBuffer<mfxExtThreadsParam>();
     MSDK_CHECK_POINTER(threadsPar, MFX_ERR_MEMORY_ALLOC);
@@ -756,6 +759,7 @@ mfxStatus CDecodingPipeline::InitMfxParams(sInputParams* pParams) {
             }
             // read a portion of data
             totalBytesProcessed += m_mfxBS.DataOffset;
+            m_mfxBS.Rebase();
             sts = m_FileReader->ReadNextFrame(&m_mfxBS);
             MSDK_CHECK_STATUS(sts, "m_FileReader->ReadNextFrame failed");
 
@@ -1740,6 +1744,7 @@ mfxStatus CDecodingPipeline::RunDecoding() {
         if (pBitstream &&
             ((MFX_ERR_MORE_DATA == sts) || (m_bIsCompleteFrame && !pBitstream->DataLength))) {
             CAutoTimer timer_fread(m_tick_fread);
+            m_mfxBS.Rebase();
             sts = m_FileReader->ReadNextFrame(pBitstream); // read more data to input bit stream
 
             if (MFX_ERR_MORE_DATA == sts) {
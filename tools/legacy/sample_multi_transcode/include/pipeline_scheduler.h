@@ -0,0 +1,81 @@
+/*############################################################################
+  # Copyright (C) 2005 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __PIPELINE_SCHEDULER_H__
+#define __PIPELINE_SCHEDULER_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "vpl/mfxdefs.h"
+
+namespace TranscodingSample {
+// Runs cooperative tasks on a fixed number of worker threads. Every worker
+// steps the tasks of its own queue in turn and steals tasks from the queues of
+// the other workers when its own queue is empty. Finished tasks are reported
+// through the completion queue.
+class PipelineScheduler {
+public:
+    // Does a piece of work without blocking. Returns MFX_ERR_NONE to be called
+    // again, MFX_WRN_IN_EXECUTION if it waits for something and has to be
+    // called again later, any other status when the task is finished.
+    typedef std::function<mfxStatus()> StepFunction;
+
+    struct Completion {
+        mfxU32 TaskID;
+        mfxStatus Status;
+    };
+
+    explicit PipelineScheduler(mfxU32 numWorkers);
+    ~PipelineScheduler();
+
+    // tasks are spread between the workers evenly, must be added before Start()
+    void AddTask(mfxU32 taskID, StepFunction step);
+    void Start();
+    void Stop();
+
+    // tasks which aren't run by the scheduler may report completion here too
+    void Complete(mfxU32 taskID, mfxStatus sts);
+    // blocks until a task is finished
+    Completion WaitForCompletion();
+
+private:
+    struct Task {
+        mfxU32 ID;
+        StepFunction Step;
+    };
+
+    struct Worker {
+        std::mutex Mutex;
+        std::deque<Task> Tasks;
+    };
+
+    void WorkerRoutine(mfxU32 workerID);
+    bool PopTask(mfxU32 workerID, Task& task);
+    bool StealTask(mfxU32 workerID, Task& task);
+    void PushTask(mfxU32 workerID, Task& task);
+
+    std::vector<std::unique_ptr<Worker>> m_Workers;
+    std::vector<std::thread> m_Threads;
+    std::atomic<bool> m_bStop;
+    mfxU32 m_nextWorker;
+
+    std::mutex m_CompletionMutex;
+    std::condition_variable m_CompletionCV;
+    std::deque<Completion> m_Completions;
+
+    PipelineScheduler(const PipelineScheduler&) = delete;
+    PipelineScheduler& operator=(const PipelineScheduler&) = delete;
+};
+} // namespace TranscodingSample
+
+#endif
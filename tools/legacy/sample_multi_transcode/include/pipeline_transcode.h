@@ -9,14 +9,17 @@
 
 #include <stddef.h>
 
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <ctime>
+#include <deque>
 #include <future>
 #include <list>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include <vector>
 
 #include "base_allocator.h"
@@ -176,6 +179,8 @@ struct __sInputParams {
     bool CascadeScaler                 = false;
     bool EnableTracing                 = false;
     mfxU32 TraceBufferSize             = 0;
+    mfxU32 TraceFlightRecorder         = 0; // seconds, 0 - flight recorder is off
+    mfxU32 nSchedulerWorkers           = 0; // 0 - thread per session
     SMTTracer::LatencyType LatencyType = SMTTracer::LatencyType::DEFAULT;
 
     // session parameters
@@ -263,6 +268,7 @@ struct __sInputParams {
     mfxU16 ScalingMode;
 
     mfxU16 nAsyncDepth; // asyncronous queue
+    mfxU16 nOutputQueueDepth; // bitstreams queued for the output writer thread, 0 - write inline
 
     PipelineMode eMode;
     PipelineMode eModeExt;
@@ -539,12 +545,22 @@ struct ExtendedBS {
 
 class CIOStat : public CTimeStatistics {
 public:
-    CIOStat() : CTimeStatistics(), ofile(stdout) {
+    CIOStat()
+            : CTimeStatistics(),
+              ofile(stdout),
+              queueDepthSum(0),
+              queueDepthSamples(0),
+              queueDepthMax(0) {
         MSDK_ZERO_MEMORY(bufDir);
         DumpLogFileName.clear();
     }
 
-    CIOStat(const msdk_char* dir) : CTimeStatistics(), ofile(stdout) {
+    CIOStat(const msdk_char* dir)
+            : CTimeStatistics(),
+              ofile(stdout),
+              queueDepthSum(0),
+              queueDepthSamples(0),
+              queueDepthMax(0) {
         msdk_strncopy_s(bufDir, MAX_PREF_LEN, dir, MAX_PREF_LEN - 1);
         bufDir[MAX_PREF_LEN - 1] = 0;
     }
@@ -572,13 +588,27 @@ public:
         }
     }
 
+    // depth of the queue in front of the measured stage, sampled once per frame
+    inline void AddQueueDepth(mfxU32 depth) {
+        queueDepthSum += depth;
+        queueDepthSamples++;
+        queueDepthMax = std::max(queueDepthMax, depth);
+    }
+
+    inline void ResetStatistics() {
+        CTimeStatistics::ResetStatistics();
+        queueDepthSum     = 0;
+        queueDepthSamples = 0;
+        queueDepthMax     = 0;
+    }
+
     inline void PrintStatistics(mfxU32 numPipelineid,
                                 mfxF64 target_framerate = -1 /*default stands for infinite*/) {
         // print timings in ms
         msdk_fprintf(
             ofile,
             MSDK_STRING(
-                "stat[%u.%llu]: %s=%d;Framerate=%.3f;Total=%.3lf;Samples=%lld;StdDev=%.3lf;Min=%.3lf;Max=%.3lf;Avg=%.3lf\n"),
+                "stat[%u.%llu]: %s=%d;Framerate=%.3f;Total=%.3lf;Samples=%lld;StdDev=%.3lf;Min=%.3lf;Max=%.3lf;Avg=%.3lf"),
             msdk_get_current_pid(),
             (unsigned long long int)rdtsc(),
             bufDir,
@@ -590,6 +620,13 @@ public:
             (double)GetMinTime(false),
             (double)GetMaxTime(false),
             (double)GetAvgTime(false));
+        if (queueDepthSamples) {
+            msdk_fprintf(ofile,
+                         MSDK_STRING(";QueueAvg=%.2lf;QueueMax=%u"),
+                         (double)queueDepthSum / queueDepthSamples,
+                         (unsigned int)queueDepthMax);
+        }
+        msdk_fprintf(ofile, MSDK_STRING("\n"));
         fflush(ofile);
 
         if (!DumpLogFileName.empty()) {
@@ -622,38 +659,45 @@ protected:
     msdk_tstring DumpLogFileName;
     FILE* ofile;
     msdk_char bufDir[MAX_PREF_LEN];
+    mfxU64 queueDepthSum;
+    mfxU64 queueDepthSamples;
+    mfxU32 queueDepthMax;
 };
 
 class ExtendedBSStore {
 public:
-    explicit ExtendedBSStore(mfxU32 size) {
-        m_pExtBS.resize(size);
+    explicit ExtendedBSStore(mfxU32 size) : m_mutex(), m_pExtBS(size), m_FreeIdx() {
+        m_FreeIdx.reserve(size);
+        ResetFreeList();
     }
     virtual ~ExtendedBSStore() {
         m_pExtBS.clear();
     }
+    // GetNext and Release may be called from different threads if the output
+    // is written asynchronously
     ExtendedBS* GetNext() {
-        for (mfxU32 i = 0; i < m_pExtBS.size(); i++) {
-            if (m_pExtBS[i].IsFree) {
-                m_pExtBS[i].IsFree = false;
-                return &m_pExtBS[i];
-            }
-        }
-        return NULL;
+        std::lock_guard<std::mutex> guard(m_mutex);
+        if (m_FreeIdx.empty())
+            return NULL;
+        ExtendedBS* pBS = &m_pExtBS[m_FreeIdx.back()];
+        m_FreeIdx.pop_back();
+        pBS->IsFree = false;
+        return pBS;
     }
     void Release(ExtendedBS* pBS) {
-        for (mfxU32 i = 0; i < m_pExtBS.size(); i++) {
-            if (&m_pExtBS[i] == pBS) {
-                m_pExtBS[i].IsFree = true;
-                return;
-            }
-        }
+        std::lock_guard<std::mutex> guard(m_mutex);
+        if (pBS < m_pExtBS.data() || pBS >= m_pExtBS.data() + m_pExtBS.size() || pBS->IsFree)
+            return;
+        pBS->IsFree = true;
+        m_FreeIdx.push_back((mfxU32)(pBS - m_pExtBS.data()));
         return;
     }
     void ReleaseAll() {
+        std::lock_guard<std::mutex> guard(m_mutex);
         for (mfxU32 i = 0; i < m_pExtBS.size(); i++) {
             m_pExtBS[i].IsFree = true;
         }
+        ResetFreeList();
         return;
     }
     void FlushAll() {
@@ -665,12 +709,125 @@ public:
     }
 
 protected:
+    // lowest indices on top, so bitstreams are handed out in the same order
+    // as before and the most recently released one is reused first
+    void ResetFreeList() {
+        m_FreeIdx.clear();
+        for (mfxU32 i = (mfxU32)m_pExtBS.size(); i > 0; i--) {
+            m_FreeIdx.push_back(i - 1);
+        }
+    }
+
+    std::mutex m_mutex;
     std::vector<ExtendedBS> m_pExtBS;
+    // indices of free bitstreams in m_pExtBS
+    std::vector<mfxU32> m_FreeIdx;
 
 private:
     DISALLOW_COPY_AND_ASSIGN(ExtendedBSStore);
 };
 
+typedef std::vector<mfxFrameSurface1*> SurfPointersArray;
+// free list of a surface pool, guarded by the FreeSurfaceNotifier of the pipeline
+struct SurfacePoolState {
+    SurfPointersArray Free; // surfaces seen unlocked, taken from the back
+    SurfPointersArray Busy; // surfaces handed out and not seen unlocked yet
+    bool Registered   = false;
+    mfxU64 WaitTimeUs = 0; // total time spent waiting for a free surface
+};
+
+// Keeps free lists of the GENERAL_ALLOC pools of one pipeline and wakes up
+// threads waiting for a free surface. Surfaces are unlocked by the pipelines
+// (SafetySurfaceBuffer) and by the library, which is done with a surface not
+// later than the sync point of the operation using it completes, so both places
+// notify the pipeline owning the pool. Handed out surfaces are moved back to the
+// free list on Notify() while somebody waits, otherwise when the free list runs
+// empty.
+class FreeSurfaceNotifier {
+public:
+    FreeSurfaceNotifier() : m_mutex(), m_cv(), m_pools(), m_generation(0), m_waiters(0) {}
+
+    void Notify();
+    // takes a free surface of the pool, waits up to msec for Notify() if there is
+    // none and sets waited; returns NULL if there is still none after the wait
+    mfxFrameSurface1* Acquire(SurfacePoolState& state,
+                              const SurfPointersArray& pool,
+                              mfxU32 msec,
+                              bool& waited);
+    // forgets all pools, called before their surfaces are freed
+    void RemovePools();
+
+private:
+    // moves handed out surfaces which are unlocked to the free list
+    static void Reclaim(SurfacePoolState& state);
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::vector<SurfacePoolState*> m_pools;
+    std::atomic<mfxU64> m_generation;
+    std::atomic<mfxU32> m_waiters;
+
+    DISALLOW_COPY_AND_ASSIGN(FreeSurfaceNotifier);
+};
+
+// FIFO queue on a ring buffer. Storage is allocated once and doubles only if
+// more elements than its capacity are queued. Not thread safe.
+template <class T>
+class RingQueue {
+public:
+    explicit RingQueue(size_t capacity) : m_Items(capacity ? capacity : 1), m_Head(0), m_Count(0) {}
+
+    size_t Size() const {
+        return m_Count;
+    }
+    // i-th element from the head
+    T& At(size_t i) {
+        return m_Items[(m_Head + i) % m_Items.size()];
+    }
+    T& Front() {
+        return m_Items[m_Head];
+    }
+    void Push(const T& item) {
+        if (m_Count == m_Items.size())
+            Grow();
+        m_Items[(m_Head + m_Count) % m_Items.size()] = item;
+        m_Count++;
+    }
+    void Pop() {
+        m_Head = (m_Head + 1) % m_Items.size();
+        m_Count--;
+    }
+    // removes i-th element from the head, O(1) for the head
+    void Erase(size_t i) {
+        if (i == 0) {
+            Pop();
+            return;
+        }
+        for (; i + 1 < m_Count; i++) {
+            At(i) = At(i + 1);
+        }
+        m_Count--;
+    }
+    void Clear() {
+        m_Head  = 0;
+        m_Count = 0;
+    }
+
+protected:
+    void Grow() {
+        std::vector<T> items(2 * m_Items.size());
+        for (size_t i = 0; i < m_Count; i++) {
+            items[i] = At(i);
+        }
+        m_Items.swap(items);
+        m_Head = 0;
+    }
+
+    std::vector<T> m_Items;
+    size_t m_Head;
+    size_t m_Count;
+};
+
 class CTranscodingPipeline;
 // thread safety buffer heterogeneous pipeline
 // only for join sessions
@@ -680,9 +837,10 @@ public:
     mfxU32 TargetID = 0;
 
     struct SurfaceDescriptor {
-        SurfaceDescriptor() : ExtSurface(), Locked(false) {}
+        SurfaceDescriptor() : ExtSurface(), Locked(false), pNotifier(NULL) {}
         ExtendedSurface ExtSurface;
         mfxU32 Locked;
+        FreeSurfaceNotifier* pNotifier; // of the pipeline owning the surface
     };
 
     SafetySurfaceBuffer(SafetySurfaceBuffer* pNext);
@@ -691,7 +849,8 @@ public:
     mfxU32 GetLength();
     mfxStatus WaitForSurfaceRelease(mfxU32 msec);
     mfxStatus WaitForSurfaceInsertion(mfxU32 msec);
-    void AddSurface(ExtendedSurface Surf);
+    // pNotifier is signalled when the surface is released
+    void AddSurface(ExtendedSurface Surf, FreeSurfaceNotifier* pNotifier = NULL);
     mfxStatus GetSurface(ExtendedSurface& Surf);
     mfxStatus ReleaseSurface(mfxFrameSurface1* pSurf);
     mfxStatus ReleaseSurfaceAll();
@@ -700,8 +859,11 @@ public:
     SafetySurfaceBuffer* m_pNext;
 
 protected:
+    // preallocated descriptors, enough for decoder pools of usual size
+    static const mfxU32 InitialCapacity = 64;
+
     std::mutex m_mutex;
-    std::list<SurfaceDescriptor> m_SList;
+    RingQueue<SurfaceDescriptor> m_SList;
     bool m_IsBufferingAllowed;
     MSDKEvent* pRelEvent;
     MSDKEvent* pInsEvent;
@@ -735,7 +897,51 @@ private:
     DISALLOW_COPY_AND_ASSIGN(FileBitstreamProcessor);
 };
 
-typedef std::vector<mfxFrameSurface1*> SurfPointersArray;
+// Writes output bitstreams of a pipeline on a dedicated thread, so slow storage
+// doesn't stall the encoding loop. The queue is bounded: Push waits while it is
+// full, which keeps bitstreams in the pipeline's BS pool and throttles the
+// encoder. Bitstreams are written in order and then released to the store.
+class AsyncBitstreamWriter {
+public:
+    AsyncBitstreamWriter(FileBitstreamProcessor* pBSProc,
+                         ExtendedBSStore* pBSStore,
+                         mfxU32 depth);
+    virtual ~AsyncBitstreamWriter();
+
+    // returns status of the first failed write, if any
+    mfxStatus Push(ExtendedBS* pBS);
+    // waits until all queued bitstreams are written or, after a failure,
+    // released to the store
+    mfxStatus Flush();
+
+    // write latency and queue depth are printed every windowSize frames
+    void SetStatistics(mfxU32 windowSize, FILE* file, const msdk_tstring& dumpName);
+    void SetPipelineID(mfxU32 id);
+
+protected:
+    void WriteRoutine();
+
+    FileBitstreamProcessor* m_pBSProc;
+    ExtendedBSStore* m_pBSStore;
+    const mfxU32 m_Depth;
+    mfxU32 m_PipelineID;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cvPush; // queue isn't empty or stop is requested
+    std::condition_variable m_cvPop; // queue isn't full
+    std::deque<ExtendedBS*> m_Queue; // includes bitstreams being written
+    mfxStatus m_Status;
+    bool m_bStop;
+
+    mfxU32 m_StatWindowSize;
+    CIOStat m_Statistics;
+
+    std::thread m_Thread;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(AsyncBitstreamWriter);
+};
+
 typedef std::vector<PreEncAuxBuffer> PreEncAuxArray;
 typedef std::list<ExtendedBS*> BSList;
 
@@ -761,6 +967,15 @@ public:
     virtual mfxStatus Reset(VPLImplementationLoader* mfxLoader);
     virtual mfxStatus Join(MFXVideoSession* pChildSession);
     virtual mfxStatus Run();
+    // Runs one iteration of Run() without waiting for the GPU. Returns
+    // MFX_ERR_NONE if it should be called again, MFX_WRN_IN_EXECUTION if the
+    // pipeline waits for the GPU, a free surface, a busy device or its frame
+    // rate, and status of Run() when transcoding is finished. Supported by transcoding pipelines only,
+    // decoding and encoding ones of heterogeneous pipelines wait for each other.
+    virtual mfxStatus RunStep();
+    bool IsRunStepSupported() {
+        return m_bDecodeEnable && m_bEncodeEnable;
+    }
     virtual mfxStatus FlushLastFrames() {
         return MFX_ERR_NONE;
     }
@@ -782,6 +997,8 @@ public:
     }
     inline void SetPipelineID(mfxU32 id) {
         m_nID = id;
+        if (m_pBSWriter)
+            m_pBSWriter->SetPipelineID(id);
     }
     void StopSession();
     mfxStatus CheckStopCondition();
@@ -847,6 +1064,13 @@ protected:
     virtual mfxStatus Decode();
     virtual mfxStatus Encode();
     virtual mfxStatus Transcode();
+    // one iteration of Transcode(), sets bFinished when transcoding is finished
+    // and bReady = false if it has to wait and bWait is false
+    virtual mfxStatus TranscodeOneFrame(bool bWait, bool& bFinished, bool& bReady);
+    // encoding part of TranscodeOneFrame(), called again for the same frame if
+    // the encoder was busy and bWait is false
+    virtual mfxStatus TranscodeEncodeFrame(bool bWait, bool& bFinished, bool& bReady);
+    virtual mfxStatus TranscodeFinish(mfxStatus sts);
     virtual mfxStatus DecodeOneFrame(ExtendedSurface* pExtSurface);
     virtual mfxStatus DecodeLastFrame(ExtendedSurface* pExtSurface);
     virtual mfxStatus VPPOneFrame(ExtendedSurface* pSurfaceIn,
@@ -882,7 +1106,19 @@ protected:
     mfxStatus LoadStaticSurface();
 
     mfxFrameSurface1* GetFreeSurface(bool isDec, mfxU64 timeout);
+    // timeout of free surface waits, RunStep() doesn't wait
+    mfxU64 GetSurfaceWaitInterval() const {
+        return m_TranscodeState.bWait ? MSDK_SURFACE_WAIT_INTERVAL : 0;
+    }
+    // returns MFX_WRN_IN_EXECUTION for RunStep() to repeat the call later, or
+    // MFX_ERR_DEVICE_FAILED if the device is busy for too long
+    mfxStatus PostponeOnDeviceBusy();
     mfxFrameSurface1* GetFreeSurfaceForCS(bool isDec, mfxU64 timeout, mfxU32 ID);
+    mfxFrameSurface1* GetFreeSurfaceFromPool(SurfPointersArray& pool,
+                                             SurfacePoolState& state,
+                                             SMTTracer::ThreadType thType,
+                                             mfxU32 thID,
+                                             mfxU64 timeout);
     mfxU32 GetFreeSurfacesCount(bool isDec);
     PreEncAuxBuffer* GetFreePreEncAuxBuffer();
     void SetEncCtrlRT(ExtendedSurface& extSurface, bool bInsertIDR);
@@ -902,7 +1138,9 @@ protected:
     void FreeMVCSeqDesc();
 
     mfxStatus AllocateSufficientBuffer(mfxBitstreamWrapper* pBS);
-    mfxStatus PutBS();
+    // with bWait = false returns MFX_WRN_IN_EXECUTION and keeps the bitstream
+    // in m_BSPool if encoding isn't finished yet
+    mfxStatus PutBS(bool bWait = true);
 
     mfxStatus DumpSurface2File(mfxFrameSurface1* pSurface);
     mfxStatus Surface2BS(ExtendedSurface* pSurf, mfxBitstreamWrapper* pBS, mfxU32 fourCC);
@@ -922,6 +1160,9 @@ protected:
     void SetNumFramesForReset(mfxU32 nFrames);
 
     void HandlePossibleGpuHang(mfxStatus& sts);
+    // wakes up waiters for surfaces of this pipeline and of the parent one,
+    // the library may have unlocked surfaces of both
+    void NotifySurfacesUnlocked();
 
     mfxStatus SetAllocatorAndHandleIfRequired();
     mfxStatus LoadGenericPlugin();
@@ -968,6 +1209,12 @@ protected:
 
     std::map<mfxU32, SurfPointersArray> m_CSSurfacePools;
 
+    SurfacePoolState m_DecPoolState;
+    SurfacePoolState m_EncPoolState;
+    std::map<mfxU32, SurfacePoolState> m_CSPoolStates;
+    // signalled when a surface of any of the pools above is unlocked
+    FreeSurfaceNotifier m_FreeSurfaceNotifier;
+
     mfxU16 m_EncSurfaceType; // actual type of encoder surface pool
     mfxU16 m_DecSurfaceType; // actual type of decoder surface pool
 
@@ -976,6 +1223,26 @@ protected:
     // transcoding pipeline specific
     BSList m_BSPool;
 
+    // state of Transcode() loop kept between TranscodeOneFrame() calls
+    struct TranscodeState {
+        bool bStarted                 = false;
+        ExtendedSurface DecExtSurface = {};
+        ExtendedSurface VppExtSurface = {};
+        bool bNeedDecodedFrames       = true; // indicates if we need to decode frames
+        bool bEndOfFile               = false;
+        bool bLastCycle               = false;
+        bool shouldReadNextFrame      = true;
+        time_t start                  = 0;
+        msdk_tick nNextFrameTime      = 0; // frame rate limit for RunStep()
+        // waits for surfaces and the device are allowed, false for RunStep()
+        bool bWait = true;
+        // encoder was busy, the frame is encoded by the next call
+        bool bEncodePending        = false;
+        msdk_tick nFrameBeginTime  = 0;
+        msdk_tick nDeviceBusySince = 0; // device is busy without output since
+    };
+    TranscodeState m_TranscodeState;
+
     mfxInitParamlWrap m_initPar;
 
     volatile bool m_bForceStop;
@@ -1051,6 +1318,8 @@ protected:
     bool m_shouldUseShifted10BitEnc;
 
     std::unique_ptr<ExtendedBSStore> m_pBSStore;
+    // writes output on a separate thread if set
+    std::unique_ptr<AsyncBitstreamWriter> m_pBSWriter;
 
     mfxU32 m_FrameNumberPreference;
     mfxU32 m_MaxFramesForTranscode;
@@ -1151,6 +1420,11 @@ struct ThreadTranscodeContext {
     // Thread handle
     std::future<void> handle;
 
+    // TranscodeStep() has started the session
+    bool isStepStarted = false;
+    // Session's starting time for TranscodeStep()
+    std::chrono::system_clock::time_point stepStartTime;
+
     void TranscodeRoutine() {
         using namespace std::chrono;
         MSDK_CHECK_POINTER_NO_RET(pPipeline);
@@ -1165,6 +1439,30 @@ struct ThreadTranscodeContext {
         MSDK_IGNORE_MFX_STS(transcodingSts, MFX_WRN_VALUE_NOT_CHANGED);
         numTransFrames = pPipeline->GetProcessFrames();
     }
+
+    // TranscodeRoutine() for PipelineScheduler, runs one step of the pipeline.
+    // Returns MFX_ERR_NONE or MFX_WRN_IN_EXECUTION until the session is finished.
+    mfxStatus TranscodeStep() {
+        using namespace std::chrono;
+        MSDK_CHECK_POINTER(pPipeline, MFX_ERR_NULL_PTR);
+        if (!isStepStarted) {
+            transcodingSts = MFX_ERR_NONE;
+            stepStartTime  = system_clock::now();
+            isStepStarted  = true;
+        }
+
+        mfxStatus sts = pPipeline->RunStep();
+        if (MFX_ERR_NONE == sts || MFX_WRN_IN_EXECUTION == sts)
+            return sts;
+
+        isStepStarted  = false;
+        transcodingSts = sts;
+        working_time   = duration_cast<duration<mfxF64>>(system_clock::now() - stepStartTime).count();
+
+        MSDK_IGNORE_MFX_STS(transcodingSts, MFX_WRN_VALUE_NOT_CHANGED);
+        numTransFrames = pPipeline->GetProcessFrames();
+        return sts;
+    }
 };
 } // namespace TranscodingSample
 
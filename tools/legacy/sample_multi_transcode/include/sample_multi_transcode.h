@@ -59,7 +59,9 @@ protected:
     virtual mfxStatus CreateSafetyBuffers();
     CascadeScalerConfig& CreateCascadeScalerConfig();
     virtual void DoTranscoding();
+    virtual void DoScheduledTranscoding(mfxU32 numWorkers);
     virtual void DoRobustTranscoding();
+    void CheckSessionStatus(size_t i);
 
     virtual void Close();
 
@@ -8,10 +8,12 @@
 #define __SMT_TRACER_H__
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <fstream>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -32,7 +34,12 @@ public:
     SMTTracer();
     ~SMTTracer();
 
-    void Init(const mfxU32 numOfChannels, const LatencyType latency, const mfxU32 TraceBufferSize);
+    //FlightRecorderSeconds > 0 turns on flight recorder mode, only events of the last
+    //FlightRecorderSeconds are kept and they are saved on GPU hang or on SIGUSR1
+    void Init(const mfxU32 numOfChannels,
+              const LatencyType latency,
+              const mfxU32 TraceBufferSize,
+              const mfxU32 FlightRecorderSeconds = 0);
     void BeginEvent(const ThreadType thType,
                     const mfxU32 thID,
                     const EventName name,
@@ -53,6 +60,15 @@ public:
     void AfterDecodeSync();
     void AfterEncodeSync();
 
+    bool IsEnabled() const {
+        return Enabled;
+    }
+
+    //flight recorder mode only, saves events recorded during the last FlightRecorderSeconds
+    void DumpFlightRecorder(const char* reason);
+    //async-signal-safe, dump is done by the next thread that records an event
+    static void RequestFlightRecorderDump();
+
 private:
     class Event {
     public:
@@ -63,10 +79,25 @@ private:
         mfxU32 EvID; //unique event ID
         mfxU64 InID; //unique dependency ID, e.g. surface pointer
         mfxU64 OutID;
-        mfxU64 TS; //time stamp
+        mfxU64 TS; //time stamp, ns
     };
     using EventIt = std::vector<Event>::iterator;
 
+    //events recorded by one thread, only this thread adds events, so the mutex
+    //is contended only while a dump copies them
+    class Shard {
+    public:
+        explicit Shard(size_t size) : Mutex(), Events(size), Count(0) {}
+        std::mutex Mutex;
+        std::vector<Event> Events; //preallocated, used as ring buffer in flight recorder mode
+        mfxU64 Count; //number of recorded events
+    };
+
+    struct ShardRef {
+        mfxU32 TracerID;
+        Shard* Ptr;
+    };
+
     class TimeInterval {
     public:
         TimeInterval(mfxU64 ts, mfxU64 duration);
@@ -82,6 +113,10 @@ private:
                   const void* inID,
                   const void* outID);
     mfxU64 GetCurrentTS();
+    Shard* GetShard();
+
+    //merges events recorded since "since" from all shards into Log, ordered by time stamp
+    void CollectEvents(mfxU64 since);
 
     //log generation functions
     void SaveTrace(mfxU32 FileID);
@@ -121,7 +156,18 @@ private:
 
     bool Enabled = false;
     mfxU32 EvID  = 0;
-    std::vector<Event> Log;
+    std::vector<std::unique_ptr<Shard>> Shards; //guarded by TracerMutex
+    size_t NextFreeShard = 0;
+    size_t ShardSize     = 0; //in events
+    mfxU32 TracerID      = 0;
+    static std::atomic<mfxU32> NextTracerID;
+    static thread_local ShardRef LocalShard; //shard of the calling thread
+
+    mfxU64 FlightRecorderWindow = 0; //ns, 0 if flight recorder is off
+    static std::atomic<bool> FlightRecorderDumpRequested;
+    std::mutex DumpMutex; //Log, AddonLog and EvID are used by one dump at a time
+
+    std::vector<Event> Log; //merged events, filled for dump only
     std::vector<Event> AddonLog;
     std::map<mfxU32, std::vector<TimeInterval>> E2ELatency;
     std::map<mfxU32, std::vector<TimeInterval>> EncLatency;
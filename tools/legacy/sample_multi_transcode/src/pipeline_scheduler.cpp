@@ -0,0 +1,138 @@
+/*############################################################################
+  # Copyright (C) 2005 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "pipeline_scheduler.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace TranscodingSample {
+
+// pause of a worker which has no task ready to run
+static const std::chrono::milliseconds IdleInterval(1);
+
+PipelineScheduler::PipelineScheduler(mfxU32 numWorkers)
+        : m_Workers(),
+          m_Threads(),
+          m_bStop(false),
+          m_nextWorker(0),
+          m_CompletionMutex(),
+          m_CompletionCV(),
+          m_Completions() {
+    for (mfxU32 i = 0; i < std::max<mfxU32>(numWorkers, 1); i++) {
+        m_Workers.emplace_back(new Worker());
+    }
+}
+
+PipelineScheduler::~PipelineScheduler() {
+    Stop();
+}
+
+void PipelineScheduler::AddTask(mfxU32 taskID, StepFunction step) {
+    Task task = { taskID, std::move(step) };
+    PushTask(m_nextWorker, task);
+    m_nextWorker = (m_nextWorker + 1) % (mfxU32)m_Workers.size();
+}
+
+void PipelineScheduler::Start() {
+    m_bStop = false;
+    for (mfxU32 i = 0; i < (mfxU32)m_Workers.size(); i++) {
+        m_Threads.emplace_back(&PipelineScheduler::WorkerRoutine, this, i);
+    }
+}
+
+void PipelineScheduler::Stop() {
+    m_bStop = true;
+    for (auto& thread : m_Threads) {
+        thread.join();
+    }
+    m_Threads.clear();
+}
+
+void PipelineScheduler::Complete(mfxU32 taskID, mfxStatus sts) {
+    {
+        std::lock_guard<std::mutex> lock(m_CompletionMutex);
+        m_Completions.push_back({ taskID, sts });
+    }
+    m_CompletionCV.notify_one();
+}
+
+PipelineScheduler::Completion PipelineScheduler::WaitForCompletion() {
+    std::unique_lock<std::mutex> lock(m_CompletionMutex);
+    m_CompletionCV.wait(lock, [this] {
+        return !m_Completions.empty();
+    });
+    Completion completion = m_Completions.front();
+    m_Completions.pop_front();
+    return completion;
+}
+
+void PipelineScheduler::WorkerRoutine(mfxU32 workerID) {
+    // steps in a row which had nothing to do
+    size_t nNotReady = 0;
+
+    while (!m_bStop) {
+        Task task;
+        if (!PopTask(workerID, task) && !StealTask(workerID, task)) {
+            // all tasks are finished or run by the other workers
+            std::this_thread::sleep_for(IdleInterval);
+            continue;
+        }
+
+        mfxStatus sts = task.Step();
+        if (MFX_ERR_NONE != sts && MFX_WRN_IN_EXECUTION != sts) {
+            Complete(task.ID, sts);
+            nNotReady = 0;
+            continue;
+        }
+
+        nNotReady = (MFX_WRN_IN_EXECUTION == sts) ? nNotReady + 1 : 0;
+        PushTask(workerID, task);
+
+        // none of the tasks of the worker is ready, don't spin
+        bool bAllWait = false;
+        {
+            std::lock_guard<std::mutex> lock(m_Workers[workerID]->Mutex);
+            bAllWait = nNotReady >= m_Workers[workerID]->Tasks.size();
+        }
+        if (bAllWait) {
+            std::this_thread::sleep_for(IdleInterval);
+            nNotReady = 0;
+        }
+    }
+}
+
+bool PipelineScheduler::PopTask(mfxU32 workerID, Task& task) {
+    Worker& worker = *m_Workers[workerID];
+    std::lock_guard<std::mutex> lock(worker.Mutex);
+    if (worker.Tasks.empty())
+        return false;
+    task = std::move(worker.Tasks.front());
+    worker.Tasks.pop_front();
+    return true;
+}
+
+bool PipelineScheduler::StealTask(mfxU32 workerID, Task& task) {
+    for (mfxU32 i = 1; i < (mfxU32)m_Workers.size(); i++) {
+        Worker& victim = *m_Workers[(workerID + i) % m_Workers.size()];
+        std::lock_guard<std::mutex> lock(victim.Mutex);
+        // the owner takes tasks from the front, so take from the back
+        if (!victim.Tasks.empty()) {
+            task = std::move(victim.Tasks.back());
+            victim.Tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void PipelineScheduler::PushTask(mfxU32 workerID, Task& task) {
+    Worker& worker = *m_Workers[workerID];
+    std::lock_guard<std::mutex> lock(worker.Mutex);
+    worker.Tasks.push_back(std::move(task));
+}
+
+} // namespace TranscodingSample
@@ -12,6 +12,7 @@
 
 #include <assert.h>
 #include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <memory>
 #include <set>
@@ -152,6 +153,9 @@ CTranscodingPipeline::CTranscodingPipeline()
           m_DecOutAllocReques({ 0 }),
           m_VPPOutAllocReques({ 0 }),
           m_CSSurfacePools(),
+          m_DecPoolState(),
+          m_EncPoolState(),
+          m_CSPoolStates(),
           m_EncSurfaceType(0),
           m_DecSurfaceType(0),
           m_pPreEncAuxPool(),
@@ -205,6 +209,7 @@ CTranscodingPipeline::CTranscodingPipeline()
           m_rawInput(false),
           m_shouldUseShifted10BitEnc(false),
           m_pBSStore(),
+          m_pBSWriter(),
           m_FrameNumberPreference(0xFFFFFFFF),
           m_MaxFramesForTranscode(0xFFFFFFFF),
           m_MaxFramesForEncode(0),
@@ -550,12 +555,14 @@ mfxStatus CTranscodingPipeline::DecodeOneFrame(ExtendedSurface* pExtSurface) {
                                               SMTTracer::EventName::SURF_WAIT,
                                               nullptr,
                                               nullptr);
-            pExtSurface->pSurface = GetFreeSurface(false, MSDK_SURFACE_WAIT_INTERVAL);
+            pExtSurface->pSurface = GetFreeSurface(false, GetSurfaceWaitInterval());
             m_ScalerConfig.Tracer->EndEvent(SMTTracer::ThreadType::DEC,
                                             0,
                                             SMTTracer::EventName::SURF_WAIT,
                                             nullptr,
                                             nullptr);
+            if (!pExtSurface->pSurface && !m_TranscodeState.bWait && !m_bForceStop)
+                return MFX_WRN_IN_EXECUTION;
 
             m_ScalerConfig.Tracer->BeginEvent(SMTTracer::ThreadType::DEC,
                                               0,
@@ -573,6 +580,8 @@ mfxStatus CTranscodingPipeline::DecodeOneFrame(ExtendedSurface* pExtSurface) {
                 return sts;
         }
         else if (MFX_WRN_DEVICE_BUSY == sts) {
+            if (!m_TranscodeState.bWait)
+                return PostponeOnDeviceBusy();
             m_ScalerConfig.Tracer->BeginEvent(SMTTracer::ThreadType::DEC,
                                               0,
                                               SMTTracer::EventName::BUSY,
@@ -609,7 +618,7 @@ mfxStatus CTranscodingPipeline::DecodeOneFrame(ExtendedSurface* pExtSurface) {
                                                   SMTTracer::EventName::SURF_WAIT,
                                                   nullptr,
                                                   nullptr);
-                pmfxSurface = GetFreeSurface(true, MSDK_SURFACE_WAIT_INTERVAL);
+                pmfxSurface = GetFreeSurface(true, GetSurfaceWaitInterval());
                 m_ScalerConfig.Tracer->EndEvent(SMTTracer::ThreadType::DEC,
                                                 0,
                                                 SMTTracer::EventName::SURF_WAIT,
@@ -627,6 +636,10 @@ mfxStatus CTranscodingPipeline::DecodeOneFrame(ExtendedSurface* pExtSurface) {
                 sts = CheckStopCondition();
                 MSDK_BREAK_ON_ERROR(sts);
 
+                // RunStep() decodes the frame later
+                if (!pmfxSurface && !m_TranscodeState.bWait && !m_bForceStop)
+                    return MFX_WRN_IN_EXECUTION;
+
                 // return an error if a free surface wasn't found
                 MSDK_CHECK_POINTER_SAFE(
                     pmfxSurface,
@@ -701,17 +714,23 @@ mfxStatus CTranscodingPipeline::DecodeLastFrame(ExtendedSurface* pExtSurface) {
     // retrieve the buffered decoded frames
     while (MFX_ERR_MORE_SURFACE == sts || MFX_WRN_DEVICE_BUSY == sts) {
         if (m_rawInput) {
-            pExtSurface->pSurface = GetFreeSurface(false, MSDK_SURFACE_WAIT_INTERVAL);
-            sts                   = m_pBSProcessor->GetInputFrame(pExtSurface->pSurface);
+            pExtSurface->pSurface = GetFreeSurface(false, GetSurfaceWaitInterval());
+            if (!pExtSurface->pSurface && !m_TranscodeState.bWait && !m_bForceStop)
+                return MFX_WRN_IN_EXECUTION;
+            sts = m_pBSProcessor->GetInputFrame(pExtSurface->pSurface);
         }
         else if (MFX_WRN_DEVICE_BUSY == sts) {
+            if (!m_TranscodeState.bWait)
+                return PostponeOnDeviceBusy();
             WaitForDeviceToBecomeFree(*m_pmfxSession, m_LastDecSyncPoint, sts);
         }
 
         if (!m_rawInput) {
             if (m_MemoryModel == GENERAL_ALLOC) {
                 // find new working surface
-                pmfxSurface = GetFreeSurface(true, MSDK_SURFACE_WAIT_INTERVAL);
+                pmfxSurface = GetFreeSurface(true, GetSurfaceWaitInterval());
+                if (!pmfxSurface && !m_TranscodeState.bWait && !m_bForceStop)
+                    return MFX_WRN_IN_EXECUTION;
                 MSDK_CHECK_POINTER_SAFE(
                     pmfxSurface,
                     MFX_ERR_MEMORY_ALLOC,
@@ -767,7 +786,9 @@ mfxStatus CTranscodingPipeline::VPPOneFrame(ExtendedSurface* pSurfaceIn,
     if (m_MemoryModel == GENERAL_ALLOC || m_MemoryModel == VISIBLE_INT_ALLOC) {
         if (m_MemoryModel == GENERAL_ALLOC) {
             // find/wait for a free working surface
-            out_surface = GetFreeSurfaceForCS(false, MSDK_SURFACE_WAIT_INTERVAL, ID);
+            out_surface = GetFreeSurfaceForCS(false, GetSurfaceWaitInterval(), ID);
+            if (!out_surface && !m_TranscodeState.bWait && !m_bForceStop)
+                return MFX_WRN_IN_EXECUTION;
             MSDK_CHECK_POINTER_SAFE(
                 out_surface,
                 MFX_ERR_MEMORY_ALLOC,
@@ -863,6 +884,8 @@ mfxStatus CTranscodingPipeline::VPPOneFrame(ExtendedSurface* pSurfaceIn,
                  !out_surface)) // repeat the call if warning and no output
             {
                 if (MFX_WRN_DEVICE_BUSY == sts) {
+                    if (!m_TranscodeState.bWait)
+                        return PostponeOnDeviceBusy();
                     if (TargetID == DecoderTargetID && desc.CascadeScaler) {
                         m_ScalerConfig.Tracer->BeginEvent(SMTTracer::ThreadType::CSVPP,
                                                           desc.PoolID,
@@ -944,6 +967,8 @@ mfxStatus CTranscodingPipeline::EncodeOneFrame(ExtendedSurface* pExtSurface,
         if (MFX_ERR_NONE < sts && !pExtSurface->Syncp) // repeat the call if warning and no output
         {
             if (MFX_WRN_DEVICE_BUSY == sts) {
+                if (!m_TranscodeState.bWait)
+                    return PostponeOnDeviceBusy();
                 m_ScalerConfig.Tracer->BeginEvent(SMTTracer::ThreadType::ENC,
                                                   TargetID,
                                                   SMTTracer::EventName::BUSY,
@@ -1013,6 +1038,7 @@ void CTranscodingPipeline::NoMoreFramesSignal() {
 void CTranscodingPipeline::StopSession() {
     std::lock_guard<std::mutex> guard(m_mStopSession);
     m_bForceStop = true;
+    m_FreeSurfaceNotifier.Notify();
 
     msdk_stringstream ss;
     ss << MSDK_STRING("session [") << GetSessionText() << MSDK_STRING("] m_bForceStop is set")
@@ -1276,6 +1302,7 @@ mfxStatus CTranscodingPipeline::Decode() {
             HandlePossibleGpuHang(sts);
             PreEncExtSurface.Syncp = NULL;
             MSDK_CHECK_ERR_NONE_STATUS(sts, MFX_ERR_ABORTED, "PreEnc: SyncOperation failed");
+            m_FreeSurfaceNotifier.Notify();
         }
 
         // add surfaces in queue for all sinks
@@ -1287,6 +1314,7 @@ mfxStatus CTranscodingPipeline::Decode() {
                     DecreaseReference(*s.pSurface);
                 }
             }
+            m_FreeSurfaceNotifier.Notify();
 
             //build list of output buffers and reverse it to match order of output surfaces
             std::vector<SafetySurfaceBuffer*> buf;
@@ -1302,20 +1330,20 @@ mfxStatus CTranscodingPipeline::Decode() {
                 if (buf[i]->TargetID != OutSurfaces[i].TargetID) {
                     return MFX_ERR_UNKNOWN;
                 }
-                buf[i]->AddSurface(OutSurfaces[i]);
+                buf[i]->AddSurface(OutSurfaces[i], &m_FreeSurfaceNotifier);
             }
 
             OutSurfaces.clear();
         }
         else {
-            pNextBuffer->AddSurface(PreEncExtSurface);
+            pNextBuffer->AddSurface(PreEncExtSurface, &m_FreeSurfaceNotifier);
             /* one of key parts for N_to_1 mode:
             * decoded frame should be in one buffer only as we have only 1 (one!) sink
             * */
             if (0 == m_nVPPCompMode) {
                 while (pNextBuffer->m_pNext) {
                     pNextBuffer = pNextBuffer->m_pNext;
-                    pNextBuffer->AddSurface(PreEncExtSurface);
+                    pNextBuffer->AddSurface(PreEncExtSurface, &m_FreeSurfaceNotifier);
                 }
             }
         }
@@ -1350,6 +1378,7 @@ mfxStatus CTranscodingPipeline::Decode() {
                 HandlePossibleGpuHang(sts);
                 MSDK_CHECK_ERR_NONE_STATUS(sts, MFX_ERR_ABORTED, "SyncOperation failed");
                 frontSurface.Syncp = NULL;
+                m_FreeSurfaceNotifier.Notify();
             }
         }
 
@@ -1439,6 +1468,7 @@ mfxStatus CTranscodingPipeline::Encode() {
                     MSDK_CHECK_ERR_NONE_STATUS(sts,
                                                MFX_ERR_ABORTED,
                                                "Encode: SyncOperation failed");
+                    m_pParentPipeline->m_FreeSurfaceNotifier.Notify();
                 }
             }
 
@@ -1506,6 +1536,7 @@ mfxStatus CTranscodingPipeline::Encode() {
                 sts = m_pmfxSession->SyncOperation(VppExtSurface.Syncp, GetSyncOpTimeout());
                 HandlePossibleGpuHang(sts);
                 MSDK_CHECK_ERR_NONE_STATUS(sts, MFX_ERR_ABORTED, "VPP: SyncOperation failed");
+                m_FreeSurfaceNotifier.Notify();
                 if (m_pSurfaceUtilizationSynchronizer && m_MemoryModel != GENERAL_ALLOC) {
                     m_pSurfaceUtilizationSynchronizer->NotifyFreeCome();
                 }
@@ -1538,6 +1569,10 @@ mfxStatus CTranscodingPipeline::Encode() {
         mfxU32 NumFramesForReset =
             m_pParentPipeline ? m_pParentPipeline->GetNumFramesForReset() : 0;
         if (NumFramesForReset && !(m_nProcessedFramesNum % NumFramesForReset)) {
+            if (m_pBSWriter) {
+                sts = m_pBSWriter->Flush();
+                MSDK_CHECK_STATUS(sts, "m_pBSWriter->Flush failed");
+            }
             m_pBSProcessor->ResetOutput();
         }
 
@@ -1677,6 +1712,10 @@ mfxStatus CTranscodingPipeline::Encode() {
                 sts = PutBS();
                 MSDK_CHECK_STATUS(sts, "PutBS failed");
             }
+            if (m_pBSWriter) {
+                sts = m_pBSWriter->Flush();
+                MSDK_CHECK_STATUS(sts, "m_pBSWriter->Flush failed");
+            }
         }
     }
 
@@ -1879,220 +1918,317 @@ void CTranscodingPipeline::SetEncCtrlRT(ExtendedSurface& extSurface, bool bInser
 }
 
 mfxStatus CTranscodingPipeline::Transcode() {
-    mfxStatus sts                 = MFX_ERR_NONE;
-    ExtendedSurface DecExtSurface = { 0 };
-    ExtendedSurface VppExtSurface = { 0 };
-    ExtendedBS* pBS               = NULL;
-    bool bNeedDecodedFrames       = true; // indicates if we need to decode frames
-    bool bEndOfFile               = false;
-    bool bLastCycle               = false;
-    bool shouldReadNextFrame      = true;
-
-    time_t start = time(0);
-    while (MFX_ERR_NONE == sts) {
-        msdk_tick nBeginTime = msdk_time_get_tick(); // microseconds.
+    mfxStatus sts = MFX_ERR_NONE;
 
-        if (time(0) - start >= m_nTimeout)
-            bLastCycle = true;
-        if (m_MaxFramesForTranscode == m_nProcessedFramesNum) {
-            DecExtSurface.pSurface = NULL; // to get buffered VPP or ENC frames
-            bNeedDecodedFrames     = false; // no more decoded frames needed
+    m_TranscodeState       = TranscodeState();
+    m_TranscodeState.start = time(0);
+
+    bool bFinished = false;
+    bool bReady    = true;
+    while (MFX_ERR_NONE == sts && !bFinished) {
+        sts = TranscodeOneFrame(true, bFinished, bReady);
+    }
+
+    return TranscodeFinish(sts);
+} // mfxStatus CTranscodingPipeline::Transcode()
+
+mfxStatus CTranscodingPipeline::TranscodeOneFrame(bool bWait, bool& bFinished, bool& bReady) {
+    mfxStatus sts                  = MFX_ERR_NONE;
+    ExtendedSurface& DecExtSurface = m_TranscodeState.DecExtSurface;
+    ExtendedSurface& VppExtSurface = m_TranscodeState.VppExtSurface;
+    ExtendedBS* pBS                = NULL;
+    bool& bNeedDecodedFrames       = m_TranscodeState.bNeedDecodedFrames;
+    bool& bEndOfFile               = m_TranscodeState.bEndOfFile;
+    bool& bLastCycle               = m_TranscodeState.bLastCycle;
+    bool& shouldReadNextFrame      = m_TranscodeState.shouldReadNextFrame;
+    time_t start                   = m_TranscodeState.start;
+
+    bFinished              = false;
+    bReady                 = true;
+    m_TranscodeState.bWait = bWait;
+
+    // encoder was busy in the previous call
+    if (m_TranscodeState.bEncodePending)
+        return TranscodeEncodeFrame(bWait, bFinished, bReady);
+
+    // output of the previous iteration wasn't ready
+    if (m_BSPool.size() == m_AsyncDepth) {
+        sts = PutBS(bWait);
+        if (!bWait && MFX_WRN_IN_EXECUTION == sts) {
+            bReady = false;
+            return MFX_ERR_NONE;
         }
+        MSDK_CHECK_STATUS(sts, "PutBS failed");
+        if (MFX_ERR_NONE != sts)
+            return sts;
+    }
+    if (!bWait && msdk_time_get_tick() < m_TranscodeState.nNextFrameTime) {
+        bReady = false;
+        return MFX_ERR_NONE;
+    }
 
-        // if need more decoded frames
-        // decode a frame
-        if (bNeedDecodedFrames && shouldReadNextFrame) {
-            if (!bEndOfFile) {
-                sts = DecodeOneFrame(&DecExtSurface);
-                if (MFX_ERR_MORE_DATA == sts) {
-                    if (!bLastCycle) {
-                        m_bInsertIDR = true;
+    m_TranscodeState.nFrameBeginTime = msdk_time_get_tick(); // microseconds.
 
-                        m_pBSProcessor->ResetInput();
-                        m_pBSProcessor->ResetOutput();
-                        bNeedDecodedFrames = true;
+    if (time(0) - start >= m_nTimeout)
+        bLastCycle = true;
+    if (m_MaxFramesForTranscode == m_nProcessedFramesNum) {
+        DecExtSurface.pSurface = NULL; // to get buffered VPP or ENC frames
+        bNeedDecodedFrames     = false; // no more decoded frames needed
+    }
 
-                        bEndOfFile = false;
-                        sts        = MFX_ERR_NONE;
-                        continue;
-                    }
-                    else {
-                        bEndOfFile = true;
-                    }
-                }
-            }
+    // if need more decoded frames
+    // decode a frame
+    if (bNeedDecodedFrames && shouldReadNextFrame) {
+        if (!bEndOfFile) {
+            sts = DecodeOneFrame(&DecExtSurface);
+            if (MFX_ERR_MORE_DATA == sts) {
+                if (!bLastCycle) {
+                    m_bInsertIDR = true;
 
-            if (bEndOfFile) {
-                sts = DecodeLastFrame(&DecExtSurface);
-            }
+                    if (m_pBSWriter) {
+                        sts = m_pBSWriter->Flush();
+                        MSDK_CHECK_STATUS(sts, "m_pBSWriter->Flush failed");
+                    }
+                    m_pBSProcessor->ResetInput();
+                    m_pBSProcessor->ResetOutput();
+                    bNeedDecodedFrames = true;
 
-            if (sts == MFX_ERR_MORE_DATA) {
-                DecExtSurface.pSurface = NULL; // to get buffered VPP or ENC frames
-                sts                    = MFX_ERR_NONE;
+                    bEndOfFile = false;
+                    sts        = MFX_ERR_NONE;
+                    return sts;
+                }
+                else {
+                    bEndOfFile = true;
+                }
             }
-            MSDK_CHECK_STATUS(sts, "Decode<One|Last>Frame failed");
         }
-        if (m_bIsFieldWeaving && DecExtSurface.pSurface != NULL) {
-            m_mfxDecParams.mfx.FrameInfo.PicStruct = DecExtSurface.pSurface->Info.PicStruct;
+
+        if (bEndOfFile) {
+            sts = DecodeLastFrame(&DecExtSurface);
         }
-        if (m_bIsFieldSplitting && DecExtSurface.pSurface != NULL) {
-            m_mfxDecParams.mfx.FrameInfo.PicStruct = DecExtSurface.pSurface->Info.PicStruct;
+
+        // no free surface or the device is busy, decoding is repeated by the next call
+        if (MFX_WRN_IN_EXECUTION == sts) {
+            bReady = false;
+            return MFX_ERR_NONE;
         }
-        // pre-process a frame
-        if (m_pmfxVPP.get() && bNeedDecodedFrames && !m_rawInput) {
-            if (m_bIsFieldWeaving) {
-                // In case of field weaving output surface's parameters for ODD calls to VPPOneFrame will be ignored (because VPP will return ERR_MORE_DATA).
-                // So, we need to set output surface picstruct properly for EVEN calls (no matter what will be set for ODD calls).
-                // We might have 2 cases: decoder gives us pairs (TF BF)... or (BF)(TF). In first case we should set TFF for output, in second - BFF.
-                // So, if even input surface is BF, we set TFF for output and vise versa. For odd input surface - no matter what we set.
-                if (DecExtSurface.pSurface) {
-                    if ((DecExtSurface.pSurface->Info.PicStruct &
-                         MFX_PICSTRUCT_FIELD_TFF)) // Incoming Top Field in a single surface
-                    {
-                        m_mfxVppParams.vpp.Out.PicStruct = MFX_PICSTRUCT_FIELD_BFF;
-                    }
-                    if (DecExtSurface.pSurface->Info.PicStruct &
-                        MFX_PICSTRUCT_FIELD_BFF) // Incoming Bottom Field in a single surface
-                    {
-                        m_mfxVppParams.vpp.Out.PicStruct = MFX_PICSTRUCT_FIELD_TFF;
-                    }
+
+        if (sts == MFX_ERR_MORE_DATA) {
+            DecExtSurface.pSurface = NULL; // to get buffered VPP or ENC frames
+            sts                    = MFX_ERR_NONE;
+        }
+        MSDK_CHECK_STATUS(sts, "Decode<One|Last>Frame failed");
+    }
+    if (m_bIsFieldWeaving && DecExtSurface.pSurface != NULL) {
+        m_mfxDecParams.mfx.FrameInfo.PicStruct = DecExtSurface.pSurface->Info.PicStruct;
+    }
+    if (m_bIsFieldSplitting && DecExtSurface.pSurface != NULL) {
+        m_mfxDecParams.mfx.FrameInfo.PicStruct = DecExtSurface.pSurface->Info.PicStruct;
+    }
+    // pre-process a frame
+    if (m_pmfxVPP.get() && bNeedDecodedFrames && !m_rawInput) {
+        if (m_bIsFieldWeaving) {
+            // In case of field weaving output surface's parameters for ODD calls to VPPOneFrame will be ignored (because VPP will return ERR_MORE_DATA).
+            // So, we need to set output surface picstruct properly for EVEN calls (no matter what will be set for ODD calls).
+            // We might have 2 cases: decoder gives us pairs (TF BF)... or (BF)(TF). In first case we should set TFF for output, in second - BFF.
+            // So, if even input surface is BF, we set TFF for output and vise versa. For odd input surface - no matter what we set.
+            if (DecExtSurface.pSurface) {
+                if ((DecExtSurface.pSurface->Info.PicStruct &
+                     MFX_PICSTRUCT_FIELD_TFF)) // Incoming Top Field in a single surface
+                {
+                    m_mfxVppParams.vpp.Out.PicStruct = MFX_PICSTRUCT_FIELD_BFF;
+                }
+                if (DecExtSurface.pSurface->Info.PicStruct &
+                    MFX_PICSTRUCT_FIELD_BFF) // Incoming Bottom Field in a single surface
+                {
+                    m_mfxVppParams.vpp.Out.PicStruct = MFX_PICSTRUCT_FIELD_TFF;
                 }
-                sts = VPPOneFrame(&DecExtSurface, &VppExtSurface);
             }
-            else {
-                if (m_bIsFieldSplitting) {
-                    if (DecExtSurface.pSurface) {
-                        if (DecExtSurface.pSurface->Info.PicStruct & MFX_PICSTRUCT_FIELD_TFF ||
-                            DecExtSurface.pSurface->Info.PicStruct & MFX_PICSTRUCT_FIELD_BFF) {
-                            m_mfxVppParams.vpp.Out.PicStruct = MFX_PICSTRUCT_FIELD_SINGLE;
-                            sts = VPPOneFrame(&DecExtSurface, &VppExtSurface);
-                        }
-                        else {
-                            VppExtSurface.pSurface = DecExtSurface.pSurface;
-                            VppExtSurface.pAuxCtrl = DecExtSurface.pAuxCtrl;
-                            VppExtSurface.Syncp    = DecExtSurface.Syncp;
-                        }
+            sts = VPPOneFrame(&DecExtSurface, &VppExtSurface);
+        }
+        else {
+            if (m_bIsFieldSplitting) {
+                if (DecExtSurface.pSurface) {
+                    if (DecExtSurface.pSurface->Info.PicStruct & MFX_PICSTRUCT_FIELD_TFF ||
+                        DecExtSurface.pSurface->Info.PicStruct & MFX_PICSTRUCT_FIELD_BFF) {
+                        m_mfxVppParams.vpp.Out.PicStruct = MFX_PICSTRUCT_FIELD_SINGLE;
+                        sts = VPPOneFrame(&DecExtSurface, &VppExtSurface);
                     }
                     else {
-                        sts = VPPOneFrame(&DecExtSurface, &VppExtSurface);
+                        VppExtSurface.pSurface = DecExtSurface.pSurface;
+                        VppExtSurface.pAuxCtrl = DecExtSurface.pAuxCtrl;
+                        VppExtSurface.Syncp    = DecExtSurface.Syncp;
                     }
                 }
                 else {
                     sts = VPPOneFrame(&DecExtSurface, &VppExtSurface);
                 }
             }
-            // check for interlaced stream
-
-            if (m_MemoryModel != GENERAL_ALLOC && DecExtSurface.pSurface) {
-                mfxStatus sts_release =
-                    DecExtSurface.pSurface->FrameInterface->Release(DecExtSurface.pSurface);
-                MSDK_CHECK_STATUS(sts_release, "FrameInterface->Release failed");
+            else {
+                sts = VPPOneFrame(&DecExtSurface, &VppExtSurface);
             }
         }
-        else // no VPP - just copy pointers
-        {
-            VppExtSurface.pSurface = DecExtSurface.pSurface;
-            VppExtSurface.pAuxCtrl = DecExtSurface.pAuxCtrl;
-            VppExtSurface.Syncp    = DecExtSurface.Syncp;
-        }
+        // check for interlaced stream
 
-        if (MFX_ERR_MORE_SURFACE == sts) {
+        // VPP is repeated with the same input by the next call
+        if (MFX_WRN_IN_EXECUTION == sts) {
             shouldReadNextFrame = false;
-            sts                 = MFX_ERR_NONE;
+            bReady              = false;
+            return MFX_ERR_NONE;
         }
-        else {
-            shouldReadNextFrame = true;
+
+        if (m_MemoryModel != GENERAL_ALLOC && DecExtSurface.pSurface) {
+            mfxStatus sts_release =
+                DecExtSurface.pSurface->FrameInterface->Release(DecExtSurface.pSurface);
+            MSDK_CHECK_STATUS(sts_release, "FrameInterface->Release failed");
         }
+    }
+    else // no VPP - just copy pointers
+    {
+        VppExtSurface.pSurface = DecExtSurface.pSurface;
+        VppExtSurface.pAuxCtrl = DecExtSurface.pAuxCtrl;
+        VppExtSurface.Syncp    = DecExtSurface.Syncp;
+    }
 
-        if (sts == MFX_ERR_MORE_DATA) {
-            sts = MFX_ERR_NONE;
-            if (NULL == DecExtSurface.pSurface) // there are no more buffered frames in VPP
-            {
-                VppExtSurface.pSurface = NULL; // to get buffered ENC frames
-            }
-            else {
-                continue; // go get next frame from Decode
-            }
+    if (MFX_ERR_MORE_SURFACE == sts) {
+        shouldReadNextFrame = false;
+        sts                 = MFX_ERR_NONE;
+    }
+    else {
+        shouldReadNextFrame = true;
+    }
+
+    if (sts == MFX_ERR_MORE_DATA) {
+        sts = MFX_ERR_NONE;
+        if (NULL == DecExtSurface.pSurface) // there are no more buffered frames in VPP
+        {
+            VppExtSurface.pSurface = NULL; // to get buffered ENC frames
+        }
+        else {
+            return sts; // go get next frame from Decode
         }
+    }
 
-        MSDK_CHECK_STATUS(sts, "Unexpected error!!");
+    MSDK_CHECK_STATUS(sts, "Unexpected error!!");
 
-        // encode frame
-        pBS = m_pBSStore->GetNext();
-        if (!pBS)
-            return MFX_ERR_NOT_FOUND;
+    // encode frame
+    pBS = m_pBSStore->GetNext();
+    if (!pBS)
+        return MFX_ERR_NOT_FOUND;
 
-        m_BSPool.push_back(pBS);
+    m_BSPool.push_back(pBS);
 
-        // Set Encoding control if it is required.
+    // Set Encoding control if it is required.
 
-        SetEncCtrlRT(VppExtSurface, m_bInsertIDR);
-        m_bInsertIDR = false;
+    SetEncCtrlRT(VppExtSurface, m_bInsertIDR);
+    m_bInsertIDR = false;
 
-        if (DecExtSurface.pSurface)
-            m_nProcessedFramesNum++;
+    if (DecExtSurface.pSurface)
+        m_nProcessedFramesNum++;
 
-        if (m_mfxEncParams.mfx.CodecId != MFX_CODEC_DUMP) {
-            sts = EncodeOneFrame(&VppExtSurface, &m_BSPool.back()->Bitstream);
-        }
-        else {
-            sts = Surface2BS(&VppExtSurface, &m_BSPool.back()->Bitstream, m_encoderFourCC);
-        }
+    m_TranscodeState.bEncodePending = true;
+    return TranscodeEncodeFrame(bWait, bFinished, bReady);
+} // mfxStatus CTranscodingPipeline::TranscodeOneFrame()
 
-        if (m_MemoryModel != GENERAL_ALLOC && VppExtSurface.pSurface) {
-            mfxStatus sts_release =
-                VppExtSurface.pSurface->FrameInterface->Release(VppExtSurface.pSurface);
-            MSDK_CHECK_STATUS(sts_release, "FrameInterface->Release failed");
-        }
+mfxStatus CTranscodingPipeline::TranscodeEncodeFrame(bool bWait, bool& bFinished, bool& bReady) {
+    mfxStatus sts                  = MFX_ERR_NONE;
+    ExtendedSurface& VppExtSurface = m_TranscodeState.VppExtSurface;
+    ExtendedBS* pBS                = m_BSPool.back();
 
-        // check if we need one more frame from decode
-        if (MFX_ERR_MORE_DATA == sts) {
-            // the task in not in Encode queue
-            m_BSPool.pop_back();
-            m_pBSStore->Release(pBS);
+    if (m_mfxEncParams.mfx.CodecId != MFX_CODEC_DUMP) {
+        sts = EncodeOneFrame(&VppExtSurface, &m_BSPool.back()->Bitstream);
+    }
+    else {
+        sts = Surface2BS(&VppExtSurface, &m_BSPool.back()->Bitstream, m_encoderFourCC);
+    }
 
-            if (NULL == VppExtSurface.pSurface) // there are no more buffered frames in encoder
-            {
-                break;
-            }
-            sts = MFX_ERR_NONE;
-            continue;
-        }
+    // the same frame is encoded by the next call
+    if (MFX_WRN_IN_EXECUTION == sts) {
+        bReady = false;
+        return MFX_ERR_NONE;
+    }
+    m_TranscodeState.bEncodePending   = false;
+    m_TranscodeState.nDeviceBusySince = 0;
 
-        // check encoding result
-        MSDK_CHECK_STATUS(sts, "<EncodeOneFrame|Surface2BS> failed");
+    if (m_MemoryModel != GENERAL_ALLOC && VppExtSurface.pSurface) {
+        mfxStatus sts_release =
+            VppExtSurface.pSurface->FrameInterface->Release(VppExtSurface.pSurface);
+        MSDK_CHECK_STATUS(sts_release, "FrameInterface->Release failed");
+    }
 
-        if (statisticsWindowSize) {
-            if ((statisticsWindowSize && m_nOutputFramesNum &&
-                 0 == m_nProcessedFramesNum % statisticsWindowSize) ||
-                (statisticsWindowSize && (m_nProcessedFramesNum >= m_MaxFramesForTranscode))) {
-                inputStatistics.PrintStatistics(GetPipelineID());
-                outputStatistics.PrintStatistics(
-                    GetPipelineID(),
-                    (m_mfxEncParams.mfx.FrameInfo.FrameRateExtD)
-                        ? (mfxF64)m_mfxEncParams.mfx.FrameInfo.FrameRateExtN /
-                              (mfxF64)m_mfxEncParams.mfx.FrameInfo.FrameRateExtD
-                        : -1);
-                inputStatistics.ResetStatistics();
-                outputStatistics.ResetStatistics();
-            }
-        }
-        else if (0 == (m_nProcessedFramesNum - 1) % 100) {
-            msdk_printf(MSDK_STRING("."));
+    // check if we need one more frame from decode
+    if (MFX_ERR_MORE_DATA == sts) {
+        // the task in not in Encode queue
+        m_BSPool.pop_back();
+        m_pBSStore->Release(pBS);
+
+        if (NULL == VppExtSurface.pSurface) // there are no more buffered frames in encoder
+        {
+            bFinished = true;
+            return sts;
         }
+        sts = MFX_ERR_NONE;
+        return sts;
+    }
 
-        m_BSPool.back()->Syncp = VppExtSurface.Syncp;
+    // check encoding result
+    MSDK_CHECK_STATUS(sts, "<EncodeOneFrame|Surface2BS> failed");
 
-        if (m_BSPool.size() == m_AsyncDepth) {
-            sts = PutBS();
-            MSDK_CHECK_STATUS(sts, "PutBS failed");
+    if (statisticsWindowSize) {
+        if ((statisticsWindowSize && m_nOutputFramesNum &&
+             0 == m_nProcessedFramesNum % statisticsWindowSize) ||
+            (statisticsWindowSize && (m_nProcessedFramesNum >= m_MaxFramesForTranscode))) {
+            inputStatistics.PrintStatistics(GetPipelineID());
+            outputStatistics.PrintStatistics(
+                GetPipelineID(),
+                (m_mfxEncParams.mfx.FrameInfo.FrameRateExtD)
+                    ? (mfxF64)m_mfxEncParams.mfx.FrameInfo.FrameRateExtN /
+                          (mfxF64)m_mfxEncParams.mfx.FrameInfo.FrameRateExtD
+                    : -1);
+            inputStatistics.ResetStatistics();
+            outputStatistics.ResetStatistics();
         }
+    }
+    else if (0 == (m_nProcessedFramesNum - 1) % 100) {
+        msdk_printf(MSDK_STRING("."));
+    }
 
-        msdk_tick nFrameTime = msdk_time_get_tick() - nBeginTime;
-        if (nFrameTime < m_nReqFrameTime) {
+    m_BSPool.back()->Syncp = VppExtSurface.Syncp;
+
+    if (m_BSPool.size() == m_AsyncDepth) {
+        sts = PutBS(bWait);
+        // otherwise it's written by the next call
+        if (!bWait && MFX_WRN_IN_EXECUTION == sts)
+            sts = MFX_ERR_NONE;
+        MSDK_CHECK_STATUS(sts, "PutBS failed");
+    }
+
+    msdk_tick nBeginTime = m_TranscodeState.nFrameBeginTime;
+    msdk_tick nFrameTime = msdk_time_get_tick() - nBeginTime;
+    if (nFrameTime < m_nReqFrameTime) {
+        if (bWait)
             MSDK_USLEEP((mfxU32)(m_nReqFrameTime - nFrameTime));
-        }
+        else
+            m_TranscodeState.nNextFrameTime = nBeginTime + m_nReqFrameTime;
     }
+
+    return sts;
+} // mfxStatus CTranscodingPipeline::TranscodeEncodeFrame()
+
+mfxStatus CTranscodingPipeline::PostponeOnDeviceBusy() {
+    msdk_tick now = msdk_time_get_tick();
+    if (!m_TranscodeState.nDeviceBusySince) {
+        m_TranscodeState.nDeviceBusySince = now;
+    }
+    else if ((mfxF64)(now - m_TranscodeState.nDeviceBusySince) / msdk_time_get_frequency() >
+             (mfxF64)GetSyncOpTimeout() / 1000) {
+        msdk_printf(MSDK_STRING("ERROR: Device busy (during long period)\n"));
+        return MFX_ERR_DEVICE_FAILED;
+    }
+    return MFX_WRN_IN_EXECUTION;
+} // mfxStatus CTranscodingPipeline::PostponeOnDeviceBusy()
+
+mfxStatus CTranscodingPipeline::TranscodeFinish(mfxStatus sts) {
     MSDK_IGNORE_MFX_STS(sts, MFX_ERR_MORE_DATA);
 
     // need to get buffered bitstream
@@ -2101,36 +2237,48 @@ mfxStatus CTranscodingPipeline::Transcode() {
             sts = PutBS();
             MSDK_CHECK_STATUS(sts, "PutBS failed");
         }
+        if (m_pBSWriter) {
+            sts = m_pBSWriter->Flush();
+            MSDK_CHECK_STATUS(sts, "m_pBSWriter->Flush failed");
+        }
     }
 
     if (MFX_ERR_NONE == sts)
         sts = MFX_WRN_VALUE_NOT_CHANGED;
 
     return sts;
-} // mfxStatus CTranscodingPipeline::Transcode()
+} // mfxStatus CTranscodingPipeline::TranscodeFinish()
 
-mfxStatus CTranscodingPipeline::PutBS() {
+mfxStatus CTranscodingPipeline::PutBS(bool bWait) {
     mfxStatus sts            = MFX_ERR_NONE;
     ExtendedBS* pBitstreamEx = m_BSPool.front();
     MSDK_CHECK_POINTER(pBitstreamEx, MFX_ERR_NULL_PTR);
 
     // get result coded stream, synchronize only if we still have sync point
     if (pBitstreamEx->Syncp) {
-        m_ScalerConfig.Tracer->BeginEvent(SMTTracer::ThreadType::ENC,
-                                          TargetID,
-                                          SMTTracer::EventName::SYNC,
-                                          pBitstreamEx->Syncp,
-                                          nullptr);
-        sts = m_pmfxSession->SyncOperation(pBitstreamEx->Syncp, GetSyncOpTimeout());
+        if (bWait) {
+            m_ScalerConfig.Tracer->BeginEvent(SMTTracer::ThreadType::ENC,
+                                              TargetID,
+                                              SMTTracer::EventName::SYNC,
+                                              pBitstreamEx->Syncp,
+                                              nullptr);
+            sts = m_pmfxSession->SyncOperation(pBitstreamEx->Syncp, GetSyncOpTimeout());
 
-        m_ScalerConfig.Tracer->EndEvent(SMTTracer::ThreadType::ENC,
-                                        TargetID,
-                                        SMTTracer::EventName::SYNC,
-                                        pBitstreamEx->Syncp,
-                                        nullptr);
+            m_ScalerConfig.Tracer->EndEvent(SMTTracer::ThreadType::ENC,
+                                            TargetID,
+                                            SMTTracer::EventName::SYNC,
+                                            pBitstreamEx->Syncp,
+                                            nullptr);
+        }
+        else {
+            sts = m_pmfxSession->SyncOperation(pBitstreamEx->Syncp, 0);
+            if (MFX_WRN_IN_EXECUTION == sts)
+                return sts;
+        }
         m_ScalerConfig.Tracer->AfterEncodeSync();
         HandlePossibleGpuHang(sts);
         MSDK_CHECK_ERR_NONE_STATUS(sts, MFX_ERR_ABORTED, "Encode: SyncOperation failed");
+        NotifySurfacesUnlocked();
         if (m_pSurfaceUtilizationSynchronizer && m_MemoryModel != GENERAL_ALLOC) {
             m_pSurfaceUtilizationSynchronizer->NotifyFreeCome();
         }
@@ -2144,6 +2292,17 @@ mfxStatus CTranscodingPipeline::PutBS() {
         outputStatistics.StartTimeMeasurement();
     }
 
+    if (m_pBSWriter) {
+        UnPreEncAuxBuffer(pBitstreamEx->pCtrl);
+
+        if (m_BSPool.size())
+            m_BSPool.pop_front();
+        // the writer releases the bitstream to m_pBSStore once it's written
+        sts = m_pBSWriter->Push(pBitstreamEx);
+        MSDK_CHECK_STATUS(sts, "m_pBSWriter->Push failed");
+        return sts;
+    }
+
     sts = m_pBSProcessor->ProcessOutputBitstream(&pBitstreamEx->Bitstream);
     MSDK_CHECK_STATUS(sts, "m_pBSProcessor->ProcessOutputBitstream failed");
 
@@ -2157,7 +2316,7 @@ mfxStatus CTranscodingPipeline::PutBS() {
     m_pBSStore->Release(pBitstreamEx);
 
     return sts;
-} //mfxStatus CTranscodingPipeline::PutBS()
+} //mfxStatus CTranscodingPipeline::PutBS(bool bWait)
 
 mfxStatus CTranscodingPipeline::DumpSurface2File(mfxFrameSurface1* pSurf) {
     mfxStatus sts = MFX_ERR_NONE;
@@ -2200,6 +2359,7 @@ mfxStatus CTranscodingPipeline::Surface2BS(ExtendedSurface* pSurf,
         HandlePossibleGpuHang(sts);
         MSDK_CHECK_ERR_NONE_STATUS(sts, MFX_ERR_ABORTED, "SyncOperation failed");
         pSurf->Syncp = 0;
+        NotifySurfacesUnlocked();
 
         if (!m_pBSProcessor->IsNulOutput()) {
             //--- Copying data from surface to bitstream
@@ -3820,6 +3980,8 @@ void CTranscodingPipeline::CorrectNumberOfAllocatedFrames(mfxFrameAllocRequest*
 }
 
 void CTranscodingPipeline::FreeFrames() {
+    m_FreeSurfaceNotifier.RemovePools();
+
     std::for_each(m_pSurfaceDecPool.begin(), m_pSurfaceDecPool.end(), [](mfxFrameSurface1* s) {
         auto surface = static_cast<mfxFrameSurfaceWrap*>(s);
         delete surface;
@@ -3936,7 +4098,18 @@ mfxStatus CTranscodingPipeline::Init(sInputParams* pParams,
         statisticsWindowSize = m_MaxFramesForTranscode;
 
     if (m_bEncodeEnable) {
-        m_pBSStore.reset(new ExtendedBSStore(m_AsyncDepth));
+        // bitstreams queued for the writer thread are taken from the same store
+        m_pBSWriter.reset();
+        m_pBSStore.reset(new ExtendedBSStore(m_AsyncDepth + pParams->nOutputQueueDepth));
+        if (pParams->nOutputQueueDepth && !m_pBSProcessor->IsNulOutput()) {
+            m_pBSWriter.reset(new AsyncBitstreamWriter(m_pBSProcessor,
+                                                       m_pBSStore.get(),
+                                                       pParams->nOutputQueueDepth));
+            m_pBSWriter->SetStatistics(statisticsWindowSize,
+                                       pParams->statisticsLogFile,
+                                       pParams->DumpLogFileName);
+            m_pBSWriter->SetPipelineID(GetPipelineID());
+        }
     }
 
     // Determine processing mode
@@ -4355,47 +4528,11 @@ mfxStatus CTranscodingPipeline::CompleteInit() {
     return sts;
 } // mfxStatus CTranscodingPipeline::CompleteInit()
 mfxFrameSurface1* CTranscodingPipeline::GetFreeSurface(bool isDec, mfxU64 timeout) {
-    mfxFrameSurface1* pSurf = NULL;
-
-    CTimer t;
-    t.Start();
-    do {
-        {
-            std::lock_guard<std::mutex> lock(m_mStopSession);
-            if (m_bForceStop) {
-                msdk_printf(MSDK_STRING(
-                    "WARNING: m_bForceStop is set, returning NULL ptr from GetFreeSurface\n"));
-                break;
-            }
-        }
-
-        SurfPointersArray& workArray = isDec ? m_pSurfaceDecPool : m_pSurfaceEncPool;
-
-        int available =
-            (int)std::count_if(workArray.begin(), workArray.end(), [](mfxFrameSurface1* s) {
-                return s->Data.Locked == 0;
-            });
-        m_ScalerConfig.Tracer->AddCounterEvent(
-            isDec ? SMTTracer::ThreadType::DEC : SMTTracer::ThreadType::ENC,
-            TargetID,
-            SMTTracer::EventName::UNDEF,
-            available);
-
-        for (mfxU32 i = 0; i < workArray.size(); i++) {
-            if (!workArray[i]->Data.Locked) {
-                pSurf = workArray[i];
-                break;
-            }
-        }
-        if (pSurf) {
-            break;
-        }
-        else {
-            MSDK_SLEEP(TIME_TO_SLEEP);
-        }
-    } while (t.GetTime() < timeout / 1000);
-
-    return pSurf;
+    return GetFreeSurfaceFromPool(isDec ? m_pSurfaceDecPool : m_pSurfaceEncPool,
+                                  isDec ? m_DecPoolState : m_EncPoolState,
+                                  isDec ? SMTTracer::ThreadType::DEC : SMTTracer::ThreadType::ENC,
+                                  TargetID,
+                                  timeout);
 } // mfxFrameSurface1* CTranscodingPipeline::GetFreeSurface(bool isDec)
 
 mfxFrameSurface1* CTranscodingPipeline::GetFreeSurfaceForCS(bool isDec, mfxU64 timeout, mfxU32 ID) {
@@ -4403,7 +4540,21 @@ mfxFrameSurface1* CTranscodingPipeline::GetFreeSurfaceForCS(bool isDec, mfxU64 t
         return GetFreeSurface(isDec, timeout);
     }
 
+    auto desc = m_ScalerConfig.GetDesc(ID);
+    return GetFreeSurfaceFromPool(m_CSSurfacePools[desc.PoolID],
+                                  m_CSPoolStates[desc.PoolID],
+                                  SMTTracer::ThreadType::CSVPP,
+                                  desc.PoolID,
+                                  timeout);
+}
+
+mfxFrameSurface1* CTranscodingPipeline::GetFreeSurfaceFromPool(SurfPointersArray& pool,
+                                                               SurfacePoolState& state,
+                                                               SMTTracer::ThreadType thType,
+                                                               mfxU32 thID,
+                                                               mfxU64 timeout) {
     mfxFrameSurface1* pSurf = NULL;
+    bool waited             = false;
 
     CTimer t;
     t.Start();
@@ -4417,31 +4568,26 @@ mfxFrameSurface1* CTranscodingPipeline::GetFreeSurfaceForCS(bool isDec, mfxU64 t
             }
         }
 
-        auto desc                    = m_ScalerConfig.GetDesc(ID);
-        SurfPointersArray& workArray = m_CSSurfacePools[desc.PoolID];
+        // waits until a surface of this pipeline is released or the rest of the
+        // timeout / 1000 seconds expire, StopSession() wakes it up as well
+        mfxF64 leftMs = (mfxF64)timeout - t.GetTime() * 1000;
+        mfxU32 waitMs = (leftMs > 0) ? (mfxU32)std::min(std::ceil(leftMs), (mfxF64)MFX_INFINITE) : 0;
+        pSurf         = m_FreeSurfaceNotifier.Acquire(state, pool, waitMs, waited);
+    } while (!pSurf && t.GetTime() < timeout / 1000);
 
-        int available =
-            (int)std::count_if(workArray.begin(), workArray.end(), [](mfxFrameSurface1* s) {
-                return s->Data.Locked == 0;
-            });
-        m_ScalerConfig.Tracer->AddCounterEvent(SMTTracer::ThreadType::CSVPP,
-                                               desc.PoolID,
-                                               SMTTracer::EventName::UNDEF,
-                                               available);
-
-        for (mfxU32 i = 0; i < workArray.size(); i++) {
-            if (!workArray[i]->Data.Locked) {
-                pSurf = workArray[i];
-                break;
-            }
-        }
-        if (pSurf) {
-            break;
-        }
-        else {
-            MSDK_SLEEP(TIME_TO_SLEEP);
-        }
-    } while (t.GetTime() < timeout / 1000);
+    if (waited) {
+        state.WaitTimeUs += (mfxU64)(t.GetTime() * 1000000);
+        m_ScalerConfig.Tracer->AddCounterEvent(thType,
+                                               thID,
+                                               SMTTracer::EventName::SURF_WAIT,
+                                               state.WaitTimeUs);
+    }
+    if (m_ScalerConfig.Tracer->IsEnabled()) {
+        int available = (int)std::count_if(pool.begin(), pool.end(), [](mfxFrameSurface1* s) {
+            return s->Data.Locked == 0;
+        });
+        m_ScalerConfig.Tracer->AddCounterEvent(thType, thID, SMTTracer::EventName::UNDEF, available);
+    }
 
     return pSurf;
 }
@@ -4490,20 +4636,29 @@ void CTranscodingPipeline::SetNumFramesForReset(mfxU32 nFrames) {
 }
 
 void CTranscodingPipeline::HandlePossibleGpuHang(mfxStatus& sts) {
+    if (sts == MFX_ERR_GPU_HANG) {
+        m_ScalerConfig.Tracer->DumpFlightRecorder("GPU hang");
+    }
     if (sts == MFX_ERR_GPU_HANG && m_bSoftGpuHangRecovery) {
         msdk_printf(MSDK_STRING(
             "[WARNING] GPU hang happened. Inserting an IDR and continuing transcoding.\n"));
         m_bInsertIDR = true;
         for (BSList::iterator it = m_BSPool.begin(); it != m_BSPool.end(); it++) {
-            (*it)->IsFree               = true;
             (*it)->Bitstream.DataOffset = 0;
             (*it)->Bitstream.DataLength = 0;
+            m_pBSStore->Release(*it);
         }
         m_BSPool.clear();
         sts = MFX_ERR_NONE;
     }
 }
 
+void CTranscodingPipeline::NotifySurfacesUnlocked() {
+    m_FreeSurfaceNotifier.Notify();
+    if (m_pParentPipeline)
+        m_pParentPipeline->m_FreeSurfaceNotifier.Notify();
+}
+
 mfxStatus CTranscodingPipeline::SetAllocatorAndHandleIfRequired() {
     mfxStatus sts = MFX_ERR_NONE;
     mfxIMPL impl  = 0;
@@ -4562,6 +4717,9 @@ size_t CTranscodingPipeline::GetRobustFlag() {
 }
 
 void CTranscodingPipeline::Close() {
+    // stop writing before the encoder and its bitstreams go away
+    m_pBSWriter.reset();
+
     m_pmfxDEC.reset();
 
     m_pmfxENC.reset();
@@ -4648,6 +4806,9 @@ mfxStatus CTranscodingPipeline::Reset() {
     }
 
     // Release output bitstram pools
+    if (m_pBSWriter) {
+        std::ignore = m_pBSWriter->Flush();
+    }
     m_BSPool.clear();
     m_pBSStore->ReleaseAll();
     m_pBSStore->FlushAll();
@@ -4741,6 +4902,9 @@ mfxStatus CTranscodingPipeline::Reset(VPLImplementationLoader* mfxLoader) {
     }
 
     // Release output bitstram pools
+    if (m_pBSWriter) {
+        std::ignore = m_pBSWriter->Flush();
+    }
     m_BSPool.clear();
     m_pBSStore->ReleaseAll();
     m_pBSStore->FlushAll();
@@ -4885,131 +5049,31 @@ mfxStatus CTranscodingPipeline::Run() {
     return sts;
 }
 
-void IncreaseReference(mfxFrameSurface1& surf) {
-    msdk_atomic_inc16((volatile mfxU16*)(&surf.Data.Locked));
-    if (surf.FrameInterface) {
-        std::ignore = surf.FrameInterface->AddRef(&surf);
-    }
-}
-
-void DecreaseReference(mfxFrameSurface1& surf) {
-    msdk_atomic_dec16((volatile mfxU16*)&surf.Data.Locked);
-    if (surf.FrameInterface) {
-        std::ignore = surf.FrameInterface->Release(&surf);
-    }
-}
-
-SafetySurfaceBuffer::SafetySurfaceBuffer(SafetySurfaceBuffer* pNext)
-        : m_pNext(pNext),
-          m_IsBufferingAllowed(true),
-          pInsEvent(nullptr) {
-    mfxStatus sts = MFX_ERR_NONE;
-    pRelEvent     = new MSDKEvent(sts, false, false);
-    MSDK_CHECK_POINTER_NO_RET(pRelEvent);
-
-    pInsEvent = new MSDKEvent(sts, false, false);
-    MSDK_CHECK_POINTER_NO_RET(pInsEvent);
-
-} // SafetySurfaceBuffer::SafetySurfaceBuffer
-
-SafetySurfaceBuffer::~SafetySurfaceBuffer() {
-    delete pRelEvent;
-    delete pInsEvent;
-} //SafetySurfaceBuffer::~SafetySurfaceBuffer()
-
-mfxU32 SafetySurfaceBuffer::GetLength() {
-    std::lock_guard<std::mutex> guard(m_mutex);
-    return (mfxU32)m_SList.size();
-}
-
-mfxStatus SafetySurfaceBuffer::WaitForSurfaceRelease(mfxU32 msec) {
-    return pRelEvent->TimedWait(msec);
-}
-
-mfxStatus SafetySurfaceBuffer::WaitForSurfaceInsertion(mfxU32 msec) {
-    return pInsEvent->TimedWait(msec);
-}
-
-void SafetySurfaceBuffer::AddSurface(ExtendedSurface Surf) {
-    bool isBufferingAllowed = false;
-
-    {
-        std::lock_guard<std::mutex> guard(m_mutex);
-
-        isBufferingAllowed = m_IsBufferingAllowed;
-        if (isBufferingAllowed) {
-            SurfaceDescriptor sDescriptor;
-            // Locked is used to signal when we can free surface
-            sDescriptor.Locked     = 1;
-            sDescriptor.ExtSurface = Surf;
-
-            if (Surf.pSurface) {
-                IncreaseReference(*Surf.pSurface);
-            }
-
-            m_SList.push_back(sDescriptor);
-        }
-    }
-
-    if (isBufferingAllowed) {
-        pInsEvent->Signal();
-    }
-
-} // SafetySurfaceBuffer::AddSurface(mfxFrameSurface1 *pSurf)
-
-mfxStatus SafetySurfaceBuffer::GetSurface(ExtendedSurface& Surf) {
-    std::lock_guard<std::mutex> guard(m_mutex);
-
-    // no ready surfaces
-    if (0 == m_SList.size()) {
-        MSDK_ZERO_MEMORY(Surf)
-        return MFX_ERR_MORE_SURFACE;
-    }
-
-    SurfaceDescriptor sDescriptor = m_SList.front();
-
-    Surf = sDescriptor.ExtSurface;
-
-    return MFX_ERR_NONE;
-
-} // SafetySurfaceBuffer::GetSurface()
-
-mfxStatus SafetySurfaceBuffer::ReleaseSurface(mfxFrameSurface1* pSurf) {
-    std::unique_lock<std::mutex> lock(m_mutex);
-
-    std::list<SurfaceDescriptor>::iterator it;
-    for (it = m_SList.begin(); it != m_SList.end(); it++) {
-        if (pSurf == it->ExtSurface.pSurface) {
-            it->Locked--;
-            if (it->ExtSurface.pSurface)
-                DecreaseReference(*it->ExtSurface.pSurface);
-            if (0 == it->Locked) {
-                m_SList.erase(it);
-                lock.unlock();
-
-                // event operation should be out of synced context
-                pRelEvent->Signal();
-            }
+mfxStatus CTranscodingPipeline::RunStep() {
+    if (!IsRunStepSupported())
+        return MFX_ERR_UNSUPPORTED;
 
-            return MFX_ERR_NONE;
-        }
+    if (!m_TranscodeState.bStarted) {
+        m_TranscodeState          = TranscodeState();
+        m_TranscodeState.bStarted = true;
+        m_TranscodeState.start    = time(0);
     }
 
-    return MFX_ERR_UNKNOWN;
-} // mfxStatus SafetySurfaceBuffer::ReleaseSurface(mfxFrameSurface1* pSurf)
+    bool bFinished = false;
+    bool bReady    = true;
+    mfxStatus sts  = TranscodeOneFrame(false, bFinished, bReady);
+    if (MFX_ERR_NONE == sts && !bFinished)
+        return bReady ? MFX_ERR_NONE : MFX_WRN_IN_EXECUTION;
 
-mfxStatus SafetySurfaceBuffer::ReleaseSurfaceAll() {
-    std::lock_guard<std::mutex> guard(m_mutex);
-
-    m_SList.clear();
-    m_IsBufferingAllowed = true;
-    return MFX_ERR_NONE;
+    m_TranscodeState.bStarted = false;
+    sts                       = TranscodeFinish(sts);
 
-} // mfxStatus SafetySurfaceBuffer::ReleaseSurface(mfxFrameSurface1* pSurf)
+    msdk_stringstream ss;
+    ss << MSDK_STRING("CTranscodingPipeline::RunStep::Transcode() [") << GetSessionText()
+       << MSDK_STRING("] failed");
+    MSDK_CHECK_STATUS(sts, ss.str());
 
-void SafetySurfaceBuffer::CancelBuffering() {
-    std::lock_guard<std::mutex> guard(m_mutex);
-    m_IsBufferingAllowed = false;
+    return sts;
 }
 
 FileBitstreamProcessor::FileBitstreamProcessor() {
@@ -5032,6 +5096,8 @@ mfxStatus FileBitstreamProcessor::SetReader(std::unique_ptr<CSmplYUVReader>& rea
 mfxStatus FileBitstreamProcessor::SetReader(std::unique_ptr<CSmplBitstreamReader>& reader) {
     m_pFileReader = std::move(reader);
     m_Bitstream.Extend(1024 * 1024 * 2);
+    // refills don't move unconsumed data if the platform supports it
+    m_Bitstream.UseRingBuffer();
 
     return MFX_ERR_NONE;
 }
@@ -5046,6 +5112,7 @@ mfxStatus FileBitstreamProcessor::GetInputBitstream(mfxBitstreamWrapper** pBitst
     if (!m_pFileReader.get()) {
         return MFX_ERR_UNSUPPORTED;
     }
+    m_Bitstream.Rebase();
     mfxStatus sts = m_pFileReader->ReadNextFrame(&m_Bitstream);
     if (MFX_ERR_NONE == sts) {
         *pBitstream = &m_Bitstream;
@@ -5093,6 +5160,132 @@ bool FileBitstreamProcessor::IsNulOutput() {
     return !m_pFileWriter.get();
 }
 
+AsyncBitstreamWriter::AsyncBitstreamWriter(FileBitstreamProcessor* pBSProc,
+                                           ExtendedBSStore* pBSStore,
+                                           mfxU32 depth)
+        : m_pBSProc(pBSProc),
+          m_pBSStore(pBSStore),
+          m_Depth(depth ? depth : 1),
+          m_PipelineID(0),
+          m_mutex(),
+          m_cvPush(),
+          m_cvPop(),
+          m_Queue(),
+          m_Status(MFX_ERR_NONE),
+          m_bStop(false),
+          m_StatWindowSize(0),
+          m_Statistics(MSDK_STRING("Write")),
+          m_Thread() {
+    m_Thread = std::thread(&AsyncBitstreamWriter::WriteRoutine, this);
+}
+
+AsyncBitstreamWriter::~AsyncBitstreamWriter() {
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_bStop = true;
+    }
+    m_cvPush.notify_one();
+    if (m_Thread.joinable())
+        m_Thread.join();
+}
+
+void AsyncBitstreamWriter::SetStatistics(mfxU32 windowSize,
+                                         FILE* file,
+                                         const msdk_tstring& dumpName) {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_StatWindowSize = windowSize;
+    if (file)
+        m_Statistics.SetOutputFile(file);
+    if (!dumpName.empty())
+        m_Statistics.SetDumpName((dumpName + MSDK_STRING("_write")).c_str());
+}
+
+void AsyncBitstreamWriter::SetPipelineID(mfxU32 id) {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_PipelineID = id;
+}
+
+mfxStatus AsyncBitstreamWriter::Push(ExtendedBS* pBS) {
+    MSDK_CHECK_POINTER(pBS, MFX_ERR_NULL_PTR);
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cvPop.wait(lock, [this] {
+            return m_Queue.size() < m_Depth || m_Status != MFX_ERR_NONE;
+        });
+        if (m_Status != MFX_ERR_NONE)
+            return m_Status;
+
+        m_Queue.push_back(pBS);
+        if (m_StatWindowSize)
+            m_Statistics.AddQueueDepth((mfxU32)m_Queue.size());
+    }
+    m_cvPush.notify_one();
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus AsyncBitstreamWriter::Flush() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    // after a failed write the writer thread still releases the queued
+    // bitstreams, wait for it so that the caller can reuse the store
+    m_cvPop.wait(lock, [this] {
+        return m_Queue.empty();
+    });
+
+    // the writer thread is idle, print what is left of the last window
+    if (m_StatWindowSize && m_Statistics.GetNumMeasurements()) {
+        m_Statistics.PrintStatistics(m_PipelineID);
+        m_Statistics.ResetStatistics();
+    }
+
+    return m_Status;
+}
+
+void AsyncBitstreamWriter::WriteRoutine() {
+    std::vector<ExtendedBS*> batch;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_cvPush.wait(lock, [this] {
+            return !m_Queue.empty() || m_bStop;
+        });
+        if (m_Queue.empty())
+            break;
+
+        // write everything queued so far with one lock round trip, the queued
+        // bitstreams stay counted against the depth until they are written
+        batch.assign(m_Queue.begin(), m_Queue.end());
+        lock.unlock();
+
+        mfxStatus sts = MFX_ERR_NONE;
+        for (ExtendedBS* pBS : batch) {
+            if (sts == MFX_ERR_NONE) {
+                if (m_StatWindowSize)
+                    m_Statistics.StartTimeMeasurement();
+                sts = m_pBSProc->ProcessOutputBitstream(&pBS->Bitstream);
+                if (m_StatWindowSize)
+                    m_Statistics.StopTimeMeasurement();
+            }
+
+            pBS->Bitstream.DataLength = 0;
+            pBS->Bitstream.DataOffset = 0;
+            m_pBSStore->Release(pBS);
+        }
+
+        lock.lock();
+        m_Queue.erase(m_Queue.begin(), m_Queue.begin() + batch.size());
+        if (sts != MFX_ERR_NONE && m_Status == MFX_ERR_NONE) {
+            msdk_printf(MSDK_STRING("ERROR: output writing failed, status %d\n"), (int)sts);
+            m_Status = sts;
+        }
+        if (m_StatWindowSize && m_Statistics.GetNumMeasurements() >= m_StatWindowSize) {
+            m_Statistics.PrintStatistics(m_PipelineID);
+            m_Statistics.ResetStatistics();
+        }
+        m_cvPop.notify_all();
+    }
+}
+
 void CTranscodingPipeline::ModifyParamsUsingPresets(sInputParams& params,
                                                     mfxF64 fps,
                                                     mfxU32 width,
@@ -0,0 +1,216 @@
+/*############################################################################
+  # Copyright (C) 2005 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "mfx_samples_config.h"
+
+#include <chrono>
+#include <mutex>
+#include <tuple>
+#include "pipeline_transcode.h"
+
+using namespace TranscodingSample;
+
+void IncreaseReference(mfxFrameSurface1& surf) {
+    msdk_atomic_inc16((volatile mfxU16*)(&surf.Data.Locked));
+    if (surf.FrameInterface) {
+        std::ignore = surf.FrameInterface->AddRef(&surf);
+    }
+}
+
+void DecreaseReference(mfxFrameSurface1& surf) {
+    msdk_atomic_dec16((volatile mfxU16*)&surf.Data.Locked);
+    if (surf.FrameInterface) {
+        std::ignore = surf.FrameInterface->Release(&surf);
+    }
+}
+
+void FreeSurfaceNotifier::Notify() {
+    m_generation++;
+    // lock-free unless somebody waits, free lists are refilled by Acquire() then
+    if (m_waiters.load() == 0)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (SurfacePoolState* state : m_pools)
+            Reclaim(*state);
+    }
+    m_cv.notify_all();
+}
+
+mfxFrameSurface1* FreeSurfaceNotifier::Acquire(SurfacePoolState& state,
+                                               const SurfPointersArray& pool,
+                                               mfxU32 msec,
+                                               bool& waited) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    // all surfaces are checked once, free ones are handed out in pool order
+    if (!state.Registered) {
+        state.Free.clear();
+        state.Busy.assign(pool.rbegin(), pool.rend());
+        state.Registered = true;
+        m_pools.push_back(&state);
+    }
+
+    // taken before the free list is refilled, so a Notify() after it isn't missed
+    mfxU64 generation = m_generation.load();
+    if (state.Free.empty())
+        Reclaim(state);
+
+    if (state.Free.empty() && msec) {
+        waited = true;
+        m_waiters++;
+        m_cv.wait_for(lock, std::chrono::milliseconds(msec), [&] {
+            return !state.Free.empty() || m_generation.load() != generation;
+        });
+        m_waiters--;
+    }
+    if (state.Free.empty())
+        return NULL;
+
+    mfxFrameSurface1* pSurf = state.Free.back();
+    state.Free.pop_back();
+    state.Busy.push_back(pSurf);
+    return pSurf;
+}
+
+void FreeSurfaceNotifier::RemovePools() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (SurfacePoolState* state : m_pools) {
+        state->Free.clear();
+        state->Busy.clear();
+        state->Registered = false;
+    }
+    m_pools.clear();
+}
+
+void FreeSurfaceNotifier::Reclaim(SurfacePoolState& state) {
+    for (size_t i = state.Busy.size(); i > 0; i--) {
+        mfxFrameSurface1* pSurf = state.Busy[i - 1];
+        if (!pSurf->Data.Locked) {
+            state.Free.push_back(pSurf);
+            state.Busy[i - 1] = state.Busy.back();
+            state.Busy.pop_back();
+        }
+    }
+}
+
+SafetySurfaceBuffer::SafetySurfaceBuffer(SafetySurfaceBuffer* pNext)
+        : m_pNext(pNext),
+          m_SList(InitialCapacity),
+          m_IsBufferingAllowed(true),
+          pInsEvent(nullptr) {
+    mfxStatus sts = MFX_ERR_NONE;
+    pRelEvent     = new MSDKEvent(sts, false, false);
+    MSDK_CHECK_POINTER_NO_RET(pRelEvent);
+
+    pInsEvent = new MSDKEvent(sts, false, false);
+    MSDK_CHECK_POINTER_NO_RET(pInsEvent);
+
+} // SafetySurfaceBuffer::SafetySurfaceBuffer
+
+SafetySurfaceBuffer::~SafetySurfaceBuffer() {
+    delete pRelEvent;
+    delete pInsEvent;
+} //SafetySurfaceBuffer::~SafetySurfaceBuffer()
+
+mfxU32 SafetySurfaceBuffer::GetLength() {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return (mfxU32)m_SList.Size();
+}
+
+mfxStatus SafetySurfaceBuffer::WaitForSurfaceRelease(mfxU32 msec) {
+    return pRelEvent->TimedWait(msec);
+}
+
+mfxStatus SafetySurfaceBuffer::WaitForSurfaceInsertion(mfxU32 msec) {
+    return pInsEvent->TimedWait(msec);
+}
+
+void SafetySurfaceBuffer::AddSurface(ExtendedSurface Surf, FreeSurfaceNotifier* pNotifier) {
+    bool isBufferingAllowed = false;
+
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+
+        isBufferingAllowed = m_IsBufferingAllowed;
+        if (isBufferingAllowed) {
+            SurfaceDescriptor sDescriptor;
+            // Locked is used to signal when we can free surface
+            sDescriptor.Locked     = 1;
+            sDescriptor.ExtSurface = Surf;
+            sDescriptor.pNotifier  = pNotifier;
+
+            if (Surf.pSurface) {
+                IncreaseReference(*Surf.pSurface);
+            }
+
+            m_SList.Push(sDescriptor);
+        }
+    }
+
+    if (isBufferingAllowed) {
+        pInsEvent->Signal();
+    }
+
+} // SafetySurfaceBuffer::AddSurface(mfxFrameSurface1 *pSurf)
+
+mfxStatus SafetySurfaceBuffer::GetSurface(ExtendedSurface& Surf) {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    // no ready surfaces
+    if (0 == m_SList.Size()) {
+        MSDK_ZERO_MEMORY(Surf)
+        return MFX_ERR_MORE_SURFACE;
+    }
+
+    Surf = m_SList.Front().ExtSurface;
+
+    return MFX_ERR_NONE;
+
+} // SafetySurfaceBuffer::GetSurface()
+
+mfxStatus SafetySurfaceBuffer::ReleaseSurface(mfxFrameSurface1* pSurf) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    // sinks release surfaces in the order they got them, so the search stops
+    // at the head
+    for (size_t i = 0; i < m_SList.Size(); i++) {
+        SurfaceDescriptor& sDescriptor = m_SList.At(i);
+        if (pSurf == sDescriptor.ExtSurface.pSurface) {
+            sDescriptor.Locked--;
+            if (sDescriptor.ExtSurface.pSurface) {
+                DecreaseReference(*sDescriptor.ExtSurface.pSurface);
+                if (sDescriptor.pNotifier)
+                    sDescriptor.pNotifier->Notify();
+            }
+            if (0 == sDescriptor.Locked) {
+                m_SList.Erase(i);
+                lock.unlock();
+
+                // event operation should be out of synced context
+                pRelEvent->Signal();
+            }
+
+            return MFX_ERR_NONE;
+        }
+    }
+
+    return MFX_ERR_UNKNOWN;
+} // mfxStatus SafetySurfaceBuffer::ReleaseSurface(mfxFrameSurface1* pSurf)
+
+mfxStatus SafetySurfaceBuffer::ReleaseSurfaceAll() {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    m_SList.Clear();
+    m_IsBufferingAllowed = true;
+    return MFX_ERR_NONE;
+
+} // mfxStatus SafetySurfaceBuffer::ReleaseSurface(mfxFrameSurface1* pSurf)
+
+void SafetySurfaceBuffer::CancelBuffering() {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_IsBufferingAllowed = false;
+}
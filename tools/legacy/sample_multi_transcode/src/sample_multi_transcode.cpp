@@ -9,6 +9,7 @@
     #include <windows.h>
 #endif
 
+#include "pipeline_scheduler.h"
 #include "sample_multi_transcode.h"
 
 #if defined(LIBVA_WAYLAND_SUPPORT)
@@ -699,6 +700,16 @@ void Launcher::Run() {
 } // mfxStatus Launcher::Init()
 
 void Launcher::DoTranscoding() {
+    // Scheduler is used if it's enabled for one of the sessions
+    mfxU32 numWorkers = 0;
+    for (const auto& params : m_InputParamsArray) {
+        numWorkers = std::max(numWorkers, params.nSchedulerWorkers);
+    }
+    if (numWorkers) {
+        DoScheduledTranscoding(numWorkers);
+        return;
+    }
+
     auto RunTranscodeRoutine = [](ThreadTranscodeContext* context) {
         context->handle = std::async(std::launch::async, [context]() {
             context->TranscodeRoutine();
@@ -733,34 +744,7 @@ void Launcher::DoTranscoding() {
                 m_pThreadContextArray[i]->handle.get();
 
                 // Session is completed, let's check for its status
-                if (m_pThreadContextArray[i]->transcodingSts < MFX_ERR_NONE) {
-                    // Stop all the sessions if an error happened in one
-                    // But do not stop in robust mode when gpu hang's happened
-                    if (m_pThreadContextArray[i]->transcodingSts != MFX_ERR_GPU_HANG ||
-                        !m_pThreadContextArray[i]->pPipeline->GetRobustFlag()) {
-                        msdk_stringstream ss;
-                        ss << MSDK_STRING("\n\n session ") << i << MSDK_STRING(" [")
-                           << m_pThreadContextArray[i]->pPipeline->GetSessionText()
-                           << MSDK_STRING("] failed with status ")
-                           << StatusToString(m_pThreadContextArray[i]->transcodingSts)
-                           << MSDK_STRING(" shutting down the application...") << std::endl
-                           << std::endl;
-                        msdk_printf(MSDK_STRING("%s"), ss.str().c_str());
-
-                        for (const auto& context : m_pThreadContextArray) {
-                            context->pPipeline->StopSession();
-                        }
-                    }
-                }
-                else if (m_pThreadContextArray[i]->transcodingSts > MFX_ERR_NONE) {
-                    msdk_stringstream ss;
-                    ss << MSDK_STRING("\n\n session ") << i << MSDK_STRING(" [")
-                       << m_pThreadContextArray[i]->pPipeline->GetSessionText()
-                       << MSDK_STRING("] returned warning status ")
-                       << StatusToString(m_pThreadContextArray[i]->transcodingSts) << std::endl
-                       << std::endl;
-                    msdk_printf(MSDK_STRING("%s"), ss.str().c_str());
-                }
+                CheckSessionStatus(i);
             }
             else {
                 aliveNonOverlaySessions = aliveNonOverlaySessions ||
@@ -790,6 +774,95 @@ void Launcher::DoTranscoding() {
     }
 }
 
+void Launcher::DoScheduledTranscoding(mfxU32 numWorkers) {
+    // threads started below refer to the scheduler, so nothing may return
+    // between starting them and waiting for their completion
+    for (const auto& context : m_pThreadContextArray) {
+        MSDK_CHECK_POINTER_NO_RET(context);
+        MSDK_CHECK_POINTER_NO_RET(context->pPipeline);
+    }
+
+    PipelineScheduler scheduler(numWorkers);
+
+    // Transcoding sessions are stepped by the workers of the scheduler. The
+    // other ones wait for each other inside Run(), so they keep their threads
+    // and report completion to the same queue.
+    bool isOverlayUsed             = false;
+    size_t aliveNonOverlaySessions = 0;
+    for (size_t i = 0; i < m_pThreadContextArray.size(); ++i) {
+        ThreadTranscodeContext* context = m_pThreadContextArray[i].get();
+        if (context->pPipeline->IsRunStepSupported()) {
+            scheduler.AddTask((mfxU32)i, [context]() {
+                return context->TranscodeStep();
+            });
+        }
+        else {
+            context->handle = std::async(std::launch::async, [context, &scheduler, i]() {
+                context->TranscodeRoutine();
+                scheduler.Complete((mfxU32)i, context->transcodingSts);
+            });
+        }
+
+        if (context->pPipeline->IsOverlayUsed())
+            isOverlayUsed = true;
+        else
+            aliveNonOverlaySessions++;
+    }
+    scheduler.Start();
+
+    for (size_t aliveSessions = m_pThreadContextArray.size(); aliveSessions > 0; aliveSessions--) {
+        size_t i = scheduler.WaitForCompletion().TaskID;
+        if (m_pThreadContextArray[i]->handle.valid())
+            m_pThreadContextArray[i]->handle.get();
+
+        CheckSessionStatus(i);
+
+        // Overlay sessions never stop themselves, stop them after all non-overlay sessions
+        if (m_pThreadContextArray[i]->pPipeline->IsOverlayUsed())
+            continue;
+        if (--aliveNonOverlaySessions == 0 && isOverlayUsed) {
+            for (const auto& context : m_pThreadContextArray) {
+                if (context->pPipeline->IsOverlayUsed()) {
+                    context->pPipeline->StopSession();
+                }
+            }
+        }
+    }
+
+    scheduler.Stop();
+}
+
+void Launcher::CheckSessionStatus(size_t i) {
+    if (m_pThreadContextArray[i]->transcodingSts < MFX_ERR_NONE) {
+        // Stop all the sessions if an error happened in one
+        // But do not stop in robust mode when gpu hang's happened
+        if (m_pThreadContextArray[i]->transcodingSts != MFX_ERR_GPU_HANG ||
+            !m_pThreadContextArray[i]->pPipeline->GetRobustFlag()) {
+            msdk_stringstream ss;
+            ss << MSDK_STRING("\n\n session ") << i << MSDK_STRING(" [")
+               << m_pThreadContextArray[i]->pPipeline->GetSessionText()
+               << MSDK_STRING("] failed with status ")
+               << StatusToString(m_pThreadContextArray[i]->transcodingSts)
+               << MSDK_STRING(" shutting down the application...") << std::endl
+               << std::endl;
+            msdk_printf(MSDK_STRING("%s"), ss.str().c_str());
+
+            for (const auto& context : m_pThreadContextArray) {
+                context->pPipeline->StopSession();
+            }
+        }
+    }
+    else if (m_pThreadContextArray[i]->transcodingSts > MFX_ERR_NONE) {
+        msdk_stringstream ss;
+        ss << MSDK_STRING("\n\n session ") << i << MSDK_STRING(" [")
+           << m_pThreadContextArray[i]->pPipeline->GetSessionText()
+           << MSDK_STRING("] returned warning status ")
+           << StatusToString(m_pThreadContextArray[i]->transcodingSts) << std::endl
+           << std::endl;
+        msdk_printf(MSDK_STRING("%s"), ss.str().c_str());
+    }
+}
+
 void Launcher::DoRobustTranscoding() {
     mfxStatus sts = MFX_ERR_NONE;
 
@@ -1432,7 +1505,10 @@ CascadeScalerConfig& Launcher::CreateCascadeScalerConfig() {
     //init tracer, should be called when config is fully initialized
     for (sInputParams& par : m_InputParamsArray) {
         if (par.eMode == Sink && par.EnableTracing) {
-            cfg.Tracer->Init((mfxU32)cfg.Targets.size(), par.LatencyType, par.TraceBufferSize);
+            cfg.Tracer->Init((mfxU32)cfg.Targets.size(),
+                             par.LatencyType,
+                             par.TraceBufferSize,
+                             par.TraceFlightRecorder);
             break;
         }
     }
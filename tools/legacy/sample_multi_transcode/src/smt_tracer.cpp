@@ -6,19 +6,44 @@
 
 #include "smt_tracer.h"
 
+#if !defined(_WIN32) && !defined(_WIN64)
+    #include <signal.h>
+#endif
+
 namespace TranscodingSample {
 
-SMTTracer::SMTTracer() : Log(), AddonLog(), E2ELatency(), EncLatency(), TracerMutex() {
+std::atomic<mfxU32> SMTTracer::NextTracerID(1);
+thread_local SMTTracer::ShardRef SMTTracer::LocalShard = { 0, nullptr };
+std::atomic<bool> SMTTracer::FlightRecorderDumpRequested(false);
+
+#if !defined(_WIN32) && !defined(_WIN64)
+static void FlightRecorderSignalHandler(int) {
+    SMTTracer::RequestFlightRecorderDump();
+}
+#endif
+
+SMTTracer::SMTTracer()
+        : Shards(),
+          DumpMutex(),
+          Log(),
+          AddonLog(),
+          E2ELatency(),
+          EncLatency(),
+          TracerMutex() {
     TimeBase = GetCurrentTS();
+    TracerID = NextTracerID++;
 }
 
 SMTTracer::~SMTTracer() {
     if (!Enabled)
         return;
 
+    std::lock_guard<std::mutex> guard(DumpMutex);
+
     //these functions are intentionally called from destructor to try to save traces in case of a crash
+    CollectEvents(0);
     AddFlowEvents();
-    mfxU32 FileID = 0xfffffff & GetCurrentTS();
+    mfxU32 FileID = 0xfffffff & (GetCurrentTS() / 1000);
     SaveTrace(FileID);
 
     ComputeE2ELatency();
@@ -30,7 +55,8 @@ SMTTracer::~SMTTracer() {
 
 void SMTTracer::Init(const mfxU32 numOfChannels,
                      const LatencyType latency,
-                     const mfxU32 TraceBufferSize) {
+                     const mfxU32 TraceBufferSize,
+                     const mfxU32 FlightRecorderSeconds) {
     if (Enabled) {
         return;
     }
@@ -39,10 +65,25 @@ void SMTTracer::Init(const mfxU32 numOfChannels,
     if (TraceBufferSize > TraceBufferSizeInMBytes && TraceBufferSize < MaxTraceBufferSizeInMBytes) {
         TraceBufferSizeInMBytes = TraceBufferSize;
     }
-    Log.reserve(TraceBufferSizeInMBytes * 1024 * 1024 / sizeof(Event));
+
+    //buffer is split between decoder and encoder threads, one shard per thread
+    mfxU32 NumOfShards = numOfChannels + 1;
+    ShardSize = std::max<size_t>(
+        1,
+        TraceBufferSizeInMBytes * 1024 * 1024 / sizeof(Event) / NumOfShards);
+    for (mfxU32 i = 0; i < NumOfShards; i++) {
+        Shards.emplace_back(new Shard(ShardSize));
+    }
 
     NumOfChannels = numOfChannels;
     TypeOfLatency = latency;
+
+    if (FlightRecorderSeconds) {
+        FlightRecorderWindow = (mfxU64)FlightRecorderSeconds * 1000 * 1000 * 1000;
+#if !defined(_WIN32) && !defined(_WIN64)
+        signal(SIGUSR1, FlightRecorderSignalHandler);
+#endif
+    }
 }
 
 void SMTTracer::BeginEvent(const ThreadType thType,
@@ -115,6 +156,25 @@ void SMTTracer::AfterDecodeSync() {
     }
 }
 
+void SMTTracer::DumpFlightRecorder(const char* reason) {
+    if (!Enabled || !FlightRecorderWindow) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(DumpMutex);
+
+    mfxU64 now = GetCurrentTS();
+    CollectEvents(now > FlightRecorderWindow ? now - FlightRecorderWindow : 0);
+    AddFlowEvents();
+
+    printf("\n### flight recorder dump, reason: %s\n", reason);
+    SaveTrace(0xfffffff & (now / 1000));
+}
+
+void SMTTracer::RequestFlightRecorderDump() {
+    FlightRecorderDumpRequested = true;
+}
+
 void SMTTracer::AfterEncodeSync() {
     if (TypeOfLatency == LatencyType::E2E || TypeOfLatency == LatencyType::ENC) {
         std::unique_lock<std::mutex> guard(TracerMutex);
@@ -134,7 +194,13 @@ void SMTTracer::SaveTrace(mfxU32 FileID) {
         return;
     }
 
-    printf("\n### trace buffer usage %.2f%%\n", 100. * Log.size() / Log.capacity());
+    if (FlightRecorderWindow) {
+        printf("\n### flight recorder, last %.1f sec\n", FlightRecorderWindow / 1e9);
+    }
+    else {
+        printf("\n### trace buffer usage %.2f%%\n",
+               100. * Log.size() / (ShardSize * Shards.size()));
+    }
     printf("trace file name %s\n", FileName.c_str());
 
     trace_file << "[" << std::endl;
@@ -169,12 +235,23 @@ void SMTTracer::AddEvent(const EventType evType,
     ev.OutID  = reinterpret_cast<mfxU64>(outID);
     ev.TS     = GetCurrentTS();
 
-    if (Log.size() == Log.capacity()) {
-        return;
+    if (FlightRecorderWindow && FlightRecorderDumpRequested.load(std::memory_order_relaxed) &&
+        FlightRecorderDumpRequested.exchange(false)) {
+        DumpFlightRecorder("signal");
     }
 
-    std::lock_guard<std::mutex> guard(TracerMutex);
-    Log.push_back(ev);
+    Shard* shard = GetShard();
+    std::lock_guard<std::mutex> guard(shard->Mutex);
+    if (FlightRecorderWindow) {
+        shard->Events[shard->Count % ShardSize] = ev;
+    }
+    else if (shard->Count < ShardSize) {
+        shard->Events[shard->Count] = ev;
+    }
+    else {
+        return;
+    }
+    shard->Count++;
 }
 
 mfxU64 SMTTracer::GetCurrentTS() {
@@ -182,7 +259,46 @@ mfxU64 SMTTracer::GetCurrentTS() {
     //"system_clock" is system wide but not monotonic. We use "steady_clock", so please
     //check your implementation before comparing traces from different processes.
     using namespace std::chrono;
-    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+SMTTracer::Shard* SMTTracer::GetShard() {
+    if (LocalShard.TracerID == TracerID) {
+        return LocalShard.Ptr;
+    }
+
+    //first event of this thread
+    std::lock_guard<std::mutex> guard(TracerMutex);
+    if (NextFreeShard == Shards.size()) {
+        Shards.emplace_back(new Shard(ShardSize));
+    }
+    LocalShard = { TracerID, Shards[NextFreeShard++].get() };
+    return LocalShard.Ptr;
+}
+
+void SMTTracer::CollectEvents(mfxU64 since) {
+    Log.clear();
+    AddonLog.clear();
+
+    {
+        std::lock_guard<std::mutex> guard(TracerMutex);
+        for (auto& shard : Shards) {
+            std::lock_guard<std::mutex> shardGuard(shard->Mutex);
+            mfxU64 first = shard->Count > ShardSize ? shard->Count - ShardSize : 0;
+            for (mfxU64 i = first; i < shard->Count; i++) {
+                const Event& ev = shard->Events[i % ShardSize];
+                if (ev.TS >= since) {
+                    Log.push_back(ev);
+                }
+            }
+        }
+    }
+
+    //shards are ordered by time already, stable sort keeps order of events of one
+    //thread with equal time stamps
+    std::stable_sort(Log.begin(), Log.end(), [](const Event& a, const Event& b) {
+        return a.TS < b.TS;
+    });
 }
 
 void SMTTracer::AddFlowEvents() {
@@ -299,9 +415,9 @@ void SMTTracer::SaveLatency(LatencyType type,
             if (v.second.size() > i) {
                 trace_file << i << ",";
                 TimeInterval ti = v.second[i];
-                trace_file << ti.TS / 1000 << ",";
-                trace_file << (ti.TS - TimeBase) / 1000 << ",";
-                trace_file << ti.Duration / 1000. << ",";
+                trace_file << ti.TS / 1000000 << ",";
+                trace_file << (ti.TS - TimeBase) / 1000000 << ",";
+                trace_file << ti.Duration / 1000000. << ",";
             }
             else {
                 trace_file << ",,,,";
@@ -386,7 +502,7 @@ void SMTTracer::AddFlowEvent(const Event a, const Event b) {
     ev.TS     = b.TS;
 
     if (a.TS == b.TS) {
-        ev.TS++;
+        ev.TS += 1000;
     }
 
     AddonLog.push_back(ev);
@@ -488,7 +604,7 @@ void SMTTracer::WriteEventTID(std::ofstream& trace_file, const Event ev) {
 }
 
 void SMTTracer::WriteEventTS(std::ofstream& trace_file, const Event ev) {
-    trace_file << "\"ts\":" << ev.TS;
+    trace_file << "\"ts\":" << ev.TS / 1000;
 }
 
 void SMTTracer::WriteEventPhase(std::ofstream& trace_file, const Event ev) {
@@ -540,6 +656,10 @@ void SMTTracer::WriteEventName(std::ofstream& trace_file, const Event ev) {
                 trace_file << "unknown";
                 break;
         }
+        //total time spent waiting for a free surface of the pool, usec
+        if (ev.Name == EventName::SURF_WAIT) {
+            trace_file << "_wait_us";
+        }
     }
     else if (ev.Name != EventName::UNDEF) {
         switch (ev.Name) {
@@ -595,6 +715,10 @@ void SMTTracer::WriteEventInOutIDs(std::ofstream& trace_file, const Event ev) {
 }
 
 void SMTTracer::WriteEventCounter(std::ofstream& trace_file, const Event ev) {
+    if (ev.Name == EventName::SURF_WAIT) {
+        trace_file << "\"args\":{\"wait us\":" << ev.InID << "}";
+        return;
+    }
     trace_file << "\"args\":{\"free surfaces\":" << ev.InID << "}";
 }
 
@@ -243,6 +243,10 @@ void TranscodingSample::PrintHelp() {
     msdk_printf(MSDK_STRING("  -robust:soft  Recover from gpu hang errors by inserting an IDR\n"));
 
     msdk_printf(MSDK_STRING("  -async        Depth of asynchronous pipeline. default value 1\n"));
+    msdk_printf(MSDK_STRING(
+        "  -output_queue <depth>\n"
+        "                Write output bitstream on a separate thread, queueing up to <depth> frames.\n"
+        "                Encoding waits when the queue is full. 0 (default) - write on the transcoding thread\n"));
     msdk_printf(MSDK_STRING(
         "  -join         Join session with other session(s), by default sessions are not joined\n"));
     msdk_printf(MSDK_STRING(
@@ -583,6 +587,13 @@ void TranscodingSample::PrintHelp() {
     msdk_printf(MSDK_STRING(
         "   -trace::E2E              - turn on tracing, tune pipeline for E2E latency \n"));
     msdk_printf(MSDK_STRING("   -trace_buffer_size <x>   - trace buffer size in MBytes\n"));
+    msdk_printf(MSDK_STRING(
+        "   -trace_flight_recorder <x> - turn on tracing, keep only events of the last <x> seconds\n"
+        "                              and save them on GPU hang or on SIGUSR1 (Linux)\n"));
+    msdk_printf(MSDK_STRING(
+        "   -workers <x>             - run transcoding sessions on <x> threads with work stealing\n"
+        "                              instead of a thread per session. Sessions of heterogeneous\n"
+        "                              pipelines keep their own threads\n"));
 #if defined(LIBVA_X11_SUPPORT)
     msdk_printf(MSDK_STRING("   -rx11                    - use libva X11 backend \n"));
 #endif
@@ -1663,6 +1674,24 @@ mfxStatus ParseAdditionalParams(msdk_char* argv[],
             return MFX_ERR_UNSUPPORTED;
         }
     }
+    else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-trace_flight_recorder"))) {
+        VAL_CHECK(i + 1 == argc, i, argv[i]);
+        i++;
+        if (MFX_ERR_NONE != msdk_opt_read(argv[i], InputParams.TraceFlightRecorder)) {
+            PrintError(MSDK_STRING("-trace_flight_recorder \"%s\" is invalid"), argv[i]);
+            return MFX_ERR_UNSUPPORTED;
+        }
+        InputParams.EnableTracing = true;
+    }
+    else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-workers"))) {
+        VAL_CHECK(i + 1 == argc, i, argv[i]);
+        i++;
+        if (MFX_ERR_NONE != msdk_opt_read(argv[i], InputParams.nSchedulerWorkers) ||
+            0 == InputParams.nSchedulerWorkers) {
+            PrintError(MSDK_STRING("-workers \"%s\" is invalid"), argv[i]);
+            return MFX_ERR_UNSUPPORTED;
+        }
+    }
     else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-trace::E2E"))) {
         InputParams.EnableTracing = true;
         InputParams.LatencyType   = SMTTracer::LatencyType::E2E;
@@ -2488,6 +2517,14 @@ mfxStatus CmdProcessor::ParseParamsForOneSession(mfxU32 argc, msdk_char* argv[])
                 return MFX_ERR_UNSUPPORTED;
             }
         }
+        else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-output_queue"))) {
+            VAL_CHECK(i + 1 == argc, i, argv[i]);
+            i++;
+            if (MFX_ERR_NONE != msdk_opt_read(argv[i], InputParams.nOutputQueueDepth)) {
+                PrintError(MSDK_STRING("output_queue \"%s\" is invalid"), argv[i]);
+                return MFX_ERR_UNSUPPORTED;
+            }
+        }
         else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-join"))) {
             InputParams.bIsJoin = true;
         }
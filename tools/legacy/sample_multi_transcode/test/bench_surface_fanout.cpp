@@ -0,0 +1,250 @@
+/*############################################################################
+  # Copyright (C) 2005 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+// Emulates 1 decoder -> N encoders fan-out of joined sessions: one producer
+// thread adds every frame to the buffer of each sink, sink threads take and
+// release frames like CTranscodingPipeline::Encode does. Compares
+// SafetySurfaceBuffer of the sample (ring queue) vs. the previous std::list
+// based buffer, and ExtendedBSStore free list vs. the previous linear scan.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "pipeline_transcode.h"
+
+using namespace TranscodingSample;
+
+static void Usage(void) {
+    printf("\n");
+    printf("   Usage  :  bench_smt_fanout\n\n");
+    printf("     -n N       number of frames (default 100000)\n");
+    printf("     -sinks N   number of encoders (default 16)\n");
+    printf("     -pool N    number of decoded surfaces (default 32)\n");
+}
+
+static void AddRef(mfxFrameSurface1* pSurf) {
+    if (pSurf)
+        msdk_atomic_inc16((volatile mfxU16*)&pSurf->Data.Locked);
+}
+
+static void Unref(mfxFrameSurface1* pSurf) {
+    if (pSurf)
+        msdk_atomic_dec16((volatile mfxU16*)&pSurf->Data.Locked);
+}
+
+// previous SafetySurfaceBuffer, kept for reference
+class ListSurfaceBuffer {
+public:
+    explicit ListSurfaceBuffer(ListSurfaceBuffer*)
+            : m_mutex(),
+              m_SList(),
+              m_sts(MFX_ERR_NONE),
+              m_InsEvent(m_sts, false, false) {}
+
+    void AddSurface(ExtendedSurface Surf) {
+        {
+            std::lock_guard<std::mutex> guard(m_mutex);
+            SafetySurfaceBuffer::SurfaceDescriptor sDescriptor;
+            sDescriptor.Locked     = 1;
+            sDescriptor.ExtSurface = Surf;
+            AddRef(Surf.pSurface);
+            m_SList.push_back(sDescriptor);
+        }
+        m_InsEvent.Signal();
+    }
+    mfxStatus GetSurface(ExtendedSurface& Surf) {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        if (0 == m_SList.size()) {
+            MSDK_ZERO_MEMORY(Surf)
+            return MFX_ERR_MORE_SURFACE;
+        }
+        Surf = m_SList.front().ExtSurface;
+        return MFX_ERR_NONE;
+    }
+    mfxStatus ReleaseSurface(mfxFrameSurface1* pSurf) {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        for (auto it = m_SList.begin(); it != m_SList.end(); it++) {
+            if (pSurf == it->ExtSurface.pSurface) {
+                it->Locked--;
+                Unref(it->ExtSurface.pSurface);
+                if (0 == it->Locked)
+                    m_SList.erase(it);
+                return MFX_ERR_NONE;
+            }
+        }
+        return MFX_ERR_UNKNOWN;
+    }
+    mfxStatus WaitForSurfaceInsertion(mfxU32 msec) {
+        return m_InsEvent.TimedWait(msec);
+    }
+
+protected:
+    std::mutex m_mutex;
+    std::list<SafetySurfaceBuffer::SurfaceDescriptor> m_SList;
+    mfxStatus m_sts;
+    MSDKEvent m_InsEvent;
+};
+
+// previous ExtendedBSStore, kept for reference
+class ScanBSStore {
+public:
+    explicit ScanBSStore(mfxU32 size) : m_mutex(), m_pExtBS(size) {}
+
+    ExtendedBS* GetNext() {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        for (mfxU32 i = 0; i < m_pExtBS.size(); i++) {
+            if (m_pExtBS[i].IsFree) {
+                m_pExtBS[i].IsFree = false;
+                return &m_pExtBS[i];
+            }
+        }
+        return NULL;
+    }
+    void Release(ExtendedBS* pBS) {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        for (mfxU32 i = 0; i < m_pExtBS.size(); i++) {
+            if (&m_pExtBS[i] == pBS) {
+                m_pExtBS[i].IsFree = true;
+                return;
+            }
+        }
+    }
+
+protected:
+    std::mutex m_mutex;
+    std::vector<ExtendedBS> m_pExtBS;
+};
+
+// runs the fan-out; returns elapsed time in msec
+template <typename Buffer>
+static double FanOut(mfxU32 nFrames, mfxU32 nSinks, mfxU32 nPool, mfxU64& checksum) {
+    std::vector<std::unique_ptr<Buffer>> buffers;
+    for (mfxU32 id = 0; id < nSinks; id++)
+        buffers.emplace_back(new Buffer(NULL));
+    std::vector<mfxFrameSurface1> pool(nPool);
+    for (auto& s : pool) {
+        MSDK_ZERO_MEMORY(s);
+    }
+    std::vector<mfxU64> sums(nSinks, 0);
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::thread> sinks;
+    for (mfxU32 id = 0; id < nSinks; id++) {
+        sinks.emplace_back([&, id]() {
+            Buffer& buf = *buffers[id];
+            ExtendedSurface surf;
+            while (true) {
+                while (MFX_ERR_MORE_SURFACE == buf.GetSurface(surf))
+                    buf.WaitForSurfaceInsertion(1);
+                buf.ReleaseSurface(surf.pSurface);
+                if (!surf.pSurface)
+                    break;
+                sums[id] += surf.TargetID;
+            }
+        });
+    }
+
+    ExtendedSurface surf = { 0 };
+    mfxU32 next          = 0;
+    for (mfxU32 frame = 0; frame < nFrames; frame++) {
+        // decoder waits for a surface which all sinks released
+        while (*(volatile mfxU16*)&pool[next].Data.Locked != 0)
+            std::this_thread::yield();
+        surf.pSurface = &pool[next];
+        surf.TargetID = frame;
+        for (auto& buf : buffers)
+            buf->AddSurface(surf);
+        next = (next + 1) % nPool;
+    }
+    surf.pSurface = NULL;
+    for (auto& buf : buffers)
+        buf->AddSurface(surf);
+
+    for (auto& t : sinks)
+        t.join();
+
+    auto end = std::chrono::high_resolution_clock::now();
+    for (auto s : sums)
+        checksum += s;
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// encoder with nInFlight outputs in flight, released in order; returns elapsed time in msec
+template <typename Store>
+static double CycleBS(Store& store, mfxU32 nFrames, mfxU32 nInFlight, mfxU64& checksum) {
+    std::vector<ExtendedBS*> inFlight(nInFlight, NULL);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (mfxU32 frame = 0; frame < nFrames; frame++) {
+        ExtendedBS*& pBS = inFlight[frame % nInFlight];
+        if (pBS)
+            store.Release(pBS);
+        pBS = store.GetNext();
+        checksum += (mfxU64)(pBS != NULL);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static void PrintResult(const char* name, double ms, mfxU32 n, mfxU64 checksum) {
+    double ns = (n > 0) ? ms * 1000000.0 / n : 0;
+    printf("bench_smt_fanout -- %-24s = % 9.2f msec, % 8.1f ns/frame (checksum %llu)\n",
+           name,
+           ms,
+           ns,
+           (unsigned long long)checksum);
+}
+
+int main(int argc, char* argv[]) {
+    mfxU32 nFrames = 100000;
+    mfxU32 nSinks  = 16;
+    mfxU32 nPool   = 32;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            nFrames = (mfxU32)atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "-sinks") && i + 1 < argc) {
+            nSinks = (mfxU32)atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "-pool") && i + 1 < argc) {
+            nPool = (mfxU32)atoi(argv[++i]);
+        }
+        else {
+            Usage();
+            return 1;
+        }
+    }
+    if (!nSinks || !nPool) {
+        Usage();
+        return 1;
+    }
+
+    mfxU64 checksum = 0;
+    double ms       = 0;
+
+    ms = FanOut<ListSurfaceBuffer>(nFrames, nSinks, nPool, checksum = 0);
+    PrintResult("surface list", ms, nFrames, checksum);
+    ms = FanOut<SafetySurfaceBuffer>(nFrames, nSinks, nPool, checksum = 0);
+    PrintResult("surface ring", ms, nFrames, checksum);
+
+    // AsyncDepth 4 plus output queue of 16, as with -output_queue 16
+    const mfxU32 storeSize = 20;
+    ScanBSStore scanStore(storeSize);
+    ExtendedBSStore freeListStore(storeSize);
+    ms = CycleBS(scanStore, nFrames * nSinks, storeSize, checksum = 0);
+    PrintResult("bitstream scan", ms, nFrames * nSinks, checksum);
+    ms = CycleBS(freeListStore, nFrames * nSinks, storeSize, checksum = 0);
+    PrintResult("bitstream free list", ms, nFrames * nSinks, checksum);
+
+    return 0;
+}
@@ -0,0 +1,160 @@
+/*############################################################################
+  # Copyright (C) 2005 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+// Checks PipelineScheduler with step functions which don't run pipelines:
+// completion order, tasks waiting with MFX_WRN_IN_EXECUTION and tasks stolen
+// by idle workers.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "pipeline_scheduler.h"
+
+using namespace TranscodingSample;
+
+static bool Report(const char* name, bool ok) {
+    printf("Test %s", name);
+    if (!ok)
+        printf("\n   Error!\n");
+    else
+        printf(" ... OK\n");
+    return ok;
+}
+
+// waits until flag is set, gives up after 5 sec
+static bool WaitFor(const std::atomic<bool>& flag) {
+    auto end = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!flag) {
+        if (std::chrono::steady_clock::now() > end)
+            return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// one worker steps its tasks in turn, so shorter tasks complete first
+static bool CheckCompletionOrder() {
+    const mfxU32 steps[] = { 5, 1, 3 };
+    std::vector<mfxU32> done(3, 0);
+    bool ok = true;
+
+    PipelineScheduler scheduler(1);
+    for (mfxU32 id = 0; id < 3; id++) {
+        scheduler.AddTask(id, [&, id]() {
+            return (++done[id] < steps[id]) ? MFX_ERR_NONE : MFX_ERR_MORE_DATA;
+        });
+    }
+    scheduler.Start();
+
+    const mfxU32 order[] = { 1, 2, 0 };
+    for (mfxU32 id : order) {
+        PipelineScheduler::Completion completion = scheduler.WaitForCompletion();
+        ok &= (completion.TaskID == id && completion.Status == MFX_ERR_MORE_DATA);
+    }
+    scheduler.Stop();
+
+    for (mfxU32 id = 0; id < 3; id++)
+        ok &= (done[id] == steps[id]);
+    return ok;
+}
+
+// waiting task is queued again behind the other tasks of the worker
+static bool CheckInExecution() {
+    std::atomic<mfxU32> producerSteps(0);
+    mfxU32 waits = 0;
+    bool ok      = true;
+
+    PipelineScheduler scheduler(1);
+    scheduler.AddTask(0, [&]() {
+        if (producerSteps < 10) {
+            waits++;
+            return MFX_WRN_IN_EXECUTION;
+        }
+        return MFX_ERR_ABORTED;
+    });
+    scheduler.AddTask(1, [&]() {
+        return (++producerSteps < 10) ? MFX_ERR_NONE : MFX_ERR_MORE_DATA;
+    });
+    scheduler.Start();
+
+    PipelineScheduler::Completion first  = scheduler.WaitForCompletion();
+    PipelineScheduler::Completion second = scheduler.WaitForCompletion();
+    scheduler.Stop();
+
+    ok &= (first.TaskID == 1 && first.Status == MFX_ERR_MORE_DATA);
+    ok &= (second.TaskID == 0 && second.Status == MFX_ERR_ABORTED);
+    ok &= (waits > 0);
+    return ok;
+}
+
+// task 2 is queued behind task 0 on worker 0, which doesn't return until task 2
+// is finished, so only worker 1 stealing it can finish it
+static bool CheckStealing() {
+    std::atomic<bool> stolenDone(false);
+    std::atomic<bool> waitOk(false);
+    bool ok = true;
+
+    PipelineScheduler scheduler(2);
+    scheduler.AddTask(0, [&]() {
+        waitOk = WaitFor(stolenDone);
+        return MFX_ERR_MORE_DATA;
+    });
+    scheduler.AddTask(1, []() {
+        return MFX_ERR_MORE_DATA;
+    });
+    scheduler.AddTask(2, [&]() {
+        stolenDone = true;
+        return MFX_ERR_MORE_DATA;
+    });
+    scheduler.Start();
+
+    std::vector<bool> completed(3, false);
+    for (int i = 0; i < 3; i++) {
+        PipelineScheduler::Completion completion = scheduler.WaitForCompletion();
+        if (completion.TaskID < completed.size())
+            completed[completion.TaskID] = true;
+    }
+    scheduler.Stop();
+
+    ok &= completed[0] && completed[1] && completed[2];
+    ok &= waitOk.load();
+    return ok;
+}
+
+// sessions which run in their own threads report completion to the same queue
+static bool CheckExternalCompletion() {
+    bool ok = true;
+    PipelineScheduler scheduler(2);
+    scheduler.Start();
+
+    std::thread external([&]() {
+        scheduler.Complete(7, MFX_ERR_NONE);
+    });
+    PipelineScheduler::Completion completion = scheduler.WaitForCompletion();
+    external.join();
+    scheduler.Stop();
+
+    ok &= (completion.TaskID == 7 && completion.Status == MFX_ERR_NONE);
+    return ok;
+}
+
+int main() {
+    bool ok = true;
+    ok &= Report("completion order", CheckCompletionOrder());
+    ok &= Report("MFX_WRN_IN_EXECUTION queues the task again", CheckInExecution());
+    ok &= Report("idle worker steals tasks", CheckStealing());
+    ok &= Report("completion of tasks run outside", CheckExternalCompletion());
+
+    if (!ok) {
+        printf("\nErrors in pipeline scheduler test\n");
+        return -1;
+    }
+    printf("\nSuccess!\n");
+    return 0;
+}
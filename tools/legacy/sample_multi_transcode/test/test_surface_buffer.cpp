@@ -0,0 +1,182 @@
+/*############################################################################
+  # Copyright (C) 2005 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+// Checks the buffers joined sessions share: RingQueue, SafetySurfaceBuffer
+// (surfaces released not at the head, free list of the pool) and the free list of ExtendedBSStore.
+
+#include <cstdio>
+#include <set>
+#include <vector>
+
+#include "pipeline_transcode.h"
+
+using namespace TranscodingSample;
+
+static bool Report(const char* name, bool ok) {
+    printf("Test %s", name);
+    if (!ok)
+        printf("\n   Error!\n");
+    else
+        printf(" ... OK\n");
+    return ok;
+}
+
+static bool Contains(RingQueue<int>& q, const std::vector<int>& expected) {
+    if (q.Size() != expected.size())
+        return false;
+    for (size_t i = 0; i < expected.size(); i++) {
+        if (q.At(i) != expected[i])
+            return false;
+    }
+    return true;
+}
+
+// queue wrapped around the end of the storage keeps its order when it grows
+static bool CheckGrowWrapped() {
+    RingQueue<int> q(4);
+    bool ok = true;
+    q.Push(1);
+    q.Push(2);
+    q.Push(3);
+    q.Pop();
+    q.Pop();
+    q.Push(4);
+    q.Push(5);
+    q.Push(6);
+    ok &= Contains(q, { 3, 4, 5, 6 });
+    q.Push(7);
+    q.Push(8);
+    ok &= Contains(q, { 3, 4, 5, 6, 7, 8 });
+    ok &= (q.Front() == 3);
+
+    for (int i = 3; i <= 8; i++) {
+        ok &= (q.Front() == i);
+        q.Pop();
+    }
+    ok &= (q.Size() == 0);
+    return ok;
+}
+
+static bool CheckErase() {
+    RingQueue<int> q(5);
+    bool ok = true;
+    q.Push(0);
+    q.Push(0);
+    q.Pop();
+    q.Pop();
+    for (int i = 1; i <= 5; i++)
+        q.Push(i);
+
+    // wrapped, so erase moves elements across the end of the storage
+    q.Erase(1);
+    ok &= Contains(q, { 1, 3, 4, 5 });
+    q.Erase(3);
+    ok &= Contains(q, { 1, 3, 4 });
+    q.Erase(0);
+    ok &= Contains(q, { 3, 4 });
+    q.Push(6);
+    q.Push(7);
+    ok &= Contains(q, { 3, 4, 6, 7 });
+    q.Clear();
+    ok &= (q.Size() == 0);
+    return ok;
+}
+
+static bool CheckReleaseOrder() {
+    SafetySurfaceBuffer buffer(NULL);
+    FreeSurfaceNotifier notifier;
+    std::vector<mfxFrameSurface1> surfaces(4);
+    bool ok = true;
+
+    for (auto& s : surfaces) {
+        MSDK_ZERO_MEMORY(s);
+        ExtendedSurface ext;
+        MSDK_ZERO_MEMORY(ext);
+        ext.pSurface = &s;
+        buffer.AddSurface(ext, &notifier);
+    }
+    ok &= (buffer.GetLength() == 4);
+    ok &= (surfaces[2].Data.Locked == 1);
+
+    // all surfaces of the pool are locked by the buffer
+    SurfacePoolState state;
+    SurfPointersArray pool;
+    for (auto& s : surfaces)
+        pool.push_back(&s);
+    bool waited = false;
+    ok &= (notifier.Acquire(state, pool, 0, waited) == NULL && !waited);
+
+    // sink releases the third surface before the head, it is free in the pool again
+    ok &= (buffer.ReleaseSurface(&surfaces[2]) == MFX_ERR_NONE);
+    ok &= (surfaces[2].Data.Locked == 0);
+    ok &= (notifier.Acquire(state, pool, 0, waited) == &surfaces[2]);
+    ok &= (buffer.GetLength() == 3);
+    ok &= (buffer.ReleaseSurface(&surfaces[2]) == MFX_ERR_UNKNOWN);
+
+    ExtendedSurface head;
+    ok &= (buffer.GetSurface(head) == MFX_ERR_NONE && head.pSurface == &surfaces[0]);
+
+    ok &= (buffer.ReleaseSurface(&surfaces[3]) == MFX_ERR_NONE);
+    ok &= (buffer.ReleaseSurface(&surfaces[0]) == MFX_ERR_NONE);
+    ok &= (buffer.GetSurface(head) == MFX_ERR_NONE && head.pSurface == &surfaces[1]);
+    ok &= (buffer.ReleaseSurface(&surfaces[1]) == MFX_ERR_NONE);
+
+    ok &= (buffer.GetLength() == 0);
+    ok &= (buffer.GetSurface(head) == MFX_ERR_MORE_SURFACE);
+    for (auto& s : surfaces)
+        ok &= (s.Data.Locked == 0);
+    return ok;
+}
+
+static bool CheckBSStore() {
+    const mfxU32 size = 4;
+    ExtendedBSStore store(size);
+    std::vector<ExtendedBS*> taken;
+    bool ok = true;
+
+    for (mfxU32 i = 0; i < size; i++)
+        taken.push_back(store.GetNext());
+    // handed out in order of the store
+    for (mfxU32 i = 1; i < size; i++)
+        ok &= (taken[i] == taken[0] + i);
+    ok &= (store.GetNext() == NULL);
+
+    // second Release of the same bitstream and foreign bitstreams are ignored
+    ExtendedBS foreign;
+    store.Release(taken[1]);
+    store.Release(taken[1]);
+    store.Release(&foreign);
+    ok &= (store.GetNext() == taken[1]);
+    ok &= (store.GetNext() == NULL);
+
+    // ReleaseAll frees bitstreams which were never released one by one
+    store.Release(taken[2]);
+    store.ReleaseAll();
+    std::set<ExtendedBS*> again;
+    for (mfxU32 i = 0; i < size; i++) {
+        ExtendedBS* pBS = store.GetNext();
+        ok &= (pBS == taken[i] && !pBS->IsFree);
+        again.insert(pBS);
+    }
+    ok &= (again.size() == size);
+    ok &= (store.GetNext() == NULL);
+    return ok;
+}
+
+int main() {
+    bool ok = true;
+    ok &= Report("RingQueue grows when wrapped", CheckGrowWrapped());
+    ok &= Report("RingQueue erases inside the queue", CheckErase());
+    ok &= Report("SafetySurfaceBuffer releases not at the head", CheckReleaseOrder());
+    ok &= Report("ExtendedBSStore free list", CheckBSStore());
+
+    if (!ok) {
+        printf("\nErrors in surface buffer test\n");
+        return -1;
+    }
+    printf("\nSuccess!\n");
+    return 0;
+}